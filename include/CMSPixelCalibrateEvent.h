@@ -48,6 +48,16 @@ namespace eutelescope {
         double par3;
     } cal_param;
 
+    //! Strict ordering of calibration parameters, to share lookup tables
+    struct cal_param_less {
+        bool operator()(const cal_param& a, const cal_param& b) const {
+            if(a.par0 != b.par0) return a.par0 < b.par0;
+            if(a.par1 != b.par1) return a.par1 < b.par1;
+            if(a.par2 != b.par2) return a.par2 < b.par2;
+            return a.par3 < b.par3;
+        }
+    };
+
 
     class CMSPixelCalibrateEventProcessor:public marlin::Processor {
 
@@ -69,6 +79,7 @@ namespace eutelescope {
             void initializeGeometry();            
             void initializeCalibration() throw ( marlin::StopProcessingException );
             void initializeGaintanhCalibration() throw ( marlin::StopProcessingException );
+            void initializeCalibrationCache();
             
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
             void fillHistos (int raw, int calibrated, int sensorID);
@@ -87,6 +98,12 @@ namespace eutelescope {
             int _iRun;
             bool _fillHistos;
             bool _phCalibration;
+
+            //! Memory budget of the calibration lookup tables in kB
+            /*! 0 switches the lookup tables off and every pixel is
+             *  calibrated evaluating the calibration function.
+             */
+            int _calibrationCacheSizekB;
             
             unsigned int _noOfXPixel;
             unsigned int _noOfYPixel;
@@ -107,6 +124,41 @@ namespace eutelescope {
 	    bool calLinear(double &corr, double y);
             std::vector< std::vector< cal_param > > calibration;
 
+            //! Calibrate one pixel signal
+            /*! The lookup table of the pixel is used if available,
+             *  otherwise the calibration function is evaluated.
+             *
+             *  @return false if the signal is out of the calibration range
+             */
+            bool calibrate(short &corr, unsigned int iROC, int iPix, short signal);
+
+            //! Lookup table of one set of calibration parameters
+            /*! The ATanH calibration is only defined on an interval of
+             *  raw signals, so the table covers [firstSignal, lastSignal]
+             *  and everything outside is out of range. offset points to
+             *  the first entry in _calibrationTable, or is one of the
+             *  kCache values.
+             */
+            struct cal_cache_entry {
+                int firstSignal;
+                int lastSignal;
+                int offset;
+            };
+
+            enum { kCacheNotBuilt = -1, kCacheDirect = -2 };
+
+            //! Build, or reuse, the table for a set of parameters
+            cal_cache_entry buildCacheEntry(const cal_param& param);
+
+            //! Per ROC and pixel lookup table, built on the first hit
+            std::vector< std::vector< cal_cache_entry > > _calibrationCache;
+
+            //! Tables of all the pixel classes, one after the other
+            std::vector< short > _calibrationTable;
+
+            //! Pixels with identical parameters share the same table
+            std::map< cal_param, cal_cache_entry, cal_param_less > _calibrationClasses;
+
     };
 
     //! A global instance of the processor
@@ -191,14 +191,24 @@ namespace eutelescope {
     bool generatePedeSteeringFile(std::vector<double> &params, bool shifts, bool rotate, bool scale);
     void runPede(std::vector<double> &params);
     void addToLCIO(double chi2, int ndof);
-    void addPlaneHit(APIXFitter::FitPlane* pl, TrackerHitImpl*);
+    void setPlaneHit(APIXFitter::FitPlane* pl, int hit);
+    int gatePlaneHits(int plane, APIXFitter::TrackEstimate* est);
     double getScatterCov(int index);
     bool inTimeGood(APIXFitter::FitPlane* pl);
     bool goodResiduals(APIXFitter::FitPlane* pl);
     APIXFitter::APIXKalman* _fitter;
     std::map<double, int> _zSort;
     
-    std::vector< std::vector<TrackerHitImpl*> > _planeHits;
+    //! Hit positions in um, staged per plane before the track search
+    std::vector< std::vector<double> > _planeHitX;
+    std::vector< std::vector<double> > _planeHitY;
+    //! Hit errors of each plane, in um
+    std::vector<double> _planeErrX;
+    std::vector<double> _planeErrY;
+    //! Hits of each plane passing the normalized residual cut
+    std::vector< std::vector<int> > _planeGate;
+    //! Track estimates reused by fitPermutations, one per plane depth
+    std::vector<APIXFitter::TrackEstimate*> _estimatePool;
 
     bool _checkInTime;
 
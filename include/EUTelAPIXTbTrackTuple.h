@@ -1,10 +1,11 @@
 // Version: $Id$
-#ifndef EUTelFitTuple_h
-#define EUTelFitTuple_h 1
+#ifndef EUTelAPIXTbTrackTuple_h
+#define EUTelAPIXTbTrackTuple_h 1
 
 #include "marlin/Processor.h"
 #include "EUTelAlignmentConstant.h"
 #include "EUTelReferenceHit.h"
+#include "EUTelTupleWriter.h"
 
 
 // gear includes <.h>
@@ -35,8 +36,6 @@
 #include <map>
 
 #include <gsl/gsl_matrix_double.h>
-#include <TFile.h>
-#include <TTree.h>
 namespace eutelescope {
   class EUTelAPIXTbTrackTuple : public marlin::Processor {
     
@@ -68,6 +67,26 @@ namespace eutelescope {
     void setClusterIdInHits();
     void getDUTRot(EUTelAlignmentConstant * alignment);
 
+    //! Book a column of a tree and bind it to a processor variable
+    /*! The bound variable is copied into the column each time
+     *  fillTree() is called for the tree.
+     */
+    void bindColumn(EUTelTupleTree * tree, const std::string& name, const int * value);
+    void bindColumn(EUTelTupleTree * tree, const std::string& name, std::vector<int> * const * value);
+    void bindColumn(EUTelTupleTree * tree, const std::string& name, std::vector<double> * const * value);
+
+    //! Copy the bound variables into the tree and commit the row
+    void fillTree(EUTelTupleTree * tree);
+
+    //! A processor variable bound to a tuple column
+    struct ColumnBinding {
+      EUTelTupleTree * tree;
+      int column;
+      const int * intValue;
+      std::vector<int> * const * intVector;
+      std::vector<double> * const * doubleVector;
+    };
+
     bool _foundAllign;
     bool _doScales;
     std::vector<std::string> _alignColNames;
@@ -98,6 +117,21 @@ namespace eutelescope {
 
     std::string _path2file;
 
+    //! Basket size in bytes of the output branches
+    int _tupleBasketSize;
+
+    //! Auto flush setting of the output trees
+    /*! Positive values are entries, negative values bytes, as
+     *  TTree::SetAutoFlush
+     */
+    int _tupleAutoFlush;
+
+    //! Number of rows buffered before being handed to the writer
+    int _tupleRowsPerBlock;
+
+    //! Fill and compress the trees on a background thread
+    bool _tupleBackgroundWriting;
+
     //! reference HitCollection name 
     /*!
      */
@@ -114,9 +148,12 @@ namespace eutelescope {
 
     bool _isFirstEvent;
     
-    TFile* _file;
+    EUTelTupleFile* _file;
+
+    //! The processor variables bound to the tree columns
+    std::vector<ColumnBinding> _columnBindings;
 
-    TTree* _eutracks;
+    EUTelTupleTree* _eutracks;
     int _nTrackParams;
     std::vector<double> *_xPos;
     std::vector<double> *_yPos;
@@ -127,7 +164,7 @@ namespace eutelescope {
     std::vector<double> *_chi2;
     std::vector<double> *_ndof;    
 
-    TTree* _zstree;
+    EUTelTupleTree* _zstree;
     int _nPixHits;
     std::vector<int> *p_col;
     std::vector<int> *p_row;
@@ -137,7 +174,7 @@ namespace eutelescope {
     std::vector<int> *p_chip;
     std::vector<int> *p_clusterId;
 
-    TTree* _clutree;
+    EUTelTupleTree* _clutree;
     std::vector<int> *_clusize;
     std::vector<int> *_clusizeX;
     std::vector<int> *_clusizeY;
@@ -149,7 +186,7 @@ namespace eutelescope {
     std::map<IMPL::TrackerDataImpl*, int> *_cluPointer;
     //std::vector< >   *_cluPointerToPixHits;
     
-    TTree* _euhits;
+    EUTelTupleTree* _euhits;
     int _nHits;
     std::vector<double> *_hitXPos;
     std::vector<double> *_hitYPos;
@@ -158,7 +195,7 @@ namespace eutelescope {
     std::vector<int>    *_hitSensorId;
     std::vector<IMPL::TrackerDataImpl*>    *_hitPointerToCluster;
 
-    TTree* _rottree;
+    EUTelTupleTree* _rottree;
     std::vector<int> *_rotDUTId;  
     std::vector<double> *_alpha;
     std::vector<double> *_beta; 
@@ -0,0 +1,214 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELALIGNMENTCACHE_H
+#define EUTELALIGNMENTCACHE_H
+
+// system includes <>
+#include <cstdio>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Binary cache of the hits and track candidates used by an alignment
+  /*! Iterative alignment reads the same data many times, and each time
+   *  decodes the hits, checks them against the hot pixels, guesses
+   *  their sensor and searches the track candidates again, while only
+   *  the alignment constants applied to the hits change. The first
+   *  iteration can instead save, event by event, the selected hits and
+   *  the track candidates built from them with an
+   *  EUTelAlignmentCacheWriter, and the following iterations read
+   *  them back with an EUTelAlignmentCacheReader.
+   *
+   *  The file is made of fixed size records in the native byte order,
+   *  all aligned to 8 bytes, so it can be mapped in memory and read in
+   *  place:
+   *
+   *  \li a header: the 8 character tag "EUTALC3", the number of planes,
+   *  their sensor IDs and the length of the parameter digest (int32),
+   *  padded to 8 bytes, then the digest itself, padded to 8 bytes;
+   *
+   *  \li for every event: the number of hits and of track candidates
+   *  (int32), the hits (Hit records), and for every track candidate
+   *  the index of its hit in each plane, -1 if none (int32), padded
+   *  to 8 bytes;
+   *
+   *  \li a trailer: -1 and the number of events (int32), then the 8
+   *  character tag "EUTALEND".
+   *
+   *  The file is written under a temporary name and renamed only once
+   *  the trailer is there, and the reader checks the whole file when
+   *  opening it, so a cache left incomplete by a crashed job, or
+   *  otherwise damaged, is never used.
+   *
+   *  The parameter digest is a text given by the writer, listing the
+   *  settings the cached hits and track candidates depend on. The
+   *  user of the cache compares it with its own before reading the
+   *  events, so that a cache built with other cuts is not used.
+   *
+   *  The cache is not portable between machines of different
+   *  endianness; it is meant to live as long as an alignment campaign.
+   */
+  class EUTelAlignmentCache {
+
+  public:
+    //! One cached hit
+    struct Hit {
+      //! Position, in the units used by the alignment processor
+      double x, y, z;
+      //! Position errors, same units
+      float sigmaX, sigmaY;
+      //! Plane index of the hit
+      int plane;
+      int padding;
+    };
+
+    //! Correct a cached position with one set of alignment constants
+    /*! This is the correction of EUTelApplyAlignmentProcessor with
+     *  the rotation first: the position is rotated by -alpha, -beta
+     *  and -gamma around the X, Y and Z axes through the centre of its
+     *  sensor, then shifted by -offset. As there, the rotation centre
+     *  is the reference hit of the sensor moved by offset.
+     *
+     *  @param position The position, corrected in place
+     *  @param centre The centre of the sensor, same units
+     *  @param alpha, beta, gamma The rotation angles in radian
+     *  @param offset The shift, same units
+     */
+    static void applyAlignment(double position[3], const double centre[3],
+                               double alpha, double beta, double gamma, const double offset[3]);
+
+    //! The tag at the beginning of every cache file
+    static const char * const tag;
+
+    //! The tag at the end of every complete cache file
+    static const char * const endTag;
+  };
+
+  //! Writes an EUTelAlignmentCache file
+  class EUTelAlignmentCacheWriter {
+
+  public:
+    EUTelAlignmentCacheWriter();
+    ~EUTelAlignmentCacheWriter();
+
+    //! Create the file and write its header
+    /*! The file is written as filename.tmp until close().
+     *
+     *  @return false if the file could not be created
+     */
+    bool open(const std::string & filename, const std::vector< int > & sensorIDs,
+              const std::string & parameters);
+
+    //! Append an event
+    /*! @param hits The hits of the event
+     *  @param trackHits For each track candidate, the index in hits of
+     *  its hit in each plane (-1 if none), one candidate after the
+     *  other
+     */
+    void writeEvent(const std::vector< EUTelAlignmentCache::Hit > & hits, const std::vector< int > & trackHits);
+
+    //! Write the trailer and give the file its final name
+    /*! @return false if anything could not be written, the file is
+     *  then removed
+     */
+    bool close();
+
+    bool isOpen() const { return _file != NULL; }
+
+    //! Number of events written so far
+    size_t getNEvents() const { return _nEvents; }
+
+  private:
+    EUTelAlignmentCacheWriter(const EUTelAlignmentCacheWriter&);
+    void operator=(const EUTelAlignmentCacheWriter&);
+
+    //! Close and remove the temporary file
+    /*! Also used by the destructor: a cache not closed explicitly is
+     *  not trusted.
+     */
+    void discard();
+
+    FILE * _file;
+    std::string _filename;
+    size_t _nPlanes;
+    size_t _nEvents;
+  };
+
+  //! Reads an EUTelAlignmentCache file in place
+  /*! The file is mapped in memory, or read in one go if that is not
+   *  possible, and the events are returned as pointers into it, valid
+   *  until close().
+   */
+  class EUTelAlignmentCacheReader {
+
+  public:
+    EUTelAlignmentCacheReader();
+    ~EUTelAlignmentCacheReader();
+
+    //! Open a cache file
+    /*! All the events are checked: their sizes have to match the
+     *  trailer, the plane of every hit has to exist and every track
+     *  candidate has to point to hits of its own event.
+     *
+     *  @return false if the file does not exist or is not a complete
+     *  and valid cache
+     */
+    bool open(const std::string & filename);
+
+    //! Read the next event
+    /*! @param hits Set to the hits of the event
+     *  @param nHits Set to the number of hits
+     *  @param trackHits Set to the hit indices of the track
+     *  candidates, getNPlanes() per candidate
+     *  @param nTracks Set to the number of track candidates
+     *  @return false at the end of the file
+     */
+    bool nextEvent(const EUTelAlignmentCache::Hit * & hits, int & nHits,
+                   const int * & trackHits, int & nTracks);
+
+    //! Go back to the first event
+    void rewind();
+
+    void close();
+
+    const std::vector< int > & getSensorIDs() const { return _sensorIDs; }
+    size_t getNPlanes() const { return _sensorIDs.size(); }
+
+    //! The parameter digest given to the writer
+    const std::string & getParameters() const { return _parameters; }
+
+    //! Number of events in the file
+    size_t getNEvents() const { return _nEvents; }
+
+  private:
+    EUTelAlignmentCacheReader(const EUTelAlignmentCacheReader&);
+    void operator=(const EUTelAlignmentCacheReader&);
+
+    //! The file content, either mapped or read in _buffer
+    const char * _data;
+    size_t _size;
+    bool _mapped;
+    std::vector< double > _buffer;
+
+    //! Check all the events up to the trailer
+    bool validate();
+
+    size_t _firstEvent;
+    size_t _endOfEvents;
+    size_t _position;
+    size_t _nEvents;
+    std::vector< int > _sensorIDs;
+    std::string _parameters;
+  };
+
+}
+#endif
@@ -411,7 +411,7 @@ namespace eutelescope {
     *
     *  @return The pointer of _trackerData
     */
-    IMPL::TrackerDataImpl * trackerData() { return _trackerData; }
+    IMPL::TrackerDataImpl * trackerData() { invalidateSummary(); return _trackerData; }
 
     //! Print method
     /*! This method is used to print out the content of the clusters
@@ -424,6 +424,15 @@ namespace eutelescope {
 
     private:
 
+    //! Fill the charge part of the cluster summary
+    /*! The unwanted pixels of the bricked frame are zeroed once for
+     *  the total charge and the CoG shift together.
+     */
+    void fillSummary() const;
+
+    //! Fill the noise part of the cluster summary
+    void fillNoiseSummary() const;
+
     //! Noise values vector
     std::vector<float > _noiseValues;
 
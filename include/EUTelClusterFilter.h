@@ -305,10 +305,16 @@ namespace eutelescope {
      *  because they require a global knowledge of the event. There
      *  are no selction criteria of this kind implemented yet.
      *
-     *  All active selection criteria are tested against each
-     *  cluster. This is because at the end of the job a complete
-     *  rejection summary is displayed and the user can evaluate the
-     *  strength of each single item.
+     *  The cluster based criteria are evaluated one after the other
+     *  through a pipeline containing only the active ones, and a
+     *  cluster is rejected as soon as one of them fails. The order
+     *  of the pipeline is adapted during the processing so that the
+     *  criteria with the lowest cost per rejected cluster come
+     *  first. For this reason the rejection summary displayed at the
+     *  end of the job counts each rejected cluster only once, for
+     *  the first criterion it failed, and it is followed by the
+     *  number of evaluations, rejections and the average time of
+     *  each criterion.
      *
      *  @param evt The input LCEvent
      *
@@ -336,17 +342,73 @@ namespace eutelescope {
      */
     virtual void end();
 
+    //! Summary of a cluster under test
+    /*! The selection criteria do not ask the cluster directly for
+     *  its charge, SNR, noise and center of gravity, because each of
+     *  these requests goes through the cluster pixels again. They ask
+     *  this summary instead, which computes each quantity the first
+     *  time it is needed and reuses it for all the other criteria.
+     */
+    class ClusterSummary {
+    public:
+      //! Default constructor
+      /*! @param cluster The cluster under test, not owned
+       *  @param detectorPos The position of the cluster detector in
+       *  the selection vectors
+       */
+      ClusterSummary(EUTelVirtualCluster * cluster, int detectorPos);
+
+      //! The cluster under test
+      EUTelVirtualCluster * getCluster() const { return _cluster; }
+
+      //! The cluster detector ID
+      int getDetectorID() const { return _detectorID; }
+
+      //! The position of the detector in the selection vectors
+      int getDetectorPos() const { return _detectorPos; }
+
+      float getTotalCharge();
+      float getSeedCharge();
+      float getClusterSNR();
+      float getSeedSNR();
+      float getClusterNoise();
+      void getCenterOfGravity(float& x, float& y);
+
+    private:
+      //! Bits of the quantities already computed
+      enum {
+        kTotalCharge     = 1 << 0,
+        kSeedCharge      = 1 << 1,
+        kClusterSNR      = 1 << 2,
+        kSeedSNR         = 1 << 3,
+        kClusterNoise    = 1 << 4,
+        kCenterOfGravity = 1 << 5
+      };
+
+      EUTelVirtualCluster * _cluster;
+      int _detectorID;
+      int _detectorPos;
+      int _available;
+      float _totalCharge;
+      float _seedCharge;
+      float _clusterSNR;
+      float _seedSNR;
+      float _clusterNoise;
+      float _xCoG;
+      float _yCoG;
+    };
+
     //! Check if the total cluster charge is above a certain value
     /*! This is used to select clusters having a total integrated
      *  charge above a certain value. This threshold value is given on
      *  a per detector basis and stored into the
      *  _clusterMinTotalChargeVec.
      *
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      *  @return True if the @c cluster has a charge below its own threshold.
      *
      */
-    bool isAboveMinTotalCharge(EUTelVirtualCluster * cluster) const ;
+    bool isAboveMinTotalCharge(ClusterSummary & cluster) const ;
 
 
     //! Check if the total cluster SNR is above a certain value
@@ -354,11 +416,11 @@ namespace eutelescope {
      *  certain value. This threshold value is given on a per detector
      *  basis and stored into the _minTotalSNRVec.
      *
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      *  @return True if the @c cluster has a SNR below its own
      *  threshold.
      */
-    bool isAboveMinTotalSNR(EUTelVirtualCluster * cluster) const;
+    bool isAboveMinTotalSNR(ClusterSummary & cluster) const;
 
     //! Check if the total cluster charge is below a certain value
     /*! This is used to select clusters having a total integrated
@@ -369,7 +431,7 @@ namespace eutelescope {
      *  @return True if the @c cluster has a charge below its own threshold.
      *
      */
-    bool isBelowMaxTotalCharge(EUTelVirtualCluster * /* cluster */ ) const { return true; }
+    bool isBelowMaxTotalCharge(ClusterSummary & /* cluster */ ) const { return true; }
 
 
     //! Check if the total cluster charge is above a certain value
@@ -378,10 +440,10 @@ namespace eutelescope {
      *  a per detector basis and stored into the
      *  _clusterMaxTotalChargeVec.    .
      *
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      *
      */
-    bool isAboveNumberOfHitPixel(EUTelVirtualCluster * cluster) const;
+    bool isAboveNumberOfHitPixel(ClusterSummary & cluster) const;
 
 
     //! Check against the charge collected by N pixels
@@ -394,9 +456,9 @@ namespace eutelescope {
      *  considered.
      *
      *  @return True if the charge is above threshold
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      */
-    bool isAboveNMinCharge(EUTelVirtualCluster * cluster) const;
+    bool isAboveNMinCharge(ClusterSummary & cluster) const;
 
     //! Check against the SNR of the N most significant pixels
     /*! The SNR of the cluster made by the first N significant pixels
@@ -407,45 +469,45 @@ namespace eutelescope {
      *  considered.
      *
      *  @return True if the SNR is above threshold
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      */
-    bool isAboveNMinSNR(EUTelVirtualCluster * cluster) const;
+    bool isAboveNMinSNR(ClusterSummary & cluster) const;
 
     //! Check against the charge collected by N x N pixels
     /*! This cut is working on the charge collected by a subframe N x
      *  N pixels wide centered around the seed.
      *
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      *  @return True if the charge is above threshold.
      */
-    bool isAboveNxNMinCharge(EUTelVirtualCluster * cluster) const;
+    bool isAboveNxNMinCharge(ClusterSummary & cluster) const;
 
     //! Check against the SNR collected by N x N pixels
     /*! This cut is working on the SNR collected by a subframe N x
      *  N pixels wide centered around the seed.
      *
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      *  @return True if the SNR is above threshold.
      */
-    bool isAboveNxNMinSNR(EUTelVirtualCluster * cluster) const;
+    bool isAboveNxNMinSNR(ClusterSummary & cluster) const;
 
     //! Seed pixel cut
     /*! This is used to select clusters having a seed pixel charge
      *  above the specified threshold
      *
      *  @return True if the seed pixel charge is above threshold
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      */
-    bool isAboveMinSeedCharge(EUTelVirtualCluster * cluster) const;
+    bool isAboveMinSeedCharge(ClusterSummary & cluster) const;
 
     //! Seed SNR cut
     /*! This is used to select clusters having a seed pixel SNR above
      *  the specified threshold
      *
      *  @return True if the seed SNR is above threshold
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      */
-    bool isAboveMinSeedSNR(EUTelVirtualCluster * cluster) const;
+    bool isAboveMinSeedSNR(ClusterSummary & cluster) const;
 
     //! Quality cut
     /*! This is a selection cut based on the cluster quality. Only
@@ -456,9 +518,9 @@ namespace eutelescope {
      *  quality vector.
      *
      *  @return True if the quality is correct
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      */
-    bool hasQuality(EUTelVirtualCluster * cluster) const;
+    bool hasQuality(ClusterSummary & cluster) const;
 
     //! Same number of hits
     /*! This selection criterion can be used to select events in which
@@ -500,29 +562,29 @@ namespace eutelescope {
      *  having the center within a certain ROI.
      *
      *  @return True if the cluster center is inside the ROI
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      *
      */
-    bool isInsideROI(EUTelVirtualCluster * cluster) const;
+    bool isInsideROI(ClusterSummary & cluster) const;
 
     //! Outside the ROI
     /*! This selection criterion can be used to get only clusters
      *  having the center outside a certain ROI.
      *
      *  @return True if the cluster center is outside the ROI
-     *  @param cluster The cluster under test.
+     *  @param cluster The summary of the cluster under test.
      *
      */
-    bool isOutsideROI(EUTelVirtualCluster * cluster) const;
+    bool isOutsideROI(ClusterSummary & cluster) const;
 
     //! Below the maximum cluster noise
     /*! This selection criterion is based on the full cluster noise.
      *
      *  @return True if the cluster noise is below the maximum
      *  allowed.
-     *  @param cluster The cluster under test
+     *  @param cluster The summary of the cluster under test
      */
-    bool isBelowMaxClusterNoise(EUTelVirtualCluster * cluster) const;
+    bool isBelowMaxClusterNoise(ClusterSummary & cluster) const;
 
     //! Print the rejection summary
     /*! To better understand which cut is more important, a rejection
@@ -559,6 +621,32 @@ namespace eutelescope {
      */
     void checkCriteria() ;
 
+    //! Build the selection pipeline
+    /*! Called at the end of checkCriteria, it puts the active cluster
+     *  based criteria into the pipeline, the cheapest first.
+     */
+    void buildFilterPipeline();
+
+    //! Apply the selection pipeline to a cluster
+    /*! The criteria are evaluated in the pipeline order and the
+     *  evaluation stops at the first one failing. The pipeline is
+     *  reordered every now and then with reorderFilterPipeline().
+     *
+     *  @param cluster The summary of the cluster under test
+     *  @param isDFFCluster True for digital fixed frame clusters,
+     *  which have their own set of criteria
+     *  @return True if the cluster passed all the criteria
+     */
+    bool applyFilterPipeline(ClusterSummary & cluster, bool isDFFCluster);
+
+    //! Reorder the selection pipeline
+    /*! The criteria are sorted by their measured average time divided
+     *  by their rejection rate, the average cost per rejected
+     *  cluster, so that most clusters are rejected by the cheapest
+     *  criteria and never reach the more expensive ones.
+     */
+    void reorderFilterPipeline();
+
   protected:
 
     //! Input pulse collection name.
@@ -866,6 +954,37 @@ namespace eutelescope {
 
     //digital fixed frame cuts
     std::vector<int> _DFFNHitsCuts;
+
+    //! One stage of the selection pipeline
+    struct FilterStage {
+      //! The criterion name, as in the rejection summary
+      std::string name;
+
+      //! The selection criterion
+      bool (EUTelClusterFilter::*criterion)(ClusterSummary &) const;
+
+      //! The cluster kinds the criterion applies to
+      enum Scope { kAllClusters, kDFFClusters, kNonDFFClusters } scope;
+
+      //! Number of clusters evaluated
+      unsigned long long evaluated;
+
+      //! Number of clusters rejected
+      unsigned long long rejected;
+
+      //! Number of timed evaluations
+      unsigned long long timed;
+
+      //! Total time of the timed evaluations in seconds
+      double time;
+    };
+
+    //! The active cluster based criteria, in evaluation order
+    std::vector<FilterStage > _filterPipeline;
+
+    //! Number of clusters through the pipeline
+    unsigned long long _filteredClusterCounter;
+
   public:
 
     //! Helper predicate class
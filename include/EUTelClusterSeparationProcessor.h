@@ -48,6 +48,13 @@ namespace eutelescope {
    *  clusters with a distance between the seed pixels lesser of equal
    *  to the sum of the two radii.
    *
+   *  To avoid comparing every cluster with all the others, the seed
+   *  positions of each detector are binned in a grid having the cell
+   *  size equal to the largest merging distance, so that only
+   *  clusters in neighbouring cells are compared. Merging pairs are
+   *  then grouped with a union-find, so the whole search scales
+   *  linearly with the cluster multiplicity.
+   *
    *  Here comes a list of all implemented
    *  separation algorithm:
    *
@@ -191,6 +198,32 @@ namespace eutelescope {
      */ 
     void groupingMergingPairs(std::vector< std::pair<int , int> > pairVector, std::vector< std::set< int > > * setVector) const;
 
+    //! Seed position and size of a cluster
+    /*! This is all what is needed to decide if two clusters are
+     *  merging.
+     */
+    struct ClusterCentre {
+      int   detectorID;
+      int   xSeed;
+      int   ySeed;
+      float externalRadius;
+    };
+
+    //! Finds all pairs of merging clusters
+    /*! The cluster centres are binned detector by detector in a grid
+     *  with cell size equal to the merging distance, and each cluster
+     *  is compared only with the clusters in the same and in the
+     *  eight neighbouring cells.
+     *
+     *  @param centreVector The cluster centres, indexed as in the
+     *  clusterCollection
+     *
+     *  @param pairVector A pointer to the STL vector of pairs where
+     *  the merging pairs are appended, with first < second.
+     */
+    void findMergingPairs(const std::vector< ClusterCentre > & centreVector,
+                          std::vector< std::pair<int, int> > * pairVector) const;
+
   protected:
 
     //! Input cluster collection name.
@@ -208,7 +241,8 @@ namespace eutelescope {
      *  two clusters. If their distance is below this number, then the
      *  two will be considered merging and the separation algorithm
      *  will be applied. If it is set to 0, only touching clusters
-     *  will be considered merging.
+     *  will be considered merging, i.e. clusters closer than the sum
+     *  of their external radii.
      */
     float _minimumDistance;
 
@@ -0,0 +1,120 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELCONVERGENCEMONITOR_H
+#define EUTELCONVERGENCEMONITOR_H
+
+// marlin includes ".h"
+#include "marlin/Processor.h"
+#include "marlin/Exceptions.h"
+
+// system includes <>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Stops the job when all the calibration passes have converged
+  /*! Calibration-like processors (pre-alignment, correlation, hot
+   *  pixel finding...) usually read a fixed number of events, even if
+   *  their result stopped changing long before. With this monitor a
+   *  processor registers the estimators its result is made of, each
+   *  with an absolute tolerance, and then periodically updates their
+   *  values.
+   *
+   *  An estimator has converged when its value has changed by less
+   *  than its tolerance for getRequiredStableUpdates() updates in a
+   *  row, a processor when all its estimators have converged or when
+   *  it has read all the events it wanted anyway (see setDone()).
+   *  When every registered processor is in that state, check() throws
+   *  a marlin::StopProcessingException, so that Marlin goes directly
+   *  to the end() of all processors.
+   *
+   *  Processors which do not register are not considered, so the
+   *  monitor should only be used in jobs made of calibration passes.
+   *  There is a single monitor per job, see instance().
+   */
+  class EUTelConvergenceMonitor {
+
+  public:
+    //! The monitor of the job
+    static EUTelConvergenceMonitor & instance();
+
+    //! Register an estimator of a processor
+    /*! Registering the first estimator also registers the processor.
+     *
+     *  @param processor The processor the estimator belongs to
+     *  @param name A name unique within the processor, used in the log
+     *  @param tolerance The absolute tolerance on the estimator value
+     *  @param eventsPlanned The number of events the processor would
+     *  read without the monitor, used to report the events saved
+     */
+    void registerEstimator(marlin::Processor * processor, const std::string & name,
+                           double tolerance, int eventsPlanned);
+
+    //! Update the value of an estimator
+    /*! @param nEvent The number of events the processor has read so far
+     */
+    void update(marlin::Processor * processor, const std::string & name, double value, int nEvent);
+
+    //! Forget the previous values of the estimators of a processor
+    /*! For processors that start their estimation again, e.g. at
+     *  every cycle: the following update is not compared with the
+     *  older values.
+     */
+    void reset(marlin::Processor * processor);
+
+    //! Mark a processor as done, whatever its estimators say
+    void setDone(marlin::Processor * processor, int nEvent);
+
+    //! True if all the estimators of the processor have converged
+    bool hasConverged(marlin::Processor * processor) const;
+
+    //! Stop the job if all the registered processors have converged
+    /*! To be called by the registered processors from their
+     *  processEvent(), after their updates.
+     *
+     *  @throw marlin::StopProcessingException if all the processors
+     *  have converged or are done
+     */
+    void check(marlin::Processor * processor);
+
+    //! Number of updates within tolerance needed for convergence
+    int getRequiredStableUpdates() const { return _requiredStableUpdates; }
+    void setRequiredStableUpdates(int updates) { _requiredStableUpdates = updates; }
+
+  private:
+    EUTelConvergenceMonitor();
+    EUTelConvergenceMonitor(const EUTelConvergenceMonitor&);
+    void operator=(const EUTelConvergenceMonitor&);
+
+    struct Estimator {
+      std::string name;
+      double tolerance;
+      double value;
+      bool hasValue;
+      int stableUpdates;
+    };
+
+    struct ProcessorState {
+      std::vector< Estimator > estimators;
+      int eventsPlanned;
+      int nEvent;
+      bool done;
+      bool converged;
+    };
+
+    std::map< marlin::Processor *, ProcessorState > _processors;
+
+    int _requiredStableUpdates;
+  };
+
+}
+#endif
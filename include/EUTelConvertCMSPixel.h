@@ -15,6 +15,7 @@
 
 // EUTelescope includes
 #include "EUTELESCOPE.h"
+#include "EUTelThreadUtility.h"
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 // AIDA includes
@@ -72,9 +73,16 @@ namespace eutelescope
    * @param shufflePlanes gives the possibility to re-order the ROCs coming from the native
    * raw data. This is useful if the readout order of the ROCs is not identical with the
    * order of the ROC telescope planes.
+   * @param decoderQueueSize enables the pipelined mode if larger than zero: the raw
+   * data file is read and decoded by a separate thread, which prepares up to this
+   * number of LCIO events ahead of the processor chain. Histograms are still filled
+   * and the processors still run on the Marlin thread. With zero (the default) the
+   * decoding is done in sequence with the processing.
    *
    */
 
+    class EUTelEventImpl;
+
     class EUTelConvertCMSPixel: public marlin::DataSourceProcessor 
     {
         public:
@@ -231,8 +239,95 @@ namespace eutelescope
 
 	    //! Layer index map of the ROC planes
 	    std::map< int , int > _layerIndexMap;        	      	
+
+	    //! Number of events decoded ahead by the decoder thread
+	    /*! Zero means that no decoder thread is used.
+	     */
+	    int _decoderQueueSize;
            
         private:
+	    //! What to do with a decoded trigger
+	    enum DecoderVerdict {
+	      kUseEvent,      //!< send it to the processors
+	      kSkipEvent,     //!< corrupted or empty, go on with the next one
+	      kEndOfData,     //!< no more data in the file
+	      kTriggerLimit   //!< MaxRecordNumber reached, nothing was read
+	    };
+
+	    //! One trigger on its way from the decoder to the processors
+	    /*! The pixel vector is recycled from event to event, so that it
+	     *  is allocated only once per slot. The LCIO event is owned by
+	     *  the slot until the processor chain has seen it.
+	     */
+	    struct DecodedEvent {
+	      DecodedEvent() : data(), evtTiming(), eventNumber(0), status(0), verdict(kSkipEvent), evt(0) { }
+	      std::vector< CMSPixel::pixel > data;
+	      CMSPixel::timing evtTiming;
+	      int eventNumber;
+	      int status;
+	      DecoderVerdict verdict;
+	      EUTelEventImpl * evt;
+	    };
+
+	    //! Write the run header and book histograms
+	    void processRunHeader();
+
+	    //! Read and decode the next trigger into the slot
+	    /*! This is the only method running on the decoder thread in the
+	     *  pipelined mode, so it must not touch histograms nor the
+	     *  logging streams.
+	     */
+	    void decodeEvent(DecodedEvent * decoded);
+
+	    //! Translate the decoder return code
+	    DecoderVerdict verdictFor(int decoderStatus) const;
+
+	    //! Build the LCIO event out of the decoded pixel hits
+	    EUTelEventImpl * buildEvent(const std::vector< CMSPixel::pixel > & eventData,
+					const CMSPixel::timing & evtTiming, int evtNumber) const;
+
+	    //! Fill the histograms, log and run the processors on a decoded trigger
+	    /*! @return true if this was the last trigger of the run
+	     */
+	    bool processDecodedEvent(DecodedEvent * decoded);
+
+	    //! Fill all the per event histograms
+	    void fillEventHistos(const std::vector< CMSPixel::pixel > & eventData,
+				 const CMSPixel::timing & evtTiming, int evtNumber);
+
+	    //! Create the slots and start the decoder thread
+	    void startDecoderThread();
+
+	    //! Stop and join the decoder thread, release the slots
+	    void stopDecoderThread();
+
+	    //! Decoder thread main loop
+	    void decodeAhead();
+
+	    //! pthread entry point for decodeAhead()
+	    static void * decoderThreadEntry(void * self);
+
+	    //! The raw data decoder
+	    CMSPixel::CMSPixelFileDecoder * _readout;
+
+	    //! MaxRecordNumber of the current readDataSource call
+	    int _maxTrigger;
+
+	    //! All the slots, free or in use
+	    std::vector< DecodedEvent * > _decodedEvents;
+
+	    //! Slots ready to be reused by the decoder thread
+	    EUTelBoundedQueue< DecodedEvent * > * _freeEvents;
+
+	    //! Decoded triggers waiting for the processor chain
+	    EUTelBoundedQueue< DecodedEvent * > * _readyEvents;
+
+	    //! The decoder thread
+	    pthread_t _decoderThread;
+
+	    //! Set when the decoder thread is running
+	    bool _isDecoderThreadRunning;
+
 	    //! First procesed event
             bool _isFirstEvent;
 
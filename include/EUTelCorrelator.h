@@ -138,14 +138,6 @@ namespace eutelescope {
      */
     void bookHistos();
 
-    //! Called for first event per run
-    /*! Reads hotpixel information from hotPixelCollection into hotPixelMap
-     * to be used in the sensor exclusion area logic 
-     */
-    virtual void  FillHotPixelMap(LCEvent *event);
-
-    //! check whether the hit given as argument contains at least one hit which belongs to the hot pixel map 
-    virtual bool hitContainsHotPixels( TrackerHitImpl   * hit) ;
 
     //! internal functtion: return the ID of a plane selected as a reference plane for correlation plots
 
@@ -211,12 +203,6 @@ namespace eutelescope {
     EVENT::StringVec  _clusterCollectionVec;
 
 
-    //! A function to guess the sensorID of a hit
-    /*! It is checking against the distance of each plane assuming
-     *  that this hit is belonging to the plane at the closest distant.
-     */
-  //  int guessSensorID( TrackerHitImpl * hit ) ;
-    int guessSensorID( const double* hit ) ;
 
 
     std::vector<double> guessSensorOffset(int internalSensorID, int externalSensorID, std::vector<double> cluCenter );
@@ -355,16 +341,6 @@ namespace eutelescope {
      */
     std::string _hotPixelCollectionName;
 
-    //! Vector of map arrays, keeps record of hit pixels 
-    /*! The vector elements are sorted by Detector ID
-     *  For each Detector unique ID element a map of pixels is created. 
-     *  first level key   sensor unique 
-     *              value sensor map
-     *  sensor map key    unique row number
-     *             value  vector of column numbers.
-     */
-    
-    std::map<std::string, bool > _hotPixelMap;
 
     //! reference HitCollection name 
     /*!
@@ -148,6 +148,13 @@ namespace eutelescope {
     virtual int getClusterSize(int sensorID, TrackerHit * hit, int& sizeX, int& sizeY, int& subMatrix );
     virtual int getSubMatrix(int sensorID, float xlocal);
 
+    //! Match the fitted track positions to the DUT hits
+    /*! Fills the match table (_matches) and the matched flags of the
+     *  fitted positions and of the hits, which are then used by all
+     *  the histogram blocks of processEvent().
+     */
+    void matchFittedToMeasured();
+
     //! Called after data processing for clean up.
     /*! Used to release memory allocated in init() step
      */
@@ -272,6 +279,30 @@ protected:
  
     std::vector<float > _DUTalign;
 
+    //! A fitted position matched to a DUT hit
+    struct Match {
+      //! Track index, in _fittedX
+      int track;
+      //! Fitted position index, in _fittedX[track]
+      int fit;
+      //! Hit index, in _measuredX
+      int hit;
+      //! Squared distance between the two
+      double dist2;
+    };
+
+    //! Match table of the current event, one entry per matched track
+    std::vector<Match> _matches;
+
+    //! For each track and fitted position, true if matched
+    std::vector< std::vector<bool> > _fitMatched;
+
+    //! For each DUT hit, true if matched
+    std::vector<bool> _hitMatched;
+
+    //! DUT hits (X, index) sorted in X, for the matching
+    std::vector< std::pair<double,int> > _sortedHits;
+
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
     //! AIDA histogram maps
@@ -16,8 +16,10 @@
 #include "marlin/DataSourceProcessor.h"
 
 // lcio includes <.h>
+#include <IMPL/TrackerRawDataImpl.h>
 
 // system includes <>
+#include <string>
 
 
 namespace eutelescope {
@@ -219,6 +221,20 @@ namespace eutelescope {
    *   @param CalculationAlgorithm The algorithm to be used to fill
    *   the TrackerRawData
    *
+   *   @param UseMemoryMap If true, the input file is mapped in memory
+   *   and the event records are decoded in place, without copying
+   *   them into an intermediate buffer. If the mapping fails, the
+   *   processor falls back to the stream reading.
+   *
+   *   @param SequentialReadAhead Only with UseMemoryMap: advise the
+   *   kernel that the file is going to be read sequentially, so that
+   *   it can read ahead aggressively.
+   *
+   *   @param FirstEvent Index of the first event to be converted. The
+   *   previous ones are skipped without reading them; together with
+   *   the MaxRecordNumber this allows to convert only a subrange of
+   *   the file.
+   *
    *   @author  Antonio Bulgheroni, INFN <mailto:antonio.bulgheroni@gmail.com>
    *   @version $Id$
    *
@@ -272,8 +288,70 @@ namespace eutelescope {
     
     //! Calculation algorithm
     std::string _algo;
+
+    //! Read the file via mmap instead of ifstream
+    bool _useMemoryMap;
+
+    //! madvise the mapping for sequential access
+    bool _sequentialReadAhead;
+
+    //! First event to be converted
+    int _firstEvent;
     
   private:
+
+    //! Process the run header built from the file header
+    void processRunHeader();
+
+    //! Decode one event data block
+    /*! The selected frames are extracted from the data block and
+     *  written into the four channels, whose ADC vectors are sized
+     *  here once and then filled by index.
+     *
+     *  @param dataBlock Pointer to the first record of the event data
+     *  @param channel The four output raw data, A to D
+     */
+    void decodeDataBlock(const int * dataBlock, IMPL::TrackerRawDataImpl * channel[4]) const;
+
+    //! Build the event and send it to the processors
+    /*! @param iEvent The event index in the file
+     *  @param eventHeader The event header as read from the file
+     *  @param dataBlock Pointer to the event data block
+     *  @param eventTrailer The event trailer as read from the file
+     */
+    void processDataEvent(int iEvent, const EUDRBEventHeader & eventHeader,
+                          const int * dataBlock, const EUDRBTrailer & eventTrailer);
+
+    //! Send the EORE
+    void processEORE(int iEvent);
+
+    //! Event loop reading with ifstream
+    /*! @return the index of the last event sent
+     */
+    int readWithStream(int numEvents);
+
+    //! Event loop walking the memory mapped file
+    /*! @return the index of the last event sent, or -1 if the file
+     *  could not be mapped.
+     */
+    int readWithMemoryMap(int numEvents);
+
+    //! Size in bytes of one event record in the file
+    size_t eventRecordSize() const;
+    
+    //! Offset of the first frame and number of records to decode
+    /*! Set from the calculation algorithm in init(). 
+     */
+    int _firstFrame;
+
+    //! One after the last frame to decode
+    int _secondFrame;
+
+    //! True for the CDS algorithms, false for LF
+    bool _isCDS;
+
+    //! Time stamp assigned to all the events of the run
+    long long _runTimeStamp;
     
     //! A EUDRBFileHeader instance
     /*! This object is used to read the file header from the input
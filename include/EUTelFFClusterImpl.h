@@ -449,7 +449,7 @@ namespace eutelescope {
      *
      *  @return The pointer of _trackerData
      */
-    IMPL::TrackerDataImpl * trackerData() { return _trackerData; }
+    IMPL::TrackerDataImpl * trackerData() { invalidateSummary(); return _trackerData; }
 
     //! Print method
     /*! This method is used to print out the content of the clusters
@@ -459,6 +459,15 @@ namespace eutelescope {
     void print(std::ostream& os)  const;
 
   protected:
+
+    //! Fill the charge part of the cluster summary
+    /*! Total and seed charge and the full cluster CoG shift are
+     *  computed in a single loop over the pixels.
+     */
+    void fillSummary() const;
+
+    //! Fill the noise part of the cluster summary
+    void fillNoiseSummary() const;
     
     //! Noise values vector
     std::vector<float > _noiseValues;
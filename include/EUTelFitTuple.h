@@ -13,6 +13,9 @@
 
 #include "marlin/Processor.h"
 
+// personal includes ".h"
+#include "EUTelTupleWriter.h"
+
 // gear includes <.h>
 #include <gear/SiPlanesParameters.h>
 #include <gear/SiPlanesLayerLayout.h>
@@ -144,6 +147,24 @@ namespace eutelescope {
 
   protected:
 
+    //! Fill one column of the current n-tuple row
+    /*! The value goes to the ROOT tree when an OutputPath is given,
+     *  to the AIDA tuple otherwise.
+     */
+    template<class T>
+    void fillColumn(int column, T value) {
+#if defined(USE_ROOT) || defined(MARLIN_USE_ROOT)
+      if ( _fitTree ) {
+        _fitTree->fill( column, value );
+        return;
+      }
+#endif
+      _FitTuple->fill( column, value );
+    }
+
+    //! Commit the current n-tuple row
+    void addFitRow();
+
     //! Silicon planes parameters as described in GEAR
     /*! This structure actually contains the following:
      *  @li A reference to the telescope geoemtry and layout
@@ -222,6 +243,24 @@ namespace eutelescope {
     int _evtNr;
     long int  _tluTimeStamp;
 
+    //! Output file for the ROOT version of the n-tuple
+    /*! When empty, the n-tuple is booked as an AIDA tuple
+     */
+    std::string _outputPath;
+
+    //! Fill and compress the ROOT n-tuple on a background thread
+    bool _tupleBackgroundWriting;
+
+#if defined(USE_ROOT) || defined(MARLIN_USE_ROOT)
+
+    //! The ROOT n-tuple file, when _outputPath is set
+    EUTelTupleFile * _tupleFile;
+
+    //! The ROOT n-tuple, when _outputPath is set
+    EUTelTupleTree * _fitTree;
+
+#endif
+
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 
@@ -15,6 +15,7 @@
 #include "EUTelUtility.h"
 #include "EUTelUtilityRungeKutta.h"
 #include "EUTelEquationsOfMotion.h"
+#include "EUTelThreadUtility.h"
 
 // LCIO
 #include <IMPL/LCCollectionVec.h>
@@ -107,6 +108,14 @@ namespace eutelescope {
         inline double GetChi2Cut() const {
             return _chi2cut;
         }
+
+        /** Number of threads fitting the GBL trajectories, 1 for no additional thread.
+         *  The output does not depend on it. */
+        void setNThreads( unsigned int );
+
+        inline unsigned int getNThreads() const {
+            return _nThreads;
+        }
  
         void setParamterIdPlaneVec( const std::vector<int>& );
  
@@ -161,6 +170,12 @@ namespace eutelescope {
         
         TMatrixD propagatePar(double);
 
+        TVectorD getXYZfromDz( double, double, double, double, double, double, double ) const;
+
+        TMatrixD getPropagationJacobian( double, double, double, double, double, double, double );
+
+        TMatrixD& getProjectionMatrix( int, const double* );
+
         double interpolateTrackX(const EVENT::TrackerHitVec&, const double) const;
         double interpolateTrackY(const EVENT::TrackerHitVec&, const double) const;
  
@@ -197,6 +212,16 @@ namespace eutelescope {
         /** Parameter propagation jacobian */
         TMatrixD _parPropJac;
 
+        /** True if there is no magnetic field, the tracks are then straight lines */
+        bool _straightTracks;
+
+        /** Projection matrices onto the measurement system, by plane ID */
+        std::map< int, TMatrixD > _projectionCache;
+
+        /** Sensor scattering precision by plane ID, for _sensorScatPrecMomentum */
+        std::map< int, double > _sensorScatPrecCache;
+        double _sensorScatPrecMomentum;
+
 
     private:
         /** Beam charge in [e] */
@@ -260,6 +285,12 @@ namespace eutelescope {
 
 	/** ODE for equations of motion */
         ODE* _eomODE;
+
+        /** Number of threads fitting the GBL trajectories */
+        unsigned int _nThreads;
+
+        /** Threads fitting the GBL trajectories, created by the first FitTracks() */
+        EUTelWorkerPool* _workerPool;
         
     };
 
@@ -0,0 +1,178 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+// built only if USE_GEAR
+#if defined(USE_GEAR)
+#ifndef EUTELHITSTORE_H
+#define EUTELHITSTORE_H
+
+// lcio includes <.h>
+#include <EVENT/LCEvent.h>
+#include <IMPL/TrackerHitImpl.h>
+#include <IMPL/LCCollectionVec.h>
+
+// system includes <>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Telescope hits of an event, decoded once for all the processors
+  /*! Most of the alignment and correlation processors start their
+   *  processEvent() in the same way: they walk the hit collection,
+   *  guess the sensor of every hit from its z position, check its
+   *  pixels against the hot pixel database and copy its position into
+   *  their own arrays. In a job made of several of them this is done
+   *  again by each processor for the same hits.
+   *
+   *  The hit store does it once per event and hit collection: the first
+   *  processor asking for the store of an event builds it and adds it
+   *  to the event as a transient LCGenericObject collection, the
+   *  following ones find it there. The store is therefore deleted
+   *  together with the event, and it is never written to the output
+   *  file. The hits are sorted by plane, in the GEAR layer order, and
+   *  each plane keeps them as separate arrays (positions, errors, the
+   *  original hit and its index in the collection), which is what the
+   *  processors loop over.
+   *
+   *  The sensor of a hit is the nearest plane along z, or, if a
+   *  reference hit collection is given, the nearest reference plane
+   *  along its normal. A hit is flagged as hot if one of its pixels is
+   *  in the hot pixel collection; this is only possible for sparse
+   *  (Mimosa26 and APIX) clusters, the other hits are never flagged.
+   *  The hot flags are not part of the store key: they are computed
+   *  the first time they are asked for with a given hot pixel
+   *  collection, so that the processors with and without hot pixel
+   *  collection share the same store.
+   *
+   *  Only the plane positions and the decoded hot pixels are kept from
+   *  one event to the next. The hot pixels are read again at every new
+   *  run.
+   */
+  class EUTelHitStore {
+
+  public:
+    //! The hits of one plane
+    struct Plane {
+      //! Sensor ID of the plane
+      int sensorID;
+      //! Hit positions, as in the collection
+      std::vector< double > x, y, z;
+      //! Hit position errors, from the covariance matrix
+      std::vector< double > errX, errY;
+      //! The original hits
+      std::vector< lcio::TrackerHitImpl * > hit;
+      //! Index of the hits in the collection
+      std::vector< int > collectionIndex;
+
+      size_t size() const { return x.size(); }
+    };
+
+    //! The store of a hit collection in an event
+    /*! The store is built the first time it is asked for in an event,
+     *  and then shared by all the callers using the same collection
+     *  names. Processors changing the hit collection after the store
+     *  was built must not use it.
+     *
+     *  @param event The current event
+     *  @param hitCollectionName The TrackerHit collection
+     *  @param referenceHitCollectionName The reference hit
+     *  collection, empty to guess the sensors from the GEAR z positions
+     *
+     *  @throw lcio::DataNotAvailableException if the event has no hit
+     *  collection with that name
+     */
+    static const EUTelHitStore & get(lcio::LCEvent * event, const std::string & hitCollectionName,
+                                     const std::string & referenceHitCollectionName = "");
+
+    //! Set the sensor IDs and z positions of the planes
+    /*! By default the planes are read from GEAR the first time a
+     *  store is built. This is meant for the programs running without
+     *  GEAR, like the tests.
+     */
+    static void setPlanes(const std::vector< int > & sensorIDs, const std::vector< double > & planeZ);
+
+    EUTelHitStore();
+
+    //! Number of planes, as in GEAR
+    size_t getNPlanes() const { return _planes.size(); }
+
+    //! The hits of a plane, by plane index
+    const Plane & getPlane(size_t plane) const { return _planes[plane]; }
+
+    //! Plane index of a sensor, -1 if it is not a GEAR layer
+    int getPlaneIndex(int sensorID) const;
+
+    //! Number of hits in the collection
+    size_t getNHits() const { return _hitPlane.size(); }
+
+    //! Plane index of a hit, by index in the collection, -1 if unknown
+    int getHitPlane(size_t iHit) const { return _hitPlane[iHit]; }
+
+    //! Index of a hit in the arrays of its plane, by index in the collection
+    int getHitIndex(size_t iHit) const { return _hitIndex[iHit]; }
+
+    //! Sensor ID of a hit, by index in the collection, -1 if unknown
+    int getHitSensorID(size_t iHit) const {
+      return _hitPlane[iHit] < 0 ? -1 : _planes[ _hitPlane[iHit] ].sensorID;
+    }
+
+    //! Hot pixel flags of all the hits, by index in the collection
+    /*! A hit is flagged if one of its pixels is in the hot pixel
+     *  collection. The flags are computed the first time they are
+     *  asked for with this hot pixel collection, and also given for
+     *  the hits which could not be assigned to a plane, as the pixels
+     *  are checked against the sensor of the cluster. With an empty
+     *  collection name no hit is flagged.
+     */
+    const std::vector< bool > & getHotFlags(const std::string & hotPixelCollectionName) const;
+
+    //! True if a hit contains a hot pixel, by index in the collection
+    bool isHitHot(size_t iHit, const std::string & hotPixelCollectionName) const {
+      return getHotFlags( hotPixelCollectionName )[iHit];
+    }
+
+  private:
+    //! Hot pixels (x, y) per sensor ID
+    typedef std::map< int, std::set< std::pair< short, short > > > HotPixelMap;
+
+    //! Decode the hits of the event
+    void build(lcio::LCEvent * event, const std::string & hitCollectionName,
+               const std::string & referenceHitCollectionName);
+
+    //! The hot pixels of the current run, read if needed
+    static const HotPixelMap & getHotPixels(lcio::LCEvent * event, const std::string & hotPixelCollectionName);
+
+    //! Sensor ID guessed from the position of a hit
+    static int guessSensorID(const double * pos, lcio::LCCollectionVec * referenceHitVec);
+
+    //! True if one of the pixels of the hit is hot
+    static bool hitContainsHotPixels(lcio::TrackerHitImpl * hit, const HotPixelMap & hotPixels);
+
+    std::vector< Plane > _planes;
+    std::map< int, int > _sensorIDToPlane;
+
+    //! The event of the store, to read the hot pixels from
+    lcio::LCEvent * _event;
+
+    //! All the hits of the collection, also the unassigned ones
+    std::vector< lcio::TrackerHitImpl * > _hits;
+    std::vector< int > _hitPlane;
+    std::vector< int > _hitIndex;
+
+    //! Hot flags by hot pixel collection name, filled on demand
+    mutable std::map< std::string, std::vector< bool > > _hotFlags;
+  };
+
+}
+#endif
+#endif
@@ -122,8 +122,10 @@ namespace eutelescope {
     
     //! Check call back
     /*! This method is called every event just after the processEvent
-     *  one. For the time being it is just calling the pixel
-     *  monitoring protected method
+     *  one. At the end of each cycle the pixels firing too often are
+     *  masked. A cycle also ends as soon as the number of hot pixels
+     *  of every sensor has converged, see _convergenceTolerance, and
+     *  then no other cycle is started.
      *
      *  @param evt the current LCEvent event as passed by the
      *  ProcessMgr
@@ -298,6 +300,25 @@ namespace eutelescope {
     //! A vector with the firing frequency value
     std::vector< std::vector< unsigned short > > _firingFreqVec;
 
+    //! Tolerance on the number of hot pixels to stop early
+    /*! If positive, the number of pixels above _maxAllowedFiringFreq
+     *  of every sensor is registered with the EUTelConvergenceMonitor.
+     *  When all of them are stable within this tolerance, the current
+     *  cycle is closed, the database written and the job stops as
+     *  soon as the other monitored processors have converged too.
+     */
+    float _convergenceTolerance;
+
+    //! How often, in events, the number of hot pixels is checked
+    /*! The convergence history is reset at the end of every cycle, so
+     *  the interval is shortened if a cycle could not hold enough
+     *  checks to converge.
+     */
+    int _convergenceCheckInterval;
+
+    //! Update the convergence monitor with the current hot pixels
+    void updateConvergence();
+
     //! Simple data decoding and HotPixel database
     /*
      */
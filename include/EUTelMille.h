@@ -14,6 +14,7 @@
 #ifdef USE_GEAR
 // eutelescope includes ".h"
 //#include "TrackerHitImpl2.h"
+#include "EUTelAlignmentCache.h"
 #include "IMPL/TrackerHitImpl.h"
 
 // marlin includes ".h"
@@ -276,7 +277,27 @@ namespace eutelescope {
       return new EUTelMille;
     }
 
-    virtual bool hitContainsHotPixels( TrackerHitImpl   * hit) ;
+    //! Fit the track candidates in _xPos, _yPos and _zPos and pass them to Mille
+    void fitTrackCandidates(int nTracks);
+
+    //! Append the hits and track candidates of an event to the alignment cache
+    void writeAlignmentCache(const std::vector<std::vector<EUTelMille::HitsInPlane> > & hitsArray,
+                             const std::vector<IntVec > & indexarray);
+
+    //! The settings the alignment cache depends on, as a text
+    /*! It is stored in the cache, and a cache written with other
+     *  settings is written again.
+     */
+    std::string alignmentCacheParameters() const;
+
+    //! Fit all the track candidates of the alignment cache
+    /*! The alignment constants of the AlignmentCacheConstantsCollections
+     *  are taken from the event and applied to the cached hits as
+     *  EUTelApplyAlignmentProcessor does, rotating them around the
+     *  reference hit of their plane, or its GEAR position without
+     *  reference hits.
+     */
+    void readAlignmentCache(LCEvent * event);
 
 
     //! Default constructor
@@ -300,12 +321,6 @@ namespace eutelescope {
      */
     virtual void processRunHeader (LCRunHeader * run);
 
-    //! Called for first event per run
-    /*! Reads hotpixel information from hotPixelCollection into hotPixelMap
-     * to be used in the sensor exclusion area logic 
-     */
-    virtual void  FillHotPixelMap(LCEvent *event);
-
     //! Called every event
     /*! This is called for each event in the file. Each element of the
      *  pulse collection is scanned and the center of the cluster is
@@ -341,10 +356,6 @@ namespace eutelescope {
      */
     void bookHistos();
 
-    virtual int guessSensorID( double* hit);
-    virtual int guessSensorID( TrackerHitImpl* hit);
-
-
     TVector3 Line2Plane(int iplane, const TVector3& lpoint, const TVector3& lvector ); 
 
     virtual inline int getAllowedMissingHits(){return _allowedMissingHits;}
@@ -388,17 +399,6 @@ namespace eutelescope {
      */
     std::string _hotPixelCollectionName;
 
-    //! Vector of map arrays, keeps record of hit pixels 
-    /*! The vector elements are sorted by Detector ID
-     *  For each Detector unique ID element a map of pixels is created. 
-     *  first level key   sensor unique 
-     *              value sensor map
-     *  sensor map key    unique row number
-     *             value  vector of column numbers.
-     */
-    
-    std::map<std::string, bool > _hotPixelMap;
-
     //! Sensor ID vector
     IntVec _sensorIDVec;
 
@@ -433,6 +433,16 @@ namespace eutelescope {
 
     std::string _binaryFilename;
 
+    //! Binary cache of the hits and track candidates, empty if not used
+    std::string _alignmentCacheFile;
+    StringVec _alignmentCacheConstantsCollections;
+    EUTelAlignmentCacheWriter _alignmentCacheWriter;
+    EUTelAlignmentCacheReader _alignmentCacheReader;
+    //! True if the track candidates are read from the cache
+    bool _readAlignmentCache;
+    //! True once the cache has been read, with the first event
+    bool _isAlignmentCacheRead;
+
     float _telescopeResolution;
     bool _onlySingleHitEvents;
     bool _onlySingleTrackEvents;
@@ -13,13 +13,20 @@
 
 // eutelescope includes ".h"
 #include "EUTELESCOPE.h"
+#include "EUTelThreadUtility.h"
 
 // marlin includes ".h"
 #include "marlin/LCIOOutputProcessor.h"
+#include "marlin/EventModifier.h"
 
 // lcio includes <.h>
 #include <lcio.h>
 #include <IO/LCWriter.h>
+#include <IMPL/LCEventImpl.h>
+#include <IMPL/LCRunHeaderImpl.h>
+
+// system includes <>
+#include <string>
 
 
 namespace eutelescope {
@@ -64,19 +71,52 @@ namespace eutelescope {
    *  file will allow to remove all the intermediate EORE and leaving
    *  only the last one.
    *
+   *  Writing an event means serialising and compressing it, and in
+   *  long chains with intermediate files this is a good fraction of
+   *  the processing time. Setting WriterQueueSize to a positive
+   *  number moves the writing to a separate thread. The collections
+   *  to be written are handed over to a detached copy of the event,
+   *  that is queued to the writer thread and deleted once written,
+   *  so the processor chain can go on with the next event. When the
+   *  queue is full, the processor chain waits for the writer. Run
+   *  headers travel through the same queue to keep the file order
+   *  and the final EORE is written only after the queue has been
+   *  drained.
+   *
+   *  In this asynchronous mode the processor must really be the last
+   *  active one, because the collections are taken away from the
+   *  event: init() checks the ActiveProcessors list and falls back to
+   *  writing in sequence if this is not the case. It does the same
+   *  when the output file has to be split (SplitFileSizekB) or when
+   *  FullSubsetCollections are requested, since these are handled by
+   *  LCIOOutputProcessor while writing.
+   *
+   *  SIO keeps static state shared by the reader and the writer, so
+   *  the writer thread is never allowed to write while the Marlin
+   *  thread reads. The Marlin thread holds _sioMutex from the end of
+   *  processEvent until the next event has been read, and the
+   *  processor is an EventModifier only to release it in
+   *  modifyEvent, that LCIO calls as soon as the reading is done.
+   *  The writing of an event therefore overlaps with the processing
+   *  of the following one, not with its reading. When there are no
+   *  LCIOInputFiles the events come from a DataSourceProcessor,
+   *  LCIO never calls modifyEvent and the lock is never taken.
+   *
    *  @see marlin::LCIOOutputProcessor
    *  @see eutelescope::EventType
    *  @see eutelescope::EUTelEventImpl
    *
    *  @param All parameters available in LCIOOutputProcessir
    *  @param SkipIntermediateEORE Remove EORE in between following runs.
+   *  @param WriterQueueSize Number of events waiting for the writer
+   *  thread. 0 writes on the Marlin thread.
    *
    *
    *  @author Antonio Bulgheroni, INFN <mailto:antonio.bulgheroni@gmail.com>
    *  @version $Id$ 
    */
 
-  class EUTelOutputProcessor : public marlin::LCIOOutputProcessor {
+  class EUTelOutputProcessor : public marlin::LCIOOutputProcessor, public marlin::EventModifier {
   
   public:  
 
@@ -109,6 +149,17 @@ namespace eutelescope {
      */
     virtual void processRunHeader( LCRunHeader* run) ;
 
+    //! Called by LCIO right after an event has been read
+    /*! In the asynchronous mode it lets the writer thread access SIO
+     *  again. Nothing is changed in the event.
+     *
+     *  @param evt The LCEvent just read.
+     */
+    virtual void modifyEvent( LCEvent * evt ) ;
+
+    //! Return the name of this processor, required by EventModifier
+    virtual const std::string & name() const { return Processor::name() ; }
+
     //! Process the event
     /*! This method processes the current event, removing the dropped
      *  collections and saving the other on disk. Before returning the
@@ -126,6 +177,60 @@ namespace eutelescope {
 
 
   protected:
+
+    //! An item for the writer thread
+    /*! Exactly one of the two pointers is set. The writer thread
+     *  owns and deletes it.
+     */
+    struct WriteRequest {
+      IMPL::LCEventImpl * event;
+      IMPL::LCRunHeaderImpl * runHeader;
+    };
+
+    //! Move the content of an event into a new, writer owned, event
+    /*! Only the collections to be written are moved, with
+     *  LCEvent::removeCollection, so that they are not deleted
+     *  together with the original event. The dropped ones, flagged
+     *  transient by dropCollections, stay in the original event.
+     */
+    IMPL::LCEventImpl * detachEvent( LCEvent * evt ) const;
+
+    //! Copy a run header for the writer thread
+    IMPL::LCRunHeaderImpl * copyRunHeader( LCRunHeader * run ) const;
+
+    //! Queue a request to the writer thread
+    /*! It blocks while the queue is full. The SIO lock is released
+     *  while waiting, so that the writer can make room.
+     *
+     *  @throw lcio::IOException if the writer thread has failed.
+     */
+    void queueRequest( const WriteRequest& request );
+
+    //! Check if the writer thread can be used
+    /*! The processor has to be the last active one and neither file
+     *  splitting nor full subset collections must be requested.
+     */
+    bool canWriteBehind();
+
+    //! Keep the writer thread away from SIO
+    /*! It does nothing when the events are not read with LCIO.
+     */
+    void holdSIO();
+
+    //! Let the writer thread access SIO
+    void releaseSIO();
+
+    //! Start the writer thread
+    void startWriterThread();
+
+    //! Write all the pending requests and stop the writer thread
+    void stopWriterThread();
+
+    //! Writer thread main loop
+    void writeBehind();
+
+    //! pthread entry point for writeBehind()
+    static void * writerThreadEntry( void * self );
     
     //! The current event type
     /*! This is actually the only reason for reimplementing the
@@ -151,6 +256,35 @@ namespace eutelescope {
      * 
      */ 
     bool _skipIntermediateEORESwitch;
+
+    //! Number of events waiting for the writer thread
+    /*! 0 means synchronous writing
+     */
+    int _writerQueueSize;
+
+    //! Requests waiting for the writer thread
+    EUTelBoundedQueue< WriteRequest > * _writeRequests;
+
+    //! The writer thread
+    pthread_t _writerThread;
+
+    //! Set while the writer thread is running
+    bool _isWriterThreadRunning;
+
+    //! Serialises the SIO access of the writer and the Marlin thread
+    EUTelMutex _sioMutex;
+
+    //! Set while the Marlin thread holds _sioMutex
+    bool _isHoldingSIO;
+
+    //! Set if Marlin reads the events from LCIOInputFiles
+    bool _isReadingLCIO;
+
+    //! Error message of a failed writer thread
+    /*! Set by the writer thread before closing the queue, read by
+     *  the Marlin thread only after a refused push or the join.
+     */
+    std::string _writerError;
       
 
   } ;
@@ -10,6 +10,7 @@
 #define EUTELPEDESTALNOISEPROCESSOR_H 1
 
 // eutelescope includes ".h"
+#include "EUTelThreadUtility.h"
 
 // marlin includes ".h"
 #include "marlin/Processor.h"
@@ -29,6 +30,7 @@
 #include <string>
 #include <cmath>
 #include <list>
+#include <vector>
 
 
 namespace eutelescope {
@@ -787,8 +789,116 @@ namespace eutelescope {
      */
     bool _preLoopSwitch;
 
+    //! Number of threads for the pixel statistics
+    /*! With the MeanRMS algorithm the per pixel part of the common
+     *  mode calculation and of the pedestal and noise accumulation
+     *  is split over this number of threads, the main one
+     *  included. 1 means no additional thread.
+     */
+    int _noOfThreads;
+
   private:
 
+    //! Per detector running sums of the MeanRMS algorithm
+    /*! Structure of arrays, with one entry per pixel in each array,
+     *  so that the per event update is a single pass over contiguous
+     *  memory. The sums are taken with respect to a per pixel
+     *  reference value, the pedestal of the previous loop or the
+     *  first signal, to keep the second moment accurate.
+     *
+     *  The current pedestal is reference + sum / entries and the
+     *  noise the RMS sqrt( sum2 / entries - ( sum / entries )^2 ).
+     */
+    struct PixelStatistics {
+      std::vector< float  > reference;
+      std::vector< double > entries;
+      std::vector< double > sum;
+      std::vector< double > sum2;
+    };
+
+    //! Reset the statistics of one detector
+    /*! Each pixel starts with one entry equal to @a pedestal and with
+     *  a spread equal to @a noise, or zero if @a noise is empty.
+     */
+    static void resetPixelStatistics( PixelStatistics & stat, const FloatVec & pedestal, const FloatVec & noise );
+
+    //! Add one event to the statistics of a range of pixels
+    /*! @param iDetector The detector index
+     *  @param adcValues The raw signals of the detector
+     *  @param commonMode The per pixel common mode correction. If
+     *  NULL, no correction, status check and hit rejection are
+     *  applied, as in the first loop.
+     *  @param begin First pixel of the range
+     *  @param end One past the last pixel of the range
+     */
+    void accumulatePixelStatistics( size_t iDetector, const short * adcValues, const float * commonMode,
+                                    size_t begin, size_t end );
+
+    //! Compute the common mode correction of one detector
+    /*! The result is stored in the detector entry of _detectorJobs.
+     *  No histogram is filled here since it can run on a worker
+     *  thread.
+     */
+    void computeCommonMode( size_t iJob );
+
+    //! Per detector data of the current event
+    struct DetectorJob {
+      //! Detector index, including the collection offset
+      size_t iDetector;
+      //! The raw signals
+      const short * adcValues;
+      //! Number of pixels
+      size_t noOfPixels;
+      //! Per pixel common mode correction
+      std::vector< float > commonModeCorVec;
+      //! Common mode values to be histogrammed
+      std::vector< double > commonModeValues;
+      bool isEventValid;
+      int  skippedPixel;
+      int  skippedRow;
+    };
+
+    //! Task computing the common mode, one chunk per detector
+    class CommonModeTask : public EUTelParallelTask {
+    public:
+      explicit CommonModeTask( EUTelPedestalNoiseProcessor * processor ) : _processor( processor ) { }
+      void execute( size_t chunk ) { _processor->computeCommonMode( chunk ); }
+    private:
+      EUTelPedestalNoiseProcessor * _processor;
+    };
+
+    //! Task accumulating the pixel statistics, one chunk per pixel block
+    class AccumulateTask : public EUTelParallelTask {
+    public:
+      explicit AccumulateTask( EUTelPedestalNoiseProcessor * processor ) : _processor( processor ) { }
+      void execute( size_t chunk );
+    private:
+      EUTelPedestalNoiseProcessor * _processor;
+    };
+
+    friend class CommonModeTask;
+    friend class AccumulateTask;
+
+    //! Accumulate the current _detectorJobs in parallel
+    /*! @param withCommonMode false in the first loop
+     */
+    void accumulateDetectorJobs( bool withCommonMode );
+
+    //! Number of pixels in a chunk of AccumulateTask
+    static const size_t _pixelsPerChunk = 16384;
+
+    //! The detectors of the current event
+    std::vector< DetectorJob > _detectorJobs;
+
+    //! First chunk of each detector job in AccumulateTask
+    std::vector< size_t > _jobFirstChunk;
+
+    //! Whether the current accumulation applies the common mode
+    bool _accumulateWithCommonMode;
+
+    //! Workers for the pixel statistics, see _noOfThreads
+    EUTelWorkerPool * _workerPool;
+
     //! Detector name
     /*! This string is used to copy the detector name from the run
      *  header to the event "header"
@@ -833,35 +943,11 @@ namespace eutelescope {
      */
     IntVec _maxY;
 
-    //! Temporary array to store the running average
-    /*! This a vector of vectors of doubles. The outern layer represents
-     * the detector, while the inner layer is used to temporary store
-     * the running average of pixel output signal.  The outer layer is
-     * properly sized in the runHeader(), when the number of detector
-     * plane in the run is discovered.  The inner layer is done in the
-     * firstEvent of each detector module.
-     */
-    std::vector < FloatVec > _tempPede;
-
-    //! Temporary array to store the running sigma
-    /*! This a vector of vectors of doubles. The outern layer represents
-     * the detector, while the inner layer is used to temporary store
-     * the running sigma of pixel output signal.  The outer layer is
-     * properly sized in the runHeader(), when the number of detector
-     * plane in the run is discovered.  The inner layer is done in the
-     * firstEvent of each detector module.
-     */
-    std::vector < FloatVec > _tempNoise;
-
-    //! Temporary array to store the number of entries
-    /*! In order to have both the running average and sigma working,
-     * another array to store how many "entries" a pixel has should be
-     * recorded. This might be useless there is an entry for each event,
-     * but this is not the case when applying "hit rejection" in common
-     * mode suppression algorithm. The underlying philosophy is the same
-     * used for _tempPede and _tempNoise
-     */
-    std::vector < IntVec > _tempEntries;
+    //! Running sums of the MeanRMS algorithm, one per detector
+    /*! The outer layer is filled in the first event of each loop,
+     *  see PixelStatistics.
+     */
+    std::vector < PixelStatistics > _pixelStatistics;
 
     //! Array to store the intermediate/final pedestal value
     /*! At the end of the first loop on events, a first approximation
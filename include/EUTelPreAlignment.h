@@ -53,6 +53,7 @@ namespace eutelescope {
     float range;
     float zPos;
     int iden;
+    int nPoints;
     float getMaxBin(std::vector<int>& histo){
       int maxBin(0), maxVal(0);
       for(size_t ii = 0; ii < histo.size(); ii++){
@@ -91,14 +92,16 @@ namespace eutelescope {
     PreAligner(float pitchX, float pitchY, float zPos, int iden): 
       pitchX(pitchX), pitchY(pitchY), 
       minX(-10.0), maxX(10), range(maxX - minX),
-      zPos(zPos), iden(iden){
+      zPos(zPos), iden(iden), nPoints(0){
       histoX.assign( int( range / pitchX ), 0);
       histoY.assign( int( range / pitchY ), 0);
     }
     void* current(){return this; } 
     float getZPos() const { return(zPos); }
     int getIden() const { return(iden); }
+    int getNPoints() const { return(nPoints); }
     void addPoint(float x, float y){
+      ++nPoints;
       //Add to histo if within bounds, throw away data that is out of bounds
       try{
 	histoX.at( static_cast<int> ( (x - minX)/pitchX) ) += 1; 
@@ -132,13 +135,6 @@ namespace eutelescope {
     virtual void processRunHeader (LCRunHeader * run);
     virtual void processEvent (LCEvent * evt);
     virtual void end();
-    virtual bool hitContainsHotPixels( TrackerHitImpl   * hit) ;
-
-    //! Called for first event per run
-    /*! Reads hotpixel information from hotPixelCollection into hotPixelMap
-     * to be used in the sensor exclusion area logic 
-     */
-    virtual void  FillHotPixelMap(LCEvent *event);
 
   private:
     //! Hot pixel collection name.
@@ -154,28 +150,12 @@ namespace eutelescope {
     bool             _useReferenceHitCollection;
     LCCollectionVec* _referenceHitVec;    
     
-    //! map of vectors, keeps record of hit pixels 
-    /*! 
-     *  For each Detector a vector is stored in a map.
-     *  Each vector holds pairs of integers (representing X and Y pixel array positions).
-     *  If an element (i.e. the X and Y position of a pixel) is present in the vector,
-     *  this indicates that the corresponding pixel was marked "hot"
-     */
-    std::map<int, std::vector<std::pair<short, short> > > _hotPixelMap;
- 
     //! How many events are needed to get reasonable correlation plots 
     /*! (and Offset DB values) 
      *
      */
     int _events;
    
-    //! bool tag if PreAlign should run anyway or not;
-    /*! default 0
-     */   
-    bool _UsefullHotPixelCollectionFound;
-
-//    virtual int guessSensorID(TrackerHitImpl* hit);
-    virtual int guessSensorID(const double* hit);
 
 // maps and vectors to navigate along the geometry of the setup:
     //! vector of Rotation Matrix elements
@@ -218,6 +198,16 @@ namespace eutelescope {
     //! Boolean for turning histogram creation on and off
     bool _fillHistos;
 
+    //! Tolerance on the peak positions to stop early
+    /*! If positive, the X and Y peak positions of all the planes are
+     *  registered with the EUTelConvergenceMonitor, and the job stops
+     *  before _events when they are stable within this tolerance.
+     */
+    float _convergenceTolerance;
+
+    //! How often, in events, the peak positions are checked
+    int _convergenceCheckInterval;
+
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA) 
     std::map<unsigned int, AIDA::IBaseHistogram * > _hitXCorr;
     std::map<unsigned int, AIDA::IBaseHistogram * > _hitYCorr;
@@ -237,6 +227,26 @@ namespace eutelescope {
     gear::SiPlanesParameters * _siPlanesParameters;
     gear::SiPlanesLayerLayout * _siPlanesLayerLayout;
     std::vector<PreAligner> _preAligners;
+
+    //! Index in _preAligners of each sensor ID
+    /*! -1 for the fixed plane and for sensor IDs without a PreAligner
+     */
+    std::vector<int> _sensorIDToPreAligner;
+
+    //! Position along Z of the sensor of each PreAligner
+    std::vector<int> _preAlignerZOrder;
+
+    //! Positions of the fixed plane hits of the current event
+    std::vector<double> _refHitX, _refHitY;
+
+    //! Positions of the hits of the current event, one array per PreAligner
+    /*! Hits containing hot pixels are already removed.
+     */
+    std::vector< std::vector<double> > _planeHitX, _planeHitY;
+
+    //! Residuals within the correlation band for the current fixed plane hit
+    std::vector<float> _residX, _residY;
+    std::vector<int> _residPreAligner;
   };
   //! A global instance of the processor
   EUTelPreAlign gEUTelPreAlign;
@@ -195,6 +195,9 @@ namespace eutelescope {
         /** Maximum value of track chi2 for millipede */
         double _maxMilleChi2Cut;
 
+        /** Number of threads fitting the GBL trajectories */
+        int _nThreads;
+
         /** TGeo geometry file name */
         string _tgeoFileName;
         
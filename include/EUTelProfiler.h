@@ -0,0 +1,173 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELPROFILER_H
+#define EUTELPROFILER_H
+
+// system includes <>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Collects the time and memory allocations spent in sections of a job
+  /*! A section is either the part of the processor chain between two
+   *  EUTelUtilityProfiler checkpoints, or a piece of code enclosed in
+   *  an EUTelProfiler::Scope, such as the clustering or the track fit.
+   *
+   *  For every section the profiler keeps the wall and CPU time and
+   *  the number and size of the memory allocations, per event and in
+   *  total, and the distribution of the wall time per event, from
+   *  which printSummary() gives the median and the tails. Optionally
+   *  every measurement is also written to a CSV file, one line per
+   *  event and section, to compare runs or follow a job in time.
+   *
+   *  The allocations are only counted when the job runs with the
+   *  allocation hook library preloaded (LD_PRELOAD of
+   *  libEutelescopeAllocationHook.so, built with the CMake option
+   *  EUTELESCOPE_ALLOCATION_HOOK); otherwise they are reported as 0.
+   *
+   *  The profiler is disabled, and the scopes cost a test, unless an
+   *  EUTelUtilityProfiler is in the job. It is meant to be used from
+   *  the Marlin thread only. There is a single profiler per job, see
+   *  instance().
+   */
+  class EUTelProfiler {
+
+  public:
+    //! Times a piece of code as a profiler section
+    /*! The section is measured from the construction to the
+     *  destruction of the scope:
+     *  \code
+     *  {
+     *    EUTelProfiler::Scope scope( "clustering" );
+     *    ...
+     *  }
+     *  \endcode
+     */
+    class Scope {
+    public:
+      explicit Scope(const char * section);
+      ~Scope();
+
+    private:
+      Scope(const Scope&);
+      void operator=(const Scope&);
+
+      const char * _section;
+      double _wallTime;
+      double _cpuTime;
+      long _allocations;
+      long _allocatedBytes;
+    };
+
+    //! The profiler of the job
+    static EUTelProfiler & instance();
+
+    bool isEnabled() const { return _enabled; }
+    void setEnabled(bool enabled) { _enabled = enabled; }
+
+    //! Record a measurement of a section in the current event
+    void record(const std::string & section, double wallTime, double cpuTime,
+                long allocations, long allocatedBytes);
+
+    //! Start a new event
+    /*! Writes the measurements of the previous event to the CSV file,
+     *  if any.
+     */
+    void beginEvent(int runNumber, int eventNumber);
+
+    //! A checkpoint in the processor chain
+    /*! The time and allocations since the previous checkpoint of the
+     *  same event are recorded as the given section. The first
+     *  checkpoint of an event starts the event and records nothing.
+     */
+    void checkpoint(const std::string & section, int runNumber, int eventNumber);
+
+    //! Write every measurement to a CSV file
+    /*! @return false if the file could not be created
+     */
+    bool openEventLog(const std::string & filename);
+
+    //! Print the table of the sections, in the order they were first seen
+    void printSummary(std::ostream & os);
+
+    //! Write the table of the sections to a CSV file
+    /*! One line per section, with the same columns as printSummary(),
+     *  meant to be read back by scripts comparing jobs.
+     *
+     *  @return false if the file could not be created
+     */
+    bool writeSummary(const std::string & filename);
+
+    //! True if the allocation hook library is loaded
+    bool hasAllocationHook() const { return _allocationCounters != 0; }
+
+    //! Number of allocations since the start of the job, 0 without hook
+    long getAllocations() const;
+
+    //! Bytes allocated since the start of the job, 0 without hook
+    long getAllocatedBytes() const;
+
+  private:
+    EUTelProfiler();
+    ~EUTelProfiler();
+    EUTelProfiler(const EUTelProfiler&);
+    void operator=(const EUTelProfiler&);
+
+    //! Statistics of a section
+    struct Section {
+      std::string name;
+      long nEvents;
+      double wallTime, cpuTime;
+      double minWallTime, maxWallTime;
+      double allocations, allocatedBytes;
+      //! Distribution of the wall time per event, see timeBin()
+      std::vector< long > wallTimeBins;
+      //! Current event
+      double eventWallTime, eventCpuTime;
+      long eventAllocations, eventAllocatedBytes;
+      bool inEvent;
+    };
+
+    //! Wall time distribution: logarithmic bins from 1 us to 1000 s
+    static int timeBin(double time);
+    static double timeBinCenter(int bin);
+    static const int nTimeBins = 90;
+
+    //! Wall time below which a fraction of the events of a section is
+    double quantile(const Section & section, double fraction) const;
+
+    //! Sum the current event of all the sections into their statistics
+    void endEvent();
+
+    bool _enabled;
+
+    std::vector< Section > _sections;
+    std::map< std::string, size_t > _sectionIndex;
+
+    int _runNumber;
+    int _eventNumber;
+    bool _hasEvent;
+
+    //! The last checkpoint of the current event
+    double _checkpointWallTime, _checkpointCpuTime;
+    long _checkpointAllocations, _checkpointAllocatedBytes;
+
+    std::ofstream _eventLog;
+
+    //! Counters of the allocation hook library: number and bytes
+    const volatile long * _allocationCounters;
+  };
+
+}
+#endif
@@ -41,6 +41,93 @@ namespace eutelescope {
     return _trackerData->getChargeValues().size() / _nElement;
   }
 
+  template<class PixelType>
+  void EUTelSparseClusterImpl<PixelType>::fillSummary() const {
+
+    const unsigned int nPixel = size();
+
+    float        totalCharge = 0;
+    float        maxSignal   = -1 * std::numeric_limits<float>::max();
+    unsigned int maxIndex    = 0;
+    int xMin = std::numeric_limits<int>::max(), yMin = std::numeric_limits<int>::max();
+    int xMax = std::numeric_limits<int>::min(), yMax = std::numeric_limits<int>::min();
+    float xPos(0.0f), yPos(0.0f), totWeight(0.0f);
+
+    PixelType * pixel = new PixelType;
+    for ( unsigned int index = 0; index < nPixel ; index++ ) {
+      getSparsePixelAt( index, pixel );
+      totalCharge += pixel->getSignal();
+      if ( pixel->getSignal() > maxSignal ) {
+	maxSignal = pixel->getSignal();
+	maxIndex  = index;
+      }
+      short xCur = pixel->getXCoord();
+      short yCur = pixel->getYCoord();
+      if ( xCur < xMin ) xMin = xCur;
+      if ( xCur > xMax ) xMax = xCur;
+      if ( yCur < yMin ) yMin = yCur;
+      if ( yCur > yMax ) yMax = yCur;
+      xPos += pixel->getXCoord();
+      yPos += pixel->getYCoord();
+      totWeight += 1.0f;
+    }
+
+    int xSeed = 0, ySeed = 0;
+    if ( nPixel > 0 ) {
+      getSparsePixelAt( maxIndex, pixel );
+      xSeed = pixel->getXCoord();
+      ySeed = pixel->getYCoord();
+    }
+
+    // the CoG shift needs the seed, so it takes a second loop
+    float xCoGShift = 0., yCoGShift = 0.;
+    if ( nPixel > 1 ) {
+      float normalization = 0;
+      float tempX = 0;
+      float tempY = 0;
+      for ( unsigned int index = 0; index < nPixel ; index++ ) {
+	getSparsePixelAt( index, pixel );
+	tempX         += pixel->getSignal() * ( pixel->getXCoord() - xSeed );
+	tempY         += pixel->getSignal() * ( pixel->getYCoord() - ySeed );
+	normalization += pixel->getSignal() ;
+      }
+      if ( normalization != 0 ) {
+	xCoGShift = tempX / normalization;
+	yCoGShift = tempY / normalization;
+      }
+    }
+    delete pixel;
+
+    _summary.totalCharge = totalCharge;
+    _summary.seedCharge  = maxSignal;
+    _summary.seedIndex   = maxIndex;
+    _summary.xSeed       = xSeed;
+    _summary.ySeed       = ySeed;
+    _summary.xSize       = abs( xMax - xMin) + 1;
+    _summary.ySize       = abs( yMax - yMin) + 1;
+    _summary.xCoGShift   = xCoGShift;
+    _summary.yCoGShift   = yCoGShift;
+    _summary.xCoG        = xPos / totWeight;
+    _summary.yCoG        = yPos / totWeight;
+    _summary.chargeValid = true;
+  }
+
+  template<class PixelType>
+  void EUTelSparseClusterImpl<PixelType>::fillNoiseSummary() const {
+
+    if ( ! _summary.chargeValid ) fillSummary();
+
+    float squaredSum = 0;
+    std::vector<float >::const_iterator iter = _noiseValues.begin();
+    while ( iter != _noiseValues.end() ) {
+      squaredSum += pow( (*iter), 2 );
+      ++iter;
+    }
+    _summary.noise2Sum  = squaredSum;
+    _summary.seedNoise  = ( _summary.seedIndex < _noiseValues.size() ) ? _noiseValues[ _summary.seedIndex ] : 0.;
+    _summary.noiseValid = true;
+  }
+
   template<class PixelType>
   void EUTelSparseClusterImpl<PixelType>::setNoiseValues(std::vector<float > noiseValues) {
     if ( noiseValues.size() != size() ) {
@@ -50,6 +137,7 @@ namespace eutelescope {
     
     _noiseValues    = noiseValues;
     _noiseSetSwitch = true;
+    _summary.noiseValid = false;
 
   }
 
@@ -61,83 +149,29 @@ namespace eutelescope {
 
   template<class PixelType>
   void EUTelSparseClusterImpl<PixelType>::getSeedCoord(int& xSeed, int& ySeed) const {
-    unsigned int   maxIndex  =  0;
-    float          maxSignal = -1 * std::numeric_limits<float>::max();
-    PixelType * pixel = new PixelType;
-    for ( unsigned int index = 0; index < size() ; index++ ) {
-      getSparsePixelAt( index, pixel );
-      if ( pixel->getSignal() > maxSignal ) {
- 	maxSignal = pixel->getSignal();
- 	maxIndex  = index;
-      }
-    }
-    getSparsePixelAt( maxIndex, pixel ) ;
-    xSeed = pixel->getXCoord();
-    ySeed = pixel->getYCoord();
-    delete pixel;
+    if ( ! _summary.chargeValid ) fillSummary();
+    xSeed = _summary.xSeed;
+    ySeed = _summary.ySeed;
   }
 
   template<class PixelType>
   float EUTelSparseClusterImpl<PixelType>::getTotalCharge() const {
-    float charge = 0;
-    PixelType * pixel = new PixelType;
-    for ( unsigned int index = 0; index < size() ; index++ ) {    
-      getSparsePixelAt( index, pixel );
-      charge += pixel->getSignal();
-    }
-    delete pixel;
-    return charge;
+    if ( ! _summary.chargeValid ) fillSummary();
+    return _summary.totalCharge;
   }
 
   template<class PixelType>
   float EUTelSparseClusterImpl<PixelType>::getSeedCharge() const {
-    float          maxSignal = -1 * std::numeric_limits<float>::max();
-    PixelType * pixel = new PixelType;
-    for ( unsigned int index = 0; index < size() ; index++ ) {
-      getSparsePixelAt(index , pixel);
-      if ( pixel->getSignal() > maxSignal ) {
-	maxSignal = pixel->getSignal();
-      }
-    }
-    delete pixel;
-    return maxSignal;
+    if ( ! _summary.chargeValid ) fillSummary();
+    return _summary.seedCharge;
   }
 
 
   template<class PixelType>
   void EUTelSparseClusterImpl<PixelType>::getCenterOfGravityShift(float& xCoG, float& yCoG) const {
-
-    if ( size() == 1 ) {
-      xCoG = 0; 
-      yCoG = 0;
-      return;
-    }
-
-    float normalization = 0;
-    float tempX = 0;
-    float tempY = 0;
-
-    int xSeed, ySeed;
-    getSeedCoord(xSeed, ySeed);
-   
-    PixelType * pixel = new PixelType;
-    for ( unsigned int index = 0; index < size() ; index++ ) {
-      getSparsePixelAt( index, pixel );
-      tempX         += pixel->getSignal() * ( pixel->getXCoord() - xSeed );
-      tempY         += pixel->getSignal() * ( pixel->getYCoord() - ySeed );
-      normalization += pixel->getSignal() ;
-//      printf(" getCoG %5d %5d %5.1f \n",  pixel->getXCoord(), pixel->getYCoord(), normalization);
-    }
-    if ( normalization != 0 ) {
-      xCoG = tempX / normalization;
-      yCoG = tempY / normalization;
-    } else {
-      xCoG = 0.;
-      yCoG = 0.;
-    }
-
-    delete pixel;
-
+    if ( ! _summary.chargeValid ) fillSummary();
+    xCoG = _summary.xCoGShift;
+    yCoG = _summary.yCoGShift;
   }
 
   template<class PixelType> 
@@ -266,51 +300,18 @@ namespace eutelescope {
   //
   template<class PixelType> 
   void EUTelSparseClusterImpl<PixelType>::getCenterOfGravity(float&  xCoG, float& yCoG) const {
-    // getCenterOfGravityShift(xCoG, yCoG);
-//printf("new cluster \n");    
-    // int xSeed = 0;
-    // int ySeed = 0;
-    // getSeedCoord(xSeed, ySeed);
-    
-    // xCoG += static_cast<float > ( xSeed );
-    // yCoG += static_cast<float > ( ySeed );
-    PixelType * pixel = new PixelType;
-    float xPos(0.0f), yPos(0.0f), totWeight(0.0f);
-    for ( unsigned int index = 0; index < size() ; index++ ) {
-      getSparsePixelAt( index, pixel );
-      xPos += pixel->getXCoord();
-      yPos += pixel->getYCoord();
-      totWeight += 1.0f;
-//if(size()>3)
-//{
-//printf("index:%5d xPos:%8d  yPos:%8d weight:%8.3f :: %8.3f %8.3f \n", 
-//          index, pixel->getXCoord(), pixel->getYCoord(), totWeight, xPos / totWeight, yPos / totWeight);
-//}
-    }
-    xCoG = xPos / totWeight;
-    yCoG = yPos / totWeight;
-    delete pixel;
+    // unweighted mean of the pixel coordinates, see fillSummary()
+    if ( ! _summary.chargeValid ) fillSummary();
+    xCoG = _summary.xCoG;
+    yCoG = _summary.yCoG;
   }
 
 
   template<class PixelType>
   void EUTelSparseClusterImpl<PixelType>::getClusterSize(int& xSize, int& ySize) const {
-    int xMin = std::numeric_limits<int>::max(), yMin = std::numeric_limits<int>::max();
-    int xMax = std::numeric_limits<int>::min(), yMax = std::numeric_limits<int>::min();
-    PixelType * pixel = new PixelType;
-    for ( unsigned int index = 0; index < size() ; index++ ) {
-      getSparsePixelAt( index , pixel);
-      short xCur = pixel->getXCoord();
-      short yCur = pixel->getYCoord();
-      if ( xCur < xMin ) xMin = xCur;
-      if ( xCur > xMax ) xMax = xCur;
-      if ( yCur < yMin ) yMin = yCur;
-      if ( yCur > yMax ) yMax = yCur;
-    }
-    xSize = abs( xMax - xMin) + 1;
-    ySize = abs( yMax - yMin) + 1;
-
-    delete pixel;
+    if ( ! _summary.chargeValid ) fillSummary();
+    xSize = _summary.xSize;
+    ySize = _summary.ySize;
   }
   
   
@@ -461,15 +462,8 @@ namespace eutelescope {
   float EUTelSparseClusterImpl<PixelType>::getClusterNoise() const {
     
     if ( ! _noiseSetSwitch ) throw DataNotAvailableException("No noise values set");
-
-    float squaredSum = 0;
-    std::vector<float >::const_iterator iter = _noiseValues.begin();
-    while ( iter != _noiseValues.end() ) {
-      squaredSum += pow( (*iter), 2 );
-      ++iter;
-    }
-    return sqrt( squaredSum );
-    
+    if ( ! _summary.noiseValid ) fillNoiseSummary();
+    return sqrt( _summary.noise2Sum );
   }
   
   template<class PixelType>
@@ -484,21 +478,9 @@ namespace eutelescope {
   template<class PixelType>
   float EUTelSparseClusterImpl<PixelType>::getSeedSNR() const {
 
-      
     if ( ! _noiseSetSwitch ) throw DataNotAvailableException("No noise values set");
-    unsigned int   maxIndex  = 0;
-    float          maxSignal = -1 * std::numeric_limits<float>::max();
-    PixelType * pixel = new PixelType;
-    for ( unsigned int index = 0; index < size() ; index++ ) {
-      getSparsePixelAt( index, pixel );
-      if ( pixel->getSignal() > maxSignal ) {
- 	maxSignal = pixel->getSignal();
- 	maxIndex  = index;
-      }
-    }
-    getSparsePixelAt( maxIndex, pixel ) ;
-    delete pixel;
-    return maxSignal / _noiseValues[maxIndex];
+    if ( ! _summary.noiseValid ) fillNoiseSummary();
+    return _summary.seedCharge / _summary.seedNoise;
   }
 
   template<class PixelType>
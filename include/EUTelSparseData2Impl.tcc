@@ -54,6 +54,12 @@ namespace eutelescope {
     return *this;
   }
 */
+  template<class PixelType>
+  void EUTelSparseData2Impl<PixelType>::reserve(unsigned int nPixels) {
+    _trackerData->chargeValues().reserve( _trackerData->getChargeValues().size() + nPixels * _nElement );
+    _pixelVec.reserve( _pixelVec.size() + nPixels );
+  }
+
   template<class PixelType>
   unsigned int EUTelSparseData2Impl<PixelType>::size() const {
     return _pixelVec.size();
@@ -31,6 +31,17 @@ namespace eutelescope {
     return _trackerData->getChargeValues().size() / _nElement;
   }
 
+  template<class PixelType>
+  void EUTelSparseDataImpl<PixelType>::reserve(unsigned int nPixels) {
+    _trackerData->chargeValues().reserve( _trackerData->getChargeValues().size() + nPixels * _nElement );
+  }
+
+  template<class PixelType>
+  void EUTelSparseDataImpl<PixelType>::addSparsePixels(const float * packedPixels, unsigned int nPixels) {
+    if ( nPixels == 0 ) return;
+    _trackerData->chargeValues().insert( _trackerData->chargeValues().end(), packedPixels, packedPixels + nPixels * _nElement );
+  }
+
   template<class PixelType> 
   EUTelSparseDataImpl<PixelType>::EUTelSparseDataImpl(const EUTelSparseDataImpl &z) : _trackerData(NULL), _nElement(0), _type(0) {
     _trackerData->setCellID0(z->trackerData()->getCellID0());
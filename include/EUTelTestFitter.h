@@ -568,6 +568,9 @@ namespace eutelescope {
     double * _planeResolution;
     bool   * _isActive;
 
+    //! Plane index, in the Z order, of each sensor ID
+    std::map< int, int > _sensorIDToPlane;
+
     std::vector<int> * _planeWindowIDs;
     std::vector<int> * _planeMaskIDs;
 
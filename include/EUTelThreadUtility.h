@@ -0,0 +1,360 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELTHREADUTILITY_H
+#define EUTELTHREADUTILITY_H
+
+// system includes <>
+#include <pthread.h>
+#include <deque>
+#include <vector>
+#include <cstddef>
+
+namespace eutelescope {
+
+  //! Thin wrapper around a POSIX mutex
+  class EUTelMutex {
+
+  public:
+    EUTelMutex()  { pthread_mutex_init( &_mutex, 0 ); }
+    ~EUTelMutex() { pthread_mutex_destroy( &_mutex ); }
+
+    void lock()   { pthread_mutex_lock( &_mutex ); }
+    void unlock() { pthread_mutex_unlock( &_mutex ); }
+
+    //! The native handle, needed by condition variables
+    pthread_mutex_t * native() { return &_mutex; }
+
+  private:
+    EUTelMutex(const EUTelMutex&);
+    void operator=(const EUTelMutex&);
+
+    pthread_mutex_t _mutex;
+  };
+
+  //! Scoped lock of an EUTelMutex
+  /*! The mutex is locked in the constructor and released when the
+   *  lock goes out of scope, also in case of exceptions.
+   */
+  class EUTelMutexLock {
+
+  public:
+    explicit EUTelMutexLock(EUTelMutex & mutex) : _mutex(mutex) { _mutex.lock(); }
+    ~EUTelMutexLock() { _mutex.unlock(); }
+
+  private:
+    EUTelMutexLock(const EUTelMutexLock&);
+    void operator=(const EUTelMutexLock&);
+
+    EUTelMutex & _mutex;
+  };
+
+  //! Bounded, blocking FIFO shared between threads
+  /*! This is the hand-over point of all the producer / consumer
+   *  pipelines in EUTelescope (readers decoding ahead of the
+   *  processor chain, background writers and so on).
+   *
+   *  push() blocks while the queue is full, so that a fast producer
+   *  is slowed down to the pace of the consumer (back-pressure),
+   *  while pop() blocks while the queue is empty. Once close() has
+   *  been called, push() refuses new items and pop() returns false
+   *  as soon as the queue has been drained.
+   *
+   *  Items are copied in and out, so T is meant to be a pointer or a
+   *  small value type.
+   */
+  template<class T>
+  class EUTelBoundedQueue {
+
+  public:
+    //! Default constructor
+    /*! @param capacity The maximum number of items waiting in the
+     *  queue. Zero is promoted to one.
+     */
+    explicit EUTelBoundedQueue(size_t capacity) :
+      _capacity( capacity > 0 ? capacity : 1 ),
+      _queue(),
+      _mutex(),
+      _isClosed(false) {
+      pthread_cond_init( &_notEmpty, 0 );
+      pthread_cond_init( &_notFull, 0 );
+    }
+
+    //! Destructor
+    ~EUTelBoundedQueue() {
+      pthread_cond_destroy( &_notEmpty );
+      pthread_cond_destroy( &_notFull );
+    }
+
+    //! Add an item, waiting for a free place if needed
+    /*! @return false if the queue has been closed and the item was
+     *  not added.
+     */
+    bool push(const T & item) {
+      EUTelMutexLock lock( _mutex );
+      while ( _queue.size() >= _capacity && !_isClosed ) {
+        pthread_cond_wait( &_notFull, _mutex.native() );
+      }
+      if ( _isClosed ) return false;
+      _queue.push_back( item );
+      pthread_cond_signal( &_notEmpty );
+      return true;
+    }
+
+    //! Add an item only if there is a free place
+    /*! @return false if the queue is full or closed.
+     */
+    bool tryPush(const T & item) {
+      EUTelMutexLock lock( _mutex );
+      if ( _isClosed || _queue.size() >= _capacity ) return false;
+      _queue.push_back( item );
+      pthread_cond_signal( &_notEmpty );
+      return true;
+    }
+
+    //! Remove the oldest item, waiting for one if needed
+    /*! @return false if the queue is closed and empty. In this case
+     *  item is left untouched.
+     */
+    bool pop(T & item) {
+      EUTelMutexLock lock( _mutex );
+      while ( _queue.empty() && !_isClosed ) {
+        pthread_cond_wait( &_notEmpty, _mutex.native() );
+      }
+      if ( _queue.empty() ) return false;
+      item = _queue.front();
+      _queue.pop_front();
+      pthread_cond_signal( &_notFull );
+      return true;
+    }
+
+    //! Remove the oldest item without waiting
+    /*! @return false if the queue is currently empty.
+     */
+    bool tryPop(T & item) {
+      EUTelMutexLock lock( _mutex );
+      if ( _queue.empty() ) return false;
+      item = _queue.front();
+      _queue.pop_front();
+      pthread_cond_signal( &_notFull );
+      return true;
+    }
+
+    //! Close the queue
+    /*! All the waiting threads are woken up. Items already in the
+     *  queue can still be popped.
+     */
+    void close() {
+      EUTelMutexLock lock( _mutex );
+      _isClosed = true;
+      pthread_cond_broadcast( &_notEmpty );
+      pthread_cond_broadcast( &_notFull );
+    }
+
+    //! Re-open a closed and drained queue for a new run
+    void reopen() {
+      EUTelMutexLock lock( _mutex );
+      _isClosed = false;
+    }
+
+    //! Current number of waiting items
+    size_t size() {
+      EUTelMutexLock lock( _mutex );
+      return _queue.size();
+    }
+
+    //! Maximum number of waiting items
+    size_t capacity() const { return _capacity; }
+
+  private:
+    EUTelBoundedQueue(const EUTelBoundedQueue&);
+    void operator=(const EUTelBoundedQueue&);
+
+    //! Maximum number of waiting items
+    size_t _capacity;
+
+    //! The items
+    std::deque<T> _queue;
+
+    //! Protects all the members above and below
+    EUTelMutex _mutex;
+
+    //! Signalled when an item is added
+    pthread_cond_t _notEmpty;
+
+    //! Signalled when an item is removed
+    pthread_cond_t _notFull;
+
+    //! Set by close()
+    bool _isClosed;
+  };
+
+  //! A piece of work split in independent chunks
+  /*! See EUTelWorkerPool.
+   */
+  class EUTelParallelTask {
+
+  public:
+    virtual ~EUTelParallelTask() { }
+
+    //! Process one chunk
+    /*! Different chunks are processed concurrently, so they must not
+     *  write to the same memory. This method must not throw.
+     */
+    virtual void execute(size_t chunk) = 0;
+  };
+
+  //! Fixed set of threads sharing data parallel work
+  /*! The threads are started once in the constructor and wait for
+   *  work, so that a task can be split over several cores for every
+   *  event without paying the thread creation each time.
+   *
+   *  run() hands out the chunks of a task to the workers and to the
+   *  calling thread itself, and returns once all of them have been
+   *  processed. A pool of one thread does not start any worker and
+   *  simply runs the chunks in order.
+   */
+  class EUTelWorkerPool {
+
+  public:
+    //! Default constructor
+    /*! @param nThreads The total number of threads working on a
+     *  task, the calling one included. Zero is promoted to one.
+     */
+    explicit EUTelWorkerPool(unsigned int nThreads) :
+      _workers(),
+      _mutex(),
+      _task(0),
+      _nChunks(0),
+      _nextChunk(0),
+      _pendingChunks(0),
+      _generation(0),
+      _isStopping(false) {
+      pthread_cond_init( &_workReady, 0 );
+      pthread_cond_init( &_workDone, 0 );
+      for ( unsigned int iThread = 1; iThread < nThreads; ++iThread ) {
+        pthread_t thread;
+        if ( pthread_create( &thread, 0, &EUTelWorkerPool::workerEntry, this ) != 0 ) break;
+        _workers.push_back( thread );
+      }
+    }
+
+    //! Destructor, stops and joins the workers
+    ~EUTelWorkerPool() {
+      {
+        EUTelMutexLock lock( _mutex );
+        _isStopping = true;
+        pthread_cond_broadcast( &_workReady );
+      }
+      for ( size_t iThread = 0; iThread < _workers.size(); ++iThread ) {
+        pthread_join( _workers[iThread], 0 );
+      }
+      pthread_cond_destroy( &_workReady );
+      pthread_cond_destroy( &_workDone );
+    }
+
+    //! Process the chunks 0 to nChunks - 1 of a task
+    /*! It returns when all the chunks are done. The pool handles one
+     *  task at the time, so run() must not be called concurrently.
+     */
+    void run(EUTelParallelTask & task, size_t nChunks) {
+      if ( _workers.empty() ) {
+        for ( size_t iChunk = 0; iChunk < nChunks; ++iChunk ) task.execute( iChunk );
+        return;
+      }
+      EUTelMutexLock lock( _mutex );
+      _task          = &task;
+      _nChunks       = nChunks;
+      _nextChunk     = 0;
+      _pendingChunks = nChunks;
+      ++_generation;
+      pthread_cond_broadcast( &_workReady );
+      processChunks();
+      while ( _pendingChunks > 0 ) {
+        pthread_cond_wait( &_workDone, _mutex.native() );
+      }
+      _task = 0;
+    }
+
+    //! Total number of threads, the calling one included
+    unsigned int getNThreads() const { return _workers.size() + 1; }
+
+  private:
+    EUTelWorkerPool(const EUTelWorkerPool&);
+    void operator=(const EUTelWorkerPool&);
+
+    //! pthread entry point of the workers
+    static void * workerEntry(void * pool) {
+      static_cast< EUTelWorkerPool * >( pool )->work();
+      return 0;
+    }
+
+    //! Worker loop, waiting for a new task to process
+    void work() {
+      EUTelMutexLock lock( _mutex );
+      unsigned long lastGeneration = _generation;
+      while ( true ) {
+        while ( !_isStopping && _generation == lastGeneration ) {
+          pthread_cond_wait( &_workReady, _mutex.native() );
+        }
+        if ( _isStopping ) return;
+        lastGeneration = _generation;
+        processChunks();
+      }
+    }
+
+    //! Take chunks of the current task until there are none left
+    /*! To be called with _mutex locked, it is released while a chunk
+     *  is processed.
+     */
+    void processChunks() {
+      while ( _task != 0 && _nextChunk < _nChunks ) {
+        EUTelParallelTask * task = _task;
+        size_t chunk = _nextChunk++;
+        _mutex.unlock();
+        task->execute( chunk );
+        _mutex.lock();
+        if ( --_pendingChunks == 0 ) pthread_cond_signal( &_workDone );
+      }
+    }
+
+    //! The worker threads
+    std::vector< pthread_t > _workers;
+
+    //! Protects all the members below
+    EUTelMutex _mutex;
+
+    //! Signalled when a new task is available or the pool stops
+    pthread_cond_t _workReady;
+
+    //! Signalled when the last chunk of a task is done
+    pthread_cond_t _workDone;
+
+    //! The task being processed, 0 if none
+    EUTelParallelTask * _task;
+
+    //! Number of chunks of the current task
+    size_t _nChunks;
+
+    //! First chunk not yet handed out
+    size_t _nextChunk;
+
+    //! Chunks not yet completed
+    size_t _pendingChunks;
+
+    //! Incremented for every new task
+    unsigned long _generation;
+
+    //! Set by the destructor
+    bool _isStopping;
+  };
+
+}
+
+#endif
@@ -0,0 +1,321 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELTUPLEWRITER_H
+#define EUTELTUPLEWRITER_H
+
+#if defined(USE_ROOT) || defined(MARLIN_USE_ROOT)
+
+// personal includes ".h"
+#include "EUTelThreadUtility.h"
+
+// ROOT includes
+#include <Rtypes.h>
+
+// system includes <>
+#include <string>
+#include <vector>
+
+class TFile;
+class TTree;
+
+namespace eutelescope {
+
+  class EUTelTupleFile;
+  struct EUTelTupleBlock;
+
+  //! A ROOT tree filled row by row through column buffers
+  /*! The interface mimics the AIDA::ITuple one: columns are booked
+   *  once, then for each row the columns are filled by index and the
+   *  row is committed with addRow(). Instead of filling the TTree
+   *  straight away, the rows are accumulated column by column in a
+   *  block of EUTelTupleFile::getRowsPerBlock() rows. Full blocks are
+   *  handed to the owning EUTelTupleFile that fills, compresses and
+   *  writes them, possibly on a background thread.
+   *
+   *  Columns not filled for a row are written as zero (scalars) or
+   *  as an empty vector.
+   *
+   *  Trees are created and owned by an EUTelTupleFile.
+   *
+   *  @version $Id$
+   */
+  class EUTelTupleTree {
+
+  public:
+
+    //! The column types
+    enum ColumnType {
+      kInt,           //!< one Int_t per row
+      kLong,          //!< one Long64_t per row
+      kDouble,        //!< one Double_t per row
+      kIntVector,     //!< a std::vector<int> per row
+      kDoubleVector   //!< a std::vector<double> per row
+    };
+
+    //! Book a new column
+    /*! Columns have to be booked before EUTelTupleFile::start().
+     *
+     *  @param name The branch name
+     *  @param type The column type
+     *  @return The column index to be used with fill()
+     */
+    int addColumn(const std::string & name, ColumnType type);
+
+    //! Fill a scalar column of the current row
+    /*! The value is converted to the column type.
+     */
+    void fill(int column, int value);
+    void fill(int column, long value);
+    void fill(int column, float value);
+    void fill(int column, double value);
+
+    //! Fill a vector column of the current row
+    /*! Calling it more than once for the same row appends the values.
+     */
+    void fill(int column, const std::vector<int> & values);
+    void fill(int column, const std::vector<double> & values);
+
+    //! Commit the current row
+    void addRow();
+
+    //! Number of committed rows
+    Long64_t rows() const { return _rows; }
+
+    //! Name of the tree
+    const std::string & getName() const { return _name; }
+
+    //! The underlying TTree
+    /*! To be used only for additional set up (friends, aliases...)
+     *  before EUTelTupleFile::start(). The tree belongs to the file
+     *  and is gone after EUTelTupleFile::close().
+     */
+    TTree * tree() { return _tree; }
+
+  private:
+    friend class EUTelTupleFile;
+
+    //! One booked column
+    struct Column {
+      std::string name;
+      ColumnType type;
+
+      //! Scalar value of the row being filled
+      Long64_t longValue;
+      double doubleValue;
+
+      //! Branch buffers, used only by the writing side
+      Int_t intBranch;
+      Long64_t longBranch;
+      Double_t doubleBranch;
+      std::vector<int> * intVectorBranch;
+      std::vector<double> * doubleVectorBranch;
+    };
+
+    //! Only EUTelTupleFile creates trees
+    EUTelTupleTree(EUTelTupleFile * file, const std::string & name, const std::string & title);
+    ~EUTelTupleTree();
+
+    EUTelTupleTree(const EUTelTupleTree&);
+    void operator=(const EUTelTupleTree&);
+
+    //! Create the branches on the TTree
+    void book(int basketSize, Long64_t autoFlush);
+
+    //! Fill the TTree with all the rows of a block
+    void writeBlock(EUTelTupleBlock * block);
+
+    //! Make sure there is a block to be filled
+    void prepareBlock();
+
+    //! Hand the current block over to the file
+    void flush();
+
+    //! The owning file
+    EUTelTupleFile * _file;
+
+    //! Tree name
+    std::string _name;
+
+    //! The ROOT tree
+    TTree * _tree;
+
+    //! The booked columns
+    std::vector<Column> _columns;
+
+    //! The block being filled
+    EUTelTupleBlock * _block;
+
+    //! Committed rows
+    Long64_t _rows;
+  };
+
+
+  //! A ROOT file of EUTelTupleTree written through a background thread
+  /*! This is the shared n-tuple output component of the tuple
+   *  processors. It owns the TFile and the trees; the rows committed
+   *  by the trees are collected in blocks and, when background
+   *  writing is enabled, full blocks are queued to a writer thread
+   *  that fills the TTrees and so takes care of compression and
+   *  basket writing. The queue is bounded, so if the disk can't keep
+   *  up the processor is slowed down rather than the memory growing.
+   *
+   *  Once start() has been called the ROOT objects of this file are
+   *  touched only by the writer thread, until close() joins it. The
+   *  trees must not be shared with other ROOT objects (no friends
+   *  filled elsewhere, no TTree::Draw...) while the file is running.
+   *
+   *  Typical usage in a processor:
+   *
+   *  @code
+   *  // init()
+   *  _tupleFile = new EUTelTupleFile( fileName );
+   *  _tupleFile->setBasketSize( _basketSize );
+   *  EUTelTupleTree * tracks = _tupleFile->addTree( "tracks", "tracks" );
+   *  int xCol = tracks->addColumn( "x", EUTelTupleTree::kDoubleVector );
+   *  _tupleFile->start();
+   *
+   *  // processEvent()
+   *  tracks->fill( xCol, xVector );
+   *  tracks->addRow();
+   *
+   *  // end()
+   *  _tupleFile->close();
+   *  @endcode
+   *
+   *  @version $Id$
+   */
+  class EUTelTupleFile {
+
+  public:
+    //! Default constructor
+    /*! The file is opened straight away (in RECREATE mode), but
+     *  the current ROOT directory is left unchanged.
+     *
+     *  @param fileName The output file name
+     */
+    explicit EUTelTupleFile(const std::string & fileName);
+
+    //! Destructor
+    /*! It closes the file, if not yet done.
+     */
+    ~EUTelTupleFile();
+
+    //! Book a new tree in the file
+    EUTelTupleTree * addTree(const std::string & name, const std::string & title);
+
+    //! Basket size in bytes of all the branches
+    void setBasketSize(int basketSize) { _basketSize = basketSize; }
+
+    //! TTree::SetAutoFlush value of all the trees
+    /*! Positive values are entries, negative values bytes, as in
+     *  ROOT.
+     */
+    void setAutoFlush(Long64_t autoFlush) { _autoFlush = autoFlush; }
+
+    //! Number of rows accumulated before handing a block over
+    void setRowsPerBlock(size_t rowsPerBlock) { _rowsPerBlock = ( rowsPerBlock > 0 ? rowsPerBlock : 1 ); }
+
+    //! Number of rows accumulated before handing a block over
+    size_t getRowsPerBlock() const { return _rowsPerBlock; }
+
+    //! Enable the background writer thread
+    /*! Off by default. When enabled, TTree::Fill() and the basket
+     *  flushes run on a second thread while the Marlin thread keeps
+     *  using ROOT (histograms, gDirectory), so start() initialises
+     *  the ROOT thread support (TThread::Initialize()) before starting
+     *  the thread. Only enable it in jobs where no other processor
+     *  writes to the tuple file or changes the current directory
+     *  while the tuples are filled.
+     *
+     *  @param enable If false, the blocks are written by the calling
+     *  thread as soon as they are full.
+     *  @param queueSize Maximum number of full blocks waiting for the
+     *  writer thread.
+     */
+    void setBackgroundWriting(bool enable, size_t queueSize = 4) {
+      _useBackgroundWriting = enable;
+      _queueSize = queueSize;
+    }
+
+    //! Create the branches and start the writer thread
+    void start();
+
+    //! Flush all the rows, stop the writer thread and close the file
+    void close();
+
+    //! The file name
+    const std::string & getFileName() const { return _fileName; }
+
+  private:
+    friend class EUTelTupleTree;
+
+    EUTelTupleFile(const EUTelTupleFile&);
+    void operator=(const EUTelTupleFile&);
+
+    //! Get an empty block, recycled if possible
+    EUTelTupleBlock * getBlock();
+
+    //! Hand a full block to the writer
+    void submit(EUTelTupleBlock * block);
+
+    //! Write a block and recycle it
+    void writeBlock(EUTelTupleBlock * block);
+
+    //! Writer thread main loop
+    void writeBehind();
+
+    //! pthread entry point for writeBehind()
+    static void * writerThreadEntry(void * self);
+
+    //! Output file name
+    std::string _fileName;
+
+    //! The ROOT file
+    TFile * _file;
+
+    //! The trees in booking order
+    std::vector<EUTelTupleTree *> _trees;
+
+    //! Basket size in bytes
+    int _basketSize;
+
+    //! TTree auto flush
+    Long64_t _autoFlush;
+
+    //! Rows per block
+    size_t _rowsPerBlock;
+
+    //! Background writing switch
+    bool _useBackgroundWriting;
+
+    //! Maximum number of full blocks waiting
+    size_t _queueSize;
+
+    //! Full blocks waiting for the writer thread
+    EUTelBoundedQueue<EUTelTupleBlock *> * _fullBlocks;
+
+    //! Written blocks ready to be reused
+    EUTelBoundedQueue<EUTelTupleBlock *> * _freeBlocks;
+
+    //! The writer thread
+    pthread_t _writerThread;
+
+    //! Set while the writer thread runs
+    bool _isWriterThreadRunning;
+
+    //! Set between start() and close()
+    bool _isStarted;
+  };
+
+}
+
+#endif // USE_ROOT || MARLIN_USE_ROOT
+
+#endif
@@ -17,8 +17,12 @@
 // lcio includes <.h>
 #include <LCIOTypes.h>
 #include <IMPL/LCCollectionVec.h>
+#include <IMPL/TrackerDataImpl.h>
+#include <IMPL/TrackerRawDataImpl.h>
 
 // system includes <>
+#include <vector>
+#include <cstddef>
 
 
 
@@ -177,11 +181,47 @@ namespace eutelescope {
      *  * D </code>, where W is the @c _fixedWeightValue and @c D is
      *  the pixel current value.
      *
+     *  The status, pedestal and noise objects of each detector are
+     *  looked up only when the run or the input collections change,
+     *  see updateDetectorCache(), and the pixels are then updated in
+     *  place by fixedWeightKernel().
+     *
      *  @param evt The current LCEvent event as passed by the
      *  processEvent
      */
     void fixedWeightUpdate(LCEvent * evt);
 
+    //! Fixed weight update of one detector
+    /*! The pedestal and noise arrays are updated in place. Pixels
+     *  whose status is not EUTELESCOPE::GOODPIXEL are not changed,
+     *  but instead of skipping them with a branch their update is
+     *  multiplied by a 0 weight, so that the loop has no control flow
+     *  and can be vectorized by the compiler.
+     *
+     *  @param adc The raw signals of the detector
+     *  @param status The pixel status of the detector
+     *  @param pedestal The running pedestal values
+     *  @param noise The running noise values
+     *  @param nPixel The number of pixels of the detector
+     *  @param weight The fixed weight
+     */
+    static void fixedWeightKernel(const short * adc, const short * status,
+                                  float * pedestal, float * noise,
+                                  size_t nPixel, float weight);
+
+    //! Rebuild the per detector lookup if the run or the collections changed
+    /*! The lookup is keyed on the run number, since the conditions
+     *  are valid for a run, and then on the collections.
+     *
+     *  @param runNumber The run number of the current event
+     *  @return false if a detector is missing in one of the
+     *  collections
+     */
+    bool updateDetectorCache(int runNumber,
+                             IMPL::LCCollectionVec * pedestalCollection,
+                             IMPL::LCCollectionVec * noiseCollection,
+                             IMPL::LCCollectionVec * statusCollection);
+
     //! Pixel monitoring
     /*! This method is used to collect some information about the
      *  pedestal and noise update. Updating pedestal values is of
@@ -325,6 +365,29 @@ namespace eutelescope {
      */
     unsigned short _noOfConsecutiveMissing;
 
+    //! Conditions objects of one detector
+    struct DetectorState {
+      IMPL::TrackerRawDataImpl * status;
+      IMPL::TrackerDataImpl * pedestal;
+      IMPL::TrackerDataImpl * noise;
+      size_t nPixel;
+    };
+
+    //! Detector objects, indexed by sensorID
+    /*! A NULL status means the detector is not available.
+     */
+    std::vector< DetectorState > _detectorState;
+
+    //! Collections _detectorState has been built from
+    IMPL::LCCollectionVec * _cachedPedestalCollection;
+    IMPL::LCCollectionVec * _cachedNoiseCollection;
+    IMPL::LCCollectionVec * _cachedStatusCollection;
+
+    //! Run number _detectorState has been built for
+    /*! -1 when there is no valid lookup
+     */
+    int _cachedRunNumber;
+
   private:
 
 
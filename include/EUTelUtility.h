@@ -204,6 +204,12 @@ namespace eutelescope {
         
         /** Solve quadratic equation a*x^2 + b*x + c = 0 */
         std::vector< double > solveQuadratic( double, double, double );
+
+        /** Monotonic wall clock time in seconds, for timing measurements */
+        double getWallTime();
+
+        /** CPU time used by the process (all threads) in seconds */
+        double getCPUTime();
         
         /** Tokenize string */
                 /**
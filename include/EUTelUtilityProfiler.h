@@ -0,0 +1,93 @@
+#ifndef EUTelUtilityProfiler_h
+#define EUTelUtilityProfiler_h 1
+
+// C++
+#include <string>
+
+// LCIO
+#include "lcio.h"
+
+// Marlin
+#include "marlin/Processor.h"
+
+
+namespace eutelescope {
+
+  /**  Profiling checkpoint in the processor chain.
+   *
+   *   Each instance of this processor records the wall and CPU time, and
+   *   the memory allocations, spent since the previous checkpoint of the
+   *   same event, that is in the processors placed between the two, as
+   *   one section of the EUTelProfiler. To profile a steering file, put
+   *   a checkpoint at the beginning of the chain and one after each
+   *   processor (or group of processors) to measure.
+   *
+   *   The sections timed in the code (clustering, track search, track
+   *   fit...) are recorded as soon as one checkpoint is in the job.
+   *
+   *   The table of all the sections is printed at the end of the job;
+   *   the measurements of every event can also be written to a CSV file.
+   *
+   *   @parameter SectionName Name of the section ending at this checkpoint,
+   *   the processor name if empty
+   *
+   *   @parameter EventLogFile CSV file of the measurements per event,
+   *   none if empty
+   *
+   *   @parameter SummaryFile CSV file of the table printed at the end of
+   *   the job, none if empty
+   */
+  class EUTelUtilityProfiler : public marlin::Processor {
+	
+  public:
+	
+    /* This method will be called by the marlin package
+     * It returns a processor of the currend type
+     */
+    virtual Processor*  newProcessor() { 
+      return new EUTelUtilityProfiler;
+    }
+
+    /* the default constructor
+     * here the processor parameters are registered to the marlin package
+     */
+    EUTelUtilityProfiler() ;
+	
+    /* Enables the profiler and opens the CSV file
+     */
+    virtual void init() ;
+	
+    /* Called for every run.
+     * in this processor it is not used
+     */
+    virtual void processRunHeader( lcio::LCRunHeader* run ) ;
+	
+    /* Called for every event: records the section ending here
+     */
+    virtual void processEvent( lcio::LCEvent * evt ) ; 
+	
+    /* Prints the profile of the job, once for all the checkpoints,
+     * and writes it to the summary file if any
+     */
+    virtual void end() ;
+	
+	
+  protected:
+	
+    /// name of the section ending at this checkpoint
+    std::string _sectionName;
+
+    /// CSV file of the measurements per event
+    std::string _eventLogFile;
+
+    /// CSV file of the profile of the job
+    std::string _summaryFile;
+
+    /// the profile is printed by the first checkpoint reaching end()
+    static bool _summaryPrinted;
+
+  };
+
+}
+
+#endif
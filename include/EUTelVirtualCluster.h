@@ -38,7 +38,7 @@ namespace eutelescope {
 
   public:
     //! Default constructor
-    EUTelVirtualCluster(IMPL::TrackerDataImpl *) : _trackerData(NULL) { } 
+    EUTelVirtualCluster(IMPL::TrackerDataImpl *) : _trackerData(NULL), _summary() { } 
 
     //! Default destructor
     virtual ~EUTelVirtualCluster() {;}
@@ -331,6 +331,57 @@ protected:
      */ 
     IMPL::TrackerDataImpl * _trackerData;
 
+    //! Cluster summary
+    /*! The total and seed charge, the sizes, the center of gravity
+     *  and the noise sums are asked for several times per cluster by
+     *  the clustering, filtering, hit making and histogramming
+     *  processors. The implementations compute all of them in one
+     *  pass over the pixels the first time one is needed and keep
+     *  them here, so that the following calls do not scan the
+     *  TrackerData again.
+     *
+     *  The charge part and the noise part are filled independently
+     *  because the noise values are not always set.
+     */
+    struct Summary {
+      Summary() : chargeValid(false), noiseValid(false),
+                  totalCharge(0.), seedCharge(0.), seedIndex(0),
+                  xSeed(0), ySeed(0), xSize(0), ySize(0),
+                  xCoGShift(0.), yCoGShift(0.), xCoG(0.), yCoG(0.),
+                  noise2Sum(0.), seedNoise(0.) { }
+
+      bool  chargeValid;
+      bool  noiseValid;
+
+      float totalCharge;
+      float seedCharge;
+      unsigned int seedIndex;
+      int   xSeed;
+      int   ySeed;
+      int   xSize;
+      int   ySize;
+      float xCoGShift;
+      float yCoGShift;
+      float xCoG;
+      float yCoG;
+
+      float noise2Sum;
+      float seedNoise;
+    };
+
+    //! The cached summary, see Summary
+    mutable Summary _summary;
+
+    //! Invalidate the cached summary
+    /*! Every method that can change the pixel signals or the noise
+     *  values has to call this, trackerData() included since it
+     *  hands out a non const pointer to the data.
+     */
+    void invalidateSummary() {
+      _summary.chargeValid = false;
+      _summary.noiseValid  = false;
+    }
+
   };
 
 }
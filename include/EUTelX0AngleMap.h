@@ -0,0 +1,130 @@
+// Version: $Id$
+/*
+ * This source code is part of the Eutelescope package of Marlin.
+ * You are free to use this source files for your own development as
+ * long as it stays in a public research context. You are not
+ * allowed to use it for commercial purpose. You must put this
+ * header with author names in all development based on this file.
+ */
+
+#ifndef EUTELX0ANGLEMAP_H
+#define EUTELX0ANGLEMAP_H
+
+//  System includes
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace eutelescope {
+
+//! Fixed memory accumulator of scattering angles on a spatial map
+/*! For each bin of the radiation length map this keeps the number
+ *  of entries, the first two moments of the scattering angle and a
+ *  fixed binning histogram of the angle. The histogram is what the
+ *  width fit of EUTelX0Processor uses and it is also used as a
+ *  quantile sketch, so the angles themselves never need to be kept.
+ *
+ *  All the bins are stored in contiguous arrays whose size depends
+ *  only on the geometry given to setGeometry(), not on the number of
+ *  tracks. Accumulators with the same geometry can be added up with
+ *  merge(), and write() / read() save and restore them in a plain
+ *  text format, so partial maps of many runs processed in parallel
+ *  can be combined afterwards.
+ */
+class EUTelX0AngleMap {
+
+public:
+  //! Default constructor, an empty map
+  EUTelX0AngleMap();
+
+  //! Fix the map geometry and clear all the bins
+  /*! @param nBinsX Number of spatial bins in x
+   *  @param nBinsY Number of spatial bins in y
+   *  @param nAngleBins Number of bins of the angle histogram
+   *  @param minAngle Lower edge of the angle histogram
+   *  @param maxAngle Upper edge of the angle histogram
+   */
+  void setGeometry(int nBinsX, int nBinsY, int nAngleBins, double minAngle, double maxAngle);
+
+  //! Add an angle to a spatial bin
+  /*! Angles in bins outside the map are ignored, angles outside the
+   *  angle range only go in the under/overflow of the histogram.
+   */
+  void fill(int xBin, int yBin, double angle);
+
+  //! Add up another map with the same geometry
+  /*! @return false, leaving this map untouched, if the geometries
+   *  differ.
+   */
+  bool merge(const EUTelX0AngleMap & other);
+
+  //! Number of angles in a spatial bin
+  unsigned long long getEntries(int xBin, int yBin) const;
+
+  //! Mean of the angles in a spatial bin
+  double getMean(int xBin, int yBin) const;
+
+  //! RMS of the angles in a spatial bin
+  double getRMS(int xBin, int yBin) const;
+
+  //! Quantile of the angles in a spatial bin
+  /*! Estimated from the angle histogram with a linear interpolation
+   *  within the histogram bin, so it is exact to the histogram bin
+   *  width. Under and overflows are accounted for at the range
+   *  edges.
+   *
+   *  @param fraction The quantile, between 0 and 1
+   */
+  double getQuantile(int xBin, int yBin, double fraction) const;
+
+  //! Angle histogram of a spatial bin
+  /*! The returned array has getNAngleBins() + 2 elements: the
+   *  underflow, the nAngleBins bins and the overflow, the same
+   *  numbering as a ROOT TH1.
+   */
+  const unsigned int * getAngleHistogram(int xBin, int yBin) const;
+
+  int getNBinsX() const { return _nBinsX; }
+  int getNBinsY() const { return _nBinsY; }
+  int getNAngleBins() const { return _nAngleBins; }
+  double getMinAngle() const { return _minAngle; }
+  double getMaxAngle() const { return _maxAngle; }
+
+  //! Write the map, named, to a stream
+  /*! Only non empty bins and histogram entries are written.
+   */
+  void write(std::ostream & os, const std::string & name) const;
+
+  //! Read a map written by write()
+  /*! The geometry of this map is replaced by the one read.
+   *
+   *  @param name Set to the name of the map read
+   *  @return false if the stream does not contain a valid map
+   */
+  bool read(std::istream & is, std::string & name);
+
+private:
+  //! Index of a spatial bin, -1 if outside
+  int getIndex(int xBin, int yBin) const;
+
+  int _nBinsX;
+  int _nBinsY;
+  int _nAngleBins;
+  double _minAngle;
+  double _maxAngle;
+
+  //! Per spatial bin number of entries
+  std::vector< unsigned long long > _entries;
+
+  //! Per spatial bin sum of the angles
+  std::vector< double > _sum;
+
+  //! Per spatial bin sum of the squared angles
+  std::vector< double > _sum2;
+
+  //! Angle histograms, _nAngleBins + 2 counts per spatial bin
+  std::vector< unsigned int > _angleCounts;
+};
+
+}
+#endif
@@ -18,6 +18,7 @@
 #endif
 //  EUTelescope includes
 #include "EUTelReferenceHit.h"
+#include "EUTelX0AngleMap.h"
 //  Marlin includes
 #include <marlin/AIDAProcessor.h>
 #include "marlin/Processor.h"
@@ -146,8 +147,8 @@ private:
   std::vector< TVector3 > getHitsFromTrack(Track *track);
 
   //!Get Sigma
-  /*!Works out the sigma value from a vector which contains scattering angles*/
-  double getSigma(std::vector< double > angles);
+  /*!Works out the sigma value from the scattering angles accumulated in one bin of a radiation length map*/
+  double getSigma(const EUTelX0AngleMap &angles, std::pair< int, int > position);
   std::pair<double,double> GetLowerAndUpperBounds(TH1D *temphisto);
 
   //!Print Track Parameters
@@ -196,6 +197,39 @@ private:
   /*!This converts the global coordinates into integer bins for use when filling the radiation length maps*/
   std::pair< int, int > ConversionHitmapToX0map(double x, double y);
 
+  //!DUT Track Point
+  /*!A track of one of the double daf fitters with its fitted points and where it crosses the DUT, used to match the front and back tracks*/
+  struct DUTTrackPoint {
+    Track *track;
+    std::vector< TVector3 > hits;
+    double x;
+    double y;
+  };
+
+  //!DUT Position
+  /*!Works out the z position of the DUT from the fitted points of a front track and the DUTPosition parameter, which is relative to plane 2*/
+  double GetDUTPosition(const std::vector< TVector3 > &fronthits);
+
+  //!Get DUT Track Points
+  /*!Extrapolates all the tracks of a collection to the DUT, front tracks from their last two planes before the DUT and back tracks from their first two planes. Tracks with too few fitted points are left out*/
+  void GetDUTTrackPoints(LCCollection *trackcollection, bool front, std::vector< DUTTrackPoint > &trackpoints);
+
+  //!Match Double Daf Tracks
+  /*!Pairs each front track with at most one back track, and the other way round, if they cross the DUT within _cut of each other in x and y. The closest pairs are taken first. Returns the pairs of indices in frontpoints and backpoints*/
+  std::vector< std::pair< size_t, size_t > > MatchDoubleDafTracks(const std::vector< DUTTrackPoint > &frontpoints, const std::vector< DUTTrackPoint > &backpoints);
+
+  //!Write Partial Results
+  /*!Writes the scattering angle accumulators to _partialResultsOutputFile so that they can be merged with the ones of other jobs*/
+  void writePartialResults();
+
+  //!Read Partial Results
+  /*!Adds the scattering angle accumulators stored in _partialResultsInputFiles to the ones of this job*/
+  void readPartialResults();
+
+  //!Get Angle Map
+  /*!Returns the accumulator with the given name, as used in the partial results files, or NULL if there is none*/
+  EUTelX0AngleMap* getAngleMap(const std::string &name);
+
   /***********************
   //Private member values*
   ***********************/
@@ -203,7 +237,7 @@ private:
   //Beam energy
   double _beamEnergy;
 
-  //Cut
+  //Cut, also used to match the tracks of the double daf fitters
   double _cut;
 
   //Double Daf Fitted
@@ -212,6 +246,10 @@ private:
   //DUT position
   double _dutPosition;
 
+  //Partial results
+  std::string _partialResultsOutputFile;
+  std::vector< std::string > _partialResultsInputFiles;
+
   //Current event number
   int _eventNumber;
 
@@ -364,12 +402,13 @@ private:
 //  TH2D *RadiationLengthPlane2Map;
 //  TH2D *RadiationLengthPlane3Map;
 //  TH2D *RadiationLengthPlane4Map;
-  std::map< int, std::map< std::pair< int, int >, std::vector< double > > > ScatteringAngleXSingleMapData;
-  std::map< int, std::map< std::pair< int, int >, std::vector< double > > > ScatteringAngleYSingleMapData;
-  std::map< std::pair< int, int >, std::vector< double > > ScatteringAngleXTripleMapData; //Pair gives the x and y bins of the track at the point of the DUT and the value of the double is the scattering angle
-  std::map< std::pair< int, int >, std::vector< double > > ScatteringAngleYTripleMapData; //Pair gives the x and y bins of the track at the point of the DUT and the value of the double is the scattering angle
-  std::map< std::pair< int, int >, std::vector< double > > ScatteringAngleXTripleMapDataDaf; //Pair gives the x and y bins of the track at the point of the DUT and the value of the double is the scattering angle
-  std::map< std::pair< int, int >, std::vector< double > > ScatteringAngleYTripleMapDataDaf; //Pair gives the x and y bins of the track at the point of the DUT and the value of the double is the scattering angle
+  //The scattering angle accumulators are binned like the radiation length maps, the key of the single plane ones is the plane number
+  std::map< int, EUTelX0AngleMap > ScatteringAngleXSingleMapData;
+  std::map< int, EUTelX0AngleMap > ScatteringAngleYSingleMapData;
+  EUTelX0AngleMap ScatteringAngleXTripleMapData;
+  EUTelX0AngleMap ScatteringAngleYTripleMapData;
+  EUTelX0AngleMap ScatteringAngleXTripleMapDataDaf;
+  EUTelX0AngleMap ScatteringAngleYTripleMapDataDaf;
 //  std::map< std::pair< int, int >, std::vector< double > > ScatteringAngleXPlane1MapData; //Pair gives the x and y bins of the track at the point of the DUT and the value of the double is the scattering angle
 //  std::map< std::pair< int, int >, std::vector< double > > ScatteringAngleXPlane2MapData; //Pair gives the x and y bins of the track at the point of the DUT and the value of the double is the scattering angle
 //  std::map< std::pair< int, int >, std::vector< double > > ScatteringAngleXPlane3MapData; //Pair gives the x and y bins of the track at the point of the DUT and the value of the double is the scattering angle
@@ -317,6 +317,271 @@ def zipLogs(path, filename):
         log.error("Input/Output error: Could not create log and steering file archive ("+os.path.join(path, filename)+".zip"+")!")
 
 
+def loadparameters(jobtask, conffile, cmdoptions):
+    """ Collect the parameters of a task from the defaults, the config file
+    and the command line options (in increasing order of precedence);
+    returns None if the config file could not be processed.
+
+    """
+    import os.path
+    import ConfigParser
+    log = logging.getLogger('jobsub')
+
+    # dictionary keeping our parameters
+    # here you can set some minimal default config values that will (possibly) be overwritten by the config file
+    parameters = {"templatepath":".", "templatefile":jobtask+"-tmp.xml", "logpath":"."}
+
+    # read in config file if specified on command line
+    if conffile:
+        config = ConfigParser.SafeConfigParser()
+        # local variables useful in the context of the config; access using %(NAME)s in config
+        config.set("DEFAULT", "HOME",str(os.environ.get('HOME')))
+        if not os.environ.get('EUTELESCOPE') is None:
+            config.set("DEFAULT", "EUTelescopePath", str(os.environ.get('EUTELESCOPE')))
+        else:
+            log.debug("Environment variable EUTELESCOPE not found; will not be set for steering/config file parsing")
+        try:
+            if not config.read([conffile]): # loads global defaults
+                log.error("Could not read config file '%s'!", conffile)
+                return None
+            # merge with defaults and create final set of configuration parameters
+            if config.has_section(jobtask):
+                parameters.update(dict(config.items(jobtask)))
+            else:
+                log.warning("Config file '%s' is missing a section [%s]!", conffile, jobtask)
+            log.info("Loaded config file %s", conffile)
+        except ConfigParser.InterpolationMissingOptionError, err: # if interpolation during config parsing fails
+            log.error('Bad value substitution in config file '+str(conffile)+ ": missing '%s' key in section [%s] for option '%s'."%(err.reference, err.section, err.option))
+            if err.reference == "eutelescopepath":
+                log.error('EUTELESCOPE environment variable not set but required in config through "EUTelescopePath" key - please source build_env.sh in EUTelescope top directory or set variable manually.')
+            return None
+    else:
+        log.warn("No config file specified")
+
+    # overwrite config options with the ones given on the command line
+    for key in cmdoptions:
+        log.debug( "Parsing cmd line: Setting "+key+" to value '"+cmdoptions[key]+"', possibly overwriting corresponding config file option")
+        parameters[key.lower()] = cmdoptions[key]
+
+    log.debug( "Our final config for task "+jobtask+":")
+    for key, value in parameters.items():
+        log.debug ( "     "+key+" = "+value)
+    return parameters
+
+def generatesteeringbase(parameters, runs, concatenate):
+    """ Fill the steering file template of a task with the task parameters;
+    returns None if the template could not be found.
+
+    """
+    import os.path
+    log = logging.getLogger('jobsub')
+
+    steeringTmpFileName = os.path.join(parameters["templatepath"], parameters["templatefile"])
+    if not os.path.isfile(steeringTmpFileName):
+        log.critical("Steering file template '"+steeringTmpFileName+"' not found!")
+        return None
+
+    log.debug( "Opening steering file template "+steeringTmpFileName)
+    steeringStringBase = open(steeringTmpFileName, "r").read()
+
+    #Query replace steering template with our parameter set
+    log.debug ("Generating base steering file")
+    for key in parameters.keys():
+        # check if we actually find all parameters from the config in the steering file
+        try:
+            # need not to search for config variables only concerning submission control
+            if (not key == "templatefile" and not key == "templatepath"):
+                # if using concatenation, we have a modified behavior in case the key contains "@RunRange@": then the key is replaced for every run
+                if concatenate and parameters[key].lower().find("@runrange@")>-1:
+                    log.info("Concatenation: Option '" + key + "' contains string '@RunRange@', will fill for all runs of specified range")
+                    runiter = iter(runs)
+                    firstrun = runiter.next() # skip first run to leave one instance of @RunNumber@ in the file for main loop
+                    log.debug("Concatenation: doing substitution for first run: "+str(firstrun))
+                    runkey = ireplace("@runrange@","@RunNumber@",parameters[key]) # insert run placeholder into first key, will be later replaced in main loop
+                    # replace key and add the same key again for next run-through
+                    steeringStringBase = ireplace("@" + key + "@", runkey+" "+"@"+key+"@", steeringStringBase) 
+                    thisrun=runiter.next() 
+                    for nextrun in runiter:
+                        runkey = ireplace("@runrange@",str(thisrun).zfill(6),parameters[key]) # insert run number into key
+                        log.debug("Concatenation: doing substitution for run "+str(thisrun)+" using " + runkey)
+                        steeringStringBase = ireplace("@" + key + "@", runkey+" "+"@"+key+"@", steeringStringBase)
+                        thisrun=nextrun # effectively skipping last, will need special treatment again
+                    # last run: do not add key again
+                    runkey = ireplace("@runrange@",str(thisrun).zfill(6),parameters[key]) # insert run number into key
+                    log.debug("Concatenation: doing substitution for last run "+str(thisrun)+" using " + runkey)
+                    steeringStringBase = ireplace("@" + key + "@", runkey, steeringStringBase)
+                else: # the common case when not concatenating: just replace keyword
+                    steeringStringBase = ireplace("@" + key + "@", parameters[key], steeringStringBase)
+        except EOFError:
+            if (not key == "eutelescopepath" and not key == "home" and not key == "logpath"): # do not warn about default content of config
+                log.warn("Parameter '" + key + "' was not found in template file "+parameters["templatefile"])
+    return steeringStringBase
+
+def writesteeringfile(jobtask, parameters, steeringStringBase, run, parameters_csv):
+    """ Write the steering file of a task for one run; returns the base name
+    of the file written, an empty string if the run has to be skipped or
+    None in case of errors.
+
+    """
+    log = logging.getLogger('jobsub')
+    runnr = str(run).zfill(6)
+    log.info ("Now generating steering file for run number "+runnr+"..")
+
+    # make a copy of the preprocessed steering file content
+    steeringString = steeringStringBase
+
+    # if we have a csv file we can parse, we will lookup the runnumber and replace any
+    # variables identified by the csv header by the run specific value
+    if parameters_csv:
+        try:
+            for field in parameters_csv[run].keys():
+                # check if we actually find all parameters from the csv file in the steering file - warn if not
+                log.debug("Parsing steering file for csv field name '%s'", field)
+                try:
+                    # check that the field name is not empty and do not yet replace the runnumber
+                    if not field == "" and not field == "runnumber":                    
+                        steeringString = ireplace("@" + field + "@", parameters_csv[run][field], steeringString)
+                except EOFError:
+                    log.warn("Parameter '" + field + "' from the csv file was not found in the template file (already overwritten by config file parameters?)")
+        except KeyError:
+            log.warning("Run #" + runnr + " was not found in the specified CSV file - will skip this run! ")
+            return ""
+
+    try:
+        steeringString = ireplace("@RunNumber@", runnr, steeringString)
+    except EOFError:
+        log.error("No reference to run number ('@RunNumber@') found in template file "+parameters["templatefile"])
+        return None
+            
+    if not checkSteer(steeringString):
+        return None
+
+    log.debug ("Writing steering file for run number "+runnr)
+    basefilename = jobtask+"-"+runnr
+    steeringFile = open(basefilename+".xml", "w")
+    try:
+        steeringFile.write(steeringString)
+    finally:
+        steeringFile.close()
+    return basefilename
+
+class SchedulerJob(object):
+    """ One Marlin job of the local scheduler: a task run on one or (when concatenating) several runs """
+    def __init__(self, jobtask, runs, basefilename, logpath):
+        self.jobtask = jobtask
+        self.runs = runs
+        self.basefilename = basefilename
+        self.logpath = logpath
+        self.dependencies = list() # jobs that have to succeed before this one can start
+        self.status = "pending"    # pending, running, done, failed, skipped (dependency failed) or resumed (done before)
+        self.rcode = None
+        self.duration = 0.
+
+def runscheduler(jobs, ncores, silent, statefilename, keepRunning):
+    """ Run a dependency graph of Marlin jobs on the local machine, up to
+    ncores at the same time; jobs whose dependencies failed are
+    skipped. Successful jobs are appended to the state file so that a
+    later call can resume from there. Returns the number of failed
+    jobs.
+
+    """
+    import threading
+    import time
+    log = logging.getLogger('jobsub')
+
+    condition = threading.Condition()
+    running = [0]
+
+    def execute(job):
+        """ run one job in its own thread and report back to the scheduler """
+        start = time.time()
+        rcode = None
+        try:
+            try:
+                rcode = runMarlin(job.basefilename, job.jobtask, silent)
+            except SystemExit: # runMarlin bails out on problems starting Marlin
+                pass
+            zipLogs(job.logpath, job.basefilename)
+        finally:
+            condition.acquire()
+            try:
+                job.duration = time.time() - start
+                job.rcode = rcode
+                if rcode == 0:
+                    job.status = "done"
+                    log.info("Marlin execution done for "+job.basefilename+" (%.0f s)", job.duration)
+                    statefile = open(statefilename, "a")
+                    try:
+                        statefile.write(job.basefilename+"\n")
+                    finally:
+                        statefile.close()
+                else:
+                    job.status = "failed"
+                    log.error("Marlin returned with error code "+str(rcode)+" for "+job.basefilename+"; see the log in "+job.logpath)
+                running[0] -= 1
+                condition.notify()
+            finally:
+                condition.release()
+
+    start = time.time()
+    condition.acquire()
+    try:
+        while True:
+            launched = False
+            for job in jobs:
+                if job.status != "pending":
+                    continue
+                states = [dependency.status for dependency in job.dependencies]
+                if "failed" in states or "skipped" in states:
+                    log.warning("Skipping "+job.basefilename+": a job it depends on did not succeed")
+                    job.status = "skipped"
+                    launched = True # the skip may propagate, check the graph again
+                    continue
+                if keepRunning['Sigint'] == 'seen' or running[0] >= ncores:
+                    continue
+                if [state for state in states if state not in ("done", "resumed")]:
+                    continue
+                job.status = "running"
+                running[0] += 1
+                launched = True
+                thread = threading.Thread(target=execute, args=(job,))
+                thread.daemon = True
+                thread.start()
+            if launched:
+                continue
+            if running[0] == 0:
+                break
+            # wait with a time out, otherwise the SIGINT handler would never be called
+            condition.wait(1.)
+    finally:
+        condition.release()
+    walltime = time.time() - start
+
+    # throughput summary
+    log.info("Scheduler summary (%d cores):", ncores)
+    tasks = list()
+    for job in jobs:
+        if job.jobtask not in tasks:
+            tasks.append(job.jobtask)
+    jobtime = 0.
+    for jobtask in tasks:
+        taskjobs = [job for job in jobs if job.jobtask == jobtask]
+        count = {}
+        for job in taskjobs:
+            count[job.status] = count.get(job.status, 0) + 1
+        tasktime = sum([job.duration for job in taskjobs])
+        jobtime += tasktime
+        log.info("  %-16s %3d done, %3d resumed, %3d failed, %3d skipped, %3d not started, %8.0f s", jobtask,
+                 count.get("done", 0), count.get("resumed", 0), count.get("failed", 0),
+                 count.get("skipped", 0), count.get("pending", 0), tasktime)
+    ndone = len([job for job in jobs if job.status == "done"])
+    log.info("  wall time %.0f s, %d jobs done (%.1f jobs/hour), average parallelism %.1f", walltime, ndone,
+             ndone * 3600. / max(walltime, 1.), jobtime / max(walltime, 1.))
+    failed = [job.basefilename for job in jobs if job.status == "failed"]
+    if failed:
+        log.error("Failed jobs: "+', '.join(failed)+"; fix them and use --resume to process the remaining jobs")
+    return len(failed)
+
 def main(argv=None):
     """  main routine of jobsub: a tool for EUTelescope job submission to Marlin """
     log = logging.getLogger('jobsub') # set up logging
@@ -325,18 +590,24 @@ def main(argv=None):
     handler_stream.setFormatter(formatter)
     log.addHandler(handler_stream)
     # using this decorator, we can count the number of error messages
+    # (the scheduler calls it from several threads at the same time)
     class callcounted(object):
         """Decorator to determine number of calls for a method"""
         def __init__(self,method):
+            import threading
             self.method=method
             self.counter=0
+            self.lock=threading.Lock()
         def __call__(self,*args,**kwargs):
-            self.counter+=1
+            self.lock.acquire()
+            try:
+                self.counter+=1
+            finally:
+                self.lock.release()
             return self.method(*args,**kwargs)
     log.error=callcounted(log.error)
 
     import os.path
-    import ConfigParser
     try:
         import argparse
     except ImportError:
@@ -364,13 +635,17 @@ def main(argv=None):
     parser.add_argument('--option', '-o', action='append', metavar="NAME=VALUE", help="Specify further options such as 'beamenergy=5.3'. This switch be specified several times for multiple options or can parse a comma-separated list of options. This switch overrides any config file options.")
     parser.add_argument("-c", "--conf-file", "--config", help="Load specified config file with global and task specific variables", metavar="FILE")
     parser.add_argument("--concatenate", action="store_true", default=False, help="Modifies run range treatment: concatenate all runs into first run (e.g. to combine runs for alignment) by combining every options that includes the string '@RunRange@' multiple times, once for each run of the range specified.")
+    parser.add_argument("--concatenate-tasks", help="Comma-separated list of the tasks of a chain which concatenate all runs into the first run, as --concatenate does for all tasks (e.g. 'align')", metavar="TASKS")
     parser.add_argument("-csv", "--csv-file", help="Load additional run-specific variables from table (text file in csv format)", metavar="FILE")
     parser.add_argument("--log-file", help="Save submission log to specified file", metavar="FILE")
     parser.add_argument("-l", "--log", default="info", help="Sets the verbosity of log messages during job submission where LEVEL is either debug, info, warning or error", metavar="LEVEL")
     parser.add_argument("-s", "--silent", action="store_true", default=False, help="Suppress non-error (stdout) Marlin output to console")
     parser.add_argument("--dry-run", action="store_true", default=False, help="Write steering files but skip actual Marlin execution")
     parser.add_argument("--plain", action="store_true", default=False, help="Output written to stdout/stderr and log file in prefix-less format i.e. without time stamping")
-    parser.add_argument("jobtask", help="Which task to submit (e.g. convert, hitmaker, align); task names are arbitrary and can be set up by the user; they determine e.g. the config section and default steering file names.")
+    parser.add_argument("-j", "--jobs", type=int, help="Local scheduler mode: run up to N Marlin jobs at the same time on this machine; independent runs and tasks of a chain are processed concurrently", metavar="N")
+    parser.add_argument("--resume", action="store_true", default=False, help="Local scheduler mode: skip the jobs which succeeded in a previous call, as recorded in the state file")
+    parser.add_argument("--state-file", default="jobsub-scheduler.state", help="Local scheduler mode: file recording the jobs which succeeded (default: %(default)s)", metavar="FILE")
+    parser.add_argument("jobtask", help="Which task to submit (e.g. convert, hitmaker, align); task names are arbitrary and can be set up by the user; they determine e.g. the config section and default steering file names. A comma-separated chain of tasks (e.g. 'converter,clustering,hitmaker') is run in order for every run by the local scheduler.")
     parser.add_argument("runs", help="The runs to be analyzed; can be a list of single runs and/or a range, e.g. 1056-1060.", nargs='*')
     args = parser.parse_args(argv)
 
@@ -415,38 +690,25 @@ def main(argv=None):
         log.error("At least one run is specified multiple times!")
         return 2
 
-    # dictionary keeping our parameters
-    # here you can set some minimal default config values that will (possibly) be overwritten by the config file
-    parameters = {"templatepath":".", "templatefile":args.jobtask+"-tmp.xml", "logpath":"."}
+    jobtasks = [jobtask.strip() for jobtask in args.jobtask.split(',') if jobtask.strip()]
+    if not jobtasks:
+        log.error("No task was specified. Please see '"+progName+" --help' for details.")
+        return 2
+    concatenatetasks = list()
+    if args.concatenate_tasks:
+        concatenatetasks = [jobtask.strip() for jobtask in args.concatenate_tasks.split(',')]
+    if args.concatenate:
+        concatenatetasks = list(jobtasks)
+
+    schedulerMode = (len(jobtasks) > 1 or args.jobs is not None)
+    if schedulerMode and args.jobs is None:
+        args.jobs = 1
+    if schedulerMode and args.jobs < 1:
+        log.error("The number of jobs has to be at least 1!")
+        return 2
 
-    # read in config file if specified on command line
-    if args.conf_file:
-        config = ConfigParser.SafeConfigParser()
-        # local variables useful in the context of the config; access using %(NAME)s in config
-        config.set("DEFAULT", "HOME",str(os.environ.get('HOME')))
-        if not os.environ.get('EUTELESCOPE') is None:
-            config.set("DEFAULT", "EUTelescopePath", str(os.environ.get('EUTELESCOPE')))
-        else:
-            log.debug("Environment variable EUTELESCOPE not found; will not be set for steering/config file parsing")
-        try:
-            if not config.read([args.conf_file]): # loads global defaults
-                log.error("Could not read config file '%s'!", args.conf_file)
-                return 1
-            # merge with defaults and create final set of configuration parameters
-            if config.has_section(args.jobtask):
-                parameters.update(dict(config.items(args.jobtask)))
-            else:
-                log.warning("Config file '%s' is missing a section [%s]!", args.conf_file, args.jobtask)
-            log.info("Loaded config file %s", args.conf_file)
-        except ConfigParser.InterpolationMissingOptionError, err: # if interpolation during config parsing fails
-            log.error('Bad value substitution in config file '+str(args.conf_file)+ ": missing '%s' key in section [%s] for option '%s'."%(err.reference, err.section, err.option))
-            if err.reference == "eutelescopepath":
-                log.error('EUTELESCOPE environment variable not set but required in config through "EUTelescopePath" key - please source build_env.sh in EUTelescope top directory or set variable manually.')
-            return 1
-    else:
-        log.warn("No config file specified")
-    
     # Parse option part of the  argument here -> overwriting config options
+    cmdoptions = {}
     if args.option is None:
         log.debug("Nothing to parse: No additional config options specified through command line arguments. ")
     else:
@@ -456,55 +718,100 @@ def main(argv=None):
         except ValueError:
             log.error( "Command line error: cannot parse --option argument(s). Please use a '--option name=value' format. ")
             return 2
-        for key in cmdoptions: # and overwrite our current config settings
-            log.debug( "Parsing cmd line: Setting "+key+" to value '"+cmdoptions[key]+"', possibly overwriting corresponding config file option")
-            parameters[key.lower()] = cmdoptions[key]
 
-    log.debug( "Our final config:")
-    for key, value in parameters.items():
-        log.debug ( "     "+key+" = "+value)
+    # setup mechanism to deal with user pressing ctrl-c in a safe way while we execute marlin later
+    import signal
+    keepRunning = {'Sigint':'no'}
+    def signal_handler(signal, frame):
+        """ log if SIGINT detected, set variable to indicate status """
+        log.critical ('You pressed Ctrl+C!')
+        keepRunning['Sigint'] = 'seen'
 
-    steeringTmpFileName = os.path.join(parameters["templatepath"], parameters["templatefile"])
-    if not os.path.isfile(steeringTmpFileName):
-        log.critical("Steering file template '"+steeringTmpFileName+"' not found!")
-        return 1
+    if schedulerMode:
+        # build the graph: every job depends on the jobs of the previous task sharing a run with it
+        jobs = list()
+        previous = list()
+        for jobtask in jobtasks:
+            parameters = loadparameters(jobtask, args.conf_file, cmdoptions)
+            if parameters is None:
+                return 1
+            concatenate = jobtask in concatenatetasks
+            steeringStringBase = generatesteeringbase(parameters, runs, concatenate)
+            if steeringStringBase is None:
+                return 1
+            taskruns = runs
+            if concatenate:
+                log.info("Concatenating runs into first run for task "+jobtask)
+                taskruns = runs[0:1]
+            parameters_csv = loadparamsfromcsv(args.csv_file, taskruns)
+            current = list()
+            for run in taskruns:
+                basefilename = writesteeringfile(jobtask, parameters, steeringStringBase, run, parameters_csv)
+                if basefilename is None:
+                    return 1
+                if not basefilename:
+                    continue
+                jobruns = [run]
+                if concatenate:
+                    jobruns = list(runs)
+                job = SchedulerJob(jobtask, jobruns, basefilename, parameters["logpath"])
+                job.dependencies = [dependency for dependency in previous if set(dependency.runs) & set(jobruns)]
+                current.append(job)
+            jobs = jobs + current
+            previous = current
+
+        for job in jobs:
+            log.debug("Job "+job.basefilename+" depends on: "+', '.join([dependency.basefilename for dependency in job.dependencies]))
 
-    log.debug( "Opening steering file template "+steeringTmpFileName)
-    steeringStringBase = open(steeringTmpFileName, "r").read()
+        # bail out if running a dry run
+        if args.dry_run:
+            log.info("Dry run: skipping Marlin execution. Steering files written for "+str(len(jobs))+" jobs")
+            return 0
 
-    #Query replace steering template with our parameter set
-    log.debug ("Generating base steering file")
-    for key in parameters.keys():
-        # check if we actually find all parameters from the config in the steering file
-        try:
-            # need not to search for config variables only concerning submission control
-            if (not key == "templatefile" and not key == "templatepath"):
-                # if using concatenation, we have a modified behavior in case the key contains "@RunRange@": then the key is replaced for every run
-                if args.concatenate and parameters[key].lower().find("@runrange@")>-1:
-                    log.info("Concatenation: Option '" + key + "' contains string '@RunRange@', will fill for all runs of specified range")
-                    runiter = iter(runs)
-                    firstrun = runiter.next() # skip first run to leave one instance of @RunNumber@ in the file for main loop
-                    log.debug("Concatenation: doing substitution for first run: "+str(firstrun))
-                    runkey = ireplace("@runrange@","@RunNumber@",parameters[key]) # insert run placeholder into first key, will be later replaced in main loop
-                    # replace key and add the same key again for next run-through
-                    steeringStringBase = ireplace("@" + key + "@", runkey+" "+"@"+key+"@", steeringStringBase) 
-                    thisrun=runiter.next() 
-                    for nextrun in runiter:
-                        runkey = ireplace("@runrange@",str(thisrun).zfill(6),parameters[key]) # insert run number into key
-                        log.debug("Concatenation: doing substitution for run "+str(thisrun)+" using " + runkey)
-                        steeringStringBase = ireplace("@" + key + "@", runkey+" "+"@"+key+"@", steeringStringBase)
-                        thisrun=nextrun # effectively skipping last, will need special treatment again
-                    # last run: do not add key again
-                    runkey = ireplace("@runrange@",str(thisrun).zfill(6),parameters[key]) # insert run number into key
-                    log.debug("Concatenation: doing substitution for last run "+str(thisrun)+" using " + runkey)
-                    steeringStringBase = ireplace("@" + key + "@", runkey, steeringStringBase)
-                else: # the common case when not concatenating: just replace keyword
-                    steeringStringBase = ireplace("@" + key + "@", parameters[key], steeringStringBase)
-        except EOFError:
-            if (not key == "eutelescopepath" and not key == "home" and not key == "logpath"): # do not warn about default content of config
-                log.warn("Parameter '" + key + "' was not found in template file "+parameters["templatefile"])
+        if not check_program("Marlin"):
+            log.error("Marlin executable not found in PATH!")
+            return 1
 
-    if args.concatenate:
+        if args.resume and os.path.isfile(args.state_file):
+            statefile = open(args.state_file, "r")
+            try:
+                succeeded = set([line.strip() for line in statefile])
+            finally:
+                statefile.close()
+            for job in jobs:
+                if job.basefilename in succeeded:
+                    log.info("Resuming: "+job.basefilename+" succeeded before, not running it again")
+                    job.status = "resumed"
+                    os.remove(job.basefilename+".xml") # the archive of the previous execution is kept
+        elif os.path.isfile(args.state_file):
+            os.remove(args.state_file) # a new campaign
+
+        if not args.silent and args.jobs > 1:
+            log.info("Running "+str(args.jobs)+" jobs at the same time: Marlin output only goes to the job logs")
+
+        prevINTHandler = signal.signal(signal.SIGINT, signal_handler)
+        log.info("Will now start processing tasks "+', '.join(jobtasks)+" for the following runs: "+', '.join(map(str, runs)))
+        nfailed = runscheduler(jobs, args.jobs, args.silent or args.jobs > 1, args.state_file, keepRunning)
+
+        # return to the prvious signal handler
+        signal.signal(signal.SIGINT, prevINTHandler)
+        if log.error.counter>0:
+            log.warning("There were "+str(log.error.counter)+" error messages reported")
+        if nfailed > 0:
+            return 1
+        return 0
+
+    jobtask = jobtasks[0]
+    parameters = loadparameters(jobtask, args.conf_file, cmdoptions)
+    if parameters is None:
+        return 1
+
+    concatenate = jobtask in concatenatetasks
+    steeringStringBase = generatesteeringbase(parameters, runs, concatenate)
+    if steeringStringBase is None:
+        return 1
+
+    if concatenate:
         # replace list of runs with first run only
         log.info("Concatenating runs into first run")
         runs = runs[0:1] # slice run list down to first item
@@ -513,13 +820,6 @@ def main(argv=None):
     log.debug ("Loading csv file (if requested)")
     parameters_csv = loadparamsfromcsv(args.csv_file, runs) # store all information needed from the csv file
 
-    # setup mechanism to deal with user pressing ctrl-c in a safe way while we execute marlin later
-    import signal
-    keepRunning = {'Sigint':'no'}
-    def signal_handler(signal, frame):
-        """ log if SIGINT detected, set variable to indicate status """
-        log.critical ('You pressed Ctrl+C!')
-        keepRunning['Sigint'] = 'seen'
     prevINTHandler = signal.signal(signal.SIGINT, signal_handler)
 
     log.info("Will now start processing the following runs: "+', '.join(map(str, runs)))
@@ -529,51 +829,17 @@ def main(argv=None):
             log.critical("Stopping to process remaining runs now")
             break  # if we received ctrl-c (SIGINT) we stop processing here
 
-        runnr = str(run).zfill(6)
-        log.info ("Now generating steering file for run number "+runnr+"..")
-
-        # make a copy of the preprocessed steering file content
-        steeringString = steeringStringBase
-
-        # if we have a csv file we can parse, we will lookup the runnumber and replace any
-        # variables identified by the csv header by the run specific value
-        if parameters_csv:
-            try:
-                for field in parameters_csv[run].keys():
-                    # check if we actually find all parameters from the csv file in the steering file - warn if not
-                    log.debug("Parsing steering file for csv field name '%s'", field)
-                    try:
-                        # check that the field name is not empty and do not yet replace the runnumber
-                        if not field == "" and not field == "runnumber":                    
-                            steeringString = ireplace("@" + field + "@", parameters_csv[run][field], steeringString)
-                    except EOFError:
-                        log.warn("Parameter '" + field + "' from the csv file was not found in the template file (already overwritten by config file parameters?)")
-            except KeyError:
-                log.warning("Run #" + runnr + " was not found in the specified CSV file - will skip this run! ")
-                continue
-
-        try:
-            steeringString = ireplace("@RunNumber@", runnr, steeringString)
-        except EOFError:
-            log.error("No reference to run number ('@RunNumber@') found in template file "+steeringTmpFileName)
-            return 1
-                
-        if not checkSteer(steeringString):
+        basefilename = writesteeringfile(jobtask, parameters, steeringStringBase, run, parameters_csv)
+        if basefilename is None:
             return 1
-
-        log.debug ("Writing steering file for run number "+runnr)
-        basefilename = args.jobtask+"-"+runnr
-        steeringFile = open(basefilename+".xml", "w")
-        try:
-            steeringFile.write(steeringString)
-        finally:
-            steeringFile.close()
+        if not basefilename:
+            continue
 
         # bail out if running a dry run
         if args.dry_run:
             log.info("Dry run: skipping Marlin execution. Steering file written to "+basefilename+'.xml')
         else:
-            rcode = runMarlin(basefilename, args.jobtask, args.silent) # start Marlin execution
+            rcode = runMarlin(basefilename, jobtask, args.silent) # start Marlin execution
             if rcode == 0:
                 log.info("Marlin execution done")
             else:
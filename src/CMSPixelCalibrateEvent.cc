@@ -67,6 +67,9 @@
 #include <memory>
 #include <TMath.h>
 #include <vector>
+#include <map>
+#include <cmath>
+#include <climits>
 
 using namespace std;
 using namespace lcio;
@@ -102,6 +105,8 @@ CMSPixelCalibrateEventProcessor::CMSPixelCalibrateEventProcessor () :Processor("
     registerProcessorParameter ("calibrationType", "Switch between calibration input data types phCalibration (0)  and Gaintanh calibration (1).",
                               _phCalibration, static_cast< bool > ( 1 ) );
 	registerProcessorParameter("HistogramFilling","Switch on or off the histogram filling", _fillHistos, static_cast< bool > ( false ) );
+    registerOptionalParameter ("CalibrationCacheSizekB", "Memory budget in kB of the per pixel ADC to Vcal lookup tables. Pixels sharing the same parameters share the table, pixels not fitting in the budget are calibrated evaluating the function. 0 switches the tables off.",
+                              _calibrationCacheSizekB, static_cast< int > ( 0 ) );
 	
 }
 
@@ -309,6 +314,97 @@ void CMSPixelCalibrateEventProcessor::initializeGaintanhCalibration() throw ( ma
     streamlog_out( MESSAGE5 ) << endl;
 }
 
+void CMSPixelCalibrateEventProcessor::initializeCalibrationCache() {
+
+    _calibrationCache.clear();
+    _calibrationTable.clear();
+    _calibrationClasses.clear();
+
+    // Only the ATanH calibration is implemented, the others always fail:
+    if(_calibrationCacheSizekB <= 0 || !_phCalibration) return;
+
+    // The tables themselves are built on the first hit of each pixel:
+    cal_cache_entry notBuilt = { 0, -1, kCacheNotBuilt };
+    for(unsigned int i = 0; i < calibration.size(); i++) {
+        _calibrationCache.push_back( std::vector< cal_cache_entry >( calibration[i].size(), notBuilt ) );
+    }
+
+    streamlog_out( MESSAGE5 ) << "Calibration lookup tables enabled with " << _calibrationCacheSizekB << " kB budget" << endl;
+
+}
+
+
+CMSPixelCalibrateEventProcessor::cal_cache_entry CMSPixelCalibrateEventProcessor::buildCacheEntry(const cal_param& param) {
+
+    std::map< cal_param, cal_cache_entry, cal_param_less >::iterator found = _calibrationClasses.find(param);
+    if(found != _calibrationClasses.end()) return found->second;
+
+    cal_cache_entry entry = { 0, -1, 0 };
+
+    // Signals outside ]p3 - |p2|, p3 + |p2|[ are out of the ATanH range.
+    // Scan one count more on each side and then trim the invalid ends:
+    // (y-p3)/p2 is monotonic in y, so the valid signals are an interval.
+    double halfWidth = fabs(param.par2);
+    double low  = floor(param.par3 - halfWidth) - 1;
+    double high = ceil(param.par3 + halfWidth) + 1;
+    if(!(low  >= SHRT_MIN)) low  = SHRT_MIN;
+    if(!(high <= SHRT_MAX)) high = SHRT_MAX;
+
+    double corr;
+    int first = static_cast< int >(low);
+    int last  = static_cast< int >(high);
+    while(first <= last && !calTanH(corr, first, param.par0, param.par1, param.par2, param.par3)) ++first;
+    while(last >= first && !calTanH(corr, last, param.par0, param.par1, param.par2, param.par3)) --last;
+
+    if(first <= last) {
+        size_t budget = static_cast< size_t >(_calibrationCacheSizekB) * 1024 / sizeof(short);
+        size_t length = static_cast< size_t >(last - first + 1);
+
+        if(_calibrationTable.size() + length > budget) {
+            entry.offset = kCacheDirect;
+        } else {
+            entry.firstSignal = first;
+            entry.lastSignal  = last;
+            entry.offset      = static_cast< int >(_calibrationTable.size());
+            for(int y = first; y <= last; y++) {
+                calTanH(corr, y, param.par0, param.par1, param.par2, param.par3);
+                _calibrationTable.push_back( static_cast< short >(corr) );
+            }
+        }
+    }
+
+    _calibrationClasses.insert( make_pair(param, entry) );
+    return entry;
+
+}
+
+
+bool CMSPixelCalibrateEventProcessor::calibrate(short &corr, unsigned int iROC, int iPix, short signal) {
+
+    const cal_param& param = calibration[iROC][iPix];
+
+    if(!_calibrationCache.empty()) {
+        cal_cache_entry& entry = _calibrationCache[iROC][iPix];
+        if(entry.offset == kCacheNotBuilt) entry = buildCacheEntry(param);
+
+        if(entry.offset != kCacheDirect) {
+            if(signal < entry.firstSignal || signal > entry.lastSignal) return false;
+            corr = _calibrationTable[entry.offset + signal - entry.firstSignal];
+            return true;
+        }
+    }
+
+    double value;
+    bool rangecheck;
+    if(_phCalibration) rangecheck = calTanH(value, signal, param.par0, param.par1, param.par2, param.par3);
+    else rangecheck = calWeibull(value, signal);
+
+    if(rangecheck) corr = static_cast< short >(value);
+    return rangecheck;
+
+}
+
+
 void CMSPixelCalibrateEventProcessor::init () {
 
     printParameters ();
@@ -323,6 +419,7 @@ void CMSPixelCalibrateEventProcessor::init () {
     // Initialize Calibration:
     if(_phCalibration) initializeCalibration();
     else initializeGaintanhCalibration();
+    initializeCalibrationCache();
     
     // Book histogramms:
     if ( _fillHistos ) bookHistos();
@@ -387,13 +484,11 @@ void CMSPixelCalibrateEventProcessor::processEvent (LCEvent * event) {
                 
                 int iPix = Pixel.getXCoord()*_noOfYPixel + Pixel.getYCoord();
 
-                double corrected;
-		bool rangecheck = true;
-                if(_phCalibration) rangecheck = calTanH(corrected,Pixel.getSignal(),calibration[iDetector][iPix].par0,calibration[iDetector][iPix].par1,calibration[iDetector][iPix].par2,calibration[iDetector][iPix].par3);
-		else rangecheck = calWeibull(corrected,Pixel.getSignal());
+                short corrected;
+		bool rangecheck = calibrate(corrected, iDetector, iPix, Pixel.getSignal());
                 
 	        if(rangecheck) {
-		  correctedPixel->setSignal( static_cast< short int >(corrected));
+		  correctedPixel->setSignal( corrected );
                     
                     // Filling histogramms if needed:
                		if ( _fillHistos ) fillHistos ( static_cast< int >(Pixel.getSignal()), static_cast< int >(correctedPixel->getSignal()), iDetector );
@@ -437,6 +532,10 @@ void CMSPixelCalibrateEventProcessor::check (LCEvent * /* evt */ ) {
 
 void CMSPixelCalibrateEventProcessor::end() {
 
+    if(!_calibrationCache.empty()) {
+        streamlog_out ( MESSAGE5 ) << "Calibration lookup tables: " << _calibrationClasses.size() << " pixel classes in "
+                                   << _calibrationTable.size() * sizeof(short) / 1024 << " kB" << endl;
+    }
     streamlog_out ( MESSAGE5 ) <<  "Successfully finished" << endl;
 }
 
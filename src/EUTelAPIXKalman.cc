@@ -137,7 +137,12 @@ EUTelAPIXKalman::EUTelAPIXKalman ()
   _maxChi2(0.0),
   _fitter(NULL),
   _zSort(),
-  _planeHits(),
+  _planeHitX(),
+  _planeHitY(),
+  _planeErrX(),
+  _planeErrY(),
+  _planeGate(),
+  _estimatePool(),
   _checkInTime(false),
   _nTracks(0),
   _expectedTracks(0),
@@ -233,7 +238,11 @@ void EUTelAPIXKalman::init() {
     _zSort[ _siPlanesLayerLayout->getLayerPositionZ(plane) ] = plane;
   }
   //Making space for all hits
-  _planeHits.resize( _zSort.size() );
+  _planeHitX.resize( _zSort.size() );
+  _planeHitY.resize( _zSort.size() );
+  _planeGate.resize( _zSort.size() );
+  _planeErrX.clear();
+  _planeErrY.clear();
   //If we do not want to use supplied resolution, make sure vector is empty
   if(_useHitResol){ _telescopeResolution.clear();}
   //The fitter is implemented in the APIXFitter namespace
@@ -249,6 +258,8 @@ void EUTelAPIXKalman::init() {
     }
     double errX = _telescopeResolution.at(index);
     double errY = _telescopeResolution.at(index);
+    _planeErrX.push_back( errX );
+    _planeErrY.push_back( sensorID > 7 ? 8.0 * errY : errY );
 
     bool excluded = (find(_excludePlanes.begin(), _excludePlanes.end(), sensorID)
 		     != _excludePlanes.end());
@@ -262,6 +273,10 @@ void EUTelAPIXKalman::init() {
     pl->print();
     _fitter->addPlane(index, pl);
   }
+  //One estimate per depth of the permutation search, plus the seed
+  for(size_t depth = 0; depth <= _zSort.size(); depth++){
+    _estimatePool.push_back(new TrackEstimate());
+  }
   if(nActive - _nSkipMax  < 2) {
     streamlog_out ( ERROR5 ) << "Too few active planes(" << nActive << ") when " << _nSkipMax << " planes can be skipped." 
 			    << "Please check your configuration." << endl;
@@ -316,8 +331,11 @@ int EUTelAPIXKalman::getPlaneIndex(double zPos){
 }
 
 void EUTelAPIXKalman::readHitCollection(LCEvent* event){
-  //Clear _planeHits
-  for(int ii = 0; ii < static_cast< int >(_planeHits.size()); ii++){ _planeHits.at(ii).clear();}
+  //Clear the staged hits
+  for(int ii = 0; ii < static_cast< int >(_planeHitX.size()); ii++){
+    _planeHitX.at(ii).clear();
+    _planeHitY.at(ii).clear();
+  }
   //Extract hits from collection, add to 
   LCCollection* collection;
   for(size_t i =0;i < _hitCollectionName.size();i++){
@@ -352,7 +370,11 @@ void EUTelAPIXKalman::readHitCollection(LCEvent* event){
 	//cluster->getClusterSize(xSize, ySize);
 	//if( xSize != 2 ) { continue; }
       }
-      if(planeIndex >=0 ) { _planeHits.at(planeIndex).push_back( hit );}
+      if(planeIndex >=0 ) {
+	//Fitter uses microns, framework uses mm
+	_planeHitX.at(planeIndex).push_back( hit->getPosition()[0] * 1000.0 );
+	_planeHitY.at(planeIndex).push_back( hit->getPosition()[1] * 1000.0 );
+      }
     }
   }
 }
@@ -375,10 +397,9 @@ void EUTelAPIXKalman::processEvent (LCEvent * event) {
     _fittrackvec->setFlag(flag.getFlag());
   }
   // Run the fit
-  TrackEstimate* estim = new TrackEstimate();
+  TrackEstimate* estim = _estimatePool.at(0);
   estim->makeSeed();
   fitPermutations(0, NULL, estim, 0);
-  delete estim;
   //Plot number of found tracks
   tryFill( _numberTracksLocalname, _nTracks);
   if(_addToLCIO){ event->addCollection(_fittrackvec,_trackCollectionName); }
@@ -389,7 +410,7 @@ void EUTelAPIXKalman::processEvent (LCEvent * event) {
 void EUTelAPIXKalman::fitPermutations(int plane, FitPlane* prev, TrackEstimate* est, int nSkipped){
   //Got track?
   if(_nTracks > 15) { return; }
-  if(plane == static_cast< int >(_planeHits.size())){
+  if(plane == static_cast< int >(_planeHitX.size())){
     finalizeTrack();
     return;
   }
@@ -410,44 +431,62 @@ void EUTelAPIXKalman::fitPermutations(int plane, FitPlane* prev, TrackEstimate*
   bool isSeed = (gsl_vector_get(est->param, 0) == 0.0) and (gsl_vector_get(est->param, 1) == 0.0);
   //How many tracks are found before this track candidate has been fully checked?
   int tmpNtracks = _nTracks;
-  for(uint hit = 0; hit < _planeHits.at(plane).size(); hit++){
-    addPlaneHit(cur, _planeHits.at(plane).at(hit));
-    //Check normalized residuals if estimate is a real prediction
-    if( (not isSeed) ){ 
-      if( fabs( gsl_vector_get(est->param, 0) - cur->hitPosX)/cur->errX > _normalizedResidualsMax ) continue;
-      if( fabs( gsl_vector_get(est->param, 1) - cur->hitPosY)/cur->errY > _normalizedResidualsMax ) continue;
-    }
-    //Since a track candidate can branch out, we need to clone the estimate in order to not
-    //contaminate the other track candidates
-    TrackEstimate* clone = new TrackEstimate();
+  //Check normalized residuals of all hits at once if estimate is a real prediction
+  int nGood = 0;
+  if( isSeed ){
+    nGood = static_cast< int >(_planeHitX.at(plane).size());
+    _planeGate.at(plane).resize( max(nGood, static_cast< int >(_planeGate.at(plane).size())) );
+    for(int hit = 0; hit < nGood; hit++){ _planeGate.at(plane)[hit] = hit; }
+  } else {
+    nGood = gatePlaneHits(plane, est);
+  }
+  //Since a track candidate can branch out, we need to clone the estimate in order to not
+  //contaminate the other track candidates. The clone of this depth is reused for every hit.
+  TrackEstimate* clone = _estimatePool.at(plane + 1);
+  for(int good = 0; good < nGood; good++){
+    setPlaneHit(cur, _planeGate.at(plane)[good]);
     if(plane == 0){ clone->makeSeed(); }
     else { clone->copy(est);}
     _fitter->update(cur, clone);
     fitPermutations(plane + 1, cur, clone, nSkipped);
-    delete clone;
   }
   //If no measurement in this plane lead to an accepted track, try to skip this plane by
   //temporarily excluding this plane. Note, this will only work right when we expect at most
   //one track per trigger. For APIX data this is the case.
   if( (_nTracks == tmpNtracks)  and nSkipped < _nSkipMax){
+    //As before the gating, the skipped plane keeps its last hit
+    if( not _planeHitX.at(plane).empty() ){ setPlaneHit(cur, static_cast< int >(_planeHitX.at(plane).size()) - 1); }
     cur->excluded = true;
     _fitter->update(cur, est);
     fitPermutations(plane + 1, cur, est, nSkipped + 1);
     cur->excluded = false;
   }
 }
-void EUTelAPIXKalman::addPlaneHit(FitPlane* pl, TrackerHitImpl* hit){
-  const double * pos = hit->getPosition();
-  //Fitter uses microns, framework uses mm
-  pl->hitPosX = pos[0] * 1000.0;
-  pl->hitPosY = pos[1] * 1000.0;
-
-  pl->errX = _telescopeResolution.at( pl->index);
-  pl->errY = _telescopeResolution.at( pl->index);
-  if(pl->sensorID > 7){
-    pl->errY = _telescopeResolution.at( pl->index) * 8.0;
+int EUTelAPIXKalman::gatePlaneHits(int plane, TrackEstimate* est){
+  //Normalized residual cut on all the hits of the plane, without branching, then
+  //compaction of the indices of the hits passing it
+  const vector<double>& hitX = _planeHitX.at(plane);
+  const vector<double>& hitY = _planeHitY.at(plane);
+  vector<int>& gate = _planeGate.at(plane);
+  const int nHits = static_cast< int >(hitX.size());
+  if( static_cast< int >(gate.size()) < nHits ){ gate.resize(nHits); }
+  const double estX = gsl_vector_get(est->param, 0);
+  const double estY = gsl_vector_get(est->param, 1);
+  const double cutX = _normalizedResidualsMax * _planeErrX.at(plane);
+  const double cutY = _normalizedResidualsMax * _planeErrY.at(plane);
+  int nGood = 0;
+  for(int hit = 0; hit < nHits; hit++){
+    gate[nGood] = hit;
+    nGood += (fabs(estX - hitX[hit]) <= cutX) & (fabs(estY - hitY[hit]) <= cutY);
   }
-  
+  return(nGood);
+}
+
+void EUTelAPIXKalman::setPlaneHit(FitPlane* pl, int hit){
+  pl->hitPosX = _planeHitX.at(pl->index)[hit];
+  pl->hitPosY = _planeHitY.at(pl->index)[hit];
+  pl->errX = _planeErrX.at(pl->index);
+  pl->errY = _planeErrY.at(pl->index);
   // if(not _useHitResol) { return; }
   // //If _useHitResol and non singular hit error matrix, extract errors from hit.
   // const EVENT::FloatVec cov = hit->getCovMatrix();
@@ -456,7 +495,7 @@ void EUTelAPIXKalman::addPlaneHit(FitPlane* pl, TrackerHitImpl* hit){
 }
 void EUTelAPIXKalman::addToMille(){
   const int nLC = 4; //number of local parameters
-  const int nGL = _planeHits.size() * 5; // number of global parameters
+  const int nGL = _planeHitX.size() * 5; // number of global parameters
 
   float *derLC = new float[nLC]; // array of derivatives for local parameters
   float *derGL = new float[nGL]; // array of derivatives for global parameters
@@ -530,8 +569,8 @@ bool EUTelAPIXKalman::goodResiduals(FitPlane* pl){
 bool EUTelAPIXKalman::inTimeGood(FitPlane* pl){
   //Check if track is intime with plane using residuals
   if(find (_inTimeCheck.begin(), _inTimeCheck.end(), pl->sensorID) == _inTimeCheck.end()){ return(false);}
-  for(int hit = 0; hit < static_cast< int >(_planeHits.at(pl->index).size()); hit++ ){
-    addPlaneHit(pl, _planeHits.at(pl->index).at(hit));
+  for(int hit = 0; hit < static_cast< int >(_planeHitX.at(pl->index).size()); hit++ ){
+    setPlaneHit(pl, hit);
     if( goodResiduals(pl) ){ return(true); }
   }
   return(false);
@@ -1003,5 +1042,7 @@ void EUTelAPIXKalman::end() {
   streamlog_out ( MESSAGE5 ) << "Number of tracks used: " << _nMilleTracks << endl;
   streamlog_out ( MESSAGE5 ) << endl;
   streamlog_out ( MESSAGE5 ) << "Successfully finished" << endl << flush << flush;
+  for(size_t depth = 0; depth < _estimatePool.size(); depth++){ delete _estimatePool.at(depth); }
+  _estimatePool.clear();
 }
 #endif // USE_GEAR
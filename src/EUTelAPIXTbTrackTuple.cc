@@ -35,6 +35,9 @@
 
 #include <UTIL/CellIDEncoder.h>
 
+// ROOT includes
+#include <TTree.h>
+
 //TbTrack include
 #include <algorithm>
 #include <gsl/gsl_blas.h>
@@ -72,6 +75,10 @@ EUTelAPIXTbTrackTuple::EUTelAPIXTbTrackTuple()
   _dutZsColName(""),
   _clusterBased(false),
   _path2file(""),
+  _tupleBasketSize(32000),
+  _tupleAutoFlush(-30000000),
+  _tupleRowsPerBlock(1000),
+  _tupleBackgroundWriting(false),
   _referenceHitCollectionName(""),
   _referenceHitVec(NULL),
   _nRun (0),
@@ -80,6 +87,7 @@ EUTelAPIXTbTrackTuple::EUTelAPIXTbTrackTuple()
   _evtNr(0),
   _isFirstEvent(false),
   _file(NULL),
+  _columnBindings(),
   _eutracks(NULL),
   _nTrackParams(0),
   _xPos(NULL),
@@ -177,6 +185,19 @@ EUTelAPIXTbTrackTuple::EUTelAPIXTbTrackTuple()
   registerProcessorParameter ("DoScales",
 			      "If true assume alignment corrections uses scales, if false assume full rotations",
 			      _doScales, true);
+
+  registerOptionalParameter ("TupleBasketSize",
+			     "Basket size in bytes of the output branches",
+			     _tupleBasketSize, static_cast < int > (32000));
+  registerOptionalParameter ("TupleAutoFlush",
+			     "Auto flush of the output trees: entries if positive, bytes if negative",
+			     _tupleAutoFlush, static_cast < int > (-30000000));
+  registerOptionalParameter ("TupleRowsPerBlock",
+			     "Number of events buffered before being handed to the tree writer",
+			     _tupleRowsPerBlock, static_cast < int > (1000));
+  registerOptionalParameter ("TupleBackgroundWriting",
+			     "If true the trees are filled and compressed on a background thread (see EUTelTupleFile::setBackgroundWriting)",
+			     _tupleBackgroundWriting, false);
 }
 
 
@@ -277,10 +298,10 @@ void EUTelAPIXTbTrackTuple::processEvent( LCEvent * event ) {
   if (_clusterBased) setClusterIdInHits();
 
   /* Filling tree */
-  _zstree->Fill();
-  _eutracks->Fill();
-  _clutree->Fill();
-   if (_clusterBased) _euhits->Fill();
+  fillTree(_zstree);
+  fillTree(_eutracks);
+  fillTree(_clutree);
+   if (_clusterBased) fillTree(_euhits);
 
    if( _isFirstEvent )
    {
@@ -290,8 +311,10 @@ void EUTelAPIXTbTrackTuple::processEvent( LCEvent * event ) {
 }
 
 void EUTelAPIXTbTrackTuple::end(){
-  message<DEBUG5> ( log() << "N-tuple with " << _zstree->GetEntries() << " entries written to" << _path2file.c_str() <<",");
-  _file->Write();
+  message<DEBUG5> ( log() << "N-tuple with " << _zstree->rows() << " entries written to" << _path2file.c_str() <<",");
+  _file->close();
+  delete _file;
+  _file = NULL;
 }
 
 void EUTelAPIXTbTrackTuple::setClusterIdInHits() {
@@ -1000,7 +1023,11 @@ void EUTelAPIXTbTrackTuple::readAlignment(LCEvent* event){
 }
 
 void EUTelAPIXTbTrackTuple::prepareTree(){
-  _file = new TFile(_path2file.c_str(),"RECREATE");
+  _file = new EUTelTupleFile(_path2file);
+  _file->setBasketSize(_tupleBasketSize);
+  _file->setAutoFlush(_tupleAutoFlush);
+  _file->setRowsPerBlock(_tupleRowsPerBlock);
+  _file->setBackgroundWriting(_tupleBackgroundWriting);
    streamlog_out ( DEBUG5 )  << "Writing to: " << _path2file.c_str() << endl;
   //Old school tbtrack tree
 
@@ -1043,63 +1070,97 @@ void EUTelAPIXTbTrackTuple::prepareTree(){
   _rotXY = new vector<double>();
   _rotZX = new vector<double>();
   _rotZY = new vector<double>();
+  _alpha = new vector<double>();
+  _beta = new vector<double>();
+  _gamma = new vector<double>();
+  _rotXYerr = new vector<double>();
+  _rotZXerr = new vector<double>();
+  _rotZYerr = new vector<double>();
   
-  _euhits = new TTree("euhits","euhits");
-  _euhits->Branch("nHits", &_nHits);
-  _euhits->Branch("xPos", &_hitXPos);
-  _euhits->Branch("yPos", &_hitYPos);
-  _euhits->Branch("zPos", &_hitZPos);
-  _euhits->Branch("clusterId", &_hitClusterId);
-  _euhits->Branch("sensorId", &_hitSensorId);
+  _euhits = _file->addTree("euhits", "euhits");
+  bindColumn(_euhits, "nHits", &_nHits);
+  bindColumn(_euhits, "xPos", &_hitXPos);
+  bindColumn(_euhits, "yPos", &_hitYPos);
+  bindColumn(_euhits, "zPos", &_hitZPos);
+  bindColumn(_euhits, "clusterId", &_hitClusterId);
+  bindColumn(_euhits, "sensorId", &_hitSensorId);
       
-  _zstree = new TTree("zspix", "zspix");
-  _zstree->Branch("nPixHits", &_nPixHits);
-  _zstree->Branch("euEvt",    &_nEvt);
-  _zstree->Branch("col",      &p_col);
-  _zstree->Branch("row",      &p_row);
-  _zstree->Branch("tot",      &p_tot);
-  _zstree->Branch("lv1",      &p_lv1);
-  _zstree->Branch("iden",     &p_iden);
-  _zstree->Branch("chip",     &p_chip);
-  _zstree->Branch("clusterId",&p_clusterId);
+  _zstree = _file->addTree("zspix", "zspix");
+  bindColumn(_zstree, "nPixHits", &_nPixHits);
+  bindColumn(_zstree, "euEvt", &_nEvt);
+  bindColumn(_zstree, "col", &p_col);
+  bindColumn(_zstree, "row", &p_row);
+  bindColumn(_zstree, "tot", &p_tot);
+  bindColumn(_zstree, "lv1", &p_lv1);
+  bindColumn(_zstree, "iden", &p_iden);
+  bindColumn(_zstree, "chip", &p_chip);
+  bindColumn(_zstree, "clusterId", &p_clusterId);
   //Tree for storing all track param info
-  _eutracks = new TTree("eutracks", "eutracks");
-  _eutracks->Branch("nTrackParams", &_nTrackParams);
-  _eutracks->Branch("euEvt", &_nEvt);
-  _eutracks->Branch("xPos", &_xPos);
-  _eutracks->Branch("yPos", &_yPos);
-  _eutracks->Branch("dxdz", &_dxdz);
-  _eutracks->Branch("dydz", &_dydz);
-  _eutracks->Branch("trackNum", &_trackNum);
-  _eutracks->Branch("iden", &_trackIden);
-  _eutracks->Branch("chi2", &_chi2);
-  _eutracks->Branch("ndof", &_ndof);
+  _eutracks = _file->addTree("eutracks", "eutracks");
+  bindColumn(_eutracks, "nTrackParams", &_nTrackParams);
+  bindColumn(_eutracks, "euEvt", &_nEvt);
+  bindColumn(_eutracks, "xPos", &_xPos);
+  bindColumn(_eutracks, "yPos", &_yPos);
+  bindColumn(_eutracks, "dxdz", &_dxdz);
+  bindColumn(_eutracks, "dydz", &_dydz);
+  bindColumn(_eutracks, "trackNum", &_trackNum);
+  bindColumn(_eutracks, "iden", &_trackIden);
+  bindColumn(_eutracks, "chi2", &_chi2);
+  bindColumn(_eutracks, "ndof", &_ndof);
   //TTree for cluster info
-  _clutree = new TTree("euclusters", "euclusters");
-  _clutree->Branch("euEvt", &_nEvt);
-  _clutree->Branch("size", &_clusize);
-  _clutree->Branch("sizeX", &_clusizeX);
-  _clutree->Branch("sizeY", &_clusizeY);
-  _clutree->Branch("posX", &_cluposX);
-  _clutree->Branch("posY", &_cluposY);
-  _clutree->Branch("charge", &_clucharge);
-  _clutree->Branch("iden", &_cluSensorId);
-  _clutree->Branch("ID", &_cluClusterId);
+  _clutree = _file->addTree("euclusters", "euclusters");
+  bindColumn(_clutree, "euEvt", &_nEvt);
+  bindColumn(_clutree, "size", &_clusize);
+  bindColumn(_clutree, "sizeX", &_clusizeX);
+  bindColumn(_clutree, "sizeY", &_clusizeY);
+  bindColumn(_clutree, "posX", &_cluposX);
+  bindColumn(_clutree, "posY", &_cluposY);
+  bindColumn(_clutree, "charge", &_clucharge);
+  bindColumn(_clutree, "iden", &_cluSensorId);
+  bindColumn(_clutree, "ID", &_cluClusterId);
   //TTree for DUT rot info
-  _rottree = new TTree("DUTrotation", "DUTrotation");
-  _rottree->Branch("ID", &_rotDUTId);
-  _rottree->Branch("Alpha", &_alpha);
-  _rottree->Branch("Beta", &_beta);
-  _rottree->Branch("Gamma", &_gamma);
-  _rottree->Branch("RotXY", &_rotXY);
-  _rottree->Branch("RotZX", &_rotZX);
-  _rottree->Branch("RotZY", &_rotZY);
-  _rottree->Branch("RotXYErr", &_rotXYerr);
-  _rottree->Branch("RotZXErr", &_rotZXerr);
-  _rottree->Branch("RotZYErr", &_rotZYerr);
+  _rottree = _file->addTree("DUTrotation", "DUTrotation");
+  bindColumn(_rottree, "ID", &_rotDUTId);
+  bindColumn(_rottree, "Alpha", &_alpha);
+  bindColumn(_rottree, "Beta", &_beta);
+  bindColumn(_rottree, "Gamma", &_gamma);
+  bindColumn(_rottree, "RotXY", &_rotXY);
+  bindColumn(_rottree, "RotZX", &_rotZX);
+  bindColumn(_rottree, "RotZY", &_rotZY);
+  bindColumn(_rottree, "RotXYErr", &_rotXYerr);
+  bindColumn(_rottree, "RotZXErr", &_rotZXerr);
+  bindColumn(_rottree, "RotZYErr", &_rotZYerr);
   
-  _euhits->AddFriend(_clutree);
-  _euhits->AddFriend(_zstree);
+  _euhits->tree()->AddFriend(_clutree->tree());
+  _euhits->tree()->AddFriend(_zstree->tree());
+
+  _file->start();
+}
+
+void EUTelAPIXTbTrackTuple::bindColumn(EUTelTupleTree * tree, const std::string& name, const int * value){
+  ColumnBinding binding = { tree, tree->addColumn(name, EUTelTupleTree::kInt), value, NULL, NULL };
+  _columnBindings.push_back(binding);
+}
+
+void EUTelAPIXTbTrackTuple::bindColumn(EUTelTupleTree * tree, const std::string& name, std::vector<int> * const * value){
+  ColumnBinding binding = { tree, tree->addColumn(name, EUTelTupleTree::kIntVector), NULL, value, NULL };
+  _columnBindings.push_back(binding);
+}
+
+void EUTelAPIXTbTrackTuple::bindColumn(EUTelTupleTree * tree, const std::string& name, std::vector<double> * const * value){
+  ColumnBinding binding = { tree, tree->addColumn(name, EUTelTupleTree::kDoubleVector), NULL, NULL, value };
+  _columnBindings.push_back(binding);
+}
+
+void EUTelAPIXTbTrackTuple::fillTree(EUTelTupleTree * tree){
+  for( size_t i = 0; i < _columnBindings.size(); ++i ) {
+    const ColumnBinding& binding = _columnBindings[i];
+    if( binding.tree != tree ) continue;
+    if( binding.intValue != NULL )          tree->fill(binding.column, *binding.intValue);
+    else if( binding.intVector != NULL )    tree->fill(binding.column, **binding.intVector);
+    else                                    tree->fill(binding.column, **binding.doubleVector);
+  }
+  tree->addRow();
 }
 
 void EUTelAPIXTbTrackTuple::getDUTRot(EUTelAlignmentConstant * alignment){
@@ -1142,6 +1203,6 @@ void EUTelAPIXTbTrackTuple::getDUTRot(EUTelAlignmentConstant * alignment){
   //fill tree omly once
   //first plane has no alignment
   if ((_countrotstored + 1) == _siPlanesParameters->getSiPlanesNumber()){
-    _rottree->Fill();
+    fillTree(_rottree);
   }
 }
@@ -0,0 +1,334 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelAlignmentCache.h"
+
+// system includes <>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace eutelescope;
+
+const char * const EUTelAlignmentCache::tag    = "EUTALC3";
+const char * const EUTelAlignmentCache::endTag = "EUTALEND";
+
+namespace {
+
+  const size_t tagSize = 8;
+
+  //! Size rounded up to a multiple of 8 bytes
+  size_t padded(size_t size) {
+    return ( size + 7 ) & ~static_cast< size_t >( 7 );
+  }
+
+  void writePadding(FILE * file, size_t size) {
+    static const char zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    if ( padded( size ) != size ) fwrite( zeros, 1, padded( size ) - size, file );
+  }
+
+  void writeTag(FILE * file, const char * tag) {
+    char record[tagSize];
+    memset( record, 0, tagSize );
+    memcpy( record, tag, strlen( tag ) < tagSize ? strlen( tag ) : tagSize );
+    fwrite( record, 1, tagSize, file );
+  }
+
+  std::string temporaryName(const std::string & filename) {
+    return filename + ".tmp";
+  }
+
+  //! Rotate (a, b) by angle, as TVector3 does around the third axis
+  void rotate(double & a, double & b, double angle) {
+    const double c = cos( angle );
+    const double s = sin( angle );
+    const double rotated = c * a - s * b;
+    b = s * a + c * b;
+    a = rotated;
+  }
+
+}
+
+void EUTelAlignmentCache::applyAlignment(double position[3], const double centre[3],
+                                         double alpha, double beta, double gamma, const double offset[3]) {
+
+  // x_refhit in EUTelApplyAlignmentProcessor
+  double pivot[3];
+  for ( int i = 0; i < 3; ++i ) pivot[i] = centre[i] + offset[i];
+
+  double x = position[0] - pivot[0];
+  double y = position[1] - pivot[1];
+  double z = position[2] - pivot[2];
+  rotate( y, z, - alpha );
+  rotate( z, x, - beta  );
+  rotate( x, y, - gamma );
+
+  position[0] = pivot[0] + x - offset[0];
+  position[1] = pivot[1] + y - offset[1];
+  position[2] = pivot[2] + z - offset[2];
+}
+
+EUTelAlignmentCacheWriter::EUTelAlignmentCacheWriter() :
+  _file(NULL),
+  _filename(),
+  _nPlanes(0),
+  _nEvents(0) {
+}
+
+EUTelAlignmentCacheWriter::~EUTelAlignmentCacheWriter() {
+  discard();
+}
+
+bool EUTelAlignmentCacheWriter::open(const string & filename, const vector< int > & sensorIDs,
+                                     const string & parameters) {
+
+  discard();
+  _file = fopen( temporaryName( filename ).c_str(), "wb" );
+  if ( _file == NULL ) return false;
+  _filename = filename;
+
+  writeTag( _file, EUTelAlignmentCache::tag );
+
+  int nPlanes = static_cast< int >( sensorIDs.size() );
+  int parametersLength = static_cast< int >( parameters.size() );
+  fwrite( &nPlanes, sizeof( int ), 1, _file );
+  if ( nPlanes > 0 ) fwrite( &sensorIDs[0], sizeof( int ), nPlanes, _file );
+  fwrite( &parametersLength, sizeof( int ), 1, _file );
+  writePadding( _file, sizeof( int ) * ( nPlanes + 2 ) );
+  fwrite( parameters.data(), 1, parameters.size(), _file );
+  writePadding( _file, parameters.size() );
+
+  _nPlanes = sensorIDs.size();
+  _nEvents = 0;
+  return true;
+}
+
+void EUTelAlignmentCacheWriter::writeEvent(const vector< EUTelAlignmentCache::Hit > & hits, const vector< int > & trackHits) {
+
+  if ( _file == NULL || _nPlanes == 0 ) return;
+
+  int counts[2];
+  counts[0] = static_cast< int >( hits.size() );
+  counts[1] = static_cast< int >( trackHits.size() / _nPlanes );
+  fwrite( counts, sizeof( int ), 2, _file );
+  if ( ! hits.empty() ) fwrite( &hits[0], sizeof( EUTelAlignmentCache::Hit ), hits.size(), _file );
+
+  size_t nIndices = counts[1] * _nPlanes;
+  if ( nIndices > 0 ) fwrite( &trackHits[0], sizeof( int ), nIndices, _file );
+  writePadding( _file, sizeof( int ) * nIndices );
+  ++_nEvents;
+}
+
+bool EUTelAlignmentCacheWriter::close() {
+
+  if ( _file == NULL ) return false;
+
+  int trailer[2];
+  trailer[0] = -1;
+  trailer[1] = static_cast< int >( _nEvents );
+  fwrite( trailer, sizeof( int ), 2, _file );
+  writeTag( _file, EUTelAlignmentCache::endTag );
+
+  bool isWritten = ( fflush( _file ) == 0 && ferror( _file ) == 0 );
+  isWritten = ( fclose( _file ) == 0 ) && isWritten;
+  _file = NULL;
+
+  if ( ! isWritten || rename( temporaryName( _filename ).c_str(), _filename.c_str() ) != 0 ) {
+    remove( temporaryName( _filename ).c_str() );
+    return false;
+  }
+  return true;
+}
+
+void EUTelAlignmentCacheWriter::discard() {
+  if ( _file == NULL ) return;
+  fclose( _file );
+  _file = NULL;
+  remove( temporaryName( _filename ).c_str() );
+}
+
+EUTelAlignmentCacheReader::EUTelAlignmentCacheReader() :
+  _data(NULL),
+  _size(0),
+  _mapped(false),
+  _buffer(),
+  _firstEvent(0),
+  _endOfEvents(0),
+  _position(0),
+  _nEvents(0),
+  _sensorIDs(),
+  _parameters() {
+}
+
+EUTelAlignmentCacheReader::~EUTelAlignmentCacheReader() {
+  close();
+}
+
+bool EUTelAlignmentCacheReader::open(const string & filename) {
+
+  close();
+
+  int fd = ::open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 ) return false;
+
+  struct stat status;
+  if ( fstat( fd, &status ) != 0 || status.st_size < static_cast< off_t >( tagSize + 8 ) ) {
+    ::close( fd );
+    return false;
+  }
+  _size = status.st_size;
+
+  void * mapped = mmap( NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  if ( mapped != MAP_FAILED ) {
+    _data   = static_cast< const char * >( mapped );
+    _mapped = true;
+  } else {
+    // read the whole file instead, in a buffer aligned for doubles
+    _buffer.resize( padded( _size ) / sizeof( double ) );
+    char * buffer = reinterpret_cast< char * >( &_buffer[0] );
+    size_t done = 0;
+    while ( done < _size ) {
+      ssize_t n = read( fd, buffer + done, _size - done );
+      if ( n <= 0 ) break;
+      done += n;
+    }
+    if ( done != _size ) {
+      ::close( fd );
+      close();
+      return false;
+    }
+    _data = buffer;
+  }
+  ::close( fd );
+
+  if ( strncmp( _data, EUTelAlignmentCache::tag, tagSize ) != 0 ) {
+    close();
+    return false;
+  }
+
+  int nPlanes;
+  memcpy( &nPlanes, _data + tagSize, sizeof( int ) );
+  if ( nPlanes <= 0 || static_cast< size_t >( nPlanes ) > _size ) {
+    close();
+    return false;
+  }
+  const size_t parametersStart = tagSize + padded( sizeof( int ) * ( nPlanes + 2 ) );
+  if ( parametersStart > _size ) {
+    close();
+    return false;
+  }
+  const int * sensorIDs = reinterpret_cast< const int * >( _data + tagSize + sizeof( int ) );
+  _sensorIDs.assign( sensorIDs, sensorIDs + nPlanes );
+
+  const int parametersLength = sensorIDs[ nPlanes ];
+  if ( parametersLength < 0 || parametersStart + padded( parametersLength ) > _size ) {
+    close();
+    return false;
+  }
+  _parameters.assign( _data + parametersStart, parametersLength );
+  _firstEvent = parametersStart + padded( parametersLength );
+
+  if ( ! validate() ) {
+    close();
+    return false;
+  }
+  _position = _firstEvent;
+  return true;
+}
+
+bool EUTelAlignmentCacheReader::validate() {
+
+  const int nPlanes = static_cast< int >( _sensorIDs.size() );
+  size_t position = _firstEvent;
+  size_t nEvents  = 0;
+
+  while ( position + 2 * sizeof( int ) <= _size ) {
+
+    const int * counts = reinterpret_cast< const int * >( _data + position );
+    const int nHits   = counts[0];
+    const int nTracks = counts[1];
+
+    if ( nHits == -1 ) {
+      // the trailer, which has to close the file
+      if ( nTracks < 0 || static_cast< size_t >( nTracks ) != nEvents ) return false;
+      if ( position + 2 * sizeof( int ) + tagSize != _size ) return false;
+      if ( strncmp( _data + position + 2 * sizeof( int ), EUTelAlignmentCache::endTag, tagSize ) != 0 ) return false;
+      _endOfEvents = position;
+      _nEvents     = nEvents;
+      return true;
+    }
+    if ( nHits < 0 || nTracks < 0 ) return false;
+
+    const size_t hitBytes   = sizeof( EUTelAlignmentCache::Hit ) * nHits;
+    const size_t trackBytes = sizeof( int ) * nTracks * nPlanes;
+    const size_t next = position + 2 * sizeof( int ) + hitBytes + padded( trackBytes );
+    if ( next > _size ) return false;
+
+    const EUTelAlignmentCache::Hit * hits = reinterpret_cast< const EUTelAlignmentCache::Hit * >( _data + position + 2 * sizeof( int ) );
+    for ( int iHit = 0; iHit < nHits; ++iHit ) {
+      if ( hits[iHit].plane < 0 || hits[iHit].plane >= nPlanes ) return false;
+    }
+
+    const int * trackHits = reinterpret_cast< const int * >( _data + position + 2 * sizeof( int ) + hitBytes );
+    for ( int iIndex = 0; iIndex < nTracks * nPlanes; ++iIndex ) {
+      if ( trackHits[iIndex] < -1 || trackHits[iIndex] >= nHits ) return false;
+    }
+
+    position = next;
+    ++nEvents;
+  }
+
+  // no trailer: the file was cut short
+  return false;
+}
+
+bool EUTelAlignmentCacheReader::nextEvent(const EUTelAlignmentCache::Hit * & hits, int & nHits,
+                                          const int * & trackHits, int & nTracks) {
+
+  // the events have been checked by open()
+  if ( _data == NULL || _position >= _endOfEvents ) return false;
+
+  const int * counts = reinterpret_cast< const int * >( _data + _position );
+  nHits   = counts[0];
+  nTracks = counts[1];
+
+  size_t hitBytes   = sizeof( EUTelAlignmentCache::Hit ) * nHits;
+  size_t trackBytes = sizeof( int ) * nTracks * _sensorIDs.size();
+  size_t next = _position + 2 * sizeof( int ) + hitBytes + padded( trackBytes );
+
+  hits      = reinterpret_cast< const EUTelAlignmentCache::Hit * >( _data + _position + 2 * sizeof( int ) );
+  trackHits = reinterpret_cast< const int * >( _data + _position + 2 * sizeof( int ) + hitBytes );
+  _position = next;
+  return true;
+}
+
+void EUTelAlignmentCacheReader::rewind() {
+  _position = _firstEvent;
+}
+
+void EUTelAlignmentCacheReader::close() {
+  if ( _mapped && _data != NULL ) munmap( const_cast< char * >( _data ), _size );
+  _data   = NULL;
+  _size   = 0;
+  _mapped = false;
+  _buffer.clear();
+  _sensorIDs.clear();
+  _parameters.clear();
+  _firstEvent  = 0;
+  _endOfEvents = 0;
+  _position    = 0;
+  _nEvents     = 0;
+}
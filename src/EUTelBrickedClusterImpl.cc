@@ -40,6 +40,105 @@ EUTelBrickedClusterImpl::EUTelBrickedClusterImpl(TrackerDataImpl * data) : EUTel
   _noiseSetSwitch = false;
 }
 
+void EUTelBrickedClusterImpl::fillSummary() const {
+
+  //!will be okay if we set zeros for the unwanted pixels
+  FloatVec vectorCopy(_trackerData->getChargeValues());
+  setOutsiderValuesInVectorInterpretedAsBrickedMatrix( static_cast< std::vector< float>& > (vectorCopy), 0.0f );
+
+  float totalCharge = 0;
+  FloatVec::const_iterator iter = vectorCopy.begin();
+  while (iter != vectorCopy.end()) {
+    totalCharge += (*iter++);
+  }
+
+  // the seed is looked for in the full frame, as it always was
+  const FloatVec & charges = _trackerData->getChargeValues();
+  float seedCharge = 0;
+  unsigned int seedIndex = 0;
+  for ( unsigned int iPixel = 0; iPixel < charges.size(); ++iPixel ) {
+    if ( iPixel == 0 || charges[iPixel] > seedCharge ) {
+      seedCharge = charges[iPixel];
+      seedIndex  = iPixel;
+    }
+  }
+
+  int xSize, ySize;
+  getClusterSize(xSize, ySize);
+  if (!(xSize==3 && ySize==3))
+  {
+      //NOTE fix this if you switch the implemenatation to a variable size:
+      streamlog_out( WARNING4 ) << " BRICKED PIXEL FIXED FRAME CLUSTER SIZE MUST BE 3x3!!!" << endl;
+      streamlog_out( WARNING4 ) << " BUT IT IS " << xSize << "x" << ySize << "!!!" << endl;
+  }
+
+  int seedX, seedY;
+  getSeedCoord(seedX, seedY);
+
+  bool bSeedRowIsEven = false;
+  if (seedY % 2 == 0) bSeedRowIsEven = true; //seed pixel's row is even
+
+  float normalization = 0;
+  float tempX = 0;
+  float tempY = 0;
+
+  float skewCorrectionX;
+  bool  currRowIsEven;
+  int   iPixel = 0;
+
+  for (int yPixel = -1 * (ySize / 2); yPixel <= (ySize / 2); yPixel++)
+  {
+      //Pixel Choice Correction not needed. Unwanted pixels are set to 0.
+
+      //Coordinate Correction:
+      currRowIsEven = (bSeedRowIsEven && (yPixel % 2 == 0)) || (!bSeedRowIsEven && (yPixel % 2 != 0)); //even+even or odd+odd
+      if (currRowIsEven)
+          skewCorrectionX = -0.5;
+      else
+          skewCorrectionX = 0.0;
+
+      for (int xPixel = -1 * (xSize / 2); xPixel <= (xSize / 2); xPixel++)
+      {
+          normalization += vectorCopy[iPixel];
+          tempX         += (xPixel+skewCorrectionX) * vectorCopy[iPixel];
+          tempY         +=  yPixel                  * vectorCopy[iPixel];
+          ++iPixel;
+      }
+  }
+
+  _summary.totalCharge = totalCharge;
+  _summary.seedCharge  = seedCharge;
+  _summary.seedIndex   = seedIndex;
+  _summary.xSize       = xSize;
+  _summary.ySize       = ySize;
+  if ( normalization != 0)
+  {
+      _summary.xCoGShift = tempX / normalization;
+      _summary.yCoGShift = tempY / normalization;
+  }
+  else
+  {
+      _summary.xCoGShift = 0;
+      _summary.yCoGShift = 0;
+  }
+  _summary.chargeValid = true;
+}
+
+void EUTelBrickedClusterImpl::fillNoiseSummary() const {
+
+  if ( ! _summary.chargeValid ) fillSummary();
+
+  float squaredSum = 0; //!will be okay if we set zeros @ noise for the unwanted pixels (which we did)
+  vector<float >::const_iterator iter = _noiseValues.begin();
+  while ( iter != _noiseValues.end() ) {
+    squaredSum += pow( (*iter), 2 );
+    ++iter;
+  }
+  _summary.noise2Sum = squaredSum;
+  _summary.seedNoise = ( _summary.seedIndex < _noiseValues.size() ) ? _noiseValues[ _summary.seedIndex ] : 0.;
+  _summary.noiseValid = true;
+}
+
 float EUTelBrickedClusterImpl::getDistance(EUTelVirtualCluster * otherCluster) const {
 
   int xOtherSeed, yOtherSeed;
@@ -76,86 +175,19 @@ float EUTelBrickedClusterImpl::getExternalRadius() const {
 
 float EUTelBrickedClusterImpl::getTotalCharge() const {
 
-  float totalCharge = 0;
-
-  //!will be okay if we set zeros for the unwanted pixels
-  FloatVec vectorCopy(_trackerData->getChargeValues());
-  setOutsiderValuesInVectorInterpretedAsBrickedMatrix( static_cast< std::vector< float>& > (vectorCopy), 0.0f );
-
-  FloatVec::const_iterator iter = vectorCopy.begin();
-
-  while (iter != vectorCopy.end()) {
-    totalCharge += (*iter++);
-  }
-
-  return totalCharge;
+  if ( ! _summary.chargeValid ) fillSummary();
+  return _summary.totalCharge;
 }
 
 void EUTelBrickedClusterImpl::getCenterOfGravityShift(float& xCoG, float& yCoG) const {
-    //!will be okay if we set zeros for the unwanted pixels
-    FloatVec vectorCopy(_trackerData->getChargeValues());
-    setOutsiderValuesInVectorInterpretedAsBrickedMatrix( static_cast< std::vector< float>& > (vectorCopy), 0.0f );
-
-    //streamlog_out( MESSAGE4 ) << "RUNNING EUTelBrickedClusterImpl::getCenterOfGravityShift() " << endl;
 
     //NOTE this whole class could use a flag showing, if even rows are skewed left or right!
     //NOTE then the offset would become +/-0.5 depending on the flag, instead of fixed -0.5 here!
+    //NOTE the computation is done in fillSummary()
 
-    int xSize, ySize;
-    getClusterSize(xSize, ySize);
-    if (!(xSize==3 && ySize==3))
-    {
-        //NOTE fix this if you switch the implemenatation to a variable size:
-        streamlog_out( WARNING4 ) << " BRICKED PIXEL FIXED FRAME CLUSTER SIZE MUST BE 3x3!!!" << endl;
-        streamlog_out( WARNING4 ) << " BUT IT IS " << xSize << "x" << ySize << "!!!" << endl;
-    }
-
-    int seedX, seedY;
-    getSeedCoord(seedX, seedY);
-
-    bool bSeedRowIsEven = false;
-    if (seedY % 2 == 0) bSeedRowIsEven = true; //seed pixel's row is even
-
-    float normalization = 0;
-    float tempX = 0;
-    float tempY = 0;
-
-    float skewCorrectionX;
-    bool  currRowIsEven;
-    int   iPixel = 0;
-
-    for (int yPixel = -1 * (ySize / 2); yPixel <= (ySize / 2); yPixel++)
-    {
-        //Pixel Choice Correction not needed. Unwanted pixels are set to 0.
-
-        //Coordinate Correction:
-        currRowIsEven = (bSeedRowIsEven && (yPixel % 2 == 0)) || (!bSeedRowIsEven && (yPixel % 2 != 0)); //even+even or odd+odd
-        if (currRowIsEven)
-            skewCorrectionX = -0.5;
-        else
-            skewCorrectionX = 0.0;
-
-        //Go:
-        for (int xPixel = -1 * (xSize / 2); xPixel <= (xSize / 2); xPixel++)
-        {
-            normalization += vectorCopy[iPixel];
-            tempX         += (xPixel+skewCorrectionX) * vectorCopy[iPixel];
-            tempY         +=  yPixel                  * vectorCopy[iPixel];
-            ++iPixel;
-        }
-    }
-
-    if ( normalization != 0)
-    {
-        xCoG = tempX / normalization;
-        yCoG = tempY / normalization;
-    }
-    else
-    {
-        xCoG = 0;
-        yCoG = 0;
-    }
-
+    if ( ! _summary.chargeValid ) fillSummary();
+    xCoG = _summary.xCoGShift;
+    yCoG = _summary.yCoGShift;
 }
 
 void EUTelBrickedClusterImpl::getCenterOfGravityShift(float& xCoG, float& yCoG, int , int) const {
@@ -367,8 +399,8 @@ void EUTelBrickedClusterImpl::setClusterQuality(ClusterQuality quality) {
 
 float EUTelBrickedClusterImpl::getSeedCharge() const {
 
-  return *max_element( _trackerData->getChargeValues().begin(),
-                       _trackerData->getChargeValues().end() );
+  if ( ! _summary.chargeValid ) fillSummary();
+  return _summary.seedCharge;
 }
 
 float EUTelBrickedClusterImpl::getClusterCharge(int nPixel) const {
@@ -441,6 +473,7 @@ void EUTelBrickedClusterImpl::setNoiseValues(std::vector<float > noiseValues ) {
   _noiseValues = noiseValues;
   setOutsiderValuesInVectorInterpretedAsBrickedMatrix( _noiseValues, 0.0f ); //!HACK TAKI
   _noiseSetSwitch = true;
+  _summary.noiseValid = false;
 
 }
 
@@ -454,14 +487,8 @@ float EUTelBrickedClusterImpl::getClusterNoise() const {
 
   if ( ! _noiseSetSwitch ) throw DataNotAvailableException("No noise values set");
 
-  float squaredSum = 0; //!will be okay if we set zeros @ noise for the unwanted pixels (which we did)
-  vector<float >::const_iterator iter = _noiseValues.begin();
-  while ( iter != _noiseValues.end() ) {
-    squaredSum += pow( (*iter), 2 );
-    ++iter;
-  }
-  return sqrt( squaredSum );
-
+  if ( ! _summary.noiseValid ) fillNoiseSummary();
+  return sqrt( _summary.noise2Sum );
 }
 
 float EUTelBrickedClusterImpl::getClusterSNR() const {
@@ -476,15 +503,13 @@ float EUTelBrickedClusterImpl::getClusterSNR() const {
 float EUTelBrickedClusterImpl::getSeedSNR() const {
 
   if ( ! _noiseSetSwitch ) throw DataNotAvailableException("No noise values set");
-  vector<float >::const_iterator chargeBegin    = _trackerData->getChargeValues().begin();
-  vector<float >::const_iterator seedChargeIter = max_element( chargeBegin, _trackerData->getChargeValues().end() );
-  vector<float >::const_iterator seedNoiseIter  = _noiseValues.begin() + ( seedChargeIter - chargeBegin );
-  if (*seedNoiseIter==0.0)
+  if ( ! _summary.noiseValid ) fillNoiseSummary();
+  if (_summary.seedNoise==0.0)
   {
         streamlog_out( ERROR4 ) << "[getSeedSNR()] Just found a noise value == 0.0 !" << endl;
         return 0;
   }
-  return (*seedChargeIter) / (*seedNoiseIter);
+  return _summary.seedCharge / _summary.seedNoise;
 }
 
 float EUTelBrickedClusterImpl::getClusterSNR(int nPixel) const {
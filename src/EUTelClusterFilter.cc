@@ -23,6 +23,7 @@
 #include "EUTelExceptions.h"
 #include "EUTelROI.h"
 #include "EUTelMatrixDecoder.h"
+#include "EUTelUtility.h"
 
 // marlin includes ".h"
 #include "marlin/Processor.h"
@@ -50,6 +51,14 @@ using namespace lcio;
 using namespace marlin;
 using namespace eutelescope;
 
+namespace {
+  //! Only one cluster every kTimingSampling is timed, to keep the timing overhead low
+  const unsigned long long kTimingSampling = 16;
+
+  //! The pipeline is reordered every kReorderPeriod clusters
+  const unsigned long long kReorderPeriod = 10000;
+}
+
 EUTelClusterFilter::EUTelClusterFilter () :Processor("EUTelClusterFilter") {
 
   // modify processor description
@@ -253,6 +262,9 @@ void EUTelClusterFilter::init () {
 
   printParameters ();
 
+  _filterPipeline.clear();
+  _filteredClusterCounter = 0;
+
   // check and set properly the switches
   // total cluster charge
   if (count_if( _minTotalChargeVec.begin(),  _minTotalChargeVec.end(),  bind2nd(greater<float>(), 0) ) != 0 ) {
@@ -650,7 +662,7 @@ void EUTelClusterFilter::checkCriteria() {
                                << "The number of planes is " << _noOfDetectors
                                << " while the thresholds are " << _maxClusterNoiseVec.size()   << "\n"
                                << "Disabling the selection criterion and continue without" << endl;
-      _maxClusterNoSwitch = false;
+      _maxClusterNoiseSwitch = false;
     } else {
       streamlog_out ( DEBUG1 ) << "Maximum cluster noise criterion verified and switched on" << endl;
       vector<unsigned int > rejectedCounter(_noOfDetectors, 0);
@@ -692,6 +704,113 @@ void EUTelClusterFilter::checkCriteria() {
     _rejectionMap.insert( make_pair("SameNumberOfHitCut", rejectedCounter ));
   }
 
+  buildFilterPipeline();
+
+}
+
+void EUTelClusterFilter::buildFilterPipeline() {
+
+  _filterPipeline.clear();
+  _filteredClusterCounter = 0;
+
+  // the initial order is a guess of the cost of each criterion, the
+  // cheapest first. It is then refined with the measured values.
+  struct {
+    bool                 active;
+    const char *         name;
+    bool (EUTelClusterFilter::*criterion)(ClusterSummary &) const;
+    FilterStage::Scope   scope;
+  } candidates[] = {
+    { _clusterQualitySwitch,  "ClusterQualityCut",  &EUTelClusterFilter::hasQuality,              FilterStage::kAllClusters    },
+    { _insideROISwitch,       "InsideROICut",       &EUTelClusterFilter::isInsideROI,             FilterStage::kAllClusters    },
+    { _outsideROISwitch,      "OutsideROICut",      &EUTelClusterFilter::isOutsideROI,            FilterStage::kAllClusters    },
+    { _dffnhitsswitch,        "MinHitPixel",        &EUTelClusterFilter::isAboveNumberOfHitPixel, FilterStage::kDFFClusters    },
+    { _minSeedChargeSwitch,   "MinSeedChargeCut",   &EUTelClusterFilter::isAboveMinSeedCharge,    FilterStage::kNonDFFClusters },
+    { _minTotalChargeSwitch,  "MinTotalChargeCut",  &EUTelClusterFilter::isAboveMinTotalCharge,   FilterStage::kNonDFFClusters },
+    { _minNChargeSwitch,      "MinNChargeCut",      &EUTelClusterFilter::isAboveNMinCharge,       FilterStage::kNonDFFClusters },
+    { _minNxNChargeSwitch,    "MinNxNChargeCut",    &EUTelClusterFilter::isAboveNxNMinCharge,     FilterStage::kNonDFFClusters },
+    { _minSeedSNRSwitch,      "MinSeedSNRCut",      &EUTelClusterFilter::isAboveMinSeedSNR,       FilterStage::kNonDFFClusters },
+    { _minTotalSNRSwitch,     "MinTotalSNRCut",     &EUTelClusterFilter::isAboveMinTotalSNR,      FilterStage::kNonDFFClusters },
+    { _minNSNRSwitch,         "MinNSNRCut",         &EUTelClusterFilter::isAboveNMinSNR,          FilterStage::kNonDFFClusters },
+    { _minNxNSNRSwitch,       "MinNxNSNRCut",       &EUTelClusterFilter::isAboveNxNMinSNR,        FilterStage::kNonDFFClusters },
+    { _maxClusterNoiseSwitch, "MaxClusterNoiseCut", &EUTelClusterFilter::isBelowMaxClusterNoise,  FilterStage::kNonDFFClusters }
+  };
+
+  for ( size_t iCandidate = 0; iCandidate < sizeof(candidates) / sizeof(candidates[0]); ++iCandidate ) {
+    if ( ! candidates[iCandidate].active ) continue;
+    FilterStage stage;
+    stage.name      = candidates[iCandidate].name;
+    stage.criterion = candidates[iCandidate].criterion;
+    stage.scope     = candidates[iCandidate].scope;
+    stage.evaluated = 0;
+    stage.rejected  = 0;
+    stage.timed     = 0;
+    stage.time      = 0.;
+    _filterPipeline.push_back( stage );
+    streamlog_out ( DEBUG1 ) << "Criterion " << stage.name << " added to the selection pipeline" << endl;
+  }
+}
+
+bool EUTelClusterFilter::applyFilterPipeline(ClusterSummary & cluster, bool isDFFCluster) {
+
+  const bool isTimed = ( _filteredClusterCounter % kTimingSampling == 0 );
+  bool isAccepted = true;
+
+  for ( vector<FilterStage >::iterator stage = _filterPipeline.begin(); stage != _filterPipeline.end(); ++stage ) {
+    if ( ( stage->scope == FilterStage::kDFFClusters    && ! isDFFCluster ) ||
+         ( stage->scope == FilterStage::kNonDFFClusters &&   isDFFCluster ) ) continue;
+
+    ++stage->evaluated;
+    bool isPassed;
+    if ( isTimed ) {
+      double start = Utility::getWallTime();
+      isPassed = (this->*(stage->criterion))( cluster );
+      stage->time += Utility::getWallTime() - start;
+      ++stage->timed;
+    } else {
+      isPassed = (this->*(stage->criterion))( cluster );
+    }
+
+    if ( ! isPassed ) {
+      ++stage->rejected;
+      isAccepted = false;
+      break;
+    }
+  }
+
+  if ( ++_filteredClusterCounter % kReorderPeriod == 0 ) reorderFilterPipeline();
+
+  return isAccepted;
+}
+
+namespace {
+  //! Average cost of a criterion per rejected cluster
+  /*! A criterion not measured yet, or never rejecting, costs the
+   *  most and is not moved ahead of the measured ones.
+   */
+  double costPerRejection(unsigned long long evaluated, unsigned long long rejected,
+                          unsigned long long timed, double time) {
+    if ( timed == 0 || evaluated == 0 || rejected == 0 ) return numeric_limits<double>::max();
+    return ( time / timed ) / ( static_cast<double>( rejected ) / evaluated );
+  }
+}
+
+void EUTelClusterFilter::reorderFilterPipeline() {
+
+  // a simple insertion sort, the pipeline is short and usually
+  // already almost sorted. Equal costs keep their order.
+  for ( size_t i = 1; i < _filterPipeline.size(); ++i ) {
+    FilterStage stage = _filterPipeline[i];
+    double cost = costPerRejection( stage.evaluated, stage.rejected, stage.timed, stage.time );
+    size_t j = i;
+    while ( j > 0 ) {
+      const FilterStage & previous = _filterPipeline[j - 1];
+      if ( costPerRejection( previous.evaluated, previous.rejected, previous.timed, previous.time ) <= cost ) break;
+      _filterPipeline[j] = previous;
+      --j;
+    }
+    _filterPipeline[j] = stage;
+  }
 }
 
 
@@ -980,30 +1099,12 @@ void EUTelClusterFilter::processEvent (LCEvent * event) {
                 throw UnknownDataTypeException("Cluster type unknown");
             }
 
-            // increment the event counter
-            _totalClusterCounter[ _ancillaryIndexMap[ cluster->getDetectorID() ] ]++;
+            ClusterSummary summary( cluster, _ancillaryIndexMap[ cluster->getDetectorID() ] );
 
-            bool isAccepted = true;
+            // increment the event counter
+            _totalClusterCounter[ summary.getDetectorPos() ]++;
 
-            if ( type == kEUTelDFFClusterImpl )
-            {
-                isAccepted &= isAboveNumberOfHitPixel(cluster);
-            }
-            else
-            {
-                isAccepted &= isAboveMinTotalCharge(cluster);
-                isAccepted &= isAboveMinTotalSNR(cluster);
-                isAccepted &= isAboveNMinCharge(cluster);
-                isAccepted &= isAboveNMinSNR(cluster);
-                isAccepted &= isAboveNxNMinCharge(cluster);
-                isAccepted &= isAboveNxNMinSNR(cluster);
-                isAccepted &= isAboveMinSeedCharge(cluster);
-                isAccepted &= isAboveMinSeedSNR(cluster);
-                isAccepted &= isBelowMaxClusterNoise(cluster);
-            }
-            isAccepted &= hasQuality(cluster);
-            isAccepted &= isInsideROI(cluster);
-            isAccepted &= isOutsideROI(cluster);
+            bool isAccepted = applyFilterPipeline( summary, type == kEUTelDFFClusterImpl );
 
             if ( isAccepted )  acceptedClusterVec.push_back(iPulse);
 
@@ -1163,18 +1264,80 @@ bool EUTelClusterFilter::hasSameNumberOfHit(std::vector<int > clusterNoVec) cons
   return hasSameNumber;
 }
 
-bool EUTelClusterFilter::isAboveNumberOfHitPixel(EUTelVirtualCluster * cluster) const {
+EUTelClusterFilter::ClusterSummary::ClusterSummary(EUTelVirtualCluster * cluster, int detectorPos) :
+  _cluster(cluster),
+  _detectorID(cluster->getDetectorID()),
+  _detectorPos(detectorPos),
+  _available(0),
+  _totalCharge(0.),
+  _seedCharge(0.),
+  _clusterSNR(0.),
+  _seedSNR(0.),
+  _clusterNoise(0.),
+  _xCoG(0.),
+  _yCoG(0.) {
+}
+
+float EUTelClusterFilter::ClusterSummary::getTotalCharge() {
+  if ( ! ( _available & kTotalCharge ) ) {
+    _totalCharge = _cluster->getTotalCharge();
+    _available |= kTotalCharge;
+  }
+  return _totalCharge;
+}
+
+float EUTelClusterFilter::ClusterSummary::getSeedCharge() {
+  if ( ! ( _available & kSeedCharge ) ) {
+    _seedCharge = _cluster->getSeedCharge();
+    _available |= kSeedCharge;
+  }
+  return _seedCharge;
+}
+
+float EUTelClusterFilter::ClusterSummary::getClusterSNR() {
+  if ( ! ( _available & kClusterSNR ) ) {
+    _clusterSNR = _cluster->getClusterSNR();
+    _available |= kClusterSNR;
+  }
+  return _clusterSNR;
+}
+
+float EUTelClusterFilter::ClusterSummary::getSeedSNR() {
+  if ( ! ( _available & kSeedSNR ) ) {
+    _seedSNR = _cluster->getSeedSNR();
+    _available |= kSeedSNR;
+  }
+  return _seedSNR;
+}
+
+float EUTelClusterFilter::ClusterSummary::getClusterNoise() {
+  if ( ! ( _available & kClusterNoise ) ) {
+    _clusterNoise = _cluster->getClusterNoise();
+    _available |= kClusterNoise;
+  }
+  return _clusterNoise;
+}
+
+void EUTelClusterFilter::ClusterSummary::getCenterOfGravity(float& x, float& y) {
+  if ( ! ( _available & kCenterOfGravity ) ) {
+    _cluster->getCenterOfGravity(_xCoG, _yCoG);
+    _available |= kCenterOfGravity;
+  }
+  x = _xCoG;
+  y = _yCoG;
+}
+
+bool EUTelClusterFilter::isAboveNumberOfHitPixel(ClusterSummary & cluster) const {
   if ( !_dffnhitsswitch ) {
     return true;
   }
   streamlog_out ( DEBUG1 ) << "Filtering against number of hit pixel inside a cluster " << endl;
 
-  int detectorID = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap[ detectorID ];
+  int detectorPos = cluster.getDetectorPos();
 
-  if ( static_cast< int >(cluster->getTotalCharge()) >= _DFFNHitsCuts[detectorPos] ) return true;
+  if ( static_cast< int >(cluster.getTotalCharge()) >= _DFFNHitsCuts[detectorPos] ) return true;
   else {
-    streamlog_out ( DEBUG2 )  << "Rejected cluster because the number of hit pixel is " << static_cast< int >(cluster->getTotalCharge())
+    streamlog_out ( DEBUG2 )  << "Rejected cluster because the number of hit pixel is " << static_cast< int >(cluster.getTotalCharge())
                               << " and the threshold is " << _DFFNHitsCuts[detectorPos] << endl;
     _rejectionMap["MinHitPixel"][detectorPos]++;
     return false;
@@ -1183,55 +1346,52 @@ bool EUTelClusterFilter::isAboveNumberOfHitPixel(EUTelVirtualCluster * cluster)
 
 
 
-bool EUTelClusterFilter::isAboveMinTotalCharge(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::isAboveMinTotalCharge(ClusterSummary & cluster) const {
 
   if ( !_minTotalChargeSwitch ) {
     return true;
   }
   streamlog_out ( DEBUG1 ) << "Filtering against the total charge " << endl;
 
-  int detectorID  = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap[ detectorID ];
+  int detectorPos = cluster.getDetectorPos();
 
-  if ( cluster->getTotalCharge() > _minTotalChargeVec[detectorPos] ) return true;
+  if ( cluster.getTotalCharge() > _minTotalChargeVec[detectorPos] ) return true;
   else {
-    streamlog_out ( DEBUG2 )  << "Rejected cluster because its charge is " << cluster->getTotalCharge()
+    streamlog_out ( DEBUG2 )  << "Rejected cluster because its charge is " << cluster.getTotalCharge()
                               << " and the threshold is " << _minTotalChargeVec[detectorPos] << endl;
     _rejectionMap["MinTotalChargeCut"][detectorPos]++;
     return false;
   }
 }
 
-bool EUTelClusterFilter::isAboveMinTotalSNR(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::isAboveMinTotalSNR(ClusterSummary & cluster) const {
 
   if ( !_noiseRelatedCuts   ) return true;
   if ( !_minTotalSNRSwitch  ) return true;
 
-  int detectorID  = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap [ detectorID ];
+  int detectorPos = cluster.getDetectorPos();
 
   streamlog_out ( DEBUG1 ) << "Filtering against the minimum total SNR " << endl;
-  if  ( cluster->getClusterSNR() > _minTotalSNRVec[ detectorPos ] ) return true;
+  if  ( cluster.getClusterSNR() > _minTotalSNRVec[ detectorPos ] ) return true;
   else {
-    streamlog_out ( DEBUG2 )  << "Rejected cluster because its SNR is " << cluster->getClusterSNR()
+    streamlog_out ( DEBUG2 )  << "Rejected cluster because its SNR is " << cluster.getClusterSNR()
                               << " and the threshold is " << _minTotalSNRVec[ detectorPos ] << endl;
     _rejectionMap["MinTotalSNRCut"][detectorPos]++;
     return false;
   }
 }
 
-bool EUTelClusterFilter::isAboveNMinCharge(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::isAboveNMinCharge(ClusterSummary & cluster) const {
 
   if ( !_minNChargeSwitch ) return true;
 
   streamlog_out ( DEBUG1 ) << "Filtering against the N Pixel charge " << endl;
 
-  int detectorID = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap [ detectorID ];
+  int detectorPos = cluster.getDetectorPos();
   vector<float >::const_iterator iter = _minNChargeVec.begin();
   while ( iter != _minNChargeVec.end() ) {
     int nPixel      = static_cast<int > (*iter);
-    float charge    = cluster->getClusterCharge(nPixel);
+    float charge    = cluster.getCluster()->getClusterCharge(nPixel);
     float threshold = (* (iter + detectorPos + 1) );
     if ( charge > threshold ) {
       iter += _noOfDetectors + 1;
@@ -1246,19 +1406,18 @@ bool EUTelClusterFilter::isAboveNMinCharge(EUTelVirtualCluster * cluster) const
 }
 
 
-bool EUTelClusterFilter::isAboveNMinSNR(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::isAboveNMinSNR(ClusterSummary & cluster) const {
 
   if ( !_noiseRelatedCuts ) return true;
   if ( !_minNSNRSwitch    ) return true;
 
   streamlog_out ( DEBUG1 ) << "Filtering against the N pixel SNR " << endl;
 
-  int detectorID = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap [ detectorID ];
+  int detectorPos = cluster.getDetectorPos();
   vector<float >::const_iterator iter = _minNSNRVec.begin();
   while ( iter !=  _minNSNRVec.end() ) {
     int nPixel      = static_cast<int > (*iter);
-    float SNR       = cluster->getClusterSNR(nPixel);
+    float SNR       = cluster.getCluster()->getClusterSNR(nPixel);
     float threshold = (* (iter + detectorPos + 1 ) );
     if ( SNR > threshold ) {
       iter += _noOfDetectors + 1;
@@ -1275,18 +1434,17 @@ bool EUTelClusterFilter::isAboveNMinSNR(EUTelVirtualCluster * cluster) const {
 
 
 
-bool EUTelClusterFilter::isAboveNxNMinCharge(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::isAboveNxNMinCharge(ClusterSummary & cluster) const {
 
   if ( !_minNxNChargeSwitch ) return true;
 
   streamlog_out ( DEBUG1 ) << "Filtering against the N x N pixel charge" << endl;
 
-  int detectorID = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap [ detectorID ];
+  int detectorPos = cluster.getDetectorPos();
   vector<float >::const_iterator iter = _minNxNChargeVec.begin();
   while ( iter != _minNxNChargeVec.end() ) {
     int nxnPixel    = static_cast<int > ( *iter ) ;
-    float charge    = cluster->getClusterCharge(nxnPixel, nxnPixel);
+    float charge    = cluster.getCluster()->getClusterCharge(nxnPixel, nxnPixel);
     float threshold = (* ( iter + detectorPos + 1 )) ;
     if ( ( threshold <= 0) || (charge > threshold) ) {
       iter += _noOfDetectors + 1;
@@ -1301,19 +1459,18 @@ bool EUTelClusterFilter::isAboveNxNMinCharge(EUTelVirtualCluster * cluster) cons
 }
 
 
-bool EUTelClusterFilter::isAboveNxNMinSNR(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::isAboveNxNMinSNR(ClusterSummary & cluster) const {
 
   if ( !_noiseRelatedCuts  ) return true;
   if ( !_minNxNSNRSwitch   ) return true;
 
   streamlog_out ( DEBUG1 ) << "Filtering against the N x N pixel charge" << endl;
 
-  int detectorID = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap [ detectorID ];
+  int detectorPos = cluster.getDetectorPos();
   vector<float >::const_iterator iter = _minNxNSNRVec.begin();
   while ( iter != _minNxNSNRVec.end() ) {
     int nxnPixel    = static_cast<int > ( *iter ) ;
-    float snr       = cluster->getClusterSNR(nxnPixel, nxnPixel);
+    float snr       = cluster.getCluster()->getClusterSNR(nxnPixel, nxnPixel);
     float threshold = (* ( iter + detectorPos + 1 )) ;
     if ( ( threshold <= 0) || (snr > threshold) ) {
       iter += _noOfDetectors + 1;
@@ -1328,35 +1485,33 @@ bool EUTelClusterFilter::isAboveNxNMinSNR(EUTelVirtualCluster * cluster) const {
 
 }
 
-bool EUTelClusterFilter::isAboveMinSeedCharge(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::isAboveMinSeedCharge(ClusterSummary & cluster) const {
 
   if ( !_minSeedChargeSwitch ) return true;
 
   streamlog_out ( DEBUG1 ) << "Filtering against the seed charge " << endl;
 
-  int detectorID = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap [ detectorID ];
-  if ( cluster->getSeedCharge() > _minSeedChargeVec[detectorPos] ) return true;
+  int detectorPos = cluster.getDetectorPos();
+  if ( cluster.getSeedCharge() > _minSeedChargeVec[detectorPos] ) return true;
   else {
-    streamlog_out ( DEBUG2 )  << "Rejected cluster because its seed charge is " << cluster->getSeedCharge()
+    streamlog_out ( DEBUG2 )  << "Rejected cluster because its seed charge is " << cluster.getSeedCharge()
                               << " and the threshold is " <<  _minSeedChargeVec[detectorPos] << endl;
     _rejectionMap["MinSeedChargeCut"][detectorPos]++;
     return false;
   }
 }
 
-bool EUTelClusterFilter::isAboveMinSeedSNR(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::isAboveMinSeedSNR(ClusterSummary & cluster) const {
 
   if ( !_noiseRelatedCuts  ) return true;
   if ( !_minSeedSNRSwitch  ) return true;
 
   streamlog_out ( DEBUG1 ) << "Filtering against the seed SNR " << endl;
 
-  int detectorID = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap [ detectorID ];
-  if ( cluster->getSeedSNR() > _minSeedSNRVec[detectorPos] ) return true;
+  int detectorPos = cluster.getDetectorPos();
+  if ( cluster.getSeedSNR() > _minSeedSNRVec[detectorPos] ) return true;
   else {
-    streamlog_out ( DEBUG2 ) << "Rejected cluster because its seed charge is " << cluster->getSeedSNR()
+    streamlog_out ( DEBUG2 ) << "Rejected cluster because its seed charge is " << cluster.getSeedSNR()
                              << " and the threshold is " <<  _minSeedSNRVec[detectorPos] << endl;
     _rejectionMap["MinSeedSNRCut"][detectorPos]++;
     return false;
@@ -1365,15 +1520,15 @@ bool EUTelClusterFilter::isAboveMinSeedSNR(EUTelVirtualCluster * cluster) const
 
 
 
-bool EUTelClusterFilter::hasQuality(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::hasQuality(ClusterSummary & cluster) const {
 
   if ( !_clusterQualitySwitch ) return true;
 
-  int detectorID = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap [ detectorID ];
+  int detectorID  = cluster.getDetectorID();
+  int detectorPos = cluster.getDetectorPos();
   if ( _clusterQualityVec[detectorID] < 0 ) return true;
 
-  ClusterQuality actual = cluster->getClusterQuality();
+  ClusterQuality actual = cluster.getCluster()->getClusterQuality();
   ClusterQuality needed = static_cast<ClusterQuality> ( _clusterQualityVec[detectorPos] );
 
   if ( actual == needed ) return true;
@@ -1385,18 +1540,18 @@ bool EUTelClusterFilter::hasQuality(EUTelVirtualCluster * cluster) const {
   }
 }
 
-bool EUTelClusterFilter::isBelowMaxClusterNoise(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::isBelowMaxClusterNoise(ClusterSummary & cluster) const {
 
   if ( !_noiseRelatedCuts       ) return true;
   if ( !_maxClusterNoiseSwitch  ) return true;
 
   streamlog_out ( DEBUG1 ) << "Filtering against the maximum cluster noise"  << endl;
-  int detectorID = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap [ detectorID ];
-  if (  ( cluster->getClusterNoise() < _maxClusterNoiseVec[detectorPos] ) ||
+  int detectorID  = cluster.getDetectorID();
+  int detectorPos = cluster.getDetectorPos();
+  if (  ( cluster.getClusterNoise() < _maxClusterNoiseVec[detectorPos] ) ||
         ( _maxClusterNoiseVec[detectorID] < 0 ) ) return true;
   else {
-    streamlog_out ( DEBUG2 )  << "Rejected cluster because its noise is " << cluster->getClusterNoise()
+    streamlog_out ( DEBUG2 )  << "Rejected cluster because its noise is " << cluster.getClusterNoise()
                               << " and the threshold is " <<  _maxClusterNoiseVec[detectorPos] << endl;
     _rejectionMap["MaxClusterNoiseCut"][detectorPos]++;
     return false;
@@ -1404,14 +1559,14 @@ bool EUTelClusterFilter::isBelowMaxClusterNoise(EUTelVirtualCluster * cluster) c
 }
 
 
-bool EUTelClusterFilter::isInsideROI(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::isInsideROI(ClusterSummary & cluster) const {
 
   if ( !_insideROISwitch ) return true;
 
-  int detectorID = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap [ detectorID ];
+  int detectorID  = cluster.getDetectorID();
+  int detectorPos = cluster.getDetectorPos();
   float x, y;
-  cluster->getCenterOfGravity(x, y);
+  cluster.getCenterOfGravity(x, y);
 
   bool tempAccepted = true;
   vector<EUTelROI>::const_iterator iter = _insideROIVec.begin();
@@ -1435,14 +1590,14 @@ bool EUTelClusterFilter::isInsideROI(EUTelVirtualCluster * cluster) const {
 
 }
 
-bool EUTelClusterFilter::isOutsideROI(EUTelVirtualCluster * cluster) const {
+bool EUTelClusterFilter::isOutsideROI(ClusterSummary & cluster) const {
 
   if ( !_outsideROISwitch ) return true;
 
-  int detectorID = cluster->getDetectorID();
-  int detectorPos = _ancillaryIndexMap [ detectorID ];
+  int detectorID  = cluster.getDetectorID();
+  int detectorPos = cluster.getDetectorPos();
   float x, y;
-  cluster->getCenterOfGravity(x, y);
+  cluster.getCenterOfGravity(x, y);
 
   bool tempAccepted = true;
   vector<EUTelROI>::const_iterator iter = _outsideROIVec.begin();
@@ -1521,6 +1676,23 @@ string EUTelClusterFilter::printSummary() const {
   }
   ss << "\n" << doubleLine.str() << endl;
 
+  if ( ! _filterPipeline.empty() ) {
+    ss << " Selection pipeline (evaluation order) " << endl
+       << doubleLine.str() << endl
+       << " " << setiosflags(ios::left) << setw(bigSpacer) << "Criterion" << resetiosflags(ios::left)
+       << setw(smallSpacer) << "Evaluated" << setw(smallSpacer) << "Rejected" << setw(smallSpacer) << "Time [us]" << endl
+       << singleLine.str() << endl;
+    vector<FilterStage >::const_iterator stage = _filterPipeline.begin();
+    while ( stage != _filterPipeline.end() ) {
+      double averageTime = ( stage->timed > 0 ) ? 1e6 * stage->time / stage->timed : 0.;
+      ss << " " << setiosflags(ios::left) << setw(bigSpacer) << stage->name << resetiosflags(ios::left)
+         << setw(smallSpacer) << stage->evaluated << setw(smallSpacer) << stage->rejected
+         << setw(smallSpacer) << setprecision(3) << averageTime << endl;
+      ++stage;
+    }
+    ss << doubleLine.str() << endl;
+  }
+
   return ss.str();
 
 }
@@ -32,9 +32,12 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <map>
 #include <memory>
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <cmath>
 
 using namespace std;
 using namespace lcio;
@@ -117,6 +120,13 @@ void EUTelClusterSeparationProcessor::processEvent (LCEvent * event) {
   CellIDDecoder<TrackerPulseImpl> cellDecoder(clusterCollectionVec);
 
   vector< pair<int, int > >       mergingPairVector;
+  vector< ClusterCentre >         centreVector;
+  centreVector.reserve( clusterCollectionVec->getNumberOfElements() );
+
+  // the sparse pixel type is the same for all the sparse clusters
+  // of the event, so it is looked up only once
+  bool            isPixelTypeKnown = false;
+  SparsePixelType pixelType        = kUnknownPixelType;
 
   for ( int iCluster = 0 ; iCluster < clusterCollectionVec->getNumberOfElements() ; iCluster++) {
 
@@ -125,32 +135,34 @@ void EUTelClusterSeparationProcessor::processEvent (LCEvent * event) {
 
     // all clusters have to inherit from the virtual cluster (that is
     // a TrackerDataImpl with some utility methods).
-    EUTelVirtualCluster    * cluster;
+    auto_ptr<EUTelVirtualCluster> cluster;
 
     if ( type == kEUTelFFClusterImpl )
     {
-      cluster = new EUTelFFClusterImpl( static_cast<TrackerDataImpl*> (pulse->getTrackerData()) ) ;
+      cluster.reset( new EUTelFFClusterImpl( static_cast<TrackerDataImpl*> (pulse->getTrackerData()) ) );
     }
     else if ( type == kEUTelBrickedClusterImpl )
     {
-      cluster = new EUTelBrickedClusterImpl( static_cast<TrackerDataImpl*> (pulse->getTrackerData()) ) ;
+      cluster.reset( new EUTelBrickedClusterImpl( static_cast<TrackerDataImpl*> (pulse->getTrackerData()) ) );
     }
     else if ( type == kEUTelSparseClusterImpl ) {
 
       // ok the cluster is of sparse type, but we also need to know
       // the kind of pixel description used. This information is
       // stored in the corresponding original data collection.
-
-      LCCollectionVec * sparseClusterCollectionVec = dynamic_cast < LCCollectionVec * > (evt->getCollection("original_zsdata"));
-      TrackerDataImpl * oneCluster = dynamic_cast<TrackerDataImpl*> (sparseClusterCollectionVec->getElementAt( 0 ));
-      CellIDDecoder<TrackerDataImpl > anotherDecoder(sparseClusterCollectionVec);
-      SparsePixelType pixelType = static_cast<SparsePixelType> ( static_cast<int> ( anotherDecoder( oneCluster )["sparsePixelType"] ));
+      if ( !isPixelTypeKnown ) {
+        LCCollectionVec * sparseClusterCollectionVec = dynamic_cast < LCCollectionVec * > (evt->getCollection("original_zsdata"));
+        TrackerDataImpl * oneCluster = dynamic_cast<TrackerDataImpl*> (sparseClusterCollectionVec->getElementAt( 0 ));
+        CellIDDecoder<TrackerDataImpl > anotherDecoder(sparseClusterCollectionVec);
+        pixelType = static_cast<SparsePixelType> ( static_cast<int> ( anotherDecoder( oneCluster )["sparsePixelType"] ));
+        isPixelTypeKnown = true;
+      }
 
       // now we know the pixel type. So we can properly create a new
       // instance of the sparse cluster
       if ( pixelType == kEUTelSimpleSparsePixel ) {
-        cluster = new EUTelSparseClusterImpl< EUTelSimpleSparsePixel >
-          ( static_cast<TrackerDataImpl *> ( pulse->getTrackerData()  ) );
+        cluster.reset( new EUTelSparseClusterImpl< EUTelSimpleSparsePixel >
+                       ( static_cast<TrackerDataImpl *> ( pulse->getTrackerData()  ) ) );
       } else {
         streamlog_out ( ERROR4 ) << "Unknown pixel type. Sorry for quitting." << endl;
         throw UnknownDataTypeException("Pixel type unknown");
@@ -161,57 +173,16 @@ void EUTelClusterSeparationProcessor::processEvent (LCEvent * event) {
       throw UnknownDataTypeException("Cluster type unknown");
     }
 
-    int  iOtherCluster     = iCluster + 1;
-    bool isExisisting      = (iOtherCluster < clusterCollectionVec->getNumberOfElements() );
-    bool isOnSameDetector  = true;
-
-
-    while ( isOnSameDetector && isExisisting ) {
-
-      // get the next cluster in the collection
-      TrackerPulseImpl    * otherPulse   = dynamic_cast<TrackerPulseImpl *> (clusterCollectionVec->getElementAt(iOtherCluster)) ;
-      EUTelVirtualCluster * otherCluster;
-
-      if ( type == kEUTelFFClusterImpl )
-        otherCluster = new EUTelFFClusterImpl( static_cast<TrackerDataImpl*> (otherPulse->getTrackerData()) );
-      else if ( type == kEUTelBrickedClusterImpl )
-        otherCluster = new EUTelBrickedClusterImpl( static_cast<TrackerDataImpl*> (otherPulse->getTrackerData()) );
-      else
-      {
-        streamlog_out ( ERROR4 ) << "Unknown cluster type. Sorry for quitting" << endl;
-        throw UnknownDataTypeException("Cluster type unknown");
-      }
-
-      // check if the two are on the same detector
-      if ( cluster->getDetectorID() == otherCluster->getDetectorID() ) {
-
-        if ( _minimumDistance == 0 ) {
-          // ok we need to calculate the touching distance
-          float radius      = cluster->getExternalRadius();
-          float otherRadius = otherCluster->getExternalRadius();
-          _minimumDistance  = radius + otherRadius;
-        }
-
-        // ok they are on the same plane, so it makes sense check it
-        // they are merging
-        float distance = cluster->getDistance(otherCluster);
-
-        if ( distance < _minimumDistance ) {
-          // they are merging! we need to apply the separation
-          // algorithm
-          mergingPairVector.push_back( make_pair(iCluster, iOtherCluster) );
-        }
+    ClusterCentre centre;
+    centre.detectorID     = cluster->getDetectorID();
+    cluster->getCenterCoord( centre.xSeed, centre.ySeed );
+    centre.externalRadius = ( _minimumDistance == 0 ) ? cluster->getExternalRadius() : 0;
+    centreVector.push_back( centre );
 
-      } else {
-        isOnSameDetector = false;
-      }
-      isExisisting = (++iOtherCluster <  clusterCollectionVec->getNumberOfElements() );
-      delete otherCluster;
-    }
-
-    delete cluster;
   }
 
+  findMergingPairs( centreVector, &mergingPairVector );
+
   // at this point we have inserted into the mergingPairVector all the
   // pairs of merging clusters. we can try to put together all groups
   // of clusters, but only in the case the mergingPairVector has a non
@@ -330,42 +301,135 @@ bool EUTelClusterSeparationProcessor::applySeparationAlgorithm(std::vector<std::
 
 }
 
+namespace {
+
+  //! A cluster centre sorted in its grid cell
+  struct GridEntry {
+    int detectorID;
+    int xCell;
+    int yCell;
+    int index;
+
+    bool operator<(const GridEntry & other) const {
+      if ( detectorID != other.detectorID ) return detectorID < other.detectorID;
+      if ( xCell      != other.xCell      ) return xCell      < other.xCell;
+      if ( yCell      != other.yCell      ) return yCell      < other.yCell;
+      return index < other.index;
+    }
+  };
+
+  //! Root of a union-find tree, with path halving
+  int findRoot(vector<int> & parent, int index) {
+    while ( parent[ index ] != index ) {
+      parent[ index ] = parent[ parent[ index ] ];
+      index = parent[ index ];
+    }
+    return index;
+  }
+
+}
+
+void EUTelClusterSeparationProcessor::findMergingPairs(const std::vector< ClusterCentre > & centreVector,
+                                                       std::vector< std::pair<int, int> > * pairVector) const {
+
+  // the cell size of each detector is the largest merging distance
+  // on it, so that merging clusters are at most one cell apart
+  map<int, float > cellSizeMap;
+  for ( size_t iCluster = 0; iCluster < centreVector.size(); ++iCluster ) {
+    float  distance = ( _minimumDistance == 0 ) ? 2 * centreVector[ iCluster ].externalRadius : _minimumDistance;
+    float& cellSize = cellSizeMap[ centreVector[ iCluster ].detectorID ];
+    if ( distance > cellSize ) cellSize = distance;
+  }
+
+  vector< GridEntry > gridVector;
+  gridVector.reserve( centreVector.size() );
+  for ( size_t iCluster = 0; iCluster < centreVector.size(); ++iCluster ) {
+    const ClusterCentre& centre = centreVector[ iCluster ];
+    float cellSize = cellSizeMap[ centre.detectorID ];
+    if ( cellSize < 1 ) cellSize = 1;
+    GridEntry entry;
+    entry.detectorID = centre.detectorID;
+    entry.xCell      = static_cast< int >( floor( centre.xSeed / cellSize ) );
+    entry.yCell      = static_cast< int >( floor( centre.ySeed / cellSize ) );
+    entry.index      = static_cast< int >( iCluster );
+    gridVector.push_back( entry );
+  }
+  sort( gridVector.begin(), gridVector.end() );
+
+  for ( size_t iEntry = 0; iEntry < gridVector.size(); ++iEntry ) {
+
+    const GridEntry&     entry  = gridVector[ iEntry ];
+    const ClusterCentre& centre = centreVector[ entry.index ];
+
+    for ( int xCell = entry.xCell - 1; xCell <= entry.xCell + 1; ++xCell ) {
+      for ( int yCell = entry.yCell - 1; yCell <= entry.yCell + 1; ++yCell ) {
+
+        GridEntry cellBegin = { entry.detectorID, xCell, yCell, entry.index + 1 };
+        vector< GridEntry >::iterator iter = lower_bound( gridVector.begin(), gridVector.end(), cellBegin );
+
+        // within a cell the entries are sorted by index, so each pair
+        // is considered only once
+        while ( iter != gridVector.end() && iter->detectorID == entry.detectorID
+                && iter->xCell == xCell && iter->yCell == yCell ) {
+
+          const ClusterCentre& otherCentre = centreVector[ iter->index ];
+          float minimumDistance = ( _minimumDistance == 0 ) ?
+            centre.externalRadius + otherCentre.externalRadius : _minimumDistance;
+          float distance = sqrt( pow( static_cast<double> ( centre.xSeed - otherCentre.xSeed ), 2 ) +
+                                 pow( static_cast<double> ( centre.ySeed - otherCentre.ySeed ), 2 ) );
+
+          if ( distance < minimumDistance ) {
+            // they are merging! we need to apply the separation
+            // algorithm
+            pairVector->push_back( make_pair( entry.index, iter->index ) );
+          }
+          ++iter;
+        }
+      }
+    }
+  }
+
+}
+
 void EUTelClusterSeparationProcessor::groupingMergingPairs(std::vector< std::pair<int , int> > pairVector,
                                                            std::vector< std::set<int > > * setVector) const {
 
   streamlog_out ( DEBUG0 ) << "Grouping merging pairs of clusters " << endl;
 
+  // union-find over the cluster indices appearing in the pairs
+  int maxIndex = -1;
   vector< pair<int, int> >::iterator iter = pairVector.begin();
   while ( iter != pairVector.end() ) {
+    maxIndex = max( maxIndex, max( iter->first, iter->second ) );
+    ++iter;
+  }
 
-    set<int > tempSet;
-    // add the pair to the tempSet
-    tempSet.insert(pairVector.front().first);
-    tempSet.insert(pairVector.front().second);
-
-    vector<vector< pair<int, int> >::iterator > tempIterVec;
-    tempIterVec.push_back(iter);
-
-    if ( iter + 1 != pairVector.end() ) {
-      vector< pair<int, int> >::iterator otherIter = iter + 1;
-      while (otherIter != pairVector.end() ) {
-        if ( ( tempSet.find(otherIter->first)  != tempSet.end() ) ||
-             ( tempSet.find(otherIter->second) != tempSet.end() ) ) {
-          tempSet.insert(otherIter->first);
-          tempSet.insert(otherIter->second);
-          tempIterVec.push_back(otherIter);
-        }
-        ++otherIter;
-      }
-    }
-    setVector->push_back(tempSet);
+  vector<int > parent( maxIndex + 1 );
+  for ( int index = 0; index <= maxIndex; ++index ) parent[ index ] = index;
+
+  for ( iter = pairVector.begin(); iter != pairVector.end(); ++iter ) {
+    int firstRoot  = findRoot( parent, iter->first );
+    int secondRoot = findRoot( parent, iter->second );
+    if ( firstRoot != secondRoot ) parent[ max( firstRoot, secondRoot ) ] = min( firstRoot, secondRoot );
+  }
+
+  // one set per tree, ordered by the lowest cluster index
+  vector<bool > isPaired( maxIndex + 1, false );
+  for ( iter = pairVector.begin(); iter != pairVector.end(); ++iter ) {
+    isPaired[ iter->first  ] = true;
+    isPaired[ iter->second ] = true;
+  }
 
-    // remove the pairs already grouped starting from the last
-    vector<vector< pair<int, int> >::iterator >::reverse_iterator iterIter = tempIterVec.rbegin();
-    while ( iterIter != tempIterVec.rend() ) {
-      pairVector.erase(*iterIter);
-      ++iterIter;
+  map<int, size_t > rootToSet;
+  for ( int index = 0; index <= maxIndex; ++index ) {
+    if ( !isPaired[ index ] ) continue;
+    int root = findRoot( parent, index );
+    map<int, size_t >::iterator found = rootToSet.find( root );
+    if ( found == rootToSet.end() ) {
+      found = rootToSet.insert( make_pair( root, setVector->size() ) ).first;
+      setVector->push_back( set<int >() );
     }
+    (*setVector)[ found->second ].insert( index );
   }
 }
 
@@ -31,6 +31,7 @@
 #include "EUTelSparseClusterImpl.h"
 #include "EUTelSparseData2Impl.h"
 #include "EUTelSparseCluster2Impl.h"
+#include "EUTelProfiler.h"
 
 // gear includes <.h>
 #include <gear/GearMgr.h>
@@ -770,29 +771,33 @@ void EUTelClusteringProcessor::processEvent (LCEvent * event)
     pulseCollection = new LCCollectionVec(LCIO::TRACKERPULSE);
   }
 
-  // 
-  // non Zero Suppresed (RAW data)
-  // 
-  if ( hasNZSData ) 
   {
-    // put here all the possible algorithm applicable to NZS data
-    if ( _nzsClusteringAlgo == EUTELESCOPE::FIXEDFRAME )     fixedFrameClustering(evt, pulseCollection);
-    if ( _nzsClusteringAlgo == EUTELESCOPE::BRICKEDCLUSTER ) nzsBrickedClustering(evt, pulseCollection);   // force 3x3 clusters         
-  }
+    EUTelProfiler::Scope profilerScope( "clustering" );
 
-  // 
-  // ZS data
-  //
-  if ( hasZSData ) 
-  {
-    // put here all the possible algorithm applicable to ZS data
-    if      ( _zsClusteringAlgo == EUTELESCOPE::SPARSECLUSTER  ) sparseClustering(evt, pulseCollection);
-    else if ( _zsClusteringAlgo == EUTELESCOPE::SPARSECLUSTER2 ) sparseClustering2(evt, pulseCollection);
-    else if ( _zsClusteringAlgo == EUTELESCOPE::FIXEDFRAME     ) zsFixedFrameClustering(evt, pulseCollection);
-    else if ( _zsClusteringAlgo == EUTELESCOPE::DFIXEDFRAME    ) digitalFixedFrameClustering(evt, pulseCollection);
-
-    // the bricked clustering type is solely needed for TAKI sensors type 
-    else if ( _zsClusteringAlgo == EUTELESCOPE::BRICKEDCLUSTER ) zsBrickedClustering(evt, pulseCollection); // force 3x3 clusters      
+    // 
+    // non Zero Suppresed (RAW data)
+    // 
+    if ( hasNZSData ) 
+    {
+      // put here all the possible algorithm applicable to NZS data
+      if ( _nzsClusteringAlgo == EUTELESCOPE::FIXEDFRAME )     fixedFrameClustering(evt, pulseCollection);
+      if ( _nzsClusteringAlgo == EUTELESCOPE::BRICKEDCLUSTER ) nzsBrickedClustering(evt, pulseCollection);   // force 3x3 clusters         
+    }
+
+    // 
+    // ZS data
+    //
+    if ( hasZSData ) 
+    {
+      // put here all the possible algorithm applicable to ZS data
+      if      ( _zsClusteringAlgo == EUTELESCOPE::SPARSECLUSTER  ) sparseClustering(evt, pulseCollection);
+      else if ( _zsClusteringAlgo == EUTELESCOPE::SPARSECLUSTER2 ) sparseClustering2(evt, pulseCollection);
+      else if ( _zsClusteringAlgo == EUTELESCOPE::FIXEDFRAME     ) zsFixedFrameClustering(evt, pulseCollection);
+      else if ( _zsClusteringAlgo == EUTELESCOPE::DFIXEDFRAME    ) digitalFixedFrameClustering(evt, pulseCollection);
+
+      // the bricked clustering type is solely needed for TAKI sensors type 
+      else if ( _zsClusteringAlgo == EUTELESCOPE::BRICKEDCLUSTER ) zsBrickedClustering(evt, pulseCollection); // force 3x3 clusters      
+    }
   }
 
   // if the pulseCollection is not empty add it to the event
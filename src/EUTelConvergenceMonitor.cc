@@ -0,0 +1,133 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelConvergenceMonitor.h"
+#include "EUTELESCOPE.h"
+
+// system includes <>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+using namespace marlin;
+using namespace eutelescope;
+
+EUTelConvergenceMonitor & EUTelConvergenceMonitor::instance() {
+  static EUTelConvergenceMonitor monitor;
+  return monitor;
+}
+
+EUTelConvergenceMonitor::EUTelConvergenceMonitor() :
+  _processors(),
+  _requiredStableUpdates(3) {
+}
+
+void EUTelConvergenceMonitor::registerEstimator(Processor * processor, const string & name,
+                                                double tolerance, int eventsPlanned) {
+
+  map< Processor *, ProcessorState >::iterator iter = _processors.find( processor );
+  if ( iter == _processors.end() ) {
+    ProcessorState state;
+    state.eventsPlanned = eventsPlanned;
+    state.nEvent        = 0;
+    state.done          = false;
+    state.converged     = false;
+    iter = _processors.insert( make_pair( processor, state ) ).first;
+  }
+
+  Estimator estimator;
+  estimator.name          = name;
+  estimator.tolerance     = tolerance;
+  estimator.value         = 0.;
+  estimator.hasValue      = false;
+  estimator.stableUpdates = 0;
+  iter->second.estimators.push_back( estimator );
+  iter->second.converged = false;
+}
+
+void EUTelConvergenceMonitor::update(Processor * processor, const string & name, double value, int nEvent) {
+
+  map< Processor *, ProcessorState >::iterator iter = _processors.find( processor );
+  if ( iter == _processors.end() ) return;
+  ProcessorState & state = iter->second;
+  state.nEvent = nEvent;
+
+  bool converged = true;
+  for ( size_t i = 0; i < state.estimators.size(); ++i ) {
+    Estimator & estimator = state.estimators[i];
+    if ( estimator.name == name ) {
+      if ( estimator.hasValue && abs( value - estimator.value ) <= estimator.tolerance ) {
+        ++estimator.stableUpdates;
+      } else {
+        estimator.stableUpdates = 0;
+      }
+      estimator.value    = value;
+      estimator.hasValue = true;
+    }
+    if ( estimator.stableUpdates < _requiredStableUpdates ) converged = false;
+  }
+
+  if ( converged && ! state.converged ) {
+    streamlog_out( MESSAGE5 ) << processor->name() << " converged after " << nEvent << " events" << endl;
+  }
+  state.converged = converged;
+}
+
+void EUTelConvergenceMonitor::reset(Processor * processor) {
+
+  map< Processor *, ProcessorState >::iterator iter = _processors.find( processor );
+  if ( iter == _processors.end() ) return;
+  ProcessorState & state = iter->second;
+  for ( size_t i = 0; i < state.estimators.size(); ++i ) {
+    state.estimators[i].hasValue      = false;
+    state.estimators[i].stableUpdates = 0;
+  }
+  state.converged = false;
+}
+
+void EUTelConvergenceMonitor::setDone(Processor * processor, int nEvent) {
+
+  map< Processor *, ProcessorState >::iterator iter = _processors.find( processor );
+  if ( iter == _processors.end() ) return;
+  iter->second.done   = true;
+  iter->second.nEvent = nEvent;
+}
+
+bool EUTelConvergenceMonitor::hasConverged(Processor * processor) const {
+
+  map< Processor *, ProcessorState >::const_iterator iter = _processors.find( processor );
+  return iter != _processors.end() && iter->second.converged;
+}
+
+void EUTelConvergenceMonitor::check(Processor * processor) {
+
+  if ( _processors.empty() ) return;
+
+  map< Processor *, ProcessorState >::const_iterator iter;
+  for ( iter = _processors.begin(); iter != _processors.end(); ++iter ) {
+    if ( ! iter->second.converged && ! iter->second.done ) return;
+  }
+
+  streamlog_out( MESSAGE5 ) << "All the monitored processors have converged, stopping the job" << endl;
+  for ( iter = _processors.begin(); iter != _processors.end(); ++iter ) {
+    const ProcessorState & state = iter->second;
+    if ( state.done && ! state.converged ) {
+      streamlog_out( MESSAGE5 ) << "  " << iter->first->name() << ": read all the " << state.nEvent << " events planned" << endl;
+    } else {
+      int saved = state.eventsPlanned - state.nEvent;
+      streamlog_out( MESSAGE5 ) << "  " << iter->first->name() << ": converged, stopped after " << state.nEvent
+                                << " of " << state.eventsPlanned << " events, "
+                                << ( saved > 0 ? saved : 0 ) << " events saved" << endl;
+    }
+  }
+
+  throw StopProcessingException( processor );
+}
@@ -13,6 +13,7 @@
 #include "EUTelExceptions.h"
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelEventImpl.h"
+#include "EUTelThreadUtility.h"
 
 // GEAR includes
 #include <gear/GearMgr.h>
@@ -71,7 +72,15 @@ std::string EUTelConvertCMSPixel::_dcolMonitorEvtHistoName        = "dcolMonitor
 #endif
 
 
-EUTelConvertCMSPixel::EUTelConvertCMSPixel ():DataSourceProcessor  ("EUTelConvertCMSPixel") {
+EUTelConvertCMSPixel::EUTelConvertCMSPixel ():DataSourceProcessor  ("EUTelConvertCMSPixel"),
+  _decoderQueueSize(0),
+  _readout(NULL),
+  _maxTrigger(0),
+  _decodedEvents(),
+  _freeEvents(NULL),
+  _readyEvents(NULL),
+  _decoderThread(),
+  _isDecoderThreadRunning(false) {
 
   _description =
     "Reads PSI46 testboard data files and creates LCEvents (zero suppressed data as sparsePixel).\n"
@@ -124,6 +133,9 @@ EUTelConvertCMSPixel::EUTelConvertCMSPixel ():DataSourceProcessor  ("EUTelConver
   registerOptionalParameter("debugDecoder","Set decoder verbosity level: QUIET, SUMMARY, ERROR, WARNING, INFO, DEBUG, DEBUG1-4", _debugSwitch, static_cast< std::string > ( "SUMMARY" ) );
   
   registerProcessorParameter("HistogramFilling","Switch on or off the histogram filling", _fillHistos, static_cast< bool > ( true ) );
+
+  registerOptionalParameter("DecoderQueueSize","Number of events decoded ahead by a separate decoder thread while the processors run. 0 decodes in sequence on the Marlin thread.",
+			    _decoderQueueSize, static_cast< int > ( 0 ) );
  
 }
 
@@ -187,7 +199,6 @@ void EUTelConvertCMSPixel::readDataSource (int Ntrig)
 {
    
   EUTelEventImpl *evt = NULL;
-  CMSPixelFileDecoder *readout;
 
   // Initialize geometry:
   initializeGeometry();
@@ -202,195 +213,60 @@ void EUTelConvertCMSPixel::readDataSource (int Ntrig)
     streamlog_out( DEBUG5 ) << "Constructing RAL testboard decoder..." << endl;
     streamlog_out( DEBUG5 ) << "Parameters: file: " << _fileName << " nROCs: " << _noOfROC 
 			    << " flags: " << flags << " rocType: " << _ROC_type << endl;
-    readout = new CMSPixelFileDecoderRAL(_fileName.c_str(),_noOfROC,flags,_ROC_type);
+    _readout = new CMSPixelFileDecoderRAL(_fileName.c_str(),_noOfROC,flags,_ROC_type);
   }
   else if(strcmp(_TB_type.c_str(),"PSI_DTB") == 0) {
     streamlog_out( DEBUG5 ) << "Constructing PSI_DTB testboard decoder..." << endl;
     streamlog_out( DEBUG5 ) << "Parameters: file: " << _fileName << " nROCs: " << _noOfROC 
 			    << " flags: " << flags << " rocType: " << _ROC_type 
 			    << " levels: " << _levelsFile << endl;
-    readout = new CMSPixelFileDecoderPSI_DTB(_fileName.c_str(),_noOfROC,flags,_ROC_type,_levelsFile.c_str());
+    _readout = new CMSPixelFileDecoderPSI_DTB(_fileName.c_str(),_noOfROC,flags,_ROC_type,_levelsFile.c_str());
   }
   else if(strcmp(_TB_type.c_str(),"PSI_ATB") == 0) {
     streamlog_out( DEBUG5 ) << "Constructing PSI_ATB testboard decoder..." << endl;
     streamlog_out( DEBUG5 ) << "Parameters: file: " << _fileName << " nROCs: " << _noOfROC 
 			    << " flags: " << flags << " rocType: " << _ROC_type
 			    << " levels: " << _levelsFile << endl;
-    readout = new CMSPixelFileDecoderPSI_ATB(_fileName.c_str(),_noOfROC,flags,_ROC_type,_levelsFile.c_str());
+    _readout = new CMSPixelFileDecoderPSI_ATB(_fileName.c_str(),_noOfROC,flags,_ROC_type,_levelsFile.c_str());
   }
   else {
     throw DataNotAvailableException("Could not determine correct testboard type. Check configuration.");
   }
 
+  // The run header goes first, we are in the BORE:
+  if(_isFirstEvent) {
+    processRunHeader();
+    _isFirstEvent = false;
+  }
 
-  // Loop while we have input data, break points set in Decoder call:
-  while (true) {
-
-      // Check if it's the first event:
-      if(_isFirstEvent) {
-	// We are in the first event, so type BORE. Write the run header.
-	auto_ptr<IMPL::LCRunHeaderImpl> lcHeader  ( new IMPL::LCRunHeaderImpl );
-	auto_ptr<EUTelRunHeaderImpl>    runHeader ( new EUTelRunHeaderImpl (lcHeader.get()) );
-	runHeader->addProcessor( type() );
-	runHeader->lcRunHeader()->setDescription(" Events read from CMSPixel input file: " + _fileName);
-	runHeader->lcRunHeader()->setRunNumber (_runNumber);
-	runHeader->setHeaderVersion (0.0001);
-	runHeader->setDataType (EUTELESCOPE::CONVDATA);
-	runHeader->setDateTime ();
-	runHeader->addIntermediateFile (_fileName);
-	runHeader->addProcessor (_processorName);
-	runHeader->setNoOfDetector(_noOfROC);
-	runHeader->setMinX(IntVec(_noOfROC, 0));
-	runHeader->setMaxX(IntVec(_noOfROC, _noOfXPixel - 1));
-	runHeader->setMinY(IntVec(_noOfROC, 0));
-	runHeader->setMaxY(IntVec(_noOfROC, _noOfYPixel - 1));
-	runHeader->lcRunHeader()->setDetectorName("CMSPixelTelescope");
-
-	// Process the run header:
-	ProcessorMgr::instance()->processRunHeader(static_cast<lcio::LCRunHeader*>(lcHeader.release()));
-            
-	// Book histogramms:
-	if(_fillHistos) bookHistos();
-
-	_isFirstEvent = false;
-      }
-
-      // Trigger counter:
-      if(eventNumber >= Ntrig) {
-	streamlog_out ( MESSAGE5 ) << " ---------------------------------------------------------" << endl;
-	streamlog_out ( MESSAGE5 ) << "  End of processing: reached MaxRecordNumber (" << Ntrig << ")" << endl;
-	streamlog_out ( MESSAGE5 ) << "  If you want to process more events check your steerfile." << endl;                                    
-	break;
-      }
-      eventNumber++;
-
-    
-      // Initialize pixel vector:
-      std::vector< pixel > event_data;
-      CMSPixel::timing evt_timing;
-
-      // Read next event from file, containing all ROCs / pixels for one trigger:
-      status = readout->get_event(&event_data,evt_timing);
-
-      // Fill the trigger phase histogram for all events, even empty ones:
-      (dynamic_cast<AIDA::IHistogram1D*> (_aidaHistoMap[_triggerPhaseHistoName]))->fill((int)evt_timing.trigger_phase);
-
-      // Get timestamp from first event:
-      if(timestamp_event1 == 0) timestamp_event1 = evt_timing.timestamp;
-
-      if(status <= DEC_ERROR_NO_MORE_DATA) {
-	streamlog_out (ERROR) << "Decoder returned error " << status << std::endl;
-	// We didn't write single event - it was just impossible to open/read the data file:
-	if(eventNumber == 1) {
-	  streamlog_out ( WARNING ) << "The data file contained no valid event." << endl;
-	  readout->statistics.print();
-	  throw DataNotAvailableException("Failed to read from data file.");
-	}
-	// Else: we just reached EOF.
-	else break;
-      }
-      else if(status <= DEC_ERROR_NO_TBM_HEADER ) {
-	streamlog_out (WARNING5) << "There was an exception while processing event " << eventNumber << ". Will continue with next event." << std::endl;
-	continue;
-      }
-      else if(status <= DEC_ERROR_INVALID_ROC_HEADER) {
-	streamlog_out (DEBUG5) << "Issue with ROC header or pixel address in event " << eventNumber << ". Event will be used anyway." << std::endl;
-      }
-      else if(!_writeEmptyEvents && status == DEC_ERROR_EMPTY_EVENT) {
-	streamlog_out (DEBUG5) << "Event " << eventNumber << " is empty. Continuing with next." << std::endl;
-	continue;
-      }
-      
-      streamlog_out(DEBUG5) << "Event read: " << event_data.size() << " hits" << std::endl;
-      for(std::vector<pixel>::const_iterator it = event_data.begin(); it < event_data.end(); ++it) {
-	streamlog_out(DEBUG5) << "ROC" << (*it).roc << " x" << (*it).col << " y" << (*it).row 
-			      << " ph" << (*it).raw << std::endl;
-      }
-
-      LCCollectionVec * sparseDataCollection = new LCCollectionVec(LCIO::TRACKERDATA);
-
-
-      // Fill the trigger phase histograms of events containing a hit:
-      if(!event_data.empty()) (dynamic_cast<AIDA::IHistogram1D*> (_aidaHistoMap[_triggerPhaseHitHistoName]))->fill((int)evt_timing.trigger_phase);
-      // Initialize bool to write trigger phase for events within the cut boundaries:
-      bool cut_done = false;
+  _maxTrigger = Ntrig;
+  if(_decoderQueueSize > 0) startDecoderThread();
+  else _decodedEvents.assign(1, new DecodedEvent);
 
-      // Initialize iterator ROC counter:
-      std::vector<pixel>::const_iterator it = event_data.begin();
-        
-      // Now loop over all ROC chips to be read out:
-      for(uint16_t iROC = 0; iROC < _noOfROC; iROC++) {
-	//      while(it != event_data.end()) {
-
-	//streamlog_out(DEBUG5) << "Processing ROC " << (*it).roc << std::endl;
-	streamlog_out(DEBUG5) << "Processing ROC " << iROC << std::endl;
-	//iROC = (*it).roc;
-
-	// Prepare the sensor's header:
-	TrackerDataImpl * sparse = new TrackerDataImpl();
-	CellIDEncoder<TrackerDataImpl> sparseDataEncoder(EUTELESCOPE::ZSDATADEFAULTENCODING, sparseDataCollection);
-	sparseDataEncoder["sensorID"]        = iROC;//(*it).roc;
-	sparseDataEncoder["sparsePixelType"] = static_cast<int>(1);
-	sparseDataEncoder.setCellID(sparse);
-	EUTelSparseDataImpl<EUTelSimpleSparsePixel> sparseData(sparse) ;
-        
-	// Now add all the pixel hits to that sensor:
-	while(it != event_data.end() && iROC == (*it).roc) {
-	  streamlog_out(DEBUG5) << "At ROC " << (*it).roc << ", still having hit data..." << std::endl;
-	  // Create a new pixel to be stored:
-	  auto_ptr<EUTelSimpleSparsePixel> sparsePixel(new EUTelSimpleSparsePixel);
-	  sparsePixel->setXCoord( static_cast<int>((*it).col ));
-	  sparsePixel->setYCoord( static_cast<int>((*it).row ));
-	  sparsePixel->setSignal( static_cast<short>((*it).raw));
-	  streamlog_out(DEBUG0) << (*sparsePixel.get()) << endl;
-	  
-	  // Fill histogramms if necessary:
-	  if(_fillHistos) fillHistos((*it).col, (*it).row, (*it).raw, (*it).roc, evt_timing.timestamp, evt_timing.trigger_phase, eventNumber);
-
-	  // Fill the trigger phase histogram (hit/cut) if we have pixel hits within the cut boundaries:
-	  if((*it).roc == _cutHitmap[0] 
-	     && (*it).col >= _cutHitmap[1] && (*it).col <= _cutHitmap[2]
-	     && (*it).row >= _cutHitmap[3] && (*it).row <= _cutHitmap[4]) {
-	      string tempHistoName = _hitMapCutHistoName + "_d" + to_string((*it).roc);
-	      (dynamic_cast<AIDA::IHistogram2D*> (_aidaHistoMap[tempHistoName]))->fill(static_cast<double >((*it).col), static_cast<double >((*it).row), 1.);
-
-	      if(!cut_done) {
-		(dynamic_cast<AIDA::IHistogram1D*> (_aidaHistoMap[_triggerPhaseHitCutHistoName]))->fill((int)evt_timing.trigger_phase);
-		cut_done = true;
-	      }
-	  }
-
-	  sparseData.addSparsePixel(sparsePixel.get());
-	  
-	  // Move on to next pixel hit:
-	  ++it;
-	}
-	
-	streamlog_out(DEBUG5) << sparseData.size() << " pixel hits stored for this ROC." << std::endl;
-	sparseDataCollection->push_back( sparse );
-            
+  // Loop while we have input data, break points set in Decoder call:
+  try {
+    while (true) {
+
+      DecodedEvent * decoded = NULL;
+      if(_isDecoderThreadRunning) {
+	// the decoder thread always sends a last slot before leaving
+	if(!_readyEvents->pop(decoded)) break;
+      } else {
+	decoded = _decodedEvents[0];
+	decodeEvent(decoded);
       }
 
-      streamlog_out(DEBUG5) << "We stored all pixel hits on " << sparseDataCollection->size() 
-			    << " ROCs, finalising event now..." << std::endl;
-
-      // Start constructing current event:
-      evt = new EUTelEventImpl();
-      evt->setDetectorName("CMSPixelTelescope");
-      evt->setEventType(kDE);
-      evt->setRunNumber (_runNumber);
-      evt->setEventNumber (eventNumber);
-      LCTime * now = new LCTime();
-      evt->setTimeStamp(evt_timing.timestamp);
-      delete now;
-      // ...and write it out:
-      evt->addCollection (sparseDataCollection, _sparseDataCollectionName);
-      ProcessorMgr::instance()->processEvent(static_cast<LCEventImpl*> (evt));
-     
-      delete evt;
+      bool isLast = processDecodedEvent(decoded);
+      if(_isDecoderThreadRunning) _freeEvents->push(decoded);
+      if(isLast) break;
 
     }; // end of while (true)
-
+  } catch(...) {
+    // don't leave the decoder thread behind, e.g. on a StopProcessingException
+    stopDecoderThread();
+    throw;
+  }
+  stopDecoderThread();
 
   // Write last event with type EORE
   eventNumber++;    
@@ -408,7 +284,8 @@ void EUTelConvertCMSPixel::readDataSource (int Ntrig)
         
   // Print the readout statistics, invoked by the destructor:
   streamlog_out ( MESSAGE5 ) << " ---------------------------------------------------------" << endl;    
-  delete readout;
+  delete _readout;
+  _readout = NULL;
   streamlog_out ( MESSAGE5 ) << " ---------------------------------------------------------" << endl;    
 
   // Delete the EORE event:    
@@ -416,6 +293,272 @@ void EUTelConvertCMSPixel::readDataSource (int Ntrig)
 }
 
 
+void EUTelConvertCMSPixel::processRunHeader() {
+
+  auto_ptr<IMPL::LCRunHeaderImpl> lcHeader  ( new IMPL::LCRunHeaderImpl );
+  auto_ptr<EUTelRunHeaderImpl>    runHeader ( new EUTelRunHeaderImpl (lcHeader.get()) );
+  runHeader->addProcessor( type() );
+  runHeader->lcRunHeader()->setDescription(" Events read from CMSPixel input file: " + _fileName);
+  runHeader->lcRunHeader()->setRunNumber (_runNumber);
+  runHeader->setHeaderVersion (0.0001);
+  runHeader->setDataType (EUTELESCOPE::CONVDATA);
+  runHeader->setDateTime ();
+  runHeader->addIntermediateFile (_fileName);
+  runHeader->addProcessor (_processorName);
+  runHeader->setNoOfDetector(_noOfROC);
+  runHeader->setMinX(IntVec(_noOfROC, 0));
+  runHeader->setMaxX(IntVec(_noOfROC, _noOfXPixel - 1));
+  runHeader->setMinY(IntVec(_noOfROC, 0));
+  runHeader->setMaxY(IntVec(_noOfROC, _noOfYPixel - 1));
+  runHeader->lcRunHeader()->setDetectorName("CMSPixelTelescope");
+
+  // Process the run header:
+  ProcessorMgr::instance()->processRunHeader(static_cast<lcio::LCRunHeader*>(lcHeader.release()));
+            
+  // Book histogramms:
+  if(_fillHistos) bookHistos();
+}
+
+
+EUTelConvertCMSPixel::DecoderVerdict EUTelConvertCMSPixel::verdictFor(int decoderStatus) const {
+
+  if(decoderStatus <= DEC_ERROR_NO_MORE_DATA) return kEndOfData;
+  if(decoderStatus <= DEC_ERROR_NO_TBM_HEADER) return kSkipEvent;
+  // Issues with ROC header or pixel address: event will be used anyway.
+  if(decoderStatus <= DEC_ERROR_INVALID_ROC_HEADER) return kUseEvent;
+  if(!_writeEmptyEvents && decoderStatus == DEC_ERROR_EMPTY_EVENT) return kSkipEvent;
+  return kUseEvent;
+}
+
+
+void EUTelConvertCMSPixel::decodeEvent(DecodedEvent * decoded) {
+
+  decoded->evt = NULL;
+
+  // Trigger counter:
+  if(eventNumber >= _maxTrigger) {
+    decoded->verdict = kTriggerLimit;
+    return;
+  }
+  eventNumber++;
+  decoded->eventNumber = eventNumber;
+
+  // Read next event from file, containing all ROCs / pixels for one
+  // trigger. The pixel vector keeps its capacity from the previous use.
+  decoded->data.clear();
+  decoded->status  = _readout->get_event(&decoded->data, decoded->evtTiming);
+  decoded->verdict = verdictFor(decoded->status);
+
+  if(decoded->verdict == kUseEvent) decoded->evt = buildEvent(decoded->data, decoded->evtTiming, decoded->eventNumber);
+}
+
+
+EUTelEventImpl * EUTelConvertCMSPixel::buildEvent(const std::vector< pixel > & eventData,
+						  const CMSPixel::timing & evtTiming, int evtNumber) const {
+
+  LCCollectionVec * sparseDataCollection = new LCCollectionVec(LCIO::TRACKERDATA);
+
+  // Initialize iterator ROC counter:
+  std::vector<pixel>::const_iterator it = eventData.begin();
+        
+  // Now loop over all ROC chips to be read out:
+  for(uint16_t iROC = 0; iROC < _noOfROC; iROC++) {
+
+    // Prepare the sensor's header:
+    TrackerDataImpl * sparse = new TrackerDataImpl();
+    CellIDEncoder<TrackerDataImpl> sparseDataEncoder(EUTELESCOPE::ZSDATADEFAULTENCODING, sparseDataCollection);
+    sparseDataEncoder["sensorID"]        = iROC;
+    sparseDataEncoder["sparsePixelType"] = static_cast<int>(1);
+    sparseDataEncoder.setCellID(sparse);
+    EUTelSparseDataImpl<EUTelSimpleSparsePixel> sparseData(sparse) ;
+
+    // Hits are ordered by ROC, so we know in advance how many of
+    // them belong to this sensor:
+    std::vector<pixel>::const_iterator rocEnd = it;
+    while(rocEnd != eventData.end() && iROC == (*rocEnd).roc) ++rocEnd;
+    sparseData.reserve(static_cast<unsigned int>(rocEnd - it));
+        
+    // Now add all the pixel hits to that sensor:
+    for(; it != rocEnd; ++it) {
+      sparseData.addSparsePixel( static_cast<short>((*it).col), static_cast<short>((*it).row), static_cast<short>((*it).raw) );
+    }
+	
+    sparseDataCollection->push_back( sparse );
+  }
+
+  // Start constructing current event:
+  EUTelEventImpl * evt = new EUTelEventImpl();
+  evt->setDetectorName("CMSPixelTelescope");
+  evt->setEventType(kDE);
+  evt->setRunNumber (_runNumber);
+  evt->setEventNumber (evtNumber);
+  evt->setTimeStamp(evtTiming.timestamp);
+  evt->addCollection (sparseDataCollection, _sparseDataCollectionName);
+  return evt;
+}
+
+
+bool EUTelConvertCMSPixel::processDecodedEvent(DecodedEvent * decoded) {
+
+  if(decoded->verdict == kTriggerLimit) {
+    streamlog_out ( MESSAGE5 ) << " ---------------------------------------------------------" << endl;
+    streamlog_out ( MESSAGE5 ) << "  End of processing: reached MaxRecordNumber (" << _maxTrigger << ")" << endl;
+    streamlog_out ( MESSAGE5 ) << "  If you want to process more events check your steerfile." << endl;                                    
+    return true;
+  }
+
+  const int evtNumber = decoded->eventNumber;
+  const int decoderStatus = decoded->status;
+
+  // Fill the trigger phase histogram for all events, even empty ones:
+  (dynamic_cast<AIDA::IHistogram1D*> (_aidaHistoMap[_triggerPhaseHistoName]))->fill((int)decoded->evtTiming.trigger_phase);
+
+  // Get timestamp from first event:
+  if(timestamp_event1 == 0) timestamp_event1 = decoded->evtTiming.timestamp;
+
+  if(decoded->verdict == kEndOfData) {
+    streamlog_out (ERROR) << "Decoder returned error " << decoderStatus << std::endl;
+    // We didn't write single event - it was just impossible to open/read the data file:
+    if(evtNumber == 1) {
+      streamlog_out ( WARNING ) << "The data file contained no valid event." << endl;
+      _readout->statistics.print();
+      throw DataNotAvailableException("Failed to read from data file.");
+    }
+    // Else: we just reached EOF.
+    return true;
+  }
+  else if(decoded->verdict == kSkipEvent) {
+    if(decoderStatus <= DEC_ERROR_NO_TBM_HEADER) {
+      streamlog_out (WARNING5) << "There was an exception while processing event " << evtNumber << ". Will continue with next event." << std::endl;
+    } else {
+      streamlog_out (DEBUG5) << "Event " << evtNumber << " is empty. Continuing with next." << std::endl;
+    }
+    return false;
+  }
+  else if(decoderStatus <= DEC_ERROR_INVALID_ROC_HEADER) {
+    streamlog_out (DEBUG5) << "Issue with ROC header or pixel address in event " << evtNumber << ". Event will be used anyway." << std::endl;
+  }
+      
+  streamlog_out(DEBUG5) << "Event read: " << decoded->data.size() << " hits" << std::endl;
+  for(std::vector<pixel>::const_iterator it = decoded->data.begin(); it < decoded->data.end(); ++it) {
+    streamlog_out(DEBUG5) << "ROC" << (*it).roc << " x" << (*it).col << " y" << (*it).row 
+			  << " ph" << (*it).raw << std::endl;
+  }
+
+  fillEventHistos(decoded->data, decoded->evtTiming, evtNumber);
+
+  // ...and write it out:
+  ProcessorMgr::instance()->processEvent(static_cast<LCEventImpl*> (decoded->evt));
+     
+  delete decoded->evt;
+  decoded->evt = NULL;
+  return false;
+}
+
+
+void EUTelConvertCMSPixel::fillEventHistos(const std::vector< pixel > & eventData,
+					   const CMSPixel::timing & evtTiming, int evtNumber) {
+
+  // Fill the trigger phase histograms of events containing a hit:
+  if(!eventData.empty()) (dynamic_cast<AIDA::IHistogram1D*> (_aidaHistoMap[_triggerPhaseHitHistoName]))->fill((int)evtTiming.trigger_phase);
+  // Initialize bool to write trigger phase for events within the cut boundaries:
+  bool cut_done = false;
+
+  // Same ROC by ROC walk as in buildEvent, so that exactly the stored
+  // hits are histogrammed:
+  std::vector<pixel>::const_iterator it = eventData.begin();
+  for(uint16_t iROC = 0; iROC < _noOfROC; iROC++) {
+    for(; it != eventData.end() && iROC == (*it).roc; ++it) {
+
+      // Fill histogramms if necessary:
+      if(_fillHistos) fillHistos((*it).col, (*it).row, (*it).raw, (*it).roc, evtTiming.timestamp, evtTiming.trigger_phase, evtNumber);
+
+      // Fill the trigger phase histogram (hit/cut) if we have pixel hits within the cut boundaries:
+      if((*it).roc == _cutHitmap[0] 
+	 && (*it).col >= _cutHitmap[1] && (*it).col <= _cutHitmap[2]
+	 && (*it).row >= _cutHitmap[3] && (*it).row <= _cutHitmap[4]) {
+	string tempHistoName = _hitMapCutHistoName + "_d" + to_string((*it).roc);
+	(dynamic_cast<AIDA::IHistogram2D*> (_aidaHistoMap[tempHistoName]))->fill(static_cast<double >((*it).col), static_cast<double >((*it).row), 1.);
+
+	if(!cut_done) {
+	  (dynamic_cast<AIDA::IHistogram1D*> (_aidaHistoMap[_triggerPhaseHitCutHistoName]))->fill((int)evtTiming.trigger_phase);
+	  cut_done = true;
+	}
+      }
+    }
+  }
+}
+
+
+void EUTelConvertCMSPixel::startDecoderThread() {
+
+  // one slot for each queued event, plus the one being decoded and
+  // the one being processed
+  const size_t noOfSlots = static_cast<size_t>(_decoderQueueSize) + 2;
+  _decodedEvents.clear();
+  _freeEvents  = new EUTelBoundedQueue< DecodedEvent * >(noOfSlots);
+  _readyEvents = new EUTelBoundedQueue< DecodedEvent * >(static_cast<size_t>(_decoderQueueSize));
+  for(size_t iSlot = 0; iSlot < noOfSlots; ++iSlot) {
+    _decodedEvents.push_back(new DecodedEvent);
+    _freeEvents->push(_decodedEvents.back());
+  }
+
+  if(pthread_create(&_decoderThread, NULL, &EUTelConvertCMSPixel::decoderThreadEntry, this) != 0) {
+    streamlog_out ( WARNING ) << "Unable to start the decoder thread, decoding in sequence." << endl;
+    delete _freeEvents;
+    delete _readyEvents;
+    _freeEvents = NULL;
+    _readyEvents = NULL;
+    for(size_t iSlot = 1; iSlot < noOfSlots; ++iSlot) delete _decodedEvents[iSlot];
+    _decodedEvents.resize(1);
+    return;
+  }
+  _isDecoderThreadRunning = true;
+  streamlog_out ( MESSAGE5 ) << "Decoder thread started, reading up to " << _decoderQueueSize << " events ahead" << endl;
+}
+
+
+void EUTelConvertCMSPixel::stopDecoderThread() {
+
+  if(_isDecoderThreadRunning) {
+    // closing the queues wakes the decoder up wherever it is waiting
+    _freeEvents->close();
+    _readyEvents->close();
+    pthread_join(_decoderThread, NULL);
+    _isDecoderThreadRunning = false;
+    delete _freeEvents;
+    delete _readyEvents;
+    _freeEvents = NULL;
+    _readyEvents = NULL;
+  }
+
+  // events decoded ahead but never processed:
+  for(size_t iSlot = 0; iSlot < _decodedEvents.size(); ++iSlot) {
+    delete _decodedEvents[iSlot]->evt;
+    delete _decodedEvents[iSlot];
+  }
+  _decodedEvents.clear();
+}
+
+
+void EUTelConvertCMSPixel::decodeAhead() {
+
+  DecodedEvent * decoded = NULL;
+  while(_freeEvents->pop(decoded)) {
+    decodeEvent(decoded);
+    const bool isLast = (decoded->verdict == kEndOfData || decoded->verdict == kTriggerLimit);
+    if(!_readyEvents->push(decoded)) break;
+    if(isLast) break;
+  }
+}
+
+
+void * EUTelConvertCMSPixel::decoderThreadEntry(void * self) {
+  static_cast< EUTelConvertCMSPixel * >(self)->decodeAhead();
+  return NULL;
+}
+
+
 void EUTelConvertCMSPixel::end () {
   message<MESSAGE5> ("Successfully finished") ;
 }
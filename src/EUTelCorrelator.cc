@@ -25,6 +25,7 @@
 #include "EUTelSparseClusterImpl.h"
 #include "EUTelExceptions.h"
 #include "EUTelAlignmentConstant.h"
+#include "EUTelHitStore.h"
 
 #include <UTIL/LCTime.h>
 
@@ -396,8 +397,6 @@ void EUTelCorrelator::processEvent (LCEvent * event) {
 
     } else {
     
-      FillHotPixelMap(event);
-
       bookHistos();
      
       if ( _useReferenceHitCollection ) 
@@ -637,66 +636,69 @@ void EUTelCorrelator::processEvent (LCEvent * event) {
 
     if ( _hasHitCollection ) {
 
-      LCCollectionVec * inputHitCollection = static_cast< LCCollectionVec *>
-        ( event->getCollection( _inputHitCollectionName )) ;
-      for ( size_t iExt = 0 ; iExt < inputHitCollection->size(); ++iExt ) {
-        std::vector<double> trackX;
-        std::vector<double> trackY;
-        std::vector<int  > iplane;
+      // the hits are decoded once per event for all the processors
+      // using the same collections
+      const EUTelHitStore & hitStore = EUTelHitStore::get( event, _inputHitCollectionName,
+                                                           _useReferenceHitCollection ? _referenceHitCollectionName : "" );
+      const std::vector< bool > & hotHits = hitStore.getHotFlags( _hotPixelCollectionName );
 
-       trackX.clear();
-       trackY.clear();
-       iplane.clear();
+      std::vector<double> trackX;
+      std::vector<double> trackY;
+      std::vector<int  > iplane;
 
+      for ( size_t iExtPlane = 0 ; iExtPlane < hitStore.getNPlanes(); ++iExtPlane ) {
 
-        // this is the external hit
-        TrackerHitImpl * externalHit = static_cast< TrackerHitImpl * > ( inputHitCollection->
-                                                                         getElementAt( iExt ) );
+        const EUTelHitStore::Plane & externalPlane = hitStore.getPlane( iExtPlane );
+        int externalSensorID = externalPlane.sensorID;
 
-        double * externalPosition;
-        externalPosition = const_cast< double* >( externalHit->getPosition() );
+        for ( size_t iExt = 0 ; iExt < externalPlane.size(); ++iExt ) {
 
-        int externalSensorID = guessSensorID( externalPosition );
+       trackX.clear();
+       trackY.clear();
+       iplane.clear();
 
+        // this is the external hit
+        const double externalX = externalPlane.x[ iExt ];
+        const double externalY = externalPlane.y[ iExt ];
 
-        trackX.push_back(externalPosition[0]);
-        trackY.push_back(externalPosition[1]);
+        trackX.push_back(externalX);
+        trackY.push_back(externalY);
         iplane.push_back(externalSensorID);
 
-        for ( size_t iInt = 0; iInt < inputHitCollection->size(); ++iInt ) 
+        for ( size_t iIntPlane = 0; iIntPlane < hitStore.getNPlanes(); ++iIntPlane ) 
         {
 
-          TrackerHitImpl  * internalHit = static_cast< TrackerHitImpl * > ( inputHitCollection->
-                                                                            getElementAt( iInt ) );
-          double * internalPosition;
-          internalPosition = const_cast< double* >( internalHit->getPosition() );
-
-          int internalSensorID = guessSensorID( internalPosition );
-          bool ishot = hitContainsHotPixels(internalHit); 
+          const EUTelHitStore::Plane & internalPlane = hitStore.getPlane( iIntPlane );
+          int internalSensorID = internalPlane.sensorID;
 
-          if( ishot ) continue;
-
-          if ( 
+          if ( !(
                   ( internalSensorID != getFixedPlaneID() && externalSensorID == getFixedPlaneID() )
                    ||
                   _sensorIDtoZOrderMap[internalSensorID] ==  _sensorIDtoZOrderMap[externalSensorID] +1 
-                  ) 
-            {
+                  ) ) continue;
+
+          int iz = _sensorIDtoZOrderMap[internalSensorID]; 
+
+          for ( size_t iInt = 0; iInt < internalPlane.size(); ++iInt ) 
+          {
+
+            if( hotHits[ internalPlane.collectionIndex[ iInt ] ] ) continue;
 
-            int iz = _sensorIDtoZOrderMap[internalSensorID]; 
+            const double internalX = internalPlane.x[ iInt ];
+            const double internalY = internalPlane.y[ iInt ];
 
             if(
-               ((externalPosition[0]-internalPosition[0] ) < _residualsXMax[iz]) && (_residualsXMin[iz] < (externalPosition[0]-internalPosition[0] ))   
+               ((externalX-internalX ) < _residualsXMax[iz]) && (_residualsXMin[iz] < (externalX-internalX ))   
                &&
-               ((externalPosition[1]-internalPosition[1] ) < _residualsYMax[iz]) && (_residualsYMin[iz] < (externalPosition[1]-internalPosition[1] ))
+               ((externalY-internalY ) < _residualsYMax[iz]) && (_residualsYMin[iz] < (externalY-internalY ))
               )
                {
-                trackX.push_back(internalPosition[0]);
-                trackY.push_back(internalPosition[1]);
+                trackX.push_back(internalX);
+                trackY.push_back(internalY);
                 iplane.push_back(internalSensorID);
 
                }
-            }
+          }
 
         }
 
@@ -718,6 +720,7 @@ if( static_cast< int >(iplane_unique.size()) > _minNumberOfCorrelatedHits && tra
 }else{
 }
  
+        }
       }
     }
   } catch (DataNotAvailableException& e  ) {
@@ -1462,54 +1465,6 @@ if(rowNBin>100) rowNBin=rowNBin/4;
 #endif
 }
 
-int EUTelCorrelator::guessSensorID(const double * hit ) 
-{
-
-  int sensorID = -1;
-  double minDistance =  numeric_limits< double >::max() ;
-
-  if( _referenceHitVec == 0 || _useReferenceHitCollection == false ){
-    // use z information of planes instead of reference vector
-    for ( int iPlane = 0 ; iPlane < _siPlanesLayerLayout->getNLayers(); ++iPlane ) {
-      double distance = std::abs( hit[2] - _siPlaneZPosition[ iPlane ] );
-      if ( distance < minDistance ) {
-	minDistance = distance;
-	sensorID = _siPlanesLayerLayout->getID( iPlane );
-      }
-    }
-    if ( minDistance > 30  ) {
-      // advice the user that the guessing wasn't successful 
-      streamlog_out( WARNING3 ) << "A hit was found " << minDistance << " mm far from the nearest plane\n"
-	"Please check the consistency of the data with the GEAR file: hitPosition[2]=" << hit[2] <<       endl;
-    }
-    
-    return sensorID;
-  }
-
-     streamlog_out( DEBUG5 ) << " _referenceHitVec " << _referenceHitVec << " " << _referenceHitCollectionName.c_str() << endl;
-     for(int ii = 0 ; ii <  _referenceHitVec->getNumberOfElements(); ii++)
-      {
-
-       EUTelReferenceHit* refhit = static_cast< EUTelReferenceHit*> ( _referenceHitVec->getElementAt(ii) ) ;
-       streamlog_out( DEBUG5 ) << " _referenceHitVec " << _referenceHitVec << " refhit " << refhit << endl;
-       
-        TVector3 hit3d( hit[0], hit[1], hit[2] );
-        TVector3 hitInPlane( refhit->getXOffset(), refhit->getYOffset(), refhit->getZOffset());
-        TVector3 norm2Plane( refhit->getAlpha(), refhit->getBeta(), refhit->getGamma() );
- 
-        double distance = abs( norm2Plane.Dot(hit3d-hitInPlane) );
-        if ( distance < minDistance ) 
-        {
-           minDistance = distance;
-           sensorID = refhit->getSensorID();
-        }    
-
-      }
-
-  return sensorID;
-}
-
-
 std::vector<double> EUTelCorrelator::guessSensorOffset(int internalSensorID, int externalSensorID, std::vector<double> cluCenter)
 
 {
@@ -1601,138 +1556,5 @@ std::vector<double> EUTelCorrelator::guessSensorOffset(int internalSensorID, int
       return cluster_offset;
 }
 
-void  EUTelCorrelator::FillHotPixelMap(LCEvent *event)
-{
-    LCCollectionVec *hotPixelCollectionVec = 0;
-    try 
-    {
-      hotPixelCollectionVec = static_cast< LCCollectionVec* > ( event->getCollection( _hotPixelCollectionName  ) );
-      streamlog_out ( DEBUG5 ) << "Hotpixel collection " << _hotPixelCollectionName.c_str() << " found" << endl; 
-    }
-    catch (...)
-    {
-      streamlog_out ( MESSAGE5 ) << "Hotpixel collection " << _hotPixelCollectionName.c_str() << " not found" << endl; 
-      return;
-    }
-
-        CellIDDecoder<TrackerDataImpl> cellDecoder( hotPixelCollectionVec );
-	
-        for(int i=0; i<  hotPixelCollectionVec->getNumberOfElements(); i++)
-        {
-           TrackerDataImpl* hotPixelData = dynamic_cast< TrackerDataImpl *> ( hotPixelCollectionVec->getElementAt( i ) );
-	   SparsePixelType  type         = static_cast<SparsePixelType> (static_cast<int> (cellDecoder( hotPixelData )["sparsePixelType"]));
-
-	   int sensorID              = static_cast<int > ( cellDecoder( hotPixelData )["sensorID"] );
-
-           if( type  == kEUTelAPIXSparsePixel)
-           {  
-           auto_ptr<EUTelSparseDataImpl<EUTelAPIXSparsePixel > > apixData(new EUTelSparseDataImpl<EUTelAPIXSparsePixel> ( hotPixelData ));
-	   std::vector<EUTelAPIXSparsePixel*> apixPixelVec;
-	     //auto_ptr<EUTelAPIXSparsePixel> apixPixel( new EUTelAPIXSparsePixel );
-	   EUTelAPIXSparsePixel apixPixel;
-	     //Push all single Pixels of one plane in the apixPixelVec
-
-           for ( unsigned int iPixel = 0; iPixel < apixData->size(); iPixel++ ) 
-           {
-              std::vector<int> apixColVec();
-              apixData->getSparsePixelAt( iPixel, &apixPixel);
-              try
-              {
-                 char ix[100];
-                 sprintf(ix, "%d,%d,%d", sensorID, apixPixel.getXCoord(), apixPixel.getYCoord() ); 
-                 _hotPixelMap[ix] = true;             
-              }
-              catch(...)
-              {
-		streamlog_out ( ERROR5 ) <<  "Cannot add pixel" << endl;
-              }
-           }
-
-
-           }  	
-       }
-
-}
- 
-
-bool EUTelCorrelator::hitContainsHotPixels( TrackerHitImpl   * hit) 
-{
-
-        try
-        {
-            LCObjectVec clusterVector = hit->getRawHits();
- 
-//            EUTelVirtualCluster * cluster;
-            if ( hit->getType() == kEUTelBrickedClusterImpl ) {
-
-               // fixed cluster implementation. Remember it
-               //  can come from
-               //  both RAW and ZS data
-   
-//              cluster = new EUTelBrickedClusterImpl(static_cast<TrackerDataImpl *> ( clusterVector[0] ) );
-                
-            } else if ( hit->getType() == kEUTelDFFClusterImpl ) {
-              
-              // fixed cluster implementation. Remember it can come from
-              // both RAW and ZS data
-//              cluster = new EUTelDFFClusterImpl( static_cast<TrackerDataImpl *> ( clusterVector[0] ) );
-            } else if ( hit->getType() == kEUTelFFClusterImpl ) {
-              
-              // fixed cluster implementation. Remember it can come from
-              // both RAW and ZS data
-//              cluster = new EUTelFFClusterImpl( static_cast<TrackerDataImpl *> ( clusterVector[0] ) );
-            } 
-            else if ( hit->getType() == kEUTelAPIXClusterImpl ) 
-            {
-                TrackerDataImpl * clusterFrame = static_cast<TrackerDataImpl*> ( clusterVector[0] );
-                eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelAPIXSparsePixel > 
-                              *apixCluster = new eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelAPIXSparsePixel >(clusterFrame);
-                
-		if(apixCluster == 0 ) throw UnknownDataTypeException(" problem accessing cluster ");
-                int sensorID = apixCluster->getDetectorID();
-                bool skipHit = 0;
-                for (size_t iPixel = 0; iPixel < apixCluster->size(); ++iPixel) 
-                {
-                    EUTelAPIXSparsePixel apixPixel;
-                    apixCluster->getSparsePixelAt(iPixel, &apixPixel);
-
-                    try
-                    {                       
-                       char ix[100];
-                       sprintf(ix, "%d,%d,%d", sensorID, apixPixel.getXCoord(), apixPixel.getYCoord() ); 
-                       if( _hotPixelMap[ix]  )
-                       { 
-                          skipHit = true; 	      
-                          delete apixCluster;
-                          return true; // if TRUE  this hit will be skipped
-                       }
-                       else
-                       { 
-                          skipHit = false; 	      
-                       } 
-                    } 
-                    catch (...)
-                    {
-                    }
-           
-                }
-
-                delete apixCluster;
-                return skipHit; // if TRUE  this hit will be skipped
-            } 
-            
-       }
-       catch(...)
-       { 
-          printf("something went wrong in EUTelCorrelator::hitContainsHotPixels \n");
-          // if anything went wrong in the above return FALSE, meaning do not skip this hit
-          return 0;
-       }
- 
-       // if none of the above worked return FALSE, meaning do not skip this hit
-       return 0;
-
-}
-
 
 #endif // USE_GEAR
@@ -74,6 +74,7 @@
 #include <vector>
 #include <map>
 #include <cstdlib>
+#include <algorithm>
 
 using namespace std;
 using namespace lcio ;
@@ -133,6 +134,10 @@ EUTelDUTHistograms::EUTelDUTHistograms()
   _bgfittedX(),
   _bgfittedY(),
   _DUTalign(),
+  _matches(),
+  _fitMatched(),
+  _hitMatched(),
+  _sortedHits(),
 _ClusterSizeHistos(),
 _ShiftHistos(),
 _MeasuredHistos(),
@@ -473,60 +478,25 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
 
   // Match measured and fitted positions
 
-  int nMatch=0;
-  double distmin;
+  matchFittedToMeasured();
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-//
-//
-//
-  for(int itrack=0; itrack< _maptrackid; itrack++)
-  {
-//  do{
-    int bestfit=-1;
-    int besthit=-1;
-
-    distmin = _distMax*_distMax + 10. ;
- 
-    if( static_cast<int>(_fittedX[itrack].size()) < 1 ) continue;
- 
-    for(int ifit=0;ifit<static_cast<int>(_fittedX[itrack].size()); ifit++)
-    {
-      if( _measuredX.empty() ) continue;
-
-      for(int ihit=0; ihit< static_cast<int>(_measuredX.size()) ; ihit++)
-        {
-
-          double dist2rd=
-            (_measuredX[ihit]-_fittedX[itrack][ifit])*(_measuredX[ihit]-_fittedX[itrack][ifit])
-            + (_measuredY[ihit]-_fittedY[itrack][ifit])*(_measuredY[ihit]-_fittedY[itrack][ifit]);
+  const int nMatch = static_cast<int>(_matches.size());
 
-	  if(streamlog_level(DEBUG5)){
-	    message<DEBUG5> ( log() << "Fit ["<< itrack << ":" << _maptrackid <<"], ifit= " << ifit << " ["<< _fittedX[itrack][ifit] << ":" << _fittedY[itrack][ifit] << "]" << endl) ;
-	    message<DEBUG5> ( log() << "rec " << ihit << " ["<< _measuredX[ihit] << ":" << _measuredY[ihit] << "]" << endl) ;
-	    message<DEBUG5> ( log() << "distance : " << TMath::Sqrt( dist2rd )  << endl) ;
-	  }
-          if(dist2rd<distmin)
-            {
-              distmin = dist2rd;
-              besthit = ihit;
-              bestfit = ifit;
-            }
-        }
- 
-    }
- 
-    // Match found:
+  if(streamlog_level(DEBUG5)){
+    message<DEBUG5> ( log() << nMatch << " DUT hits matched to fitted tracks ");
+    message<DEBUG5> ( log() << _measuredX.size() - nMatch << " DUT hits not matched to any track ");
+  }
 
-    if( distmin < _distMax*_distMax  )
-      {
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 
-        nMatch++;
+  for(int imatch=0; imatch<nMatch; imatch++)
+    {
+        const int itrack  = _matches[imatch].track;
+        const int bestfit = _matches[imatch].fit;
+        const int besthit = _matches[imatch].hit;
 
         // Matched hits positions
 
-#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-
 	// fill once for any matrix ("full detector")
         (dynamic_cast<AIDA::IHistogram1D*> ( _ClusterSizeHistos.at(projX).at(FullDetector)))->fill(_clusterSizeX[besthit]+0.0);
         (dynamic_cast<AIDA::IHistogram1D*> ( _ClusterSizeHistos.at(projY).at(FullDetector)))->fill(_clusterSizeY[besthit]+0.0);
@@ -612,24 +582,22 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
        } 
         // extend Eta histograms to 2 pitch range
 
-#endif
-
-        if(_localX[itrack][bestfit]<0)
-          _localX[itrack][bestfit]+=_pitchX;
+        double shiftedLocalX = _localX[itrack][bestfit];
+        if(shiftedLocalX<0)
+          shiftedLocalX+=_pitchX;
         else
-          _localX[itrack][bestfit]-=_pitchX;
+          shiftedLocalX-=_pitchX;
 
-        if(_localY[itrack][bestfit]<0)
-          _localY[itrack][bestfit]+=_pitchY;
+        double shiftedLocalY = _localY[itrack][bestfit];
+        if(shiftedLocalY<0)
+          shiftedLocalY+=_pitchY;
         else
-          _localY[itrack][bestfit]-=_pitchY;
+          shiftedLocalY-=_pitchY;
 
-#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-
-        _EtaXHisto->fill(_localX[itrack][bestfit],_measuredX[besthit]-_fittedX[itrack][bestfit]);
-        _EtaYHisto->fill(_localY[itrack][bestfit],_measuredY[besthit]-_fittedY[itrack][bestfit]);
-        _EtaX2DHisto->fill(_localX[itrack][bestfit],_measuredX[besthit]-_fittedX[itrack][bestfit]);
-        _EtaY2DHisto->fill(_localY[itrack][bestfit],_measuredY[besthit]-_fittedY[itrack][bestfit]);
+        _EtaXHisto->fill(shiftedLocalX,_measuredX[besthit]-_fittedX[itrack][bestfit]);
+        _EtaYHisto->fill(shiftedLocalY,_measuredY[besthit]-_fittedY[itrack][bestfit]);
+        _EtaX2DHisto->fill(shiftedLocalX,_measuredX[besthit]-_fittedX[itrack][bestfit]);
+        _EtaY2DHisto->fill(shiftedLocalY,_measuredY[besthit]-_fittedY[itrack][bestfit]);
 
         // Efficiency plots
         (dynamic_cast<AIDA::IProfile1D*> ( _EfficiencyHistos.at(projX)))->fill(_fittedX[itrack][bestfit],1.);
@@ -641,62 +609,34 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
         (dynamic_cast<AIDA::IProfile1D*> ( _NoiseHistos.at(projX)))->fill(_measuredX[besthit],0.);
         (dynamic_cast<AIDA::IProfile1D*> ( _NoiseHistos.at(projY)))->fill(_measuredY[besthit],0.);
         (dynamic_cast<AIDA::IProfile2D*> ( _NoiseHistos.at(projXY)))->fill(_measuredX[besthit],_measuredY[besthit],0.);
-
-#endif
-
-        // Remove matched entries from the list (so the next matching pair
-        // can be looked for)
-
-        _fittedX[itrack].erase(_fittedX[itrack].begin()+bestfit);
-        _fittedY[itrack].erase(_fittedY[itrack].begin()+bestfit);
-
-        _measuredX.erase(_measuredX.begin()+besthit);
-        _measuredY.erase(_measuredY.begin()+besthit);
-
-        _localX[itrack].erase(_localX[itrack].begin()+bestfit);
-        _localY[itrack].erase(_localY[itrack].begin()+bestfit);
-
-
-     }
-
-    // End of loop of matching DUT hits to fitted positions
-
-    if(streamlog_level(DEBUG5)){
-      message<DEBUG5> ( log() << nMatch << " DUT hits matched to fitted tracks ");
-      message<DEBUG5> ( log() << _measuredX.size() << " DUT hits not matched to any track ");
-      message<DEBUG5> ( log() << "track "<<itrack<<" has " << _fittedX[itrack].size() << " _fittedX[itrack].size() not matched to any DUT hit ");
     }
 
   // Efficiency plots - unmatched tracks
 
-#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-
-  for(int ifit=0;ifit<static_cast<int>(_localX[itrack].size()); ifit++)
-    {
-      _PixelEfficiencyHisto->fill(_localX[itrack][ ifit ]*1000.,_localY[itrack][ ifit ]*1000.,0.);
-    }
-
-  for(int ifit=0;ifit<static_cast<int>(_fittedX[itrack].size()); ifit++)
+  for(int itrack=0; itrack<_maptrackid; itrack++)
     {
-      (dynamic_cast<AIDA::IProfile1D*> ( _EfficiencyHistos.at(projX)))->fill(_fittedX[itrack][ifit],0.);
-      (dynamic_cast<AIDA::IProfile1D*> ( _EfficiencyHistos.at(projY)))->fill(_fittedY[itrack][ifit],0.);
-      (dynamic_cast<AIDA::IProfile2D*> ( _EfficiencyHistos.at(projXY)))->fill(_fittedX[itrack][ifit],_fittedY[itrack][ifit],0.);
-    }
-  #endif
-}
-//
-//
-//
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
+      const std::vector<double>& fittedX = _fittedX[itrack];
+      const std::vector<double>& fittedY = _fittedY[itrack];
+      const std::vector<double>& localX  = _localX[itrack];
+      const std::vector<double>& localY  = _localY[itrack];
 
+      for(int ifit=0;ifit<static_cast<int>(fittedX.size()); ifit++)
+        {
+          if( _fitMatched[itrack][ifit] ) continue;
 
+          _PixelEfficiencyHisto->fill(localX[ifit]*1000.,localY[ifit]*1000.,0.);
 
-#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+          (dynamic_cast<AIDA::IProfile1D*> ( _EfficiencyHistos.at(projX)))->fill(fittedX[ifit],0.);
+          (dynamic_cast<AIDA::IProfile1D*> ( _EfficiencyHistos.at(projY)))->fill(fittedY[ifit],0.);
+          (dynamic_cast<AIDA::IProfile2D*> ( _EfficiencyHistos.at(projXY)))->fill(fittedX[ifit],fittedY[ifit],0.);
+        }
+    }
 
   // Noise plots - unmatched hits
 
   for(int ihit=0;ihit<static_cast<int>(_measuredX.size()); ihit++){
+      if( _hitMatched[ihit] ) continue;
+
       (dynamic_cast<AIDA::IProfile1D*> ( _NoiseHistos.at(projX)))->fill(_measuredX[ihit],1.);
       (dynamic_cast<AIDA::IProfile1D*> ( _NoiseHistos.at(projY)))->fill(_measuredY[ihit],1.);
       (dynamic_cast<AIDA::IProfile2D*> ( _NoiseHistos.at(projXY)))->fill(_measuredX[ihit],_measuredY[ihit],1.);
@@ -717,6 +657,82 @@ void EUTelDUTHistograms::processEvent( LCEvent * event ) {
 
 
 
+void EUTelDUTHistograms::matchFittedToMeasured() {
+
+  // Each track is matched to at most one DUT hit: the pair (fitted
+  // position of the track, hit not matched yet) with the smallest
+  // distance, if below _distMax. Tracks are considered in order, as a
+  // hit taken by a track is not available to the following ones.
+  //
+  // The hits are sorted in X once, so that for each fitted position only
+  // the hits within _distMax in X have to be looked at.
+
+  const int nHits = static_cast<int>(_measuredX.size());
+  const double distMax2 = _distMax*_distMax;
+
+  _matches.clear();
+  _hitMatched.assign(nHits, false);
+  if( static_cast<int>(_fitMatched.size()) < _maptrackid ) _fitMatched.resize(_maptrackid);
+
+  _sortedHits.resize(nHits);
+  for(int ihit=0; ihit<nHits; ihit++) _sortedHits[ihit] = std::make_pair(_measuredX[ihit], ihit);
+  std::sort(_sortedHits.begin(), _sortedHits.end());
+
+  for(int itrack=0; itrack<_maptrackid; itrack++)
+    {
+      const std::vector<double>& fittedX = _fittedX[itrack];
+      const std::vector<double>& fittedY = _fittedY[itrack];
+      _fitMatched[itrack].assign(fittedX.size(), false);
+
+      int bestfit=-1;
+      int besthit=-1;
+      double distmin = distMax2;
+
+      for(int ifit=0; ifit<static_cast<int>(fittedX.size()); ifit++)
+        {
+          std::vector< std::pair<double,int> >::const_iterator iter =
+            std::lower_bound(_sortedHits.begin(), _sortedHits.end(), std::make_pair(fittedX[ifit] - _distMax, -1));
+
+          for( ; iter != _sortedHits.end() && iter->first <= fittedX[ifit] + _distMax; ++iter)
+            {
+              const int ihit = iter->second;
+              if( _hitMatched[ihit] ) continue;
+
+              const double dx = _measuredX[ihit] - fittedX[ifit];
+              const double dy = _measuredY[ihit] - fittedY[ifit];
+              const double dist2rd = dx*dx + dy*dy;
+
+              if(streamlog_level(DEBUG5)){
+                message<DEBUG5> ( log() << "Fit ["<< itrack << ":" << _maptrackid <<"], ifit= " << ifit << " ["<< fittedX[ifit] << ":" << fittedY[ifit] << "]" << endl) ;
+                message<DEBUG5> ( log() << "rec " << ihit << " ["<< _measuredX[ihit] << ":" << _measuredY[ihit] << "]" << endl) ;
+                message<DEBUG5> ( log() << "distance : " << TMath::Sqrt( dist2rd )  << endl) ;
+              }
+
+              // on ties keep the lowest hit index, as a plain loop over the hits would
+              if( dist2rd < distmin || ( dist2rd == distmin && ifit == bestfit && ihit < besthit ) )
+                {
+                  distmin = dist2rd;
+                  besthit = ihit;
+                  bestfit = ifit;
+                }
+            }
+        }
+
+      if( besthit < 0 ) continue;
+
+      Match match;
+      match.track = itrack;
+      match.fit   = bestfit;
+      match.hit   = besthit;
+      match.dist2 = distmin;
+      _matches.push_back(match);
+
+      _hitMatched[besthit] = true;
+      _fitMatched[itrack][bestfit] = true;
+    }
+}
+
+
 void EUTelDUTHistograms::check( LCEvent * /* evt */ ) {
   // nothing to check here - could be used to fill checkplots in reconstruction processor
 }
@@ -31,8 +31,14 @@
 
 // system includes 
 #include <fstream>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
+using namespace lcio;
 using namespace marlin;
 
 namespace eutelescope {
@@ -45,7 +51,9 @@ namespace eutelescope {
 using namespace eutelescope;
 
 
-EUTelEUDRBReader::EUTelEUDRBReader ():DataSourceProcessor  ("EUTelEUDRBReader"), _fileHeader(NULL) {
+EUTelEUDRBReader::EUTelEUDRBReader ():DataSourceProcessor  ("EUTelEUDRBReader"), 
+  _fileName(""), _algo(""), _useMemoryMap(false), _sequentialReadAhead(true), _firstEvent(0),
+  _firstFrame(-1), _secondFrame(-1), _isCDS(true), _runTimeStamp(0), _fileHeader(NULL), _buffer(NULL) {
   
   _description =
     "Reads data files and creates LCEvent with TrackerRawData collection.\n"
@@ -56,6 +64,15 @@ EUTelEUDRBReader::EUTelEUDRBReader ():DataSourceProcessor  ("EUTelEUDRBReader"),
 
   registerProcessorParameter ("CalculationAlgorithm", "Select if you want CDS or LF",
 			      _algo, std::string("CDS"));
+
+  registerOptionalParameter ("UseMemoryMap", "Map the input file in memory and decode the events in place",
+			     _useMemoryMap, static_cast< bool > ( false ) );
+
+  registerOptionalParameter ("SequentialReadAhead", "When the file is mapped in memory, advise the kernel for sequential read-ahead",
+			     _sequentialReadAhead, static_cast< bool > ( true ) );
+
+  registerOptionalParameter ("FirstEvent", "Index of the first event to be converted, the previous ones are skipped",
+			     _firstEvent, static_cast< int > ( 0 ) );
   
 }
 
@@ -66,11 +83,78 @@ EUTelEUDRBReader * EUTelEUDRBReader::newProcessor () {
 void EUTelEUDRBReader::init () {
   printParameters ();
 
+  // the frame selection depends only on the algorithm, so it is done
+  // once here and not for every event
+  if ( ( _algo == "CDS32" ) || ( _algo == "LF2") ) {
+    _firstFrame  = 1;
+    _secondFrame = 2;
+  } else if ( ( _algo == "CDS21" ) || ( _algo == "LF1" ) ) {
+    _firstFrame  = 0;
+    _secondFrame = 1;
+  } else if ( _algo == "LF3" ) {
+    _firstFrame = 2;
+    _secondFrame = 3;
+  } 
+  _isCDS = ( _algo.compare(0, 3, "CDS") == 0 );
+
+  if ( _firstEvent < 0 ) _firstEvent = 0;
+
+}
+
+
+size_t EUTelEUDRBReader::eventRecordSize() const {
+  return sizeof(EUDRBEventHeader) + _fileHeader->dataSize + sizeof(EUDRBTrailer);
 }
 
 
 void EUTelEUDRBReader::readDataSource (int numEvents) {
 
+  // one time stamp for the whole run, instead of one LCTime per event
+  _runTimeStamp = LCTime().timeStamp();
+
+  int lastEvent = -1;
+  if ( _useMemoryMap ) {
+    lastEvent = readWithMemoryMap( numEvents );
+    if ( lastEvent == -1 ) {
+      streamlog_out ( WARNING ) << "Unable to map " << _fileName << " in memory, reading it as a stream" << endl;
+    }
+  }
+  if ( lastEvent == -1 ) lastEvent = readWithStream( numEvents );
+
+  processEORE( lastEvent );
+}
+
+
+void EUTelEUDRBReader::processRunHeader() {
+
+  IMPL::LCRunHeaderImpl * rdr    = new IMPL::LCRunHeaderImpl;
+  EUTelRunHeaderImpl * runHeader = new EUTelRunHeaderImpl(rdr);
+  runHeader->setDAQHWName( "EUDRB" );
+  runHeader->setNoOfEvent( _fileHeader->numberOfEvent + 1);
+  runHeader->setNoOfDetector( _fileHeader->numberOfDetector * 4);
+  IntVec minX, minY, maxX, maxY;
+  for (int iDetector = 0; iDetector < _fileHeader->numberOfDetector * 4; iDetector++) {
+    minX.push_back( ( _fileHeader->nXPixel ) * iDetector );
+    maxX.push_back( ( _fileHeader->nXPixel ) * iDetector +  ( _fileHeader->nXPixel - 1 ) );
+    minY.push_back( 0 );
+    maxY.push_back( _fileHeader->nYPixel - 1 );
+  }
+  runHeader->setMinX( minX );
+  runHeader->setMaxX( maxX );
+  runHeader->setMinY( minY );
+  runHeader->setMaxY( maxY );
+
+  ProcessorMgr::instance()->processRunHeader( rdr ) ;
+
+  _isFirstEvent = false;
+
+  delete runHeader;
+  delete rdr;
+}
+
+
+int EUTelEUDRBReader::readWithStream(int numEvents) {
+
   ifstream inputFile;
   inputFile.exceptions (ifstream::failbit | ifstream::badbit );
   
@@ -83,7 +167,7 @@ void EUTelEUDRBReader::readDataSource (int numEvents) {
   }
   
   // read the file header
-  _fileHeader = new EUDRBFileHeader;
+  if ( _fileHeader == NULL ) _fileHeader = new EUDRBFileHeader;
 
   try {
     inputFile.read(reinterpret_cast<char*>(_fileHeader), sizeof(EUDRBFileHeader));
@@ -92,53 +176,24 @@ void EUTelEUDRBReader::readDataSource (int numEvents) {
     exit(-1);
   }
 
-  if (isFirstEvent() ) {
-
-    IMPL::LCRunHeaderImpl rdr      = new IMPL::LCRunHeaderImpl;
-    EUTelRunHeaderImpl * runHeader = new EUTelRunHeaderImpl(rdr)
-    runHeader->setDAQHWName( "EUDRB" );
-    runHeader->setNoOfEvent( _fileHeader->numberOfEvent + 1);
-    runHeader->setNoOfDetector( _fileHeader->numberOfDetector * 4);
-    IntVec minX, minY, maxX, maxY;
-    for (int iDetector = 0; iDetector < _fileHeader->numberOfDetector * 4; iDetector++) {
-      minX.push_back( ( _fileHeader->nXPixel ) * iDetector );
-      maxX.push_back( ( _fileHeader->nXPixel ) * iDetector +  ( _fileHeader->nXPixel - 1 ) );
-      minY.push_back( 0 );
-      maxY.push_back( _fileHeader->nYPixel - 1 );
-    }
-    runHeader->setMinX( minX );
-    runHeader->setMaxX( maxX );
-    runHeader->setMinY( minY );
-    runHeader->setMaxY( maxY );
-
-    ProcessorMgr::instance()->processRunHeader( rdr ) ;
-
-    _isFirstEvent = false;
+  if (isFirstEvent() ) processRunHeader();
 
-    delete runHeader;
-    delete rdr;
-
-    _buffer = new int[ _fileHeader->dataSize / sizeof(int) ];
+  if ( _buffer == NULL ) _buffer = new int[ _fileHeader->dataSize / sizeof(int) ];
 
+  // skip the events before the requested one
+  if ( _firstEvent > 0 ) {
+    try {
+      inputFile.seekg( static_cast< streamoff >( _firstEvent ) * static_cast< streamoff >( eventRecordSize() ), ios::cur );
+    } catch (exception & e) {
+      message<ERROR5> ( log() << "Unable to skip to event " << _firstEvent );
+      exit(-1);
+    }
   }
 
+  int lastEvent = _firstEvent;
   int iEvent;
-  for ( iEvent = 0; iEvent < _fileHeader->numberOfEvent; iEvent++ ) {
-
-    EUTelEventImpl     * event = new EUTelEventImpl;
-    event->setDetectorName("debug_detector");
-    event->setRunNumber(0);
-    event->setEventNumber(iEvent);
-    event->setEventType(kDE);
-    
-    LCTime * now = new LCTime;
-    event->setTimeStamp(now->timeStamp());
-    delete now;
+  for ( iEvent = _firstEvent; iEvent < _fileHeader->numberOfEvent && ( numEvents <= 0 || iEvent - _firstEvent < numEvents ); iEvent++ ) {
 
-    LCCollectionVec * rawData = new LCCollectionVec (LCIO::TRACKERRAWDATA);
-    CellIDEncoder < TrackerRawDataImpl > idEncoder (EUTELESCOPE::MATRIXDEFAULTENCODING, rawData);
-    
-    
     EUDRBEventHeader eventHeader;
     try {
       inputFile.read(reinterpret_cast<char*>(&eventHeader), sizeof(eventHeader));
@@ -147,14 +202,6 @@ void EUTelEUDRBReader::readDataSource (int numEvents) {
       exit(-1);
     }
     
-    // check the event number consistency
-    if ( iEvent != eventHeader.eventNumber ) {
-      message<WARNING> ( log() << "Event number not corresponding " << eventHeader.eventNumber );
-    }
-    event->setRunNumber(0);
-    event->setEventNumber(iEvent);
-    
-    
     try {
       inputFile.read(reinterpret_cast<char*>(_buffer), _fileHeader->dataSize );
     } catch (exception& e) {
@@ -162,94 +209,6 @@ void EUTelEUDRBReader::readDataSource (int numEvents) {
       exit(-1);
     }
     
-      
-    // this is made between frame 3 and frame 2
-    int frameRecordSize = _fileHeader->nXPixel * _fileHeader->nYPixel * 4 /*frame*/ / 2 /*pixel per record*/;
-    
-    TrackerRawDataImpl * channelA = new TrackerRawDataImpl;
-    idEncoder["sensorID"] = 0;
-    idEncoder["xMin"]     = 0;
-    idEncoder["xMax"]     = _fileHeader->nXPixel - 1;
-    idEncoder["yMin"]     = 0;
-    idEncoder["yMax"]     = _fileHeader->nYPixel - 1;
-    idEncoder.setCellID( channelA );
-    
-    TrackerRawDataImpl * channelB = new TrackerRawDataImpl;
-    idEncoder["sensorID"] = 1;
-    idEncoder["xMin"]     = _fileHeader->nXPixel;
-    idEncoder["xMax"]     = 2 * _fileHeader->nXPixel - 1;
-    idEncoder["yMin"]     = 0;
-    idEncoder["yMax"]     = _fileHeader->nYPixel - 1;
-    idEncoder.setCellID( channelB );
-      
-    TrackerRawDataImpl * channelC = new TrackerRawDataImpl;
-    idEncoder["sensorID"] = 2;
-    idEncoder["xMin"]     = 2 * _fileHeader->nXPixel;
-    idEncoder["xMax"]     = 3 * _fileHeader->nXPixel - 1;
-    idEncoder["yMin"]     = 0;
-    idEncoder["yMax"]     = _fileHeader->nYPixel - 1;
-    idEncoder.setCellID( channelC );
-    
-    TrackerRawDataImpl * channelD = new TrackerRawDataImpl;
-    idEncoder["sensorID"] = 3;
-    idEncoder["xMin"]     = 3 * _fileHeader->nXPixel;
-    idEncoder["xMax"]     = 4 * _fileHeader->nXPixel - 1;
-    idEncoder["yMin"]     = 0;
-    idEncoder["yMax"]     = _fileHeader->nYPixel - 1;
-    idEncoder.setCellID( channelD );
-    
-    int firstFrame = -1;
-    int secondFrame = -1;
-    if ( ( _algo == "CDS32" ) || ( _algo == "LF2") ) {
-      firstFrame  = 1;
-      secondFrame = 2;
-    } else if ( ( _algo == "CDS21" ) || ( _algo == "LF1" ) ) {
-      firstFrame  = 0;
-      secondFrame = 1;
-    } else if ( _algo == "LF3" ) {
-      firstFrame = 2;
-      secondFrame = 3;
-    } 
-    
-    for (int iRecord = firstFrame * frameRecordSize; iRecord < secondFrame * frameRecordSize; iRecord++ ) {
-      
-      short pixelA1 = static_cast< short > ( ( _buffer[iRecord] & _fileHeader->chACBitMask ) >> _fileHeader->chACRightShift ) ;
-      short pixelB1 = static_cast< short > ( ( _buffer[iRecord] & _fileHeader->chBDBitMask ) >> _fileHeader->chBDRightShift ) ;
-      if ( _algo.compare(0, 3, "CDS") == 0 ) {
-	short pixelA2 = static_cast< short > ( ( _buffer[iRecord + frameRecordSize] & _fileHeader->chACBitMask ) >> 
-					       _fileHeader->chACRightShift  );
-	short pixelB2 = static_cast< short > ( ( _buffer[iRecord + frameRecordSize] & _fileHeader->chBDBitMask ) >> 
-					       _fileHeader->chBDRightShift  );
-	channelA->adcValues().push_back( pixelA2 - pixelA1 );
-	channelB->adcValues().push_back( pixelB2 - pixelB1 );
-      } else if ( _algo.compare(0, 2, "LF") == 0 ) {
-	channelA->adcValues().push_back( pixelA1 );
-	channelB->adcValues().push_back( pixelB1 );
-      }
-
-
-      ++iRecord;      
-      short pixelC1 = static_cast< short > ( ( _buffer[iRecord] & _fileHeader->chACBitMask ) >> _fileHeader->chACRightShift ) ;
-      short pixelD1 = static_cast< short > ( ( _buffer[iRecord] & _fileHeader->chBDBitMask ) >> _fileHeader->chBDRightShift ) ;
-      if ( _algo.compare(0, 3, "CDS") == 0 ) {
-	short pixelC2 = static_cast< short > ( ( _buffer[iRecord + frameRecordSize] & _fileHeader->chACBitMask ) >> 
-					       _fileHeader->chACRightShift  );
-	short pixelD2 = static_cast< short > ( ( _buffer[iRecord + frameRecordSize] & _fileHeader->chBDBitMask ) >> 
-					       _fileHeader->chBDRightShift  );
-	channelC->adcValues().push_back( pixelC2 - pixelC1 );
-	channelD->adcValues().push_back( pixelD2 - pixelD1 );
-      } else if ( _algo.compare(0, 2, "LF" ) == 0 ) {
-	channelC->adcValues().push_back( pixelC1 );
-	channelD->adcValues().push_back( pixelD1 );
-      }
-
-    }
-    
-    rawData->push_back(channelA);
-    rawData->push_back(channelB);
-    rawData->push_back(channelC);
-    rawData->push_back(channelD);
-    
     EUDRBTrailer eventTrailer;
     try {
       inputFile.read(reinterpret_cast<char*>(&eventTrailer), sizeof(eventTrailer));
@@ -257,41 +216,197 @@ void EUTelEUDRBReader::readDataSource (int numEvents) {
       message<ERROR5> ( log() << "Problem reading the event trailer on event " << iEvent );
       exit(-1);
     }
-    // crosscheck the trailer
-    if (eventTrailer.trailer != 0x89abcdef ) {
-      message<WARNING> ( log() << "The trailer is not correct on event " << iEvent ) ;
-    }
-    
-    event->addCollection(rawData, "rawdata");
 
-    ProcessorMgr::instance()->processEvent(static_cast<LCEventImpl*> (event) );
-    delete event;
+    processDataEvent( iEvent, eventHeader, _buffer, eventTrailer );
+    lastEvent = iEvent;
 
     if ( inputFile.eof() ) break;
   }
 
-  // add the EORE event
+  inputFile.close();
+  return lastEvent;
+}
+
+
+int EUTelEUDRBReader::readWithMemoryMap(int numEvents) {
+
+  int fd = ::open( _fileName.c_str(), O_RDONLY );
+  if ( fd == -1 ) return -1;
+
+  struct stat fileStat;
+  if ( fstat( fd, &fileStat ) == -1 || static_cast< size_t >( fileStat.st_size ) < sizeof(EUDRBFileHeader) ) {
+    ::close( fd );
+    return -1;
+  }
+  const size_t fileSize = static_cast< size_t >( fileStat.st_size );
+
+  void * map = mmap( NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+  // the mapping stays valid after closing the descriptor
+  ::close( fd );
+  if ( map == MAP_FAILED ) return -1;
+
+  if ( _sequentialReadAhead ) madvise( map, fileSize, MADV_SEQUENTIAL );
+
+  const char * fileBegin = static_cast< const char * >( map );
+
+  if ( _fileHeader == NULL ) _fileHeader = new EUDRBFileHeader;
+  memcpy( _fileHeader, fileBegin, sizeof(EUDRBFileHeader) );
+
+  if (isFirstEvent() ) processRunHeader();
+
+  // the number of events really available, in case the file has
+  // been truncated
+  const size_t recordSize = eventRecordSize();
+  int noOfEventInFile = static_cast< int >( ( fileSize - sizeof(EUDRBFileHeader) ) / recordSize );
+  if ( noOfEventInFile < _fileHeader->numberOfEvent ) {
+    streamlog_out ( WARNING ) << "The file header announces " << _fileHeader->numberOfEvent 
+                              << " events, but only " << noOfEventInFile << " are in the file" << endl;
+  } else {
+    noOfEventInFile = _fileHeader->numberOfEvent;
+  }
+
+  // all the offsets are multiples of 4 bytes and the mapping is page
+  // aligned, so the data block can be read as int in place
+  const size_t pageSize = static_cast< size_t >( sysconf( _SC_PAGESIZE ) );
+  size_t releasedBytes = 0;
+  int lastEvent = _firstEvent;
+  for ( int iEvent = _firstEvent; iEvent < noOfEventInFile && ( numEvents <= 0 || iEvent - _firstEvent < numEvents ); iEvent++ ) {
+
+    const char * record = fileBegin + sizeof(EUDRBFileHeader) + static_cast< size_t >( iEvent ) * recordSize;
+
+    EUDRBEventHeader eventHeader;
+    memcpy( &eventHeader, record, sizeof(EUDRBEventHeader) );
+
+    const int * dataBlock = reinterpret_cast< const int * >( record + sizeof(EUDRBEventHeader) );
+
+    EUDRBTrailer eventTrailer;
+    memcpy( &eventTrailer, record + sizeof(EUDRBEventHeader) + _fileHeader->dataSize, sizeof(EUDRBTrailer) );
+
+    processDataEvent( iEvent, eventHeader, dataBlock, eventTrailer );
+    lastEvent = iEvent;
+
+    // pages already decoded are not needed anymore
+    if ( _sequentialReadAhead ) {
+      const size_t doneBytes = ( static_cast< size_t >( record - fileBegin ) / pageSize ) * pageSize;
+      if ( doneBytes > releasedBytes ) {
+        madvise( static_cast< char * >( map ) + releasedBytes, doneBytes - releasedBytes, MADV_DONTNEED );
+        releasedBytes = doneBytes;
+      }
+    }
+  }
+
+  munmap( map, fileSize );
+  return lastEvent;
+}
+
+
+void EUTelEUDRBReader::decodeDataBlock(const int * dataBlock, IMPL::TrackerRawDataImpl * channel[4]) const {
+
+  // this is made between frame 3 and frame 2
+  const int frameRecordSize = _fileHeader->nXPixel * _fileHeader->nYPixel * 4 /*frame*/ / 2 /*pixel per record*/;
+  const int noOfPixel       = ( _secondFrame - _firstFrame ) * frameRecordSize / 2;
+  if ( noOfPixel <= 0 ) return;
+
+  const int acMask  = _fileHeader->chACBitMask;
+  const int acShift = _fileHeader->chACRightShift;
+  const int bdMask  = _fileHeader->chBDBitMask;
+  const int bdShift = _fileHeader->chBDRightShift;
+
+  short * adc[4];
+  for ( int iChannel = 0; iChannel < 4; iChannel++ ) {
+    channel[ iChannel ]->adcValues().resize( noOfPixel );
+    adc[ iChannel ] = &( channel[ iChannel ]->adcValues()[0] );
+  }
+
+  // odd records contain channels A and B, even records C and D
+  const int * record = dataBlock + _firstFrame * frameRecordSize;
+  for ( int iPixel = 0; iPixel < noOfPixel; iPixel++, record += 2 ) {
+
+    const short pixelA1 = static_cast< short > ( ( record[0] & acMask ) >> acShift );
+    const short pixelB1 = static_cast< short > ( ( record[0] & bdMask ) >> bdShift );
+    const short pixelC1 = static_cast< short > ( ( record[1] & acMask ) >> acShift );
+    const short pixelD1 = static_cast< short > ( ( record[1] & bdMask ) >> bdShift );
+
+    if ( _isCDS ) {
+      const int * nextFrame = record + frameRecordSize;
+      adc[0][ iPixel ] = static_cast< short > ( ( ( nextFrame[0] & acMask ) >> acShift ) - pixelA1 );
+      adc[1][ iPixel ] = static_cast< short > ( ( ( nextFrame[0] & bdMask ) >> bdShift ) - pixelB1 );
+      adc[2][ iPixel ] = static_cast< short > ( ( ( nextFrame[1] & acMask ) >> acShift ) - pixelC1 );
+      adc[3][ iPixel ] = static_cast< short > ( ( ( nextFrame[1] & bdMask ) >> bdShift ) - pixelD1 );
+    } else {
+      adc[0][ iPixel ] = pixelA1;
+      adc[1][ iPixel ] = pixelB1;
+      adc[2][ iPixel ] = pixelC1;
+      adc[3][ iPixel ] = pixelD1;
+    }
+  }
+}
+
+
+void EUTelEUDRBReader::processDataEvent(int iEvent, const EUDRBEventHeader & eventHeader,
+                                        const int * dataBlock, const EUDRBTrailer & eventTrailer) {
+
   EUTelEventImpl     * event = new EUTelEventImpl;
   event->setDetectorName("debug_detector");
   event->setRunNumber(0);
   event->setEventNumber(iEvent);
+  event->setEventType(kDE);
+  event->setTimeStamp(_runTimeStamp);
+
+  // check the event number consistency
+  if ( iEvent != eventHeader.eventNumber ) {
+    message<WARNING> ( log() << "Event number not corresponding " << eventHeader.eventNumber );
+  }
+
+  LCCollectionVec * rawData = new LCCollectionVec (LCIO::TRACKERRAWDATA);
+  CellIDEncoder < TrackerRawDataImpl > idEncoder (EUTELESCOPE::MATRIXDEFAULTENCODING, rawData);
+
+  TrackerRawDataImpl * channel[4];
+  for ( int iChannel = 0; iChannel < 4; iChannel++ ) {
+    channel[ iChannel ] = new TrackerRawDataImpl;
+    idEncoder["sensorID"] = iChannel;
+    idEncoder["xMin"]     = iChannel * _fileHeader->nXPixel;
+    idEncoder["xMax"]     = ( iChannel + 1 ) * _fileHeader->nXPixel - 1;
+    idEncoder["yMin"]     = 0;
+    idEncoder["yMax"]     = _fileHeader->nYPixel - 1;
+    idEncoder.setCellID( channel[ iChannel ] );
+  }
+
+  decodeDataBlock( dataBlock, channel );
+
+  for ( int iChannel = 0; iChannel < 4; iChannel++ ) rawData->push_back( channel[ iChannel ] );
+
+  // crosscheck the trailer
+  if (eventTrailer.trailer != 0x89abcdef ) {
+    message<WARNING> ( log() << "The trailer is not correct on event " << iEvent ) ;
+  }
+
+  event->addCollection(rawData, "rawdata");
+
+  ProcessorMgr::instance()->processEvent(static_cast<LCEventImpl*> (event) );
+  delete event;
+}
+
+
+void EUTelEUDRBReader::processEORE(int iEvent) {
+
+  // add the EORE event
+  EUTelEventImpl     * event = new EUTelEventImpl;
+  event->setDetectorName("debug_detector");
   event->setEventType(kEORE);
-  LCTime * now = new LCTime;
-  event->setTimeStamp(now->timeStamp());
-  delete now;
+  event->setTimeStamp(_runTimeStamp);
   event->setRunNumber(0);
   event->setEventNumber(iEvent + 1);
 
   ProcessorMgr::instance()->processEvent(static_cast<LCEventImpl*> (event) );
   delete event;
-
-  inputFile.close();
 }
 
 
 void EUTelEUDRBReader::end () {
 
   delete [] _buffer;
+  delete _fileHeader;
   message<MESSAGE5> ( "Successfully finished" );
 
 }
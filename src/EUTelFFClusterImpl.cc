@@ -42,6 +42,71 @@ EUTelFFClusterImpl::EUTelFFClusterImpl(TrackerDataImpl * data) : EUTelVirtualClu
   _noiseSetSwitch = false;
 }
 
+void EUTelFFClusterImpl::fillSummary() const {
+
+  const FloatVec & charges = _trackerData->getChargeValues();
+
+  int xSize=0, ySize=0;
+  getClusterSize(xSize, ySize);
+
+  float totalCharge = 0;
+  float seedCharge  = 0;
+  unsigned int seedIndex = 0;
+  for ( unsigned int iPixel = 0; iPixel < charges.size(); ++iPixel ) {
+    totalCharge += charges[iPixel];
+    if ( iPixel == 0 || charges[iPixel] > seedCharge ) {
+      seedCharge = charges[iPixel];
+      seedIndex  = iPixel;
+    }
+  }
+
+  // the CoG shift is computed on the (xSize x ySize) frame only
+  float normalization = 0.;
+  float tempX = 0.;
+  float tempY = 0.;
+  unsigned int iPixel = 0;
+  for (int yPixel = -1 * (ySize-1) / 2; yPixel <= (ySize-1) / 2; yPixel++) {
+    for (int xPixel = -1 * (xSize-1) / 2; xPixel <= (xSize-1) / 2; xPixel++) {
+      if ( charges.size() <= iPixel ) break;
+      normalization += charges[iPixel];
+      if ( charges[iPixel] > 0 ) {
+        tempX += xPixel * charges[iPixel];
+        tempY += yPixel * charges[iPixel];
+      }
+      iPixel++;
+    }
+  }
+
+  _summary.totalCharge = totalCharge;
+  _summary.seedCharge  = seedCharge;
+  _summary.seedIndex   = seedIndex;
+  _summary.xSize       = xSize;
+  _summary.ySize       = ySize;
+  if ( abs(normalization) > 1e-12 ) {
+    _summary.xCoGShift = tempX / normalization;
+    _summary.yCoGShift = tempY / normalization;
+  } else {
+    _summary.xCoGShift = 0.;
+    _summary.yCoGShift = 0.;
+  }
+  _summary.chargeValid = true;
+}
+
+void EUTelFFClusterImpl::fillNoiseSummary() const {
+
+  if ( ! _summary.chargeValid ) fillSummary();
+
+  float squaredSum = 0;
+  vector<float >::const_iterator iter = _noiseValues.begin();
+  while ( iter != _noiseValues.end() ) {
+    squaredSum += pow( (*iter), 2 );
+    ++iter;
+  }
+  _summary.noise2Sum = squaredSum;
+  _summary.seedNoise = ( _summary.seedIndex < _noiseValues.size() ) ? _noiseValues[ _summary.seedIndex ] : 0.;
+  _summary.noiseValid = true;
+}
+
 
 float EUTelFFClusterImpl::getDistance(EUTelVirtualCluster * otherCluster) const {
 
@@ -67,54 +132,15 @@ float EUTelFFClusterImpl::getExternalRadius() const {
 
 float EUTelFFClusterImpl::getTotalCharge() const {
 
-  float totalCharge = 0;
-
-  FloatVec::const_iterator iter = _trackerData->getChargeValues().begin();
-
-  while (iter != _trackerData->getChargeValues().end()) {
-    totalCharge += (*iter++);
-  }
-
-  return totalCharge;
+  if ( ! _summary.chargeValid ) fillSummary();
+  return _summary.totalCharge;
 }
 
 void EUTelFFClusterImpl::getCenterOfGravityShift(float& xCoG, float& yCoG) const {
 
-  int xSize=0, ySize=0;
-  getClusterSize(xSize, ySize);
-
- 
-  float normalization = 0.;
-  float tempX = 0.;
-  float tempY = 0.;
-
-  unsigned int iPixel = 0;
-  int ii=0;
-  for (int yPixel = -1 * (ySize-1) / 2; yPixel <= (ySize-1) / 2; yPixel++) {
-    for (int xPixel = -1 * (xSize-1) / 2; xPixel <= (xSize-1) / 2; xPixel++) {
-        if( _trackerData->getChargeValues().size()<= iPixel) break;
-        normalization += _trackerData->getChargeValues()[iPixel];
-        if( _trackerData->getChargeValues()[iPixel] > 0 ){
-	  tempX         += xPixel * _trackerData->getChargeValues()[iPixel];
-	  tempY         += yPixel * _trackerData->getChargeValues()[iPixel];
-// 	  printf("x/y/adc,  %d, %d, %.0f\n", xPixel, yPixel,  _trackerData->getChargeValues()[iPixel]);
-	  ii++;
-        }      
-        iPixel++;    
-    }
-  }
-
-  
-  if ( abs(normalization) > 1e-12 )  {
-    xCoG = tempX / normalization;
-    yCoG = tempY / normalization;
-  } else {
-    xCoG = 0.;
-    yCoG = 0.;
-  }
-//   printf("size %d %d, nPixel %d  \n", xSize, ySize, ii);
-//   printf("%5.2f %5.2f  %5.2f %5.2f  norm=%5.2f\n", xCoG, yCoG, tempX,tempY, normalization);
-
+  if ( ! _summary.chargeValid ) fillSummary();
+  xCoG = _summary.xCoGShift;
+  yCoG = _summary.yCoGShift;
 }
 
 void EUTelFFClusterImpl::getCenterOfGravityShift(float& xCoG, float& yCoG, int xSize, int ySize) const {
@@ -252,8 +278,8 @@ void EUTelFFClusterImpl::setClusterQuality(ClusterQuality quality) {
 
 float EUTelFFClusterImpl::getSeedCharge() const {
 
-  return *max_element( _trackerData->getChargeValues().begin(),
-                       _trackerData->getChargeValues().end() );
+  if ( ! _summary.chargeValid ) fillSummary();
+  return _summary.seedCharge;
 }
 
 float EUTelFFClusterImpl::getClusterCharge(int nPixel) const {
@@ -316,6 +342,7 @@ void EUTelFFClusterImpl::setNoiseValues(std::vector<float > noiseValues ) {
 
   _noiseValues = noiseValues;
   _noiseSetSwitch = true;
+  _summary.noiseValid = false;
 
 }
 
@@ -328,15 +355,8 @@ vector<float > EUTelFFClusterImpl::getNoiseValues() const {
 float EUTelFFClusterImpl::getClusterNoise() const {
 
   if ( ! _noiseSetSwitch ) throw DataNotAvailableException("No noise values set");
-
-  float squaredSum = 0;
-  vector<float >::const_iterator iter = _noiseValues.begin();
-  while ( iter != _noiseValues.end() ) {
-    squaredSum += pow( (*iter), 2 );
-    ++iter;
-  }
-  return sqrt( squaredSum );
-
+  if ( ! _summary.noiseValid ) fillNoiseSummary();
+  return sqrt( _summary.noise2Sum );
 }
 
 float EUTelFFClusterImpl::getClusterSNR() const {
@@ -351,10 +371,8 @@ float EUTelFFClusterImpl::getClusterSNR() const {
 float EUTelFFClusterImpl::getSeedSNR() const {
 
   if ( ! _noiseSetSwitch ) throw DataNotAvailableException("No noise values set");
-  vector<float >::const_iterator chargeBegin    = _trackerData->getChargeValues().begin();
-  vector<float >::const_iterator seedChargeIter = max_element( chargeBegin, _trackerData->getChargeValues().end() );
-  vector<float >::const_iterator seedNoiseIter  = _noiseValues.begin() + ( seedChargeIter - chargeBegin );
-  return (*seedChargeIter) / (*seedNoiseIter);
+  if ( ! _summary.noiseValid ) fillNoiseSummary();
+  return _summary.seedCharge / _summary.seedNoise;
 }
 
 float EUTelFFClusterImpl::getClusterSNR(int nPixel) const {
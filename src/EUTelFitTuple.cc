@@ -67,7 +67,12 @@ using namespace eutelescope;
 std::string EUTelFitTuple::_FitTupleName  = "EUFit";
 
 
-EUTelFitTuple::EUTelFitTuple() : Processor("EUTelFitTuple") {
+EUTelFitTuple::EUTelFitTuple() : Processor("EUTelFitTuple")
+#if defined(USE_ROOT) || defined(MARLIN_USE_ROOT)
+  , _tupleFile(NULL)
+  , _fitTree(NULL)
+#endif
+{
 
   // modify processor description
   _description = "Prepare n-tuple with track fit results" ;
@@ -123,6 +128,14 @@ EUTelFitTuple::EUTelFitTuple() : Processor("EUTelFitTuple") {
                               "Alignment corrections for DUT: shift in X, Y and rotation around Z",
                               _DUTalign, initAlign);
 
+  registerOptionalParameter ("OutputPath",
+                             "If set, the n-tuple is written as a ROOT tree to this file instead of the AIDA output",
+                             _outputPath, static_cast < std::string > (""));
+
+  registerOptionalParameter ("TupleBackgroundWriting",
+                             "If true the ROOT n-tuple is filled and compressed on a background thread (see EUTelTupleFile::setBackgroundWriting)",
+                             _tupleBackgroundWriting, static_cast < bool > (false));
+
 }
 
 
@@ -536,26 +549,26 @@ void EUTelFitTuple::processEvent( LCEvent * event ) {
       // Fill n-tuple
 
       int icol=0;
-      _FitTuple->fill(icol++,_nEvt);
-      _FitTuple->fill(icol++,_runNr);
-      _FitTuple->fill(icol++,_evtNr);
-      _FitTuple->fill(icol++,_tluTimeStamp); // new! TLU timestamp
-      _FitTuple->fill(icol++,nTrack); // new! TLU timestamp
-      _FitTuple->fill(icol++,fittrack->getNdf());
-      _FitTuple->fill(icol++,fittrack->getChi2());
+      fillColumn(icol++,_nEvt);
+      fillColumn(icol++,_runNr);
+      fillColumn(icol++,_evtNr);
+      fillColumn(icol++,_tluTimeStamp); // new! TLU timestamp
+      fillColumn(icol++,nTrack); // new! TLU timestamp
+      fillColumn(icol++,fittrack->getNdf());
+      fillColumn(icol++,fittrack->getChi2());
 
       for(int ipl=0; ipl<_nTelPlanes;ipl++)
         {
-          _FitTuple->fill(icol++,_measuredX[ipl]);
-          _FitTuple->fill(icol++,_measuredY[ipl]);
-          _FitTuple->fill(icol++,_measuredZ[ipl]);
-          _FitTuple->fill(icol++,_measuredQ[ipl]);
-          _FitTuple->fill(icol++,_fittedX[ipl]);
-          _FitTuple->fill(icol++,_fittedY[ipl]);
-          _FitTuple->fill(icol++,_fittedEX[ipl]);
-          _FitTuple->fill(icol++,_fittedEY[ipl]);
-          _FitTuple->fill(icol++,(double)_nhits[ipl]);
-          _FitTuple->fill(icol++,(double)_ClusterSize[ipl]);
+          fillColumn(icol++,_measuredX[ipl]);
+          fillColumn(icol++,_measuredY[ipl]);
+          fillColumn(icol++,_measuredZ[ipl]);
+          fillColumn(icol++,_measuredQ[ipl]);
+          fillColumn(icol++,_fittedX[ipl]);
+          fillColumn(icol++,_fittedY[ipl]);
+          fillColumn(icol++,_fittedEX[ipl]);
+          fillColumn(icol++,_fittedEY[ipl]);
+          fillColumn(icol++,(double)_nhits[ipl]);
+          fillColumn(icol++,(double)_ClusterSize[ipl]);
 
         }
 
@@ -642,14 +655,14 @@ void EUTelFitTuple::processEvent( LCEvent * event ) {
         }
 
 
-      _FitTuple->fill(icol++,dutX);
-      _FitTuple->fill(icol++,dutY);
-      _FitTuple->fill(icol++,dutR);
-      _FitTuple->fill(icol++,dutQ);
-      _FitTuple->fill(icol++,dutClusterSize);
-      _FitTuple->fill(icol++,nTrack);
+      fillColumn(icol++,dutX);
+      fillColumn(icol++,dutY);
+      fillColumn(icol++,dutR);
+      fillColumn(icol++,dutQ);
+      fillColumn(icol++,dutClusterSize);
+      fillColumn(icol++,nTrack);
 
-      _FitTuple->addRow();
+      addFitRow();
 
       // End of loop over tracks
     }
@@ -672,6 +685,16 @@ void EUTelFitTuple::end(){
   //        << std::endl ;
 
 
+#if defined(USE_ROOT) || defined(MARLIN_USE_ROOT)
+  if ( _tupleFile ) {
+    message<MESSAGE5> ( log() << "N-tuple with "
+                       << _fitTree->rows() << " rows written to " << _outputPath );
+    _tupleFile->close();
+    delete _tupleFile;
+    _tupleFile = NULL;
+    _fitTree   = NULL;
+  } else
+#endif
   message<MESSAGE5> ( log() << "N-tuple with "
                      << _FitTuple->rows() << " rows created" );
 
@@ -702,6 +725,20 @@ void EUTelFitTuple::end(){
 
 
 
+void EUTelFitTuple::addFitRow() {
+
+#if defined(USE_ROOT) || defined(MARLIN_USE_ROOT)
+  if ( _fitTree ) {
+    _fitTree->addRow();
+    return;
+  }
+#endif
+  _FitTuple->addRow();
+
+}
+
+
+
 void EUTelFitTuple::bookHistos()
 {
 
@@ -763,6 +800,27 @@ void EUTelFitTuple::bookHistos()
   _columnNames.push_back("nTrack");
   _columnType.push_back("int");
 
+#if defined(USE_ROOT) || defined(MARLIN_USE_ROOT)
+  if ( !_outputPath.empty() ) {
+    _tupleFile = new EUTelTupleFile( _outputPath );
+    _tupleFile->setBackgroundWriting( _tupleBackgroundWriting );
+    _fitTree   = _tupleFile->addTree( _FitTupleName, _FitTupleName );
+    for ( size_t icol = 0; icol < _columnNames.size(); ++icol ) {
+      EUTelTupleTree::ColumnType type = EUTelTupleTree::kDouble;
+      if      ( _columnType[icol] == "int" )      type = EUTelTupleTree::kInt;
+      else if ( _columnType[icol] == "long int" ) type = EUTelTupleTree::kLong;
+      _fitTree->addColumn( _columnNames[icol], type );
+    }
+    _tupleFile->start();
+    message<DEBUG5> ( log() << "Fit n-tuple written to " << _outputPath );
+    return;
+  }
+#endif
+
+  if ( !_outputPath.empty() ) {
+    message<WARNING5> ( log() << "ROOT is not available, OutputPath ignored: the n-tuple is booked in the AIDA output" );
+  }
+
   _FitTuple=AIDAProcessor::tupleFactory(this)->create(_FitTupleName, _FitTupleName, _columnNames, _columnType, "");
 
 
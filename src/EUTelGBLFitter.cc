@@ -10,6 +10,7 @@
 // eutelescope includes ".h"
 #include "EUTelGeometryTelescopeGeoDescription.h"
 #include "EUTelGBLFitter.h"
+#include "EUTelProfiler.h"
 #include "EUTelTrackFitter.h"
 #include "EUTelUtilityRungeKutta.h"
 #include "EUTELESCOPE.h"
@@ -50,6 +51,55 @@
 #include <iterator>
 #include <algorithm>
 
+namespace {
+
+    /** A track candidate whose GBL trajectory is built, waiting for the fit */
+    struct GblFitJob {
+        EVENT::TrackVec::const_iterator candidate;
+        double invP;
+        std::vector< gbl::GblPoint > points;
+        /** GBL point label of each hit of the candidate */
+        std::vector< std::pair< long, int > > hitLabels;
+        gbl::GblTrajectory* trajectory;
+        double chi2;
+        double loss;
+        int ndf;
+        int ierr;
+    };
+
+    /** Fits the GBL trajectories of a set of jobs, one job per chunk */
+    class GblFitTask : public eutelescope::EUTelParallelTask {
+    public:
+        GblFitTask( std::vector< GblFitJob >& jobs, bool curvature, const std::string& mEstimatorType ) :
+            _jobs( jobs ), _curvature( curvature ), _mEstimatorType( mEstimatorType ) {
+        }
+
+        void execute( size_t chunk ) {
+            GblFitJob& job = _jobs[chunk];
+            job.chi2 = 0.;
+            job.loss = 0.;
+            job.ndf  = 0;
+            job.ierr = 0;
+            try {
+                job.trajectory = new gbl::GblTrajectory( job.points, _curvature );
+                if ( !_mEstimatorType.empty( ) ) job.ierr = job.trajectory->fit( job.chi2, job.ndf, job.loss, _mEstimatorType );
+                else job.ierr = job.trajectory->fit( job.chi2, job.ndf, job.loss );
+            } catch ( ... ) {
+                delete job.trajectory;
+                job.trajectory = 0;
+            }
+            // the trajectory has its own copy of the points
+            std::vector< gbl::GblPoint >().swap( job.points );
+        }
+
+    private:
+        std::vector< GblFitJob >& _jobs;
+        bool _curvature;
+        std::string _mEstimatorType;
+    };
+
+}
+
 namespace eutelescope {
 
     EUTelGBLFitter::EUTelGBLFitter() : EUTelTrackFitter("GBLTrackFitter"),
@@ -58,6 +108,10 @@ namespace eutelescope {
     _fittrackvec(0),
     _fithitsvec(0),
     _parPropJac(5, 5),
+    _straightTracks(false),
+    _projectionCache(),
+    _sensorScatPrecCache(),
+    _sensorScatPrecMomentum(0.),
     _beamQ(-1),
     _eBeam(-1.),
     _hitId2GblPointLabel(),
@@ -74,7 +128,9 @@ namespace eutelescope {
     _excludeFromFit(),
     _chi2cut(1000.),
     _eomIntegrator( new EUTelUtilityRungeKutta() ),
-    _eomODE( 0 )
+    _eomODE( 0 ),
+    _nThreads( 1 ),
+    _workerPool( 0 )
     {
                 // Initialise ODE integrators for eom and jacobian
                 {
@@ -90,6 +146,10 @@ namespace eutelescope {
     _fittrackvec(0),
     _fithitsvec(0),
     _parPropJac(5, 5),
+    _straightTracks(false),
+    _projectionCache(),
+    _sensorScatPrecCache(),
+    _sensorScatPrecMomentum(0.),
     _beamQ(-1),
     _eBeam(-1.),
     _hitId2GblPointLabel(),
@@ -106,7 +166,9 @@ namespace eutelescope {
     _excludeFromFit(),
     _chi2cut(1000.),
     _eomIntegrator( new EUTelUtilityRungeKutta() ),
-    _eomODE( 0 )
+    _eomODE( 0 ),
+    _nThreads( 1 ),
+    _workerPool( 0 )
     {
                 // Initialise ODE integrators for eom and jacobian
                 {
@@ -117,6 +179,13 @@ namespace eutelescope {
     }
 
     EUTelGBLFitter::~EUTelGBLFitter() {
+        delete _workerPool;
+    }
+
+    void EUTelGBLFitter::setNThreads( unsigned int nThreads ) {
+        _nThreads = nThreads > 0 ? nThreads : 1;
+        delete _workerPool;
+        _workerPool = 0;
     }
     
     void EUTelGBLFitter::setParamterIdPlaneVec( const std::vector<int>& vector)
@@ -371,6 +440,69 @@ namespace eutelescope {
        
         return result;
     }
+
+    /**
+     * Get extrapolated position of the track in global coordinate system.
+     * Without magnetic field the track is a straight line and the
+     * numerical integration of getXYZfromDzNum is skipped.
+     * 
+     * @param dz propagation distance along z
+     * @return vector of track parameters in the global coordinate system
+     */
+    TVectorD EUTelGBLFitter::getXYZfromDz( double invP, double tx, double ty, double x0, double y0, double z0, double dz ) const {
+        if ( !_straightTracks ) return getXYZfromDzNum( invP, tx, ty, x0, y0, z0, dz );
+
+        TVectorD result(5);
+        result[0] = x0 + tx * dz;
+        result[1] = y0 + ty * dz;
+        result[2] = tx;
+        result[3] = ty;
+        result[4] = invP;
+        return result;
+    }
+
+    /**
+     * Propagation jacobian. Without magnetic field it only depends on the step
+     * 
+     * @param ds        Z - Z0 propagation distance
+     * 
+     * @return          transport matrix
+     */
+    TMatrixD EUTelGBLFitter::getPropagationJacobian( double ds, double invP, double tx0, double ty0, double x0, double y0, double z0 ) {
+        if ( _straightTracks ) return propagatePar( ds );
+        return PropagatePar( ds, invP, tx0, ty0, x0, y0, z0 );
+    }
+
+    /**
+     * Projection matrix from the track coordinate system onto the
+     * measurement system of a plane. It only depends on the geometry,
+     * so the navigation to the plane is done once per plane.
+     * 
+     * @param planeID plane id
+     * @param hitPointGlobal a point of the plane in the global coordinate system
+     * @return projection matrix
+     */
+    TMatrixD& EUTelGBLFitter::getProjectionMatrix( int planeID, const double* hitPointGlobal ) {
+        std::map< int, TMatrixD >::iterator cached = _projectionCache.find( planeID );
+        if ( cached != _projectionCache.end() ) {
+            // an unknown plane is never reused
+            if ( planeID >= 0 ) return cached->second;
+            _projectionCache.erase( cached );
+        }
+
+        TMatrixD proL2m(2, 2);
+
+        const TGeoHMatrix* globalH = geo::gGeometry().getHMatrix( hitPointGlobal );
+        const TGeoHMatrix& globalHInv = globalH->Inverse();
+        const double* rotation = globalHInv.GetRotationMatrix();
+
+        proL2m[0][0] = rotation[0]; // x projection, xx
+        proL2m[0][1] = rotation[1]; // y projection, xy
+        proL2m[1][0] = rotation[3]; // x projection, yx
+        proL2m[1][1] = rotation[4]; // y projection, yy
+
+        return _projectionCache.insert( std::make_pair( planeID, proL2m ) ).first->second;
+    }
         
     void EUTelGBLFitter::SetTrackCandidates(const EVENT::TrackVec& trackCandidates) {
 
@@ -505,20 +637,30 @@ namespace eutelescope {
      * @param p momentum of the particle
      */
     void EUTelGBLFitter::addSiPlaneScattererGBL(gbl::GblPoint& point, TVectorD& scat, TVectorD& scatPrecSensor, int planeID, double p) {
-        const int iPlane = geo::gGeometry().sensorIDtoZOrder(planeID);
-        const double radlenSi           = geo::gGeometry()._siPlanesLayerLayout->getSensitiveRadLength(iPlane);
-        const double radlenKap          = geo::gGeometry()._siPlanesLayerLayout->getLayerRadLength(iPlane);
-        const double thicknessSi        = geo::gGeometry()._siPlanesLayerLayout->getSensitiveThickness(iPlane);
-        const double thicknessKap       = geo::gGeometry()._siPlanesLayerLayout->getLayerThickness(iPlane);
+        if ( p != _sensorScatPrecMomentum ) {
+            _sensorScatPrecCache.clear();
+            _sensorScatPrecMomentum = p;
+        }
 
-        const double X0Si = thicknessSi / radlenSi; // Si 
-        const double X0Kap = thicknessKap / radlenKap; // Kapton                
+        std::map< int, double >::const_iterator cached = _sensorScatPrecCache.find( planeID );
+        if ( cached == _sensorScatPrecCache.end() ) {
+            const int iPlane = geo::gGeometry().sensorIDtoZOrder(planeID);
+            const double radlenSi           = geo::gGeometry()._siPlanesLayerLayout->getSensitiveRadLength(iPlane);
+            const double radlenKap          = geo::gGeometry()._siPlanesLayerLayout->getLayerRadLength(iPlane);
+            const double thicknessSi        = geo::gGeometry()._siPlanesLayerLayout->getSensitiveThickness(iPlane);
+            const double thicknessKap       = geo::gGeometry()._siPlanesLayerLayout->getLayerThickness(iPlane);
 
-        const double tetSi = Utility::getThetaRMSHighland(p, X0Si);
-        const double tetKap = Utility::getThetaRMSHighland(p, X0Kap);
+            const double X0Si = thicknessSi / radlenSi; // Si 
+            const double X0Kap = thicknessKap / radlenKap; // Kapton                
 
-        scatPrecSensor[0] = 1.0 / (tetSi * tetSi + tetKap * tetKap);
-        scatPrecSensor[1] = 1.0 / (tetSi * tetSi + tetKap * tetKap);
+            const double tetSi = Utility::getThetaRMSHighland(p, X0Si);
+            const double tetKap = Utility::getThetaRMSHighland(p, X0Kap);
+
+            cached = _sensorScatPrecCache.insert( std::make_pair( planeID, 1.0 / (tetSi * tetSi + tetKap * tetKap) ) ).first;
+        }
+
+        scatPrecSensor[0] = cached->second;
+        scatPrecSensor[1] = cached->second;
 
         point.addScatterer(scat, scatPrecSensor);
     }
@@ -652,7 +794,7 @@ namespace eutelescope {
         float trackRefPoint[3] = { 0., 0., 0. };
         double invP = 1./_eBeam;
 
-        TVectorD prevState = getXYZfromDzNum( invP, 0., 0., 0., 0., 0., 0. );
+        TVectorD prevState = getXYZfromDz( invP, 0., 0., 0., 0., 0., 0. );
 //        double prevZ = refPoint[2];
 
         EVENT::TrackerHitVec::const_iterator itrHit;
@@ -726,7 +868,7 @@ namespace eutelescope {
 		    double trackDirGlobal[] = { 0., 0., 0. };
 	            geo::gGeometry().local2MasterVec( planeID, trackDirLocal, trackDirGlobal);
 
-                    prevState = getXYZfromDzNum( invP, trackDirGlobal[0], trackDirGlobal[1], trackPointGlobal[0], trackPointGlobal[1], trackPointGlobal[2], hitSpacingDz );
+                    prevState = getXYZfromDz( invP, trackDirGlobal[0], trackDirGlobal[1], trackPointGlobal[0], trackPointGlobal[1], trackPointGlobal[2], hitSpacingDz );
                     streamlog_out(DEBUG2) << "forward "  << prevState[0] << " "  << prevState[1] << " " << trackPointGlobal[2] << " " << hitSpacingDz << std::endl;
 
 //          jacPointToPoint = PropagatePar( step, invP, corrections[3], corrections[4], corrections[1], corrections[2], hitPointGlobal[2] );
@@ -820,10 +962,23 @@ namespace eutelescope {
         alDer.Zero();
 
         double p = _eBeam; // beam momentum
+
+        // without magnetic field the tracks are straight lines, no numerical integration is needed
+        {
+            const gear::BField&   B = geo::gGeometry().getMagneticFiled();
+            _straightTracks = ( B.at( TVector3(0.,0.,0.) ).r2() < 1.E-6 );
+        }
+
+        EVENT::FloatVec hitcov(4);
        
 
         EVENT::TrackVec::const_iterator itTrkCand;
 
+        // the trajectories are built here one after the other, because the
+        // geometry navigation is not thread safe, then fitted all together
+        std::vector< GblFitJob > jobs;
+        jobs.reserve( _trackCandidates.size() );
+
         for ( itTrkCand = _trackCandidates.begin(); itTrkCand != _trackCandidates.end(); ++itTrkCand) {
             // sanity check. Mustn't happen in principle.
             if ((*itTrkCand)->getTrackerHits().size() > geo::gGeometry().nPlanes()) continue;
@@ -856,7 +1011,7 @@ namespace eutelescope {
 	    // Reference point is the last hit on a track
 	    const float *refPoint = (*itTrkCand)->getReferencePoint();
 
-	    TVectorD prevState = getXYZfromDzNum( invP, tx, ty, refPoint[0], refPoint[1], refPoint[2], 0. );
+	    TVectorD prevState = getXYZfromDz( invP, tx, ty, refPoint[0], refPoint[1], refPoint[2], 0. );
 	    double prevZ = refPoint[2];
             
             // Loop over hits on a track candidate
@@ -873,7 +1028,7 @@ namespace eutelescope {
 
 
 //                const EVENT::FloatVec hitcov = (*itHit)->getCovMatrix();
-                EVENT::FloatVec hitcov(4);
+                hitcov.resize(4);
                 hitcov[0]=0.01;
                 hitcov[1]=0.00;
                 hitcov[2]=0.01;
@@ -921,7 +1076,7 @@ namespace eutelescope {
 		
 		// Propagate track parameters to the next hit
 // rubinskiy		TVectorD trackParamPrediction = getXYZfromDzNum( invP, prevState[2], prevState[3], prevState[0], prevState[1], refPoint[2], dz );
-                TVectorD trackParamPrediction = getXYZfromDzNum( invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ, dz );
+                TVectorD trackParamPrediction = getXYZfromDz( invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ, dz );
 //		trackParamPrediction.Print();
                 prevZ = hitPointGlobal[2];
 
@@ -950,16 +1105,7 @@ namespace eutelescope {
 //                jacPointToPoint.Print();
 
 		// Calculate projection matrix
-                TMatrixD proL2m(2, 2);
-
-		const TGeoHMatrix* globalH = geo::gGeometry().getHMatrix( hitPointGlobal );
-		const TGeoHMatrix& globalHInv = globalH->Inverse();
-		const double* rotation = globalHInv.GetRotationMatrix();
-
-		proL2m[0][0] = rotation[0]; // x projection, xx
-		proL2m[0][1] = rotation[1]; // y projection, xy
-		proL2m[1][0] = rotation[3]; // x projection, yx
-		proL2m[1][1] = rotation[4]; // y projection, yy
+                TMatrixD& proL2m = getProjectionMatrix( planeID, hitPointGlobal );
 
 //		proL2m.UnitMatrix();
 //		proL2m.Print();
@@ -1008,14 +1154,6 @@ namespace eutelescope {
                     
                     double sigmaTheta = Utility::getThetaRMSHighland(p, rad);
 
-		    // Calculate scalar products of local offset directions and track direction
-		    double uDir[] = { 1., 0., 0. };
-		    double uDirGlobal[] = { 0., 0., 0. };
-		    geo::gGeometry().local2Master(planeID,uDir,uDirGlobal);
-		    double vDir[] = { 0., 1., 0. };
-		    double vDirGlobal[] = { 0., 0., 0. };
-		    geo::gGeometry().local2Master(planeID,vDir,vDirGlobal);
-
 		    // Calculate px, py, pz at current point
 //		    const double px = p*trackParamPrediction[2] / sqrt( 1. + trackParamPrediction[2]*trackParamPrediction[2] +
 //									     trackParamPrediction[3]*trackParamPrediction[3] );
@@ -1046,11 +1184,11 @@ namespace eutelescope {
                     {   // downstream air scatterer
                         step = hitSpacingDz / 2. - hitSpacingDz / sqrt(12.);
 // rubinsky                        prevZ += step;
-                        jacPointToPoint = PropagatePar( step, invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ );
+                        jacPointToPoint = getPropagationJacobian( step, invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ );
 //rubinsky                       jacPointToPoint = PropagatePar( step, invP, trackParamPrediction[2], trackParamPrediction[3], trackParamPrediction[0], trackParamPrediction[1], hitPointGlobal[2] );
 //                        jacPointToPoint.Print();
 // rubinskiy           prevState = getXYZfromDzNum( invP, trackParamPrediction[2], trackParamPrediction[3], trackParamPrediction[0], trackParamPrediction[1], hitPointGlobal[2], step );
-                       prevState = getXYZfromDzNum( invP, trackParamPrediction[2], trackParamPrediction[3], trackParamPrediction[0], trackParamPrediction[1], prevZ, step );
+                       prevState = getXYZfromDz( invP, trackParamPrediction[2], trackParamPrediction[3], trackParamPrediction[0], trackParamPrediction[1], prevZ, step );
                        prevZ += step;
 
                         gbl::GblPoint pointInAir1(jacPointToPoint);
@@ -1062,10 +1200,10 @@ namespace eutelescope {
                         step = 2*hitSpacingDz / sqrt( 12. ); // rubinskiy
 // rubinsky                        prevZ += step;
 // rubinsky                         jacPointToPoint = PropagatePar( step, invP, prevState[2], prevState[3], prevState[0], prevState[1], hitPointGlobal[2] );
-                        jacPointToPoint = PropagatePar( step, invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ );
+                        jacPointToPoint = getPropagationJacobian( step, invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ );
 //                        jacPointToPoint.Print();
 //rubinskiy             prevState = getXYZfromDzNum( invP, prevState[2], prevState[3], prevState[0], prevState[1], hitPointGlobal[2], step );
-                        prevState = getXYZfromDzNum( invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ, step );
+                        prevState = getXYZfromDz( invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ, step );
                         prevZ += step;
                         gbl::GblPoint pointInAir2( jacPointToPoint );
                         pointInAir2.addScatterer( scat, scatPrec );
@@ -1077,42 +1215,43 @@ namespace eutelescope {
                         step = hitSpacingDz / 2. - hitSpacingDz / sqrt( 12. );
 // not needed after this step anymore                         prevZ += step;
 // rubinskiy            jacPointToPoint = PropagatePar( step, invP, prevState[2], prevState[3], prevState[0], prevState[1], hitPointGlobal[2] );
-                        jacPointToPoint = PropagatePar( step, invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ );
+                        jacPointToPoint = getPropagationJacobian( step, invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ );
 //                        jacPointToPoint.Print();
                     }
                 } // if not the last hit
             } // loop over hits
 
-            double loss = 0.;
-            double chi2 = 0.;
-            int ndf = 0;
-            // perform GBL fit
-            {
-                // check magnetic field at (0,0,0)
-                const gear::BField&   B = geo::gGeometry().getMagneticFiled();
-                const double Bmag       = B.at( TVector3(0.,0.,0.) ).r2();
-                
-                gbl::GblTrajectory* traj = 0;
-                if ( Bmag < 1.E-6 ) {
-                   traj = new gbl::GblTrajectory( pointList, false );
-                } else {
-                   traj = new gbl::GblTrajectory( pointList, true );
-                }
-                
-//                if ( !traj.isValid() ) {
-//                        streamlog_out(WARNING1) << "Not valid GBL trajectory. Check the input." << std::endl;
-//                        streamlog_message( MESSAGE0, traj->printData(); traj->printPoints(1); traj->printTrajectory(1);, std::endl;); 
-//                    continue;
-//                }
-                
-                int ierr = 0;
+            jobs.push_back( GblFitJob() );
+            GblFitJob& job = jobs.back();
+            job.candidate  = itTrkCand;
+            job.invP       = invP;
+            job.trajectory = 0;
+            job.points.swap( pointList );
+            for ( itHit = hits.rbegin(); itHit != hits.rend(); ++itHit ) {
+                job.hitLabels.push_back( std::make_pair( static_cast< long >( (*itHit)->id() ), _hitId2GblPointLabel[ (*itHit)->id() ] ) );
+            }
+        } // loop over supplied track candidates
+
+        // perform GBL fit
+        if ( _workerPool == 0 ) _workerPool = new EUTelWorkerPool( _nThreads );
+        GblFitTask fitTask( jobs, !_straightTracks, _mEstimatorType );
+        {
+            EUTelProfiler::Scope profilerScope( "GBL fit" );
+            _workerPool->run( fitTask, jobs.size() );
+        }
 
-                if ( !_mEstimatorType.empty( ) ) ierr = traj->fit( chi2, ndf, loss, _mEstimatorType );
-                else ierr = traj->fit( chi2, ndf, loss );
+        // the results are written in the order of the candidates, whatever the number of threads
+        for ( size_t iJob = 0; iJob < jobs.size(); ++iJob ) {
+            GblFitJob& job = jobs[iJob];
+            gbl::GblTrajectory* traj = job.trajectory;
+            if ( traj == 0 ) {
+                streamlog_out( ERROR2 ) << "GBL fit of track candidate " << std::distance( _trackCandidates.begin(), job.candidate ) << " failed" << std::endl;
+                continue;
+            }
 
-              if ( chi2 < _chi2cut ) 
+              if ( job.chi2 < _chi2cut ) 
                 {
-                    if ( ierr )
+                    if ( job.ierr )
                     {
 			traj->printTrajectory(1);
 			traj->printData();
@@ -1121,21 +1260,24 @@ namespace eutelescope {
                 } 
                 
                  EVENT::TrackVec::const_iterator begin = _trackCandidates.begin();
-                _gblTrackCandidates.insert( std::make_pair( std::distance( begin, itTrkCand ), traj ) );
+                _gblTrackCandidates.insert( std::make_pair( std::distance( begin, job.candidate ), traj ) );
+
+                // the hit labels as they were when this candidate was built
+                for ( size_t iHit = 0; iHit < job.hitLabels.size(); ++iHit ) {
+                    _hitId2GblPointLabel[ job.hitLabels[iHit].first ] = job.hitLabels[iHit].second;
+                }
                 
                 // Write fit result
                 {
-                    prepareLCIOTrack( traj, (*itTrkCand)->getTrackerHits(), chi2, ndf, invP, 0., 0., 0., 0. );
+                    prepareLCIOTrack( traj, (*job.candidate)->getTrackerHits(), job.chi2, job.ndf, job.invP, 0., 0., 0., 0. );
                 }
 
                 // Prepare and write Mille Out
                 if (_alignmentMode != Utility::noAlignment) 
                 {
-//                     prepareMilleOut( traj, (*itTrkCand)->getTrackerHits(), chi2, ndf, invP, 0., 0., 0., 0. );
-                   prepareMilleOut( traj, itTrkCand, chi2, ndf, invP, 0., 0., 0., 0. );
+                   prepareMilleOut( traj, job.candidate, job.chi2, job.ndf, job.invP, 0., 0., 0., 0. );
                 }
-            }
-        } // loop over supplied track candidates
+        }
 
         return;
     } // EUTelGBLFitter::FitTracks()
@@ -1164,7 +1306,7 @@ namespace eutelescope {
  
           const float *refPoint = (*itTrkCand)->getReferencePoint();
 
-          TVectorD prevState = getXYZfromDzNum( invP, tx, ty, refPoint[0], refPoint[1], refPoint[2], 0. );
+          TVectorD prevState = getXYZfromDz( invP, tx, ty, refPoint[0], refPoint[1], refPoint[2], 0. );
           double prevZ = refPoint[2];
 
           streamlog_out(DEBUG4) << "FitTracks   ";
@@ -1270,7 +1412,7 @@ namespace eutelescope {
 
 //                TVectorD trackParamPrediction = getXYZfromDzNum( invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ, dz );
 //                TVectorD trackParamPrediction = getXYZfromDzNum( invP, prevState[2], prevState[3], prevState[0], prevState[1], refPoint[2], dz );
-                TVectorD trackParamPrediction = getXYZfromDzNum( invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ, dz );
+                TVectorD trackParamPrediction = getXYZfromDz( invP, prevState[2], prevState[3], prevState[0], prevState[1], prevZ, dz );
                 streamlog_message( DEBUG2,                trackParamPrediction.Print();, std::endl; );
                 prevZ = trackPointGlobal[2];
 
@@ -1329,16 +1471,7 @@ namespace eutelescope {
             // Calculate projection matrix
 
  		// Calculate projection matrix
-                TMatrixD proL2m(2, 2);
-
-		const TGeoHMatrix* globalH = geo::gGeometry().getHMatrix( hitPointGlobal );
-		const TGeoHMatrix& globalHInv = globalH->Inverse();
-		const double* rotation = globalHInv.GetRotationMatrix();
-
-		proL2m[0][0] = rotation[0]; // x projection, xx
-		proL2m[0][1] = rotation[1]; // y projection, xy
-		proL2m[1][0] = rotation[3]; // x projection, yx
-		proL2m[1][1] = rotation[4]; // y projection, yy
+                TMatrixD& proL2m = getProjectionMatrix( planeID, hitPointGlobal );
 
 // add measurment (residuals) in the measurement system (module 2D coordinates)
                 addMeasurementsGBL( point, residual, measErr, hitPointLocal, trackPointLocal, hitcov, proL2m);
@@ -1360,7 +1493,7 @@ namespace eutelescope {
                     double step = hitPointGlobal[2] - nextHitPointGlobal[2];
                     streamlog_out(MESSAGE1) << "nexg2= " << nextHitPointGlobal[0] << " " << nextHitPointGlobal[1] << " " << nextHitPointGlobal[2] << std::endl;
 
-                    jacPointToPoint = PropagatePar( step, invP, corrections[3], corrections[4], corrections[1], corrections[2], hitPointGlobal[2] );
+                    jacPointToPoint = getPropagationJacobian( step, invP, corrections[3], corrections[4], corrections[1], corrections[2], hitPointGlobal[2] );
                 }
 
                 pushBackPointMille( pointList, point, (*itrHit)->id() );
@@ -0,0 +1,321 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+// built only if USE_GEAR
+#if defined(USE_GEAR)
+
+// eutelescope includes ".h"
+#include "EUTelHitStore.h"
+#include "EUTELESCOPE.h"
+#include "EUTelReferenceHit.h"
+#include "EUTelSparseClusterImpl.h"
+
+// marlin includes ".h"
+#include "marlin/Global.h"
+
+// streamlog includes ".h"
+#include "streamlog/streamlog.h"
+
+// lcio includes <.h>
+#include <IMPL/LCGenericObjectImpl.h>
+#include <IMPL/TrackerDataImpl.h>
+#include <EVENT/LCIO.h>
+#include <UTIL/CellIDDecoder.h>
+
+// gear includes <.h>
+#include <gear/GearMgr.h>
+#include <gear/SiPlanesParameters.h>
+
+// ROOT includes
+#include "TVector3.h"
+
+// system includes <>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+using namespace std;
+using namespace lcio;
+using namespace marlin;
+using namespace eutelescope;
+
+namespace {
+
+  //! The LCGenericObject carrying the hit store of an event
+  class EUTelHitStoreObject : public IMPL::LCGenericObjectImpl {
+  public:
+    EUTelHitStore store;
+  };
+
+  //! Sensor IDs and z positions of the planes, from GEAR or setPlanes()
+  vector< int >    planeSensorIDs;
+  vector< double > planeZ;
+
+  //! The hot pixels of a hot pixel collection and the run they were read for
+  struct HotPixelCache {
+    HotPixelCache() : runNumber(-1), pixels() { }
+    int runNumber;
+    map< int, set< pair< short, short > > > pixels;
+  };
+  map< string, HotPixelCache > hotPixelCaches;
+
+  void initPlanes() {
+
+    const gear::SiPlanesLayerLayout & layout = Global::GEAR->getSiPlanesParameters().getSiPlanesLayerLayout();
+
+    planeSensorIDs.resize( layout.getNLayers() );
+    planeZ.resize( layout.getNLayers() );
+    for ( int iPlane = 0; iPlane < layout.getNLayers(); ++iPlane ) {
+      planeSensorIDs[ iPlane ] = layout.getID( iPlane );
+      planeZ[ iPlane ] = layout.getLayerPositionZ( iPlane );
+    }
+  }
+}
+
+const EUTelHitStore & EUTelHitStore::get(LCEvent * event, const string & hitCollectionName,
+                                         const string & referenceHitCollectionName) {
+
+  const string storeName = "EUTelHitStore_" + hitCollectionName + "_" + referenceHitCollectionName;
+
+  try {
+    LCCollection * storeCollection = event->getCollection( storeName );
+    EUTelHitStoreObject * storeObject = dynamic_cast< EUTelHitStoreObject * >( storeCollection->getElementAt( 0 ) );
+    if ( storeObject != 0 ) return storeObject->store;
+  } catch ( DataNotAvailableException& e ) {
+    // first caller in this event
+  }
+
+  // build it before adding it, so that a failed build leaves nothing
+  // behind in the event
+  auto_ptr< EUTelHitStoreObject > storeObject( new EUTelHitStoreObject );
+  storeObject->store.build( event, hitCollectionName, referenceHitCollectionName );
+
+  LCCollectionVec * storeCollection = new LCCollectionVec( LCIO::LCGENERICOBJECT );
+  storeCollection->setTransient( true );
+  EUTelHitStoreObject * object = storeObject.release();
+  storeCollection->push_back( object );
+  event->addCollection( storeCollection, storeName );
+
+  return object->store;
+}
+
+void EUTelHitStore::setPlanes(const vector< int > & sensorIDs, const vector< double > & z) {
+  planeSensorIDs = sensorIDs;
+  planeZ         = z;
+  planeZ.resize( planeSensorIDs.size(), 0. );
+}
+
+EUTelHitStore::EUTelHitStore() :
+  _planes(),
+  _sensorIDToPlane(),
+  _event(0),
+  _hits(),
+  _hitPlane(),
+  _hitIndex(),
+  _hotFlags() {
+}
+
+int EUTelHitStore::getPlaneIndex(int sensorID) const {
+  map< int, int >::const_iterator iter = _sensorIDToPlane.find( sensorID );
+  return iter == _sensorIDToPlane.end() ? -1 : iter->second;
+}
+
+const vector< bool > & EUTelHitStore::getHotFlags(const string & hotPixelCollectionName) const {
+
+  map< string, vector< bool > >::iterator flags = _hotFlags.find( hotPixelCollectionName );
+  if ( flags != _hotFlags.end() ) return flags->second;
+
+  vector< bool > & hot = _hotFlags[ hotPixelCollectionName ];
+  hot.resize( _hits.size(), false );
+  if ( hotPixelCollectionName.empty() ) return hot;
+
+  const HotPixelMap & hotPixels = getHotPixels( _event, hotPixelCollectionName );
+  if ( hotPixels.empty() ) return hot;
+
+  for ( size_t iHit = 0; iHit < _hits.size(); ++iHit ) {
+    hot[ iHit ] = _hits[ iHit ] != 0 && hitContainsHotPixels( _hits[ iHit ], hotPixels );
+  }
+  return hot;
+}
+
+void EUTelHitStore::build(LCEvent * event, const string & hitCollectionName,
+                          const string & referenceHitCollectionName) {
+
+  _event = event;
+
+  if ( planeSensorIDs.empty() ) initPlanes();
+
+  _planes.resize( planeSensorIDs.size() );
+  for ( size_t iPlane = 0; iPlane < planeSensorIDs.size(); ++iPlane ) {
+    _planes[ iPlane ].sensorID = planeSensorIDs[ iPlane ];
+    _sensorIDToPlane[ planeSensorIDs[ iPlane ] ] = static_cast< int >( iPlane );
+  }
+
+  LCCollectionVec * referenceHitVec = 0;
+  if ( ! referenceHitCollectionName.empty() ) {
+    try {
+      referenceHitVec = dynamic_cast< LCCollectionVec * >( event->getCollection( referenceHitCollectionName ) );
+    } catch ( DataNotAvailableException& e ) {
+      referenceHitVec = 0;
+    }
+  }
+
+  LCCollectionVec * hitCollection = dynamic_cast< LCCollectionVec * >( event->getCollection( hitCollectionName ) );
+  if ( hitCollection == 0 ) return;
+
+  _hits.resize( hitCollection->size(), 0 );
+  _hitPlane.resize( hitCollection->size(), -1 );
+  _hitIndex.resize( hitCollection->size(), -1 );
+
+  for ( size_t iHit = 0; iHit < hitCollection->size(); ++iHit ) {
+
+    TrackerHitImpl * hit = dynamic_cast< TrackerHitImpl * >( hitCollection->getElementAt( iHit ) );
+    if ( hit == 0 ) continue;
+    _hits[ iHit ] = hit;
+
+    const double * pos = hit->getPosition();
+    int iPlane = getPlaneIndex( guessSensorID( pos, referenceHitVec ) );
+    if ( iPlane < 0 ) continue;
+
+    Plane & plane = _planes[ iPlane ];
+    _hitPlane[ iHit ] = iPlane;
+    _hitIndex[ iHit ] = static_cast< int >( plane.size() );
+
+    const EVENT::FloatVec & cov = hit->getCovMatrix();
+    plane.x.push_back( pos[0] );
+    plane.y.push_back( pos[1] );
+    plane.z.push_back( pos[2] );
+    plane.errX.push_back( cov.size() > 2 ? sqrt( cov[0] ) : 0. );
+    plane.errY.push_back( cov.size() > 2 ? sqrt( cov[2] ) : 0. );
+    plane.hit.push_back( hit );
+    plane.collectionIndex.push_back( static_cast< int >( iHit ) );
+  }
+}
+
+const EUTelHitStore::HotPixelMap & EUTelHitStore::getHotPixels(LCEvent * event, const string & hotPixelCollectionName) {
+
+  HotPixelCache & cache = hotPixelCaches[ hotPixelCollectionName ];
+  if ( cache.runNumber == event->getRunNumber() ) return cache.pixels;
+
+  LCCollectionVec * hotPixelCollectionVec = 0;
+  try {
+    hotPixelCollectionVec = static_cast< LCCollectionVec * >( event->getCollection( hotPixelCollectionName ) );
+  } catch ( DataNotAvailableException& e ) {
+    // keep the previous ones and try again with the next event
+    return cache.pixels;
+  }
+  cache.runNumber = event->getRunNumber();
+  cache.pixels.clear();
+  streamlog_out ( DEBUG5 ) << "Hotpixel collection " << hotPixelCollectionName << " found" << endl;
+
+  CellIDDecoder< TrackerDataImpl > cellDecoder( hotPixelCollectionVec );
+
+  for ( int i = 0; i < hotPixelCollectionVec->getNumberOfElements(); i++ ) {
+
+    TrackerDataImpl * hotPixelData = dynamic_cast< TrackerDataImpl * >( hotPixelCollectionVec->getElementAt( i ) );
+    SparsePixelType type = static_cast< SparsePixelType >( static_cast< int >( cellDecoder( hotPixelData )["sparsePixelType"] ) );
+    int sensorID         = static_cast< int >( cellDecoder( hotPixelData )["sensorID"] );
+
+    if ( type == kEUTelAPIXSparsePixel ) {
+      auto_ptr< EUTelSparseDataImpl< EUTelAPIXSparsePixel > > apixData( new EUTelSparseDataImpl< EUTelAPIXSparsePixel >( hotPixelData ) );
+      EUTelAPIXSparsePixel apixPixel;
+      for ( unsigned int iPixel = 0; iPixel < apixData->size(); iPixel++ ) {
+        apixData->getSparsePixelAt( iPixel, &apixPixel );
+        cache.pixels[ sensorID ].insert( make_pair( apixPixel.getXCoord(), apixPixel.getYCoord() ) );
+      }
+    } else if ( type == kEUTelSimpleSparsePixel ) {
+      auto_ptr< EUTelSparseClusterImpl< EUTelSimpleSparsePixel > > m26Data( new EUTelSparseClusterImpl< EUTelSimpleSparsePixel >( hotPixelData ) );
+      EUTelSimpleSparsePixel m26Pixel;
+      for ( unsigned int iPixel = 0; iPixel < m26Data->size(); iPixel++ ) {
+        m26Data->getSparsePixelAt( iPixel, &m26Pixel );
+        cache.pixels[ sensorID ].insert( make_pair( m26Pixel.getXCoord(), m26Pixel.getYCoord() ) );
+      }
+    }
+  }
+  return cache.pixels;
+}
+
+int EUTelHitStore::guessSensorID(const double * pos, LCCollectionVec * referenceHitVec) {
+
+  int sensorID = -1;
+  double minDistance = numeric_limits< double >::max();
+
+  if ( referenceHitVec == 0 ) {
+    // use z information of planes instead of reference vector
+    for ( size_t iPlane = 0; iPlane < planeSensorIDs.size(); ++iPlane ) {
+      double distance = std::abs( pos[2] - planeZ[ iPlane ] );
+      if ( distance < minDistance ) {
+        minDistance = distance;
+        sensorID = planeSensorIDs[ iPlane ];
+      }
+    }
+    if ( minDistance > 30 ) {
+      // advice the user that the guessing wasn't successful
+      streamlog_out( WARNING3 ) << "A hit was found " << minDistance << " mm far from the nearest plane\n"
+        "Please check the consistency of the data with the GEAR file: hitPosition[2]=" << pos[2] << endl;
+    }
+    return sensorID;
+  }
+
+  TVector3 hit3d( pos[0], pos[1], pos[2] );
+  for ( int ii = 0; ii < referenceHitVec->getNumberOfElements(); ii++ ) {
+    EUTelReferenceHit * refhit = static_cast< EUTelReferenceHit * >( referenceHitVec->getElementAt( ii ) );
+
+    TVector3 hitInPlane( refhit->getXOffset(), refhit->getYOffset(), refhit->getZOffset() );
+    TVector3 norm2Plane( refhit->getAlpha(), refhit->getBeta(), refhit->getGamma() );
+
+    double distance = std::abs( norm2Plane.Dot( hit3d - hitInPlane ) );
+    if ( distance < minDistance ) {
+      minDistance = distance;
+      sensorID = refhit->getSensorID();
+    }
+  }
+  return sensorID;
+}
+
+bool EUTelHitStore::hitContainsHotPixels(TrackerHitImpl * hit, const HotPixelMap & hotPixelMap) {
+
+  try {
+    LCObjectVec clusterVector = hit->getRawHits();
+    if ( clusterVector.empty() ) return false;
+    TrackerDataImpl * clusterFrame = static_cast< TrackerDataImpl * >( clusterVector[0] );
+
+    if ( hit->getType() == kEUTelSparseClusterImpl ) {
+
+      EUTelSparseClusterImpl< EUTelSimpleSparsePixel > cluster( clusterFrame );
+      HotPixelMap::const_iterator hotPixels = hotPixelMap.find( cluster.getDetectorID() );
+      if ( hotPixels == hotPixelMap.end() ) return false;
+
+      EUTelSimpleSparsePixel m26Pixel;
+      for ( unsigned int iPixel = 0; iPixel < cluster.size(); iPixel++ ) {
+        cluster.getSparsePixelAt( iPixel, &m26Pixel );
+        if ( hotPixels->second.count( make_pair( m26Pixel.getXCoord(), m26Pixel.getYCoord() ) ) ) return true;
+      }
+
+    } else if ( hit->getType() == kEUTelAPIXClusterImpl ) {
+
+      EUTelSparseClusterImpl< EUTelAPIXSparsePixel > cluster( clusterFrame );
+      HotPixelMap::const_iterator hotPixels = hotPixelMap.find( cluster.getDetectorID() );
+      if ( hotPixels == hotPixelMap.end() ) return false;
+
+      EUTelAPIXSparsePixel apixPixel;
+      for ( unsigned int iPixel = 0; iPixel < cluster.size(); iPixel++ ) {
+        cluster.getSparsePixelAt( iPixel, &apixPixel );
+        if ( hotPixels->second.count( make_pair( apixPixel.getXCoord(), apixPixel.getYCoord() ) ) ) return true;
+      }
+    }
+  } catch ( exception& e ) {
+    streamlog_out( ERROR4 ) << "something went wrong in EUTelHitStore::hitContainsHotPixels: " << e.what() << endl;
+  }
+
+  // if none of the above worked, do not skip this hit
+  return false;
+}
+
+#endif
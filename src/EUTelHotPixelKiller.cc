@@ -11,6 +11,7 @@
 
 // eutelescope includes ".h"
 #include "EUTelHotPixelKiller.h"
+#include "EUTelConvergenceMonitor.h"
 #include "EUTELESCOPE.h"
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelMatrixDecoder.h"
@@ -51,6 +52,7 @@
 
 
 // system includes <>
+#include <algorithm>
 #include <map>
 #include <memory>
 
@@ -91,6 +93,8 @@ EUTelHotPixelKiller::EUTelHotPixelKiller ()
   _iCycle(0),
   _killedPixelVec(),
   _firingFreqVec(),
+  _convergenceTolerance(0.),
+  _convergenceCheckInterval(1000),
   _flagBuildHotPixelDatabase(0)
 {
 
@@ -143,6 +147,12 @@ EUTelHotPixelKiller::EUTelHotPixelKiller ()
   registerOptionalParameter("HotPixelCollectionName", "This is the name of the hot pixel collection to be saved into the output slcio file",
                              _hotPixelCollectionName, static_cast< string > ( "hotpixel" ));
 
+  registerOptionalParameter("ConvergenceTolerance","If positive, end the cycle before NoOfEventPerCycle once the number of hot pixels of all sensors is stable within this tolerance, and stop the job when all the other monitored processors have converged",
+                            _convergenceTolerance, static_cast< float > ( 0. ) );
+
+  registerOptionalParameter("ConvergenceCheckInterval","How often, in events, the number of hot pixels is checked for convergence. Shortened if a cycle cannot hold enough checks to converge",
+                            _convergenceCheckInterval, static_cast< int > ( 1000 ) );
+
 }
 
 
@@ -430,6 +440,26 @@ void EUTelHotPixelKiller::processEvent (LCEvent * event)
             }
         }
         
+        if( _convergenceTolerance > 0 )
+        {
+            if( _convergenceCheckInterval <= 0 ) _convergenceCheckInterval = 1000;
+
+            // the estimators start again at every cycle, so a cycle
+            // has to hold enough checks to converge
+            const int maxInterval = std::max( 1, _noOfEventPerCycle / ( EUTelConvergenceMonitor::instance().getRequiredStableUpdates() + 1 ) );
+            if( _convergenceCheckInterval > maxInterval )
+            {
+                streamlog_out ( WARNING2 ) << "ConvergenceCheckInterval " << _convergenceCheckInterval << " is too long for cycles of "
+                                           << _noOfEventPerCycle << " events, using " << maxInterval << endl;
+                _convergenceCheckInterval = maxInterval;
+            }
+            for ( size_t iDetector = 0; iDetector < _firingFreqVec.size(); iDetector++ )
+            {
+                EUTelConvergenceMonitor::instance().registerEstimator( this, "hotPixels_" + to_string( _sensorIDVec.at( iDetector ) ),
+                                                                       _convergenceTolerance, _noOfEventPerCycle * ( _totalNoOfCycle + 1 ) );
+            }
+        }
+
         _isFirstEvent = false;
     }
     
@@ -496,6 +526,8 @@ void EUTelHotPixelKiller::processEvent (LCEvent * event)
     }
     
     ++_iEvt;
+
+    if( _convergenceTolerance > 0 && _iEvt % _convergenceCheckInterval == 0 ) updateConvergence();
   } 
   catch (lcio::DataNotAvailableException& e ) 
   {
@@ -566,7 +598,9 @@ void EUTelHotPixelKiller::check( LCEvent * event )
     }
 
     
-    if ( _iEvt == _noOfEventPerCycle -1 ) 
+    const bool hasConverged = _convergenceTolerance > 0 && EUTelConvergenceMonitor::instance().hasConverged( this );
+
+    if ( _iEvt == _noOfEventPerCycle -1 || hasConverged ) 
     {
         try 
         {            
@@ -615,6 +649,20 @@ void EUTelHotPixelKiller::check( LCEvent * event )
       // reset the _iEvt counter
       _iEvt = 0;
 
+      if( _convergenceTolerance > 0 )
+      {
+          // a stable list of hot pixels does not need more cycles
+          if( hasConverged ) _iCycle = static_cast< unsigned short >( _totalNoOfCycle ) + 1;
+          else if( _iCycle > static_cast< unsigned short >( _totalNoOfCycle ) )
+          {
+              EUTelConvergenceMonitor::instance().setDone( this, _noOfEventPerCycle * ( _totalNoOfCycle + 1 ) );
+          }
+          // the pixels masked in this cycle change the number of hot
+          // pixels of the next one: its estimation starts again
+          else EUTelConvergenceMonitor::instance().reset( this );
+          if( _iCycle > static_cast< unsigned short >( _totalNoOfCycle ) ) EUTelConvergenceMonitor::instance().check( this );
+      }
+
     } catch (lcio::DataNotAvailableException& e ) {
       streamlog_out ( WARNING2 )  << "Input collection not found in the current event. Skipping..." << endl;
       return;
@@ -623,6 +671,23 @@ void EUTelHotPixelKiller::check( LCEvent * event )
 }
 
 
+void EUTelHotPixelKiller::updateConvergence()
+{
+    EUTelConvergenceMonitor & monitor = EUTelConvergenceMonitor::instance();
+    const int nEvent = _iCycle * _noOfEventPerCycle + _iEvt;
+
+    for ( unsigned int iDetector = 0; iDetector < _firingFreqVec.size(); iDetector++ ) 
+    {
+        // the same selection as at the end of the cycle
+        int nHotPixel = 0;
+        for ( unsigned int iPixel = 0; iPixel < _firingFreqVec[iDetector].size(); iPixel++ ) 
+        {
+            if ( _firingFreqVec[iDetector][ iPixel ] / ( static_cast< double >( _iEvt ) ) > _maxAllowedFiringFreq ) ++nHotPixel;
+        }
+        monitor.update( this, "hotPixels_" + to_string( _sensorIDVec.at( iDetector ) ), nHotPixel, nEvent );
+    }
+}
+
 void EUTelHotPixelKiller::HotPixelDBWriter(LCEvent *input_event)
 {    
 
@@ -24,6 +24,7 @@
 #include "EUTelSparseClusterImpl.h"
 #include "EUTelSparseCluster2Impl.h"
 #include "EUTelExceptions.h"
+#include "EUTelHitStore.h"
 #include "EUTelPStream.h"
 #include "EUTelAlignmentConstant.h"
 #include "EUTelReferenceHit.h"
@@ -87,6 +88,7 @@
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 using namespace std;
 using namespace lcio;
@@ -325,6 +327,16 @@ EUTelMille::EUTelMille () : Processor("EUTelMille") {
   registerOptionalParameter("HotPixelCollectionName", "This is the name of the hot pixel collection to be saved into the output slcio file",
                              _hotPixelCollectionName, static_cast< string > ( "" ));
 
+  registerOptionalParameter("AlignmentCacheFile", "Binary cache of the hits and track candidates (input mode 0 only). If the file does not exist "
+                            "it is written, otherwise the track candidates are read from it instead of the input collections, all with the first event; "
+                            "the other processors still get every event. A cache written with other collections or cuts is written again. "
+                            "Empty to disable the cache",
+                            _alignmentCacheFile, static_cast< string > ( "" ));
+
+  registerOptionalParameter("AlignmentCacheConstantsCollections", "Alignment constant collections applied in this order to the cached hits, "
+                            "those of the alignment iterations done since the cache was written",
+                            _alignmentCacheConstantsCollections, StringVec());
+
 }
 
 void EUTelMille::init() {
@@ -607,6 +619,34 @@ void EUTelMille::init() {
   // booking histograms
   bookHistos();
 
+  _readAlignmentCache = false;
+  _isAlignmentCacheRead = false;
+  if ( ! _alignmentCacheFile.empty() ) {
+    if ( _inputMode != 0 ) {
+      streamlog_out ( WARNING2 ) << "The alignment cache is only available in input mode 0, ignoring " << _alignmentCacheFile << endl;
+    } else {
+      IntVec cacheSensorIDs( _sensorIDVec );
+      cacheSensorIDs.resize( _nPlanes, -1 );
+      const std::string cacheParameters = alignmentCacheParameters();
+      if ( _alignmentCacheReader.open( _alignmentCacheFile ) && _alignmentCacheReader.getSensorIDs() == cacheSensorIDs
+           && _alignmentCacheReader.getParameters() == cacheParameters ) {
+        streamlog_out ( MESSAGE5 ) << "Reading the track candidates of " << _alignmentCacheReader.getNEvents()
+                                   << " events from the alignment cache " << _alignmentCacheFile << endl;
+        _readAlignmentCache = true;
+      } else {
+        if ( _alignmentCacheReader.getNPlanes() > 0 ) {
+          streamlog_out ( WARNING2 ) << "The alignment cache " << _alignmentCacheFile << " was written with other planes or cuts, writing it again" << endl;
+        }
+        _alignmentCacheReader.close();
+        if ( ! _alignmentCacheWriter.open( _alignmentCacheFile, cacheSensorIDs, cacheParameters ) ) {
+          streamlog_out ( ERROR2 ) << "Cannot create the alignment cache " << _alignmentCacheFile << endl;
+          throw InvalidParameterException("AlignmentCacheFile");
+        }
+        streamlog_out ( MESSAGE5 ) << "Writing the track candidates to the alignment cache " << _alignmentCacheFile << endl;
+      }
+    }
+  }
+
   streamlog_out ( MESSAGE5 ) << "Initialising Mille..." << endl;
   _mille = new Mille(_binaryFilename.c_str());
 
@@ -1071,90 +1111,8 @@ double residYFit[], double angleFit[2]) {
 
 }
 
-void  EUTelMille::FillHotPixelMap(LCEvent *event)
-{
-    LCCollectionVec *hotPixelCollectionVec = 0;
-    try 
-    {
-      hotPixelCollectionVec = static_cast< LCCollectionVec* > ( event->getCollection( _hotPixelCollectionName  ) );
-    }
-    catch (...)
-    {
-      if (!_hotPixelCollectionName.empty())
-	streamlog_out ( WARNING ) << "_hotPixelCollectionName " << _hotPixelCollectionName.c_str() << " not found" << endl; 
-      return;
-    }
-
-        CellIDDecoder<TrackerDataImpl> cellDecoder( hotPixelCollectionVec );
-	
-        for(int i=0; i<  hotPixelCollectionVec->getNumberOfElements(); i++)
-        {
-           TrackerDataImpl* hotPixelData = dynamic_cast< TrackerDataImpl *> ( hotPixelCollectionVec->getElementAt( i ) );
-	   SparsePixelType  type         = static_cast<SparsePixelType> (static_cast<int> (cellDecoder( hotPixelData )["sparsePixelType"]));
-
-	   int sensorID              = static_cast<int > ( cellDecoder( hotPixelData )["sensorID"] );
-
-           if( type  == kEUTelAPIXSparsePixel)
-           {  
-             auto_ptr<EUTelSparseDataImpl<EUTelAPIXSparsePixel > > apixData(new EUTelSparseDataImpl<EUTelAPIXSparsePixel> ( hotPixelData ));
-             std::vector<EUTelAPIXSparsePixel*> apixPixelVec;
- 	     EUTelAPIXSparsePixel apixPixel;
-	     //Push all single Pixels of one plane in the apixPixelVec
-
-             for ( unsigned int iPixel = 0; iPixel < apixData->size(); iPixel++ ) 
-             {
-              IntVec apixColVec();
-              apixData->getSparsePixelAt( iPixel, &apixPixel);
-              try
-              {
-                 char ix[100];
-                 sprintf(ix, "%d,%d,%d", sensorID, apixPixel.getXCoord(), apixPixel.getYCoord() ); 
-                 _hotPixelMap[ix] = true;             
-              }
-              catch(...)
-              {
-                 streamlog_out ( ERROR5 ) << "problem adding pixel to hotpixel map! " << endl;
-              }
-             }
-
-           }  	
-           else if( type  ==  kEUTelSimpleSparsePixel )
-           {  
-              auto_ptr<EUTelSparseClusterImpl< EUTelSimpleSparsePixel > > m26Data( new EUTelSparseClusterImpl< EUTelSimpleSparsePixel >   ( hotPixelData ) );
-
-              std::vector<EUTelSimpleSparsePixel*> m26PixelVec;
-	      EUTelSimpleSparsePixel m26Pixel;
-  	      //Push all single Pixels of one plane in the m26PixelVec
-
-             for ( unsigned int iPixel = 0; iPixel < m26Data->size(); iPixel++ ) 
-             {
-              IntVec m26ColVec();
-              m26Data->getSparsePixelAt( iPixel, &m26Pixel);
-              streamlog_out ( DEBUG3 ) << iPixel << " of " << m26Data->size() << " HotPixelInfo:  " << m26Pixel.getXCoord() << " " << m26Pixel.getYCoord() << " " << m26Pixel.getSignal() << endl;
-              try
-              {
-                 char ix[100];
-                 sprintf(ix, "%d,%d,%d", sensorID, m26Pixel.getXCoord(), m26Pixel.getYCoord() ); 
-                 _hotPixelMap[ix] = true;             
-              }
-              catch(...)
-              {
-                 std::cout << "can not add pixel " << std::endl;
-                 std::cout << sensorID << " " << m26Pixel.getXCoord() << " " << m26Pixel.getYCoord() << " " << std::endl;   
-              }
-             }
-           }
-       }
-
-}
- 
 void EUTelMille::processEvent (LCEvent * event) {
 
-  if ( isFirstEvent() )
-  {
-    FillHotPixelMap(event);
-  }
-
   if ( _useReferenceHitCollection ){
     try {
     _referenceHitVec = dynamic_cast < LCCollectionVec * > (event->getCollection( _referenceHitCollectionName));
@@ -1181,6 +1139,18 @@ void EUTelMille::processEvent (LCEvent * event) {
     _telescopeResolY[help] = _telescopeResolution;
   }
 
+  if ( _readAlignmentCache )
+  {
+    // all the track candidates are in the cache: they are fitted with
+    // the first event, that brings the alignment constants, and the
+    // following events are left to the other processors
+    if ( ! _isAlignmentCacheRead ) {
+      readAlignmentCache(event);
+      _isAlignmentCacheRead = true;
+    }
+    return;
+  }
+
   EUTelEventImpl * evt = static_cast<EUTelEventImpl*> (event) ;
 
   if ( evt->getEventType() == kEORE ) {
@@ -1237,12 +1207,18 @@ void EUTelMille::processEvent (LCEvent * event) {
         // check if running in input mode 0 or 2
         if (_inputMode == 0) {
 
+          // the hot pixels are checked once per event for all the
+          // processors using the same collections
+          const EUTelHitStore & hitStore = EUTelHitStore::get( event, _hitCollectionName[i],
+                                                               _useReferenceHitCollection ? _referenceHitCollectionName : "" );
+          const vector< bool > & hotHits = hitStore.getHotFlags( _hotPixelCollectionName );
+
           // loop over all hits in collection
           for ( int iHit = 0; iHit < collection->getNumberOfElements(); iHit++ ) {
 
             TrackerHitImpl * hit = static_cast<TrackerHitImpl*> ( collection->getElementAt(iHit) );
              
-            if( hitContainsHotPixels(hit) )
+            if( hotHits[iHit] )
             {
               streamlog_out ( DEBUG3 ) << "Hit " << i << " contains hot pixels; skip this one. " << endl;
               continue;
@@ -1347,12 +1323,8 @@ void EUTelMille::processEvent (LCEvent * event) {
                 }
             }
  
-            double * hitPosition = const_cast<double * > (hit->getPosition());
-
-            unsigned int localSensorID   = guessSensorID( hitPosition );
-            localSensorID   = guessSensorID( hit );
+            unsigned int localSensorID = cluster->getDetectorID();
 
-              
             layerIndex = _sensorIDVecMap[localSensorID] ;
 
             // Getting positions of the hits.
@@ -1398,8 +1370,6 @@ void EUTelMille::processEvent (LCEvent * event) {
 
   int _nTracks = 0;
 
-  int _nGoodTracks = 0;
-
   // check if running in input mode 0 or 2 => perform simple track finding
   if (_inputMode == 0 || _inputMode == 2) {
 
@@ -1436,6 +1406,8 @@ void EUTelMille::processEvent (LCEvent * event) {
     _nTracks = static_cast< int >(indexarray.size());
     streamlog_out( DEBUG5 ) << "Track finder found " << _nTracks << std::endl;
 
+    if ( _alignmentCacheWriter.isOpen() && _nTracks > 0 ) writeAlignmentCache( _allHitsArray, indexarray );
+
     // end check if running in input mode 0 or 2 => perform simple track finding
   } else if (_inputMode == 1) {
     LCCollection* collection;
@@ -1698,6 +1670,188 @@ void EUTelMille::processEvent (LCEvent * event) {
 
   streamlog_out ( MILLEMESSAGE ) << "Number of track candidates found: " << _iEvt << ": " << _nTracks << endl;
 
+  fitTrackCandidates( _nTracks );
+
+  // count events
+  ++_iEvt;
+  if ( isFirstEvent() ) _isFirstEvent = false;
+
+}
+
+
+void EUTelMille::writeAlignmentCache(const std::vector<std::vector<EUTelMille::HitsInPlane> > & hitsArray,
+                                     const std::vector<IntVec > & indexarray) {
+
+  std::vector< EUTelAlignmentCache::Hit > hits;
+  IntVec firstHit( _nPlanes, 0 );
+  for ( size_t j = 0; j < _nPlanes; j++ ) {
+    firstHit[j] = static_cast< int >( hits.size() );
+    for ( size_t k = 0; k < hitsArray[j].size(); k++ ) {
+      EUTelAlignmentCache::Hit hit;
+      hit.x       = hitsArray[j][k].measuredX;
+      hit.y       = hitsArray[j][k].measuredY;
+      hit.z       = hitsArray[j][k].measuredZ;
+      hit.sigmaX  = _telescopeResolX[j];
+      hit.sigmaY  = _telescopeResolY[j];
+      hit.plane   = static_cast< int >( j );
+      hit.padding = 0;
+      hits.push_back( hit );
+    }
+  }
+
+  IntVec trackHits;
+  trackHits.reserve( indexarray.size() * _nPlanes );
+  for ( size_t i = 0; i < indexarray.size(); i++ ) {
+    for ( size_t j = 0; j < _nPlanes; j++ ) {
+      if ( hitsArray[j].size() > 0 && indexarray[i][j] >= 0 ) trackHits.push_back( firstHit[j] + indexarray[i][j] );
+      else trackHits.push_back( -1 );
+    }
+  }
+
+  _alignmentCacheWriter.writeEvent( hits, trackHits );
+}
+
+std::string EUTelMille::alignmentCacheParameters() const {
+
+  // every setting the cached hits and track candidates depend on
+  std::ostringstream parameters;
+  parameters.precision( 9 );
+
+  parameters << "HitCollectionName";
+  for ( size_t i = 0; i < _hitCollectionName.size(); i++ ) parameters << " " << _hitCollectionName[i];
+  parameters << "\nHotPixelCollectionName " << _hotPixelCollectionName;
+  parameters << "\nReferenceCollection " << ( _useReferenceHitCollection ? _referenceHitCollectionName : "" );
+  parameters << "\nExcludePlanes";
+  for ( size_t i = 0; i < _excludePlanes_sensorIDs.size(); i++ ) parameters << " " << _excludePlanes_sensorIDs[i];
+  parameters << "\nMaxTrackCandidates " << _maxTrackCandidates;
+  parameters << "\nAllowedMissingHits " << _allowedMissingHits;
+  parameters << "\nMimosaClusterChargeMin " << _mimosa26ClusterChargeMin;
+  parameters << "\nDistanceMax " << _distanceMax;
+  parameters << "\nDistanceMaxVec";
+  for ( size_t i = 0; i < _distanceMaxVec.size(); i++ ) parameters << " " << _distanceMaxVec[i];
+  parameters << "\nOnlySingleHitEvents " << _onlySingleHitEvents;
+  parameters << "\nOnlySingleTrackEvents " << _onlySingleTrackEvents;
+  parameters << "\nUseSensorRectangular";
+  for ( size_t i = 0; i < _useSensorRectangular.size(); i++ ) parameters << " " << _useSensorRectangular[i];
+
+  parameters << "\nUseResidualCuts " << _useResidualCuts;
+  if ( _useResidualCuts ) {
+    const FloatVec * cuts[4] = { &_residualsXMin, &_residualsXMax, &_residualsYMin, &_residualsYMax };
+    const char * names[4] = { "ResidualsXMin", "ResidualsXMax", "ResidualsYMin", "ResidualsYMax" };
+    for ( int iCut = 0; iCut < 4; iCut++ ) {
+      parameters << "\n" << names[iCut];
+      for ( size_t i = 0; i < cuts[iCut]->size(); i++ ) parameters << " " << (*cuts[iCut])[i];
+    }
+  }
+
+  return parameters.str();
+}
+
+void EUTelMille::readAlignmentCache(LCEvent * event) {
+
+  // the alignment constants of each plane, in the order they have to
+  // be applied
+  std::vector< std::vector< EUTelAlignmentConstant * > > planeConstants( _nPlanes );
+  for ( size_t iColl = 0; iColl < _alignmentCacheConstantsCollections.size(); iColl++ ) {
+    LCCollection * collection;
+    try {
+      collection = event->getCollection( _alignmentCacheConstantsCollections[iColl] );
+    } catch (DataNotAvailableException& e) {
+      streamlog_out ( ERROR2 ) << "Alignment constant collection " << _alignmentCacheConstantsCollections[iColl]
+                               << " not found, the cached hits cannot be corrected" << endl;
+      throw InvalidParameterException("AlignmentCacheConstantsCollections");
+    }
+    for ( int iElement = 0; iElement < collection->getNumberOfElements(); iElement++ ) {
+      EUTelAlignmentConstant * constant = static_cast< EUTelAlignmentConstant * > ( collection->getElementAt( iElement ) );
+      for ( size_t j = 0; j < _nPlanes; j++ ) {
+        if ( _alignmentCacheReader.getSensorIDs()[j] == constant->getSensorID() ) planeConstants[j].push_back( constant );
+      }
+    }
+  }
+
+  // the centre of each plane, around which the hits are rotated: the
+  // reference hit or, without reference hits, the GEAR layer position
+  std::vector< std::vector< double > > planeCentres( _nPlanes, std::vector< double >( 3, 0. ) );
+  for ( size_t j = 0; j < _nPlanes; j++ ) {
+    const int sensorID = _alignmentCacheReader.getSensorIDs()[j];
+    if ( _referenceHitVec != 0 ) {
+      for ( int ii = 0; ii < _referenceHitVec->getNumberOfElements(); ii++ ) {
+        EUTelReferenceHit * refhit = static_cast< EUTelReferenceHit * > ( _referenceHitVec->getElementAt(ii) );
+        if ( refhit->getSensorID() != sensorID ) continue;
+        planeCentres[j][0] = refhit->getXOffset();
+        planeCentres[j][1] = refhit->getYOffset();
+        planeCentres[j][2] = refhit->getZOffset();
+      }
+    } else {
+      for ( int iLayer = 0; iLayer < _siPlanesLayerLayout->getNLayers(); iLayer++ ) {
+        if ( _siPlanesLayerLayout->getID(iLayer) != sensorID ) continue;
+        planeCentres[j][0] = _siPlanesLayerLayout->getLayerPositionX(iLayer);
+        planeCentres[j][1] = _siPlanesLayerLayout->getLayerPositionY(iLayer);
+        planeCentres[j][2] = _siPlanesLayerLayout->getLayerPositionZ(iLayer);
+      }
+      if ( _siPlanesParameters->getSiPlanesType() == _siPlanesParameters->TelescopeWithDUT && _siPlanesLayerLayout->getDUTID() == sensorID ) {
+        planeCentres[j][0] = _siPlanesLayerLayout->getDUTPositionX();
+        planeCentres[j][1] = _siPlanesLayerLayout->getDUTPositionY();
+        planeCentres[j][2] = _siPlanesLayerLayout->getDUTPositionZ();
+      }
+    }
+    // the cached hits are in um
+    for ( int i = 0; i < 3; i++ ) planeCentres[j][i] *= 1000.;
+  }
+
+  const EUTelAlignmentCache::Hit * hits;
+  const int * trackHits;
+  int nHits, nTracks;
+  std::vector< TVector3 > positions;
+
+  while ( _nMilleTracks <= _maxTrackCandidatesTotal && _alignmentCacheReader.nextEvent( hits, nHits, trackHits, nTracks ) ) {
+
+    // apply the alignment constants, rotation first and around the
+    // plane centre as in EUTelApplyAlignmentProcessor
+    positions.resize( nHits );
+    for ( int iHit = 0; iHit < nHits; iHit++ ) {
+      double position[3] = { hits[iHit].x, hits[iHit].y, hits[iHit].z };
+      const std::vector< EUTelAlignmentConstant * > & constants = planeConstants[ hits[iHit].plane ];
+      for ( size_t iConst = 0; iConst < constants.size(); iConst++ ) {
+        const double offset[3] = { 1000. * constants[iConst]->getXOffset(),
+                                   1000. * constants[iConst]->getYOffset(),
+                                   1000. * constants[iConst]->getZOffset() };
+        EUTelAlignmentCache::applyAlignment( position, &planeCentres[ hits[iHit].plane ][0],
+                                             constants[iConst]->getAlpha(), constants[iConst]->getBeta(), constants[iConst]->getGamma(), offset );
+      }
+      positions[iHit].SetXYZ( position[0], position[1], position[2] );
+    }
+
+    if ( nTracks > _maxTrackCandidates ) nTracks = _maxTrackCandidates;
+    for ( int i = 0; i < nTracks; i++ ) {
+      for ( size_t j = 0; j < _nPlanes; j++ ) {
+        int index = trackHits[ i * _nPlanes + j ];
+        if ( index >= 0 ) {
+          _xPos[i][j] = positions[index].X();
+          _yPos[i][j] = positions[index].Y();
+          _zPos[i][j] = positions[index].Z();
+        } else {
+          _xPos[i][j] = 0.;
+          _yPos[i][j] = 0.;
+          _zPos[i][j] = 0.;
+        }
+      }
+    }
+
+    streamlog_out ( MILLEMESSAGE ) << "Number of track candidates read from the cache: " << _iEvt << ": " << nTracks << endl;
+
+    fitTrackCandidates( nTracks );
+    ++_iEvt;
+  }
+
+  streamlog_out ( MESSAGE5 ) << "Read " << _iEvt << " events from the alignment cache " << _alignmentCacheFile << endl;
+}
+
+
+void EUTelMille::fitTrackCandidates(int _nTracks) {
+
+  int _nGoodTracks = 0;
+
   // Perform fit for all found track candidates
   // ------------------------------------------
 
@@ -2582,115 +2736,6 @@ void EUTelMille::processEvent (LCEvent * event) {
 
 #endif
 
-  // count events
-  ++_iEvt;
-  if ( isFirstEvent() ) _isFirstEvent = false;
-
-}
-
-
-int EUTelMille::guessSensorID( TrackerHitImpl * hit ) {
-  if(hit==0)
-{
-    streamlog_out( ERROR5 ) << "An invalid hit pointer supplied! will exit now\n" << endl;
-    return -1;
-}
-
-        try
-        {
-            LCObjectVec clusterVector = hit->getRawHits();
-
-            EUTelVirtualCluster * cluster=0;
-
-            if ( hit->getType() == kEUTelBrickedClusterImpl ) {
-
-               // fixed cluster implementation. Remember it
-               //  can come from
-               //  both RAW and ZS data
-   
-                cluster = new EUTelBrickedClusterImpl(static_cast<TrackerDataImpl *> ( clusterVector[0] ) );
-                
-            } else if ( hit->getType() == kEUTelDFFClusterImpl ) {
-              
-              // fixed cluster implementation. Remember it can come from
-              // both RAW and ZS data
-              cluster = new EUTelDFFClusterImpl( static_cast<TrackerDataImpl *> ( clusterVector[0] ) );
-            } else if ( hit->getType() == kEUTelFFClusterImpl ) {
-              
-              // fixed cluster implementation. Remember it can come from
-              // both RAW and ZS data
-              cluster = new EUTelFFClusterImpl( static_cast<TrackerDataImpl *> ( clusterVector[0] ) );
-            } 
-            else if ( hit->getType() == kEUTelAPIXClusterImpl ) 
-            {
-              
-                TrackerDataImpl * clusterFrame = static_cast<TrackerDataImpl*> ( clusterVector[0] );
-
-                cluster = new eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelAPIXSparsePixel >(clusterFrame);
-	      
-            }
-            else if ( hit->getType() == kEUTelSparseClusterImpl ) 
-            {
-               cluster = new EUTelSparseClusterImpl< EUTelSimpleSparsePixel > ( static_cast<TrackerDataImpl *> ( clusterVector[0] ) );
-            }
-
-            if(cluster != 0)
-            {
-              int sensorID = cluster->getDetectorID();
-              return sensorID;
-            }
-          }
-          catch(...)
-          {
-	    streamlog_out( ERROR5 ) << "guessSensorID() produced an exception!" << endl;
-          }
-
-return -1;
-}
-
-int EUTelMille::guessSensorID( double * hit ) 
-{
-
-  int sensorID = -1;
-  double minDistance =  numeric_limits< double >::max() ;
-
-  if( _referenceHitVec == 0 || _useReferenceHitCollection == false)
-  {
-    // use z information of planes instead of reference vector
-    for ( int iPlane = 0 ; iPlane < _siPlanesLayerLayout->getNLayers(); ++iPlane ) {
-      double distance = std::abs( hit[2] - _siPlaneZPosition[ iPlane ] );
-      if ( distance < minDistance ) {
-	minDistance = distance;
-	sensorID = _siPlanesLayerLayout->getID( iPlane );
-      }
-    }
-    if ( minDistance > 30  ) {
-      // advice the user that the guessing wasn't successful 
-      streamlog_out( WARNING3 ) << "A hit was found " << minDistance << " mm far from the nearest plane\n"
-	"Please check the consistency of the data with the GEAR file: hitPosition[2]=" << hit[2] <<       endl;
-    }
-    
-    return sensorID;
-  }
-
-      for(size_t ii = 0 ; ii < static_cast< unsigned int >(_referenceHitVec->getNumberOfElements()); ii++)
-      {
-        EUTelReferenceHit* refhit = static_cast< EUTelReferenceHit*> ( _referenceHitVec->getElementAt(ii) ) ;
-        
-        TVector3 hit3d( hit[0], hit[1], hit[2] );
-        TVector3 hitInPlane( refhit->getXOffset(), refhit->getYOffset(), refhit->getZOffset());
-        TVector3 norm2Plane( refhit->getAlpha(), refhit->getBeta(), refhit->getGamma() );
- 
-        double distance = abs( norm2Plane.Dot(hit3d-hitInPlane) );
-        if ( distance < minDistance ) 
-        {
-           minDistance = distance;
-           sensorID = refhit->getSensorID();
-        }    
-
-      }
-
-  return sensorID;
 }
 
 
@@ -2722,119 +2767,6 @@ TVector3 EUTelMille::Line2Plane(int iplane, const TVector3& lpoint, const TVecto
 }
 
 
-      
-bool EUTelMille::hitContainsHotPixels( TrackerHitImpl   * hit) 
-{
-  bool skipHit = false;
-
-  try
-    {
-      try{
-	LCObjectVec clusterVector = hit->getRawHits();
-
-	if ( hit->getType() == kEUTelSparseClusterImpl ) 
-	  {
-      
-	    TrackerDataImpl * clusterFrame = dynamic_cast<TrackerDataImpl*> ( clusterVector[0] );
-	    if (clusterFrame == 0){
-	      // found invalid result from cast
-	      throw UnknownDataTypeException("Invalid hit found in method hitContainsHotPixels()");
-	    }
-		
-	    eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelSimpleSparsePixel > *cluster = new eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelSimpleSparsePixel >(clusterFrame);
-	    int sensorID = cluster->getDetectorID();
- 
-	    for ( unsigned int iPixel = 0; iPixel < cluster->size(); iPixel++ ) 
-              {
-                EUTelSimpleSparsePixel m26Pixel;
-                cluster->getSparsePixelAt( iPixel, &m26Pixel);
-                int pixelX, pixelY;
-                pixelX = m26Pixel.getXCoord();
-                pixelY = m26Pixel.getYCoord();
-
-		{                       
-		    char ix[100];
-		    sprintf(ix, "%d,%d,%d", sensorID, pixelX, pixelY ); 
-		    std::map<std::string, bool >::const_iterator z = _hotPixelMap.find(ix);
-		    if(z!=_hotPixelMap.end() && _hotPixelMap[ix] == true  )
-		      { 
-			skipHit = true;
-			streamlog_out(DEBUG3) << "Skipping hit as it was found in the hot pixel map." << endl;
-			return true; // if TRUE  this hit will be skipped
-		      }
-		    else
-		      { 
-			skipHit = false; 	      
-		      } 
-		} 
-	      }
-
-	  } else if ( hit->getType() == kEUTelBrickedClusterImpl ) {
-
-	  // fixed cluster implementation. Remember it
-	  //  can come from
-	  //  both RAW and ZS data
-                   
-	} else if ( hit->getType() == kEUTelDFFClusterImpl ) {
-              
-	  // fixed cluster implementation. Remember it can come from
-	  // both RAW and ZS data
-	} else if ( hit->getType() == kEUTelFFClusterImpl ) {
-              
-	  // fixed cluster implementation. Remember it can come from
-	  // both RAW and ZS data
-	} 
-	else if ( hit->getType() == kEUTelAPIXClusterImpl ) 
-	  {
-	    TrackerDataImpl * clusterFrame = static_cast<TrackerDataImpl*> ( clusterVector[0] );
-	      
-	    eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelAPIXSparsePixel > *apixCluster = new eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelAPIXSparsePixel >(clusterFrame);
-                
-	    int sensorID = apixCluster->getDetectorID();
-
-	    for (unsigned int iPixel = 0; iPixel < apixCluster->size(); ++iPixel) 
-	      {
-		EUTelAPIXSparsePixel apixPixel;
-		apixCluster->getSparsePixelAt(iPixel, &apixPixel);
-
-		  {                       
-		    char ix[100];
-		    sprintf(ix, "%d,%d,%d", sensorID, apixPixel.getXCoord(), apixPixel.getYCoord() ); 
-		    std::map<std::string, bool >::const_iterator z = _hotPixelMap.find(ix);
-		    if(z!=_hotPixelMap.end() && _hotPixelMap[ix] == true  )
-		      { 
-			skipHit = true; 	      
-			streamlog_out(DEBUG3) << "Skipping hit as it was found in the hot pixel map." << endl;
-			return true; // if TRUE  this hit will be skipped
-		      }
-		    else
-		      { 
-			skipHit = false; 	      
-		      } 
-		  }
-	      }
-
-	    return skipHit; // if TRUE  this hit will be skipped
-	  } 
-            
-      }
-      catch(lcio::Exception e){
-	// catch specific exceptions
-          streamlog_out ( ERROR5 ) << "Exception occured in hitContainsHotPixels(): " << e.what() << endl;
-      }
-    }
-  catch(...)
-    { 
-      // if anything went wrong in the above return FALSE, meaning do not skip this hit
-      return 0;
-    }
-
-  // if none of the above worked return FALSE, meaning do not skip this hit
-  return 0;
-
-}
-
-
 void EUTelMille::end() {
 
   delete [] _telescopeResolY;
@@ -2854,6 +2786,16 @@ void EUTelMille::end() {
   // close the output file
   delete _mille;
 
+  if ( _alignmentCacheWriter.isOpen() ) {
+    const size_t nCacheEvents = _alignmentCacheWriter.getNEvents();
+    if ( _alignmentCacheWriter.close() ) {
+      streamlog_out ( MESSAGE5 ) << "Wrote " << nCacheEvents << " events to the alignment cache " << _alignmentCacheFile << endl;
+    } else {
+      streamlog_out ( ERROR2 ) << "Cannot write the alignment cache " << _alignmentCacheFile << ", it will be built again by the next job" << endl;
+    }
+  }
+  _alignmentCacheReader.close();
+
   // if write the pede steering file
   if (_generatePedeSteerfile) {
 
@@ -178,27 +178,21 @@ void EUTelMimosa26Generator::processEvent (LCEvent * event) {
 
 	EUTelSparseDataImpl<EUTelSimpleSparsePixel>  sparseData( sparsified ) ;
     
-        auto_ptr<EUTelSparseDataImpl<EUTelSimpleSparsePixel > >
-          sparseinputData(new EUTelSparseDataImpl<EUTelSimpleSparsePixel> ( zsData ));
-        auto_ptr<EUTelSimpleSparsePixel > sparseinputPixel( new EUTelSimpleSparsePixel );
+        EUTelSparseDataImpl<EUTelSimpleSparsePixel> sparseinputData( zsData );
+        sparseData.reserve( sparseinputData.size() );
         
-        for ( unsigned int iPixel = 0; iPixel < sparseinputData->size(); iPixel++ ) {
-        sparseinputData->getSparsePixelAt( iPixel, sparseinputPixel.get() );
-        const int index  = matrixDecoder.getIndexFromXY( sparseinputPixel->getXCoord(), sparseinputPixel->getYCoord() );
-        const float signal = sparseinputPixel->getSignal();
+        for ( unsigned int iPixel = 0; iPixel < sparseinputData.size(); iPixel++ ) {
+        const short xCoord = sparseinputData.getXCoordAt( iPixel );
+        const short yCoord = sparseinputData.getYCoordAt( iPixel );
+        const int index  = matrixDecoder.getIndexFromXY( xCoord, yCoord );
+        const float signal = sparseinputData.getSignalAt( iPixel );
         const float n = noise->getChargeValues()[ index ];
         const float threshold = sigmaCut * n;
         if ( 
             ( status->getADCValues()[ index ] == EUTELESCOPE::GOODPIXEL ) &&
             signal > threshold
             ) {
-          auto_ptr<EUTelSimpleSparsePixel> sparsePixel( new EUTelSimpleSparsePixel );
-          sparsePixel->setXCoord( sparseinputPixel->getXCoord() );
-          sparsePixel->setYCoord( sparseinputPixel->getYCoord() );
-          sparsePixel->setSignal(1);
-         
-          sparseData.addSparsePixel( sparsePixel.get() );
-         
+          sparseData.addSparsePixel( xCoord, yCoord, 1 );
         }
 
       }
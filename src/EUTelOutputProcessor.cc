@@ -17,20 +17,68 @@
 
 // marlin includes ".h"
 #include "marlin/LCIOOutputProcessor.h"
+#include "marlin/Global.h"
 
 // lcio includes <.h>
 #include <UTIL/LCTOOLS.h>
 #include <UTIL/LCTime.h>
+#include <IMPL/LCEventImpl.h>
+#include <IMPL/LCRunHeaderImpl.h>
+#include <IMPL/LCCollectionVec.h>
+#include <EVENT/LCParameters.h>
+#include <Exceptions.h>
 
 // system includes <>
 #include <memory>
+#include <string>
+#include <vector>
 
 using namespace std;
 using namespace marlin;
 using namespace eutelescope;
 
+namespace {
+
+  //! Copy all the int, float and string parameters
+  void copyParameters( const EVENT::LCParameters & from, EVENT::LCParameters & to ) {
+
+    EVENT::StringVec keys;
+
+    from.getIntKeys( keys );
+    for ( size_t iKey = 0; iKey < keys.size(); ++iKey ) {
+      EVENT::IntVec values;
+      to.setValues( keys[ iKey ], from.getIntVals( keys[ iKey ], values ) );
+    }
+
+    keys.clear();
+    from.getFloatKeys( keys );
+    for ( size_t iKey = 0; iKey < keys.size(); ++iKey ) {
+      EVENT::FloatVec values;
+      to.setValues( keys[ iKey ], from.getFloatVals( keys[ iKey ], values ) );
+    }
+
+    keys.clear();
+    from.getStringKeys( keys );
+    for ( size_t iKey = 0; iKey < keys.size(); ++iKey ) {
+      EVENT::StringVec values;
+      to.setValues( keys[ iKey ], from.getStringVals( keys[ iKey ], values ) );
+    }
+
+  }
+
+}
  
-EUTelOutputProcessor::EUTelOutputProcessor() : LCIOOutputProcessor("EUTelOutputProcessor")  {
+EUTelOutputProcessor::EUTelOutputProcessor() : LCIOOutputProcessor("EUTelOutputProcessor"),
+  _eventType(kUNKNOWN),
+  _skipIntermediateEORESwitch(true),
+  _writerQueueSize(0),
+  _writeRequests(NULL),
+  _writerThread(),
+  _isWriterThreadRunning(false),
+  _sioMutex(),
+  _isHoldingSIO(false),
+  _isReadingLCIO(false),
+  _writerError("")  {
     
   _description = "Writes the current event to the specified LCIO outputfile."
     " Eventually it adds a EORE at the of the file if it was missing"
@@ -82,6 +130,10 @@ EUTelOutputProcessor::EUTelOutputProcessor() : LCIOOutputProcessor("EUTelOutputP
 			     "Set it to true to remove intermediate EORE in merged runs",
 			     _skipIntermediateEORESwitch, static_cast< bool > ( true ) );
 
+  registerOptionalParameter("WriterQueueSize",
+			    "Number of events waiting to be written by a separate writer thread while the processors go on. 0 writes in sequence on the Marlin thread.",
+			    _writerQueueSize, static_cast< int > ( 0 ) );
+
 
 }
 
@@ -91,6 +143,15 @@ void EUTelOutputProcessor::init() {
   // LCIOOutputProcessor
   LCIOOutputProcessor::init();
 
+  // Marlin reads the events with LCIO only when input files are
+  // given, otherwise they come from a DataSourceProcessor and
+  // modifyEvent is never called
+  StringVec inputFiles;
+  Global::parameters->getStringVals( "LCIOInputFiles", inputFiles );
+  _isReadingLCIO = !inputFiles.empty();
+
+  if ( _writerQueueSize > 0 && canWriteBehind() ) startWriterThread();
+
 }
 
 
@@ -100,12 +161,31 @@ void EUTelOutputProcessor::processRunHeader( LCRunHeader* run) {
   auto_ptr<EUTelRunHeaderImpl> runHeader ( new EUTelRunHeaderImpl( run ) ) ;
   runHeader->addProcessor( type() );
 
+  if ( _isWriterThreadRunning ) {
+    WriteRequest request = { NULL, copyRunHeader( run ) };
+    queueRequest( request );
+    _nRun++ ;
+    return;
+  }
+
   LCIOOutputProcessor::processRunHeader(run);
 
 } 
 
+void EUTelOutputProcessor::modifyEvent( LCEvent * /* evt */ ) {
+
+  // the event has been read: the writer can use SIO until the end of
+  // processEvent
+  releaseSIO();
+
+}
+
 void EUTelOutputProcessor::processEvent( LCEvent * evt ) { 
 
+  // the next thing Marlin does is reading the following event, if it
+  // reads from LCIO input files
+  if ( _isWriterThreadRunning ) holdSIO();
+
   EUTelEventImpl * eutelEvt =  static_cast<EUTelEventImpl * > ( evt );
 
   if ( _skipIntermediateEORESwitch && ( eutelEvt->getEventType() == kEORE ) ) {
@@ -118,13 +198,25 @@ void EUTelOutputProcessor::processEvent( LCEvent * evt ) {
     return ;
   }
 
-  LCIOOutputProcessor::processEvent(evt);
   _eventType = eutelEvt->getEventType();
 
+  if ( _isWriterThreadRunning ) {
+    dropCollections( evt );
+    WriteRequest request = { detachEvent( evt ), NULL };
+    queueRequest( request );
+    _nEvt++ ;
+    return;
+  }
+
+  LCIOOutputProcessor::processEvent(evt);
+
 }
 
 void EUTelOutputProcessor::end(){ 
 
+  // all the queued events have to be on disk before the EORE
+  stopWriterThread();
+
   if ( _eventType != kEORE ) {
 
     message<WARNING> ( "Adding a EORE because was missing" );
@@ -149,3 +241,187 @@ void EUTelOutputProcessor::end(){
 }
 
 
+
+LCEventImpl * EUTelOutputProcessor::detachEvent( LCEvent * evt ) const {
+
+  LCEventImpl * event = new LCEventImpl;
+  event->setRunNumber( evt->getRunNumber() );
+  event->setEventNumber( evt->getEventNumber() );
+  event->setDetectorName( evt->getDetectorName() );
+  event->setTimeStamp( evt->getTimeStamp() );
+  event->setWeight( evt->getWeight() );
+  copyParameters( evt->getParameters(), event->parameters() );
+
+  // only the kept collections are moved. The dropped ones have been
+  // flagged transient by dropCollections and stay with evt, that
+  // deletes them: references to them are written as pointers only.
+  // The list is copied because removeCollection changes it
+  const StringVec names( *evt->getCollectionNames() );
+  for ( size_t iCol = 0; iCol < names.size(); ++iCol ) {
+    LCCollection * collection = evt->getCollection( names[ iCol ] );
+    if ( collection->isTransient() ) continue;
+
+    // removeCollection, unlike takeCollection, does not flag the
+    // collection transient, and the writer skips transient ones
+    evt->removeCollection( names[ iCol ] );
+    LCCollectionVec * collectionVec = dynamic_cast< LCCollectionVec * >( collection );
+    if ( collectionVec ) collectionVec->setTransient( false );
+    event->addCollection( collection, names[ iCol ] );
+  }
+
+  return event;
+
+}
+
+LCRunHeaderImpl * EUTelOutputProcessor::copyRunHeader( LCRunHeader * run ) const {
+
+  LCRunHeaderImpl * runHeader = new LCRunHeaderImpl;
+  runHeader->setRunNumber( run->getRunNumber() );
+  runHeader->setDetectorName( run->getDetectorName() );
+  runHeader->setDescription( run->getDescription() );
+
+  const StringVec * subDetectors = run->getActiveSubdetectors();
+  for ( size_t iDet = 0; iDet < subDetectors->size(); ++iDet ) {
+    runHeader->addActiveSubdetector( (*subDetectors)[ iDet ] );
+  }
+  copyParameters( run->getParameters(), runHeader->parameters() );
+
+  return runHeader;
+
+}
+
+void EUTelOutputProcessor::queueRequest( const WriteRequest& request ) {
+
+  if ( _writeRequests->tryPush( request ) ) return;
+
+  // the queue is full: the writer needs SIO to make room, and nothing
+  // is read while waiting here
+  releaseSIO();
+  bool isQueued = _writeRequests->push( request );
+  holdSIO();
+  if ( isQueued ) return;
+
+  // the writer thread gave up
+  delete request.event;
+  delete request.runHeader;
+  throw lcio::IOException( "Writer thread of " + _lcioOutputFile + " failed: " + _writerError );
+
+}
+
+void EUTelOutputProcessor::startWriterThread() {
+
+  _writeRequests = new EUTelBoundedQueue< WriteRequest >( static_cast< size_t >( _writerQueueSize ) );
+
+  if ( pthread_create( &_writerThread, NULL, &EUTelOutputProcessor::writerThreadEntry, this ) != 0 ) {
+    message<WARNING5> ( "Unable to start the writer thread, writing in sequence" );
+    delete _writeRequests;
+    _writeRequests = NULL;
+    return;
+  }
+
+  _isWriterThreadRunning = true;
+  message<DEBUG5> ( log() << "Writer thread started with " << _writerQueueSize << " events queue" );
+
+  // the first run header is going to be read
+  holdSIO();
+
+}
+
+bool EUTelOutputProcessor::canWriteBehind() {
+
+  // the collections are taken away from the event: nobody must come
+  // after this processor
+  StringVec activeProcessors;
+  Global::parameters->getStringVals( "ActiveProcessors", activeProcessors );
+  if ( activeProcessors.empty() || activeProcessors.back() != name() ) {
+    message<WARNING5> ( log() << name() << " is not the last active processor, writing in sequence" );
+    return false;
+  }
+
+  // file splitting and full subsets are done by LCIOOutputProcessor
+  // while writing
+  if ( parameterSet( "SplitFileSizekB" ) ) {
+    message<WARNING5> ( "The writer thread does not support SplitFileSizekB, writing in sequence" );
+    return false;
+  }
+  if ( parameterSet( "FullSubsetCollections" ) ) {
+    message<WARNING5> ( "The writer thread does not support FullSubsetCollections, writing in sequence" );
+    return false;
+  }
+
+  return true;
+
+}
+
+void EUTelOutputProcessor::holdSIO() {
+
+  // nothing to protect if the Marlin thread never reads with SIO
+  if ( _isHoldingSIO || !_isReadingLCIO ) return;
+  _sioMutex.lock();
+  _isHoldingSIO = true;
+
+}
+
+void EUTelOutputProcessor::releaseSIO() {
+
+  if ( !_isHoldingSIO ) return;
+  _isHoldingSIO = false;
+  _sioMutex.unlock();
+
+}
+
+void EUTelOutputProcessor::stopWriterThread() {
+
+  if ( !_isWriterThreadRunning ) return;
+
+  // nothing is read any more
+  releaseSIO();
+  _writeRequests->close();
+  pthread_join( _writerThread, NULL );
+  _isWriterThreadRunning = false;
+
+  // requests left behind by a failed writer
+  WriteRequest request;
+  while ( _writeRequests->tryPop( request ) ) {
+    delete request.event;
+    delete request.runHeader;
+  }
+  delete _writeRequests;
+  _writeRequests = NULL;
+
+  if ( !_writerError.empty() ) {
+    message<ERROR5> ( log() << "The writer thread failed: " << _writerError );
+  }
+
+}
+
+void EUTelOutputProcessor::writeBehind() {
+
+  WriteRequest request;
+  while ( _writeRequests->pop( request ) ) {
+    try {
+      EUTelMutexLock lock( _sioMutex );
+      if ( request.runHeader != NULL ) _lcWrt->writeRunHeader( request.runHeader );
+      else                             _lcWrt->writeEvent( request.event );
+    } catch ( lcio::Exception& e ) {
+      _writerError = e.what();
+    } catch ( std::exception& e ) {
+      _writerError = e.what();
+    }
+    delete request.event;
+    delete request.runHeader;
+
+    if ( !_writerError.empty() ) {
+      _writeRequests->close();
+      return;
+    }
+  }
+
+}
+
+void * EUTelOutputProcessor::writerThreadEntry( void * self ) {
+
+  static_cast< EUTelOutputProcessor * >( self )->writeBehind();
+  return NULL;
+
+}
@@ -72,7 +72,7 @@ std::string EUTelPedestalNoiseProcessor::_fireFreqHistoName   = "FiringFrequency
 std::string EUTelPedestalNoiseProcessor::_aPixelHistoName     = "APixelHisto";
 #endif
 
-EUTelPedestalNoiseProcessor::EUTelPedestalNoiseProcessor () :Processor("EUTelPedestalNoiseProcessor") {
+EUTelPedestalNoiseProcessor::EUTelPedestalNoiseProcessor () :Processor("EUTelPedestalNoiseProcessor"), _workerPool(NULL) {
 
   // modify processor description
   _description =
@@ -160,6 +160,9 @@ EUTelPedestalNoiseProcessor::EUTelPedestalNoiseProcessor () :Processor("EUTelPed
   registerOptionalParameter ("HitRejectionPreLoop",
                              "Perform a fast first loop to improve the efficiency of hit rejection",
                              _preLoopSwitch, static_cast< bool > ( true ) ) ;
+  registerOptionalParameter ("NumberOfThreads",
+                             "Number of threads for the per pixel statistics with MeanRMS (1 = no additional thread)",
+                             _noOfThreads, static_cast< int > ( 1 ) );
 
 
   registerProcessorParameter ("FirstEvent",
@@ -214,9 +217,14 @@ void EUTelPedestalNoiseProcessor::init () {
 
   if ( _pedestalAlgo == EUTELESCOPE::MEANRMS ) {
     // reset the temporary arrays
-    _tempPede.clear ();
-    _tempNoise.clear ();
-    _tempEntries.clear ();
+    _pixelStatistics.clear();
+  }
+
+  // start the workers for the pixel statistics
+  delete _workerPool;
+  _workerPool = new EUTelWorkerPool( _noOfThreads > 1 ? _noOfThreads : 1 );
+  if ( _workerPool->getNThreads() > 1 ) {
+    streamlog_out ( MESSAGE4 ) << "Pixel statistics computed with " << _workerPool->getNThreads() << " threads" << endl;
   }
 
 #ifndef MARLIN_USE_AIDA
@@ -448,6 +456,8 @@ void EUTelPedestalNoiseProcessor::check (LCEvent * /* evt */ ) {
 
 void EUTelPedestalNoiseProcessor::end() {
 
+  delete _workerPool;
+  _workerPool = NULL;
 
   int additionalLoop = 0;
   if ( _additionalMaskingLoop ) additionalLoop = 1;
@@ -869,36 +879,22 @@ void EUTelPedestalNoiseProcessor::firstLoop(LCEvent * event) {
 
         for ( size_t iDetector = 0 ; iDetector < collectionVec->size() ; ++iDetector ) {
 
-          // _tempPedestal, _tempNoise, _tempEntries are vector of vector.
-          // they have been already cleared in the init() method we are
-          // already looping on detectors, so we just need to push back a
-          // vector empty for each cycle
-          //
-          // _tempPedestal should be initialized with the adcValues, while
-          // _tempNoise and _tempEntries must be initialized to zero. Since
-          // adcValues is a vector of shorts, we need to copy each
-          // elements into _tempPedestal with a suitable re-casting
+          // _pixelStatistics has been already cleared in the init()
+          // method. We are already looping on detectors, so we just
+          // need to push back one entry for each cycle, starting with
+          // the adcValues of this event as the first entry and a null
+          // spread.
 
           // get the TrackerRawData object from the collection for this detector
 
           TrackerRawData *trackerRawData = dynamic_cast < TrackerRawData * >(collectionVec->getElementAt (iDetector));
-          ShortVec adcValues = trackerRawData->getADCValues ();
+          const ShortVec & adcValues = trackerRawData->getADCValues ();
 
           if ( _pedestalAlgo == EUTELESCOPE::MEANRMS ) {
-            // in the case of MEANRMS we have to deal with the standard
-            // vectors
-            ShortVec::iterator iter = adcValues.begin();
-            FloatVec tempDoubleVec;
-            while ( iter != adcValues.end() ) {
-              tempDoubleVec.push_back( static_cast< double > (*iter));
-              ++iter;
-            }
-            _tempPede.push_back(tempDoubleVec);
-
-            // initialize _tempNoise and _tempEntries with all zeros and
-            // ones
-            _tempNoise.push_back(FloatVec(adcValues.size(), 0.));
-            _tempEntries.push_back(IntVec(adcValues.size(), 1));
+            // in the case of MEANRMS we have to deal with the running
+            // sums
+            _pixelStatistics.push_back( PixelStatistics() );
+            resetPixelStatistics( _pixelStatistics.back(), FloatVec( adcValues.begin(), adcValues.end() ), FloatVec() );
 
 
           } else if ( _pedestalAlgo == EUTELESCOPE::AIDAPROFILE ) {
@@ -949,6 +945,7 @@ void EUTelPedestalNoiseProcessor::firstLoop(LCEvent * event) {
   } else {
 
     // this is when it is not the first event
+    _detectorJobs.clear();
     for ( size_t iCol = 0 ; iCol < _rawDataCollectionNameVec.size() ; ++iCol ) {
 
       try {
@@ -961,38 +958,22 @@ void EUTelPedestalNoiseProcessor::firstLoop(LCEvent * event) {
 
           // get the TrackerRawData object from the collection for this plane
           TrackerRawData *trackerRawData = dynamic_cast < TrackerRawData * >(collectionVec->getElementAt (iDetector));
-          ShortVec adcValues = trackerRawData->getADCValues ();
+          const ShortVec & adcValues = trackerRawData->getADCValues ();
 
           size_t detectorOffset = ( iCol == 0 ) ? 0 : _noOfDetectorVec.at( iCol - 1 );
 
           if ( _pedestalAlgo == EUTELESCOPE::MEANRMS ) {
 
-            // start looping on all pixels
-            int iPixel = 0;
-            for (int yPixel = _minY[ iDetector + detectorOffset ]; yPixel <= _maxY[ iDetector + detectorOffset ]; yPixel++) {
-              for (int xPixel = _minX[ iDetector + detectorOffset ]; xPixel <= _maxX[ iDetector + detectorOffset ]; xPixel++) {
-                short currentVal = adcValues[iPixel];
-                bool use = true;
-                if ( _preLoopSwitch && ( ( _iEvt == _maxValuePos[ iDetector + detectorOffset ] [ iPixel ] ) ||
-                                         ( _iEvt == _minValuePos[ iDetector + detectorOffset ] [ iPixel ] ) )  ) {
-                  use = false;
-                }
-
-                if ( use ) {
-
-                  _tempEntries[iDetector + detectorOffset][iPixel]    =   _tempEntries[iDetector + detectorOffset][iPixel] + 1;
-                  _tempPede   [iDetector + detectorOffset][iPixel]    = ((_tempEntries[iDetector + detectorOffset][iPixel] - 1)
-                                                                         * _tempPede[iDetector + detectorOffset][iPixel]
-                                                                         +  currentVal) / _tempEntries[iDetector+detectorOffset][iPixel];
-                  _tempNoise  [iDetector + detectorOffset][iPixel]   = sqrt(((_tempEntries[iDetector+detectorOffset][iPixel] - 1)
-                                                                             * pow(_tempNoise[iDetector+detectorOffset][iPixel],2)
-                                                                             + pow( currentVal - _tempPede[iDetector+detectorOffset][iPixel], 2)) /
-                                                                            _tempEntries[iDetector+detectorOffset][iPixel]);
-                }
-
-                ++iPixel;
-              } // end loop on xPixel
-            }   // end loop on yPixel
+            // the pixels of all detectors are processed together
+            // after the loop on collections
+            DetectorJob job;
+            job.iDetector    = iDetector + detectorOffset;
+            job.adcValues    = adcValues.empty() ? NULL : &adcValues[0];
+            job.noOfPixels   = adcValues.size();
+            job.isEventValid = true;
+            job.skippedPixel = 0;
+            job.skippedRow   = 0;
+            _detectorJobs.push_back( job );
 
 
           } else if ( _pedestalAlgo == EUTELESCOPE::AIDAPROFILE ) {
@@ -1030,6 +1011,9 @@ void EUTelPedestalNoiseProcessor::firstLoop(LCEvent * event) {
       }
 
     }
+
+    if ( _pedestalAlgo == EUTELESCOPE::MEANRMS ) accumulateDetectorJobs( false );
+
     // increment the event number
     ++_iEvt;
   } // end elif firstEvent
@@ -1059,6 +1043,7 @@ void EUTelPedestalNoiseProcessor::otherLoop(LCEvent * event) {
   }
 
 
+  _detectorJobs.clear();
   for ( size_t iCol = 0 ; iCol < _rawDataCollectionNameVec.size() ; ++iCol ) {
 
     // let me get the rawDataCollection. This is should contain a TrackerRawDataObject
@@ -1066,204 +1051,302 @@ void EUTelPedestalNoiseProcessor::otherLoop(LCEvent * event) {
     try {
       LCCollectionVec *collectionVec = dynamic_cast < LCCollectionVec * >(evt->getCollection (_rawDataCollectionNameVec.at( iCol )));
 
+      size_t detectorOffset = ( iCol == 0 ) ? 0 : _noOfDetectorVec.at( iCol - 1 );
+
       for ( size_t iDetector = 0; iDetector < collectionVec->size(); iDetector++) {
 
         // get the TrackerRawData object from the collection for this detector
         TrackerRawData *trackerRawData = dynamic_cast < TrackerRawData * >(collectionVec->getElementAt (iDetector));
-        ShortVec adcValues = trackerRawData->getADCValues ();
+        const ShortVec & adcValues = trackerRawData->getADCValues ();
+
+        DetectorJob job;
+        job.iDetector    = iDetector + detectorOffset;
+        job.adcValues    = adcValues.empty() ? NULL : &adcValues[0];
+        job.noOfPixels   = adcValues.size();
+        job.isEventValid = true;
+        job.skippedPixel = 0;
+        job.skippedRow   = 0;
+        _detectorJobs.push_back( job );
+      }
+    } catch (DataNotAvailableException& e) {
+      streamlog_out ( WARNING2 ) << "No input collection " << _rawDataCollectionNameVec.at( iCol ) << " is not available in the current event" << endl;
+    }
+  }
 
-        // new approach for a better common mode calculation. The idea
-        // is that instead of using, as before, a single value of
-        // common mode per matrix, we will have a vector of floats
-        // containing the common mode correction for each pixel
-        vector< float > commonModeCorVec;
-        commonModeCorVec.clear();
+  // new approach for a better common mode calculation. The idea
+  // is that instead of using, as before, a single value of
+  // common mode per matrix, we will have a vector of floats
+  // containing the common mode correction for each pixel. All the
+  // detectors are done in parallel.
+  CommonModeTask commonModeTask( this );
+  _workerPool->run( commonModeTask, _detectorJobs.size() );
 
-        bool isEventValid = true;
-        int    skippedPixel = 0;
-        int    skippedRow   = 0;
+  if ( ( _commonModeAlgo != EUTELESCOPE::FULLFRAME ) && ( _commonModeAlgo != EUTELESCOPE::ROWWISE ) ) {
+    streamlog_out ( ERROR4 ) << "Unknown common mode algorithm. Using flat null correction" << endl;
+  }
 
-        size_t detectorOffset = ( iCol == 0 ) ? 0 : _noOfDetectorVec.at( iCol - 1 );
+  for ( size_t iJob = 0; iJob < _detectorJobs.size(); ++iJob ) {
 
-        if ( _commonModeAlgo == EUTELESCOPE::FULLFRAME ) {
-
-          double pixelSum     = 0.;
-          double commonMode   = 0.;
-          int    goodPixel    = 0;
-          int    iPixel       = 0;
-
-          // start looping on all pixels for hit rejection
-          for (int yPixel = _minY[iDetector + detectorOffset ]; yPixel <= _maxY[iDetector + detectorOffset ]; yPixel++) {
-            for (int xPixel = _minX[iDetector + detectorOffset ]; xPixel <= _maxX[iDetector + detectorOffset ]; xPixel++) {
-              bool isHit  = ( ( adcValues[iPixel] - _pedestal[iDetector + detectorOffset][iPixel] ) > _hitRejectionCut * _noise[iDetector + detectorOffset][iPixel] );
-              bool isGood = ( _status[iDetector + detectorOffset ][iPixel] == EUTELESCOPE::GOODPIXEL );
-              if ( !isHit && isGood ) {
-                pixelSum += adcValues[iPixel] - _pedestal[iDetector + detectorOffset ][iPixel];
-                ++goodPixel;
-              } else if ( isHit ) {
-                ++skippedPixel;
-              }
-              ++iPixel;
-            }
-          }
+    DetectorJob & job = _detectorJobs[ iJob ];
 
-          if ( ( skippedPixel < _maxNoOfRejectedPixels ) &&
-               ( goodPixel != 0 ) ) {
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+    if ( ! job.commonModeValues.empty() ) {
+      string histoname = _commonModeHistoName + "_d" + to_string( _orderedSensorIDVec.at( job.iDetector ) )
+        + "_l" + to_string( _iLoop );
+      AIDA::IHistogram1D * histo = (dynamic_cast<AIDA::IHistogram1D*>(_aidaHistoMap[ histoname ]));
+      if ( histo ) {
+        for ( size_t iValue = 0; iValue < job.commonModeValues.size(); ++iValue ) {
+          histo->fill( job.commonModeValues[ iValue ] );
+        }
+      }
+    }
+#endif
 
-            commonMode = pixelSum / goodPixel;
-            commonModeCorVec.insert( commonModeCorVec.begin(), iPixel + 1 , commonMode );
-            isEventValid = true;
+    if ( job.isEventValid ) {
 
+      if ( _pedestalAlgo == EUTELESCOPE::AIDAPROFILE) {
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-              string histoname = _commonModeHistoName + "_d" + to_string( _orderedSensorIDVec.at( iDetector + detectorOffset ) )
-                + "_l" + to_string( _iLoop );
-              AIDA::IHistogram1D * histo = (dynamic_cast<AIDA::IHistogram1D*>(_aidaHistoMap[ histoname ]));
-              if ( histo ) {
-                histo->fill(commonMode);
+        const size_t iDetector = job.iDetector;
+        stringstream ss;
+        ss << _tempProfile2DName << "_d" << _orderedSensorIDVec.at( iDetector );
+        AIDA::IProfile2D * profile = dynamic_cast<AIDA::IProfile2D*> (_aidaHistoMap[ss.str()]);
+        int iPixel = 0;
+        for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector]; yPixel++) {
+          for (int xPixel = _minX[iDetector]; xPixel <= _maxX[iDetector]; xPixel++) {
+            if ( _status[iDetector][iPixel] == EUTELESCOPE::GOODPIXEL ) {
+              double pedeCorrected = job.adcValues[iPixel] - job.commonModeCorVec[iPixel];
+              if ( std::abs( pedeCorrected - _pedestal[iDetector][iPixel] ) < _hitRejectionCut * _noise[iDetector][iPixel] ) {
+                bool use = true;
+                if ( _preLoopSwitch && ( ( _iEvt == _maxValuePos[ iDetector ] [ iPixel ] ) ||
+                                         ( _iEvt == _minValuePos[ iDetector ] [ iPixel ] ) )  ) {
+                  use = false;
+                }
+                if ( use ) {
+                  profile->fill(static_cast<double> (xPixel), static_cast<double> (yPixel), pedeCorrected);
+                }
               }
+            }
+            ++iPixel;
+          }
+        }
 #endif
+      }
 
-          } else {
+    } else {
+      if ( _commonModeAlgo == EUTELESCOPE::FULLFRAME ) {
+        streamlog_out ( WARNING2 ) <<  "Skipping event " << _iEvt << " because of max number of rejected pixels exceeded. ("
+                                   << job.skippedPixel << ") on detector " << _orderedSensorIDVec.at( job.iDetector ) << endl;
+      } else if ( _commonModeAlgo == EUTELESCOPE::ROWWISE ) {
+        streamlog_out ( WARNING2 ) <<  "Skipping event " << _iEvt << " because of max number of skipped rows is reached. ("
+                                   << job.skippedRow << ") on detector " << _orderedSensorIDVec.at( job.iDetector ) << endl;
+      }
 
-            isEventValid = false;
+      // the event has been skipped, so add this event number to the
+      // skipped list
+      _skippedEventList.push_back( _iEvt );
+    }
+  }
 
-          }
+  // the MEANRMS statistics of the valid detectors, again in parallel
+  if ( _pedestalAlgo == EUTELESCOPE::MEANRMS ) accumulateDetectorJobs( true );
 
-        } else if ( _commonModeAlgo == EUTELESCOPE::ROWWISE ) {
+  ++_iEvt;
 
-          int    iPixel       = 0;
-          int    colCounter   = 0;
-          int    rowLength    = _maxX[iDetector + detectorOffset] -  _minX[iDetector + detectorOffset] + 1;
+}
 
-          for (int yPixel = _minY[iDetector + detectorOffset]; yPixel <= _maxY[iDetector + detectorOffset]; yPixel++) {
+void EUTelPedestalNoiseProcessor::computeCommonMode( size_t iJob ) {
 
-            double pixelSum           = 0.;
-            double commonMode         = 0.;
-            int    goodPixel          = 0;
-            int    skippedPixelPerRow = 0;
+  DetectorJob & job = _detectorJobs[ iJob ];
+  const size_t iDetector = job.iDetector;
+  const short * adcValues = job.adcValues;
 
-            for ( int xPixel = _minX[iDetector + detectorOffset]; xPixel <= _maxX[iDetector + detectorOffset]; xPixel++) {
-              bool isHit  = ( ( adcValues[iPixel] - _pedestal[iDetector + detectorOffset][iPixel] ) > _hitRejectionCut * _noise[iDetector + detectorOffset][iPixel] );
-              bool isGood = ( _status[iDetector + detectorOffset][iPixel] == EUTELESCOPE::GOODPIXEL );
-              if ( !isHit && isGood ) {
-                pixelSum += adcValues[iPixel] - _pedestal[iDetector + detectorOffset][iPixel];
-                ++goodPixel;
-              } else if ( isHit ) {
-                ++skippedPixelPerRow;
-                ++skippedPixel;
-              }
-              ++iPixel;
-            }
+  job.commonModeCorVec.clear();
+  job.commonModeValues.clear();
+  job.isEventValid = true;
+  job.skippedPixel = 0;
+  job.skippedRow   = 0;
 
-            // we are now at the end of the row, so let's calculate the
-            // common mode
-            if ( ( skippedPixelPerRow < _maxNoOfRejectedPixelPerRow ) &&
-                 ( goodPixel != 0 ) ) {
-              commonMode = pixelSum / goodPixel ;
-              commonModeCorVec.insert( commonModeCorVec.begin() + colCounter * rowLength, rowLength, commonMode );
+  if ( _commonModeAlgo == EUTELESCOPE::FULLFRAME ) {
 
-#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-              string histoname = _commonModeHistoName + "_d" + to_string( _orderedSensorIDVec.at( iDetector + detectorOffset ) )
-                + "_l" + to_string( _iLoop );
-              AIDA::IHistogram1D * histo = (dynamic_cast<AIDA::IHistogram1D*>(_aidaHistoMap[ histoname ]));
-              if ( histo ) {
-                histo->fill(commonMode);
-              }
-#endif
+    double pixelSum     = 0.;
+    double commonMode   = 0.;
+    int    goodPixel    = 0;
+    int    iPixel       = 0;
 
-            } else {
-              commonModeCorVec.insert( commonModeCorVec.begin() + colCounter * rowLength, rowLength, 0. );
-              ++skippedRow;
-            }
+    // start looping on all pixels for hit rejection
+    for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector]; yPixel++) {
+      for (int xPixel = _minX[iDetector]; xPixel <= _maxX[iDetector]; xPixel++) {
+        bool isHit  = ( ( adcValues[iPixel] - _pedestal[iDetector][iPixel] ) > _hitRejectionCut * _noise[iDetector][iPixel] );
+        bool isGood = ( _status[iDetector][iPixel] == EUTELESCOPE::GOODPIXEL );
+        if ( !isHit && isGood ) {
+          pixelSum += adcValues[iPixel] - _pedestal[iDetector][iPixel];
+          ++goodPixel;
+        } else if ( isHit ) {
+          ++job.skippedPixel;
+        }
+        ++iPixel;
+      }
+    }
 
-            ++colCounter;
-          }
+    if ( ( job.skippedPixel < _maxNoOfRejectedPixels ) &&
+         ( goodPixel != 0 ) ) {
+      commonMode = pixelSum / goodPixel;
+      job.commonModeCorVec.assign( iPixel, commonMode );
+      job.commonModeValues.push_back( commonMode );
+      job.isEventValid = true;
+    } else {
+      job.isEventValid = false;
+    }
 
+  } else if ( _commonModeAlgo == EUTELESCOPE::ROWWISE ) {
 
-          if ( skippedRow < _maxNoOfSkippedRow ) {
+    int    iPixel       = 0;
+    int    rowLength    = _maxX[iDetector] -  _minX[iDetector] + 1;
 
-            isEventValid = true;
+    job.commonModeCorVec.reserve( job.noOfPixels );
+    for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector]; yPixel++) {
 
-          } else {
+      double pixelSum           = 0.;
+      double commonMode         = 0.;
+      int    goodPixel          = 0;
+      int    skippedPixelPerRow = 0;
+
+      for ( int xPixel = _minX[iDetector]; xPixel <= _maxX[iDetector]; xPixel++) {
+        bool isHit  = ( ( adcValues[iPixel] - _pedestal[iDetector][iPixel] ) > _hitRejectionCut * _noise[iDetector][iPixel] );
+        bool isGood = ( _status[iDetector][iPixel] == EUTELESCOPE::GOODPIXEL );
+        if ( !isHit && isGood ) {
+          pixelSum += adcValues[iPixel] - _pedestal[iDetector][iPixel];
+          ++goodPixel;
+        } else if ( isHit ) {
+          ++skippedPixelPerRow;
+          ++job.skippedPixel;
+        }
+        ++iPixel;
+      }
 
-            isEventValid = false;
+      // we are now at the end of the row, so let's calculate the
+      // common mode
+      if ( ( skippedPixelPerRow < _maxNoOfRejectedPixelPerRow ) &&
+           ( goodPixel != 0 ) ) {
+        commonMode = pixelSum / goodPixel ;
+        job.commonModeCorVec.insert( job.commonModeCorVec.end(), rowLength, commonMode );
+        job.commonModeValues.push_back( commonMode );
+      } else {
+        job.commonModeCorVec.insert( job.commonModeCorVec.end(), rowLength, 0. );
+        ++job.skippedRow;
+      }
+    }
 
-          }
+    job.isEventValid = ( job.skippedRow < _maxNoOfSkippedRow );
 
-        } else {
-          streamlog_out ( ERROR4 ) << "Unknown common mode algorithm. Using flat null correction" << endl;
-          commonModeCorVec.insert( commonModeCorVec.begin(),
-                                   ( _maxY[iDetector + detectorOffset] - _minY[iDetector + detectorOffset] + 1 ) *
-                                   ( _maxX[iDetector + detectorOffset] - _minX[iDetector + detectorOffset] + 1 ),
-                                   0. );
-          isEventValid = true;
-        }
+  } else {
+    // unknown algorithm, the error is reported by otherLoop
+    job.commonModeCorVec.assign( ( _maxY[iDetector] - _minY[iDetector] + 1 ) *
+                                 ( _maxX[iDetector] - _minX[iDetector] + 1 ), 0. );
+    job.isEventValid = true;
+  }
 
+}
 
-        if ( isEventValid ) {
-
-          int iPixel = 0;
-          for (int yPixel = _minY[iDetector + detectorOffset]; yPixel <= _maxY[iDetector + detectorOffset]; yPixel++) {
-            for (int xPixel = _minX[iDetector + detectorOffset]; xPixel <= _maxX[iDetector + detectorOffset]; xPixel++) {
-              if ( _status[iDetector + detectorOffset][iPixel] == EUTELESCOPE::GOODPIXEL ) {
-                double pedeCorrected = adcValues[iPixel] - commonModeCorVec[iPixel];
-                if ( std::abs( pedeCorrected - _pedestal[iDetector + detectorOffset][iPixel] ) < _hitRejectionCut * _noise[iDetector + detectorOffset][iPixel] ) {
-                  if ( _pedestalAlgo == EUTELESCOPE::MEANRMS ) {
-
-                    bool use = true;
-                    if ( _preLoopSwitch && ( ( _iEvt == _maxValuePos[ iDetector  + detectorOffset ] [ iPixel ] ) ||
-                                             ( _iEvt == _minValuePos[ iDetector  + detectorOffset ] [ iPixel ] ) )  ) {
-                      use = false;
-                    }
-                    if ( use ) {
-                      _tempEntries[iDetector + detectorOffset][iPixel] = _tempEntries[iDetector + detectorOffset][iPixel] + 1;
-                      _tempPede[iDetector + detectorOffset][iPixel]    = ((_tempEntries[iDetector + detectorOffset][iPixel] - 1)
-                                                                          * _tempPede[iDetector + detectorOffset][iPixel]
-                                                                          + pedeCorrected) / _tempEntries[iDetector + detectorOffset][iPixel];
-                      _tempNoise[iDetector + detectorOffset][iPixel]   = sqrt(((_tempEntries[iDetector + detectorOffset][iPixel] - 1)
-                                                                               * pow(_tempNoise[iDetector + detectorOffset][iPixel],2)
-                                                                               + pow(pedeCorrected - _tempPede[iDetector + detectorOffset][iPixel], 2)) /
-                                                                              _tempEntries[iDetector + detectorOffset][iPixel]);
-                    }
-                  } else if ( _pedestalAlgo == EUTELESCOPE::AIDAPROFILE) {
-#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-                    bool use = true;
-                    if ( _preLoopSwitch && ( ( _iEvt == _maxValuePos[ iDetector  + detectorOffset ] [ iPixel ] ) ||
-                                             ( _iEvt == _minValuePos[ iDetector  + detectorOffset ] [ iPixel ] ) )  ) {
-                      use = false;
-                    }
-                    if ( use ) {
-                      stringstream ss;
-                      ss << _tempProfile2DName << "_d" << _orderedSensorIDVec.at( iDetector  + detectorOffset );
-                      (dynamic_cast<AIDA::IProfile2D*> (_aidaHistoMap[ss.str()]))
-                        ->fill(static_cast<double> (xPixel), static_cast<double> (yPixel), pedeCorrected);
-                    }
-#endif
-                  }
-                }
-              }
-              ++iPixel;
-            }
-          }
-        } else {
-          if ( _commonModeAlgo == EUTELESCOPE::FULLFRAME ) {
-            streamlog_out ( WARNING2 ) <<  "Skipping event " << _iEvt << " because of max number of rejected pixels exceeded. ("
-                                       << skippedPixel << ") on detector " << _orderedSensorIDVec.at( iDetector ) << endl;
-          } else if ( _commonModeAlgo == EUTELESCOPE::ROWWISE ) {
-            streamlog_out ( WARNING2 ) <<  "Skipping event " << _iEvt << " because of max number of skipped rows is reached. ("
-                                       << skippedRow << ") on detector " << _orderedSensorIDVec.at( iDetector ) << endl;
-          }
+void EUTelPedestalNoiseProcessor::accumulateDetectorJobs( bool withCommonMode ) {
+
+  // split every detector in blocks of pixels, so that also a single
+  // large detector is shared among the threads
+  _accumulateWithCommonMode = withCommonMode;
+  _jobFirstChunk.resize( _detectorJobs.size() + 1 );
+  size_t noOfChunks = 0;
+  for ( size_t iJob = 0; iJob < _detectorJobs.size(); ++iJob ) {
+    _jobFirstChunk[ iJob ] = noOfChunks;
+    if ( _detectorJobs[ iJob ].isEventValid ) {
+      noOfChunks += ( _detectorJobs[ iJob ].noOfPixels + _pixelsPerChunk - 1 ) / _pixelsPerChunk;
+    }
+  }
+  _jobFirstChunk.back() = noOfChunks;
 
-          // the event has been skipped, so add this event number to the
-          // skipped list
-          _skippedEventList.push_back( _iEvt );
-        }
-      }
-    } catch (DataNotAvailableException& e) {
-      streamlog_out ( WARNING2 ) << "No input collection " << _rawDataCollectionNameVec.at( iCol ) << " is not available in the current event" << endl;
+  AccumulateTask accumulateTask( this );
+  _workerPool->run( accumulateTask, noOfChunks );
+
+}
+
+void EUTelPedestalNoiseProcessor::AccumulateTask::execute( size_t chunk ) {
+
+  // the job owning this chunk is the last one starting before it
+  const std::vector< size_t > & firstChunk = _processor->_jobFirstChunk;
+  size_t iJob = ( upper_bound( firstChunk.begin(), firstChunk.end(), chunk ) - firstChunk.begin() ) - 1;
+  const DetectorJob & job = _processor->_detectorJobs[ iJob ];
+
+  size_t begin = ( chunk - firstChunk[ iJob ] ) * _pixelsPerChunk;
+  size_t end   = begin + _pixelsPerChunk;
+  if ( end > job.noOfPixels ) end = job.noOfPixels;
+
+  const float * commonMode = NULL;
+  if ( _processor->_accumulateWithCommonMode ) commonMode = &job.commonModeCorVec[0];
+
+  _processor->accumulatePixelStatistics( job.iDetector, job.adcValues, commonMode, begin, end );
+
+}
+
+void EUTelPedestalNoiseProcessor::accumulatePixelStatistics( size_t iDetector, const short * adcValues, const float * commonMode,
+                                                             size_t begin, size_t end ) {
+
+  PixelStatistics & stat = _pixelStatistics[ iDetector ];
+  const float * reference = &stat.reference[0];
+  double      * entries   = &stat.entries[0];
+  double      * sum       = &stat.sum[0];
+  double      * sum2      = &stat.sum2[0];
+
+  // pixels having the max or min signal found in the pre loop are
+  // not used
+  const bool    preLoop = _preLoopSwitch;
+  const int     iEvt    = _iEvt;
+  const short * maxPos  = preLoop ? &_maxValuePos[iDetector][0] : NULL;
+  const short * minPos  = preLoop ? &_minValuePos[iDetector][0] : NULL;
+
+  // the decision is turned into a 0 / 1 weight, so that the loops
+  // have no branch and can be vectorized by the compiler
+  if ( commonMode == NULL ) {
+
+    for ( size_t iPixel = begin; iPixel < end; ++iPixel ) {
+      double use = 1.;
+      if ( preLoop ) use = ( ( iEvt != maxPos[iPixel] ) && ( iEvt != minPos[iPixel] ) ) ? 1. : 0.;
+      const double delta = adcValues[iPixel] - reference[iPixel];
+      entries[iPixel] += use;
+      sum[iPixel]     += use * delta;
+      sum2[iPixel]    += use * delta * delta;
     }
+
+  } else {
+
+    const short * status   = &_status[iDetector][0];
+    const float * pedestal = &_pedestal[iDetector][0];
+    const float * noise    = &_noise[iDetector][0];
+    const float   cut      = _hitRejectionCut;
+
+    for ( size_t iPixel = begin; iPixel < end; ++iPixel ) {
+      const double pedeCorrected = adcValues[iPixel] - commonMode[iPixel];
+      double use = ( ( status[iPixel] == EUTELESCOPE::GOODPIXEL ) &&
+                     ( std::abs( pedeCorrected - pedestal[iPixel] ) < cut * noise[iPixel] ) ) ? 1. : 0.;
+      if ( preLoop && ( ( iEvt == maxPos[iPixel] ) || ( iEvt == minPos[iPixel] ) ) ) use = 0.;
+      const double delta = pedeCorrected - reference[iPixel];
+      entries[iPixel] += use;
+      sum[iPixel]     += use * delta;
+      sum2[iPixel]    += use * delta * delta;
+    }
+
+  }
+
+}
+
+void EUTelPedestalNoiseProcessor::resetPixelStatistics( PixelStatistics & stat, const FloatVec & pedestal, const FloatVec & noise ) {
+
+  const size_t noOfPixels = pedestal.size();
+  stat.reference.assign( pedestal.begin(), pedestal.end() );
+  stat.entries.assign( noOfPixels, 1. );
+  stat.sum.assign( noOfPixels, 0. );
+  stat.sum2.assign( noOfPixels, 0. );
+  for ( size_t iPixel = 0; iPixel < noOfPixels && iPixel < noise.size(); ++iPixel ) {
+    stat.sum2[iPixel] = static_cast< double >( noise[iPixel] ) * noise[iPixel];
   }
-  ++_iEvt;
 
 }
 
@@ -1566,15 +1649,27 @@ void EUTelPedestalNoiseProcessor::finalizeProcessor(bool fromMaskingLoop) {
 
     if ( _pedestalAlgo == EUTELESCOPE::MEANRMS ) {
 
-      // the loop on events is over so we need to move temporary vectors
-      // to final vectors
-      _pedestal = _tempPede;
-      _noise    = _tempNoise;
+      // the loop on events is over so we need to turn the running
+      // sums into the final vectors
+      _pedestal.clear();
+      _noise.clear();
+      for ( size_t iDetector = 0; iDetector < _pixelStatistics.size(); ++iDetector ) {
+        const PixelStatistics & stat = _pixelStatistics[ iDetector ];
+        const size_t noOfPixels = stat.reference.size();
+        FloatVec pedestal( noOfPixels );
+        FloatVec noise( noOfPixels );
+        for ( size_t iPixel = 0; iPixel < noOfPixels; ++iPixel ) {
+          const double mean     = stat.sum[iPixel] / stat.entries[iPixel];
+          const double variance = stat.sum2[iPixel] / stat.entries[iPixel] - mean * mean;
+          pedestal[iPixel] = stat.reference[iPixel] + mean;
+          noise[iPixel]    = ( variance > 0 ) ? sqrt( variance ) : 0.;
+        }
+        _pedestal.push_back( pedestal );
+        _noise.push_back( noise );
+      }
 
       // clear the temporary vectors
-      _tempPede.clear();
-      _tempNoise.clear();
-      _tempEntries.clear();
+      _pixelStatistics.clear();
 
     } else if ( _pedestalAlgo == EUTELESCOPE::AIDAPROFILE ) {
 
@@ -1781,12 +1876,10 @@ void EUTelPedestalNoiseProcessor::finalizeProcessor(bool fromMaskingLoop) {
     if ( _pedestalAlgo == EUTELESCOPE::MEANRMS ) {
 
       // the collection contains several TrackerRawData
-      // move back the _pedestal and _noise to the _temp vector
-      _tempPede  = _pedestal;
-      _tempNoise = _noise;
-
+      // restart the running sums from the _pedestal and _noise
+      _pixelStatistics.assign( _noOfDetector, PixelStatistics() );
       for ( size_t iDetector = 0; iDetector < _noOfDetector; iDetector++) {
-        _tempEntries.push_back(IntVec( _noise[iDetector].size(), 1));
+        resetPixelStatistics( _pixelStatistics[iDetector], _pedestal[iDetector], _noise[iDetector] );
       }
 
     } else if ( _pedestalAlgo == EUTELESCOPE::AIDAPROFILE ) {
@@ -2,6 +2,8 @@
 #ifdef USE_GEAR
 // eutelescope includes ".h"
 #include "EUTelPreAlignment.h"
+#include "EUTelConvergenceMonitor.h"
+#include "EUTelHitStore.h"
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelEventImpl.h"
 #include "EUTelAlignmentConstant.h"
@@ -96,6 +98,12 @@ EUTelPreAlign::EUTelPreAlign () :Processor("EUTelPreAlign") {
 
   registerOptionalParameter("HistogramFilling","Switch on or off the histogram filling",_fillHistos, static_cast< bool > ( true ) );
 
+  registerOptionalParameter("ConvergenceTolerance","If positive, stop before the requested number of events once the X and Y offsets of all planes are stable within this tolerance (in mm) and all the other monitored processors have converged",
+                            _convergenceTolerance, static_cast< float > ( 0. ) );
+
+  registerOptionalParameter("ConvergenceCheckInterval","How often, in events, the offsets are checked for convergence",
+                            _convergenceCheckInterval, static_cast< int > ( 1000 ) );
+
 }
 
 
@@ -108,8 +116,6 @@ void EUTelPreAlign::init () {
   // set to zero the run and event counters
   _iRun = 0;  _iEvt = 0;
 
-  _UsefullHotPixelCollectionFound = 0; 
-
   _referenceHitVec = 0;
 
   // clear the sensor ID vector
@@ -177,6 +183,31 @@ void EUTelPreAlign::init () {
       _sensorIDinZordered.insert( make_pair( _sensorIDtoZOrderMap[ sensorID ], sensorID ) );
     }
 
+  // direct lookup of the PreAligner of a sensor, used to sort the hits once per event
+  _sensorIDToPreAligner.clear();
+  _preAlignerZOrder.clear();
+  for( size_t ii = 0; ii < _preAligners.size(); ii++ )
+    {
+      int sensorID = _preAligners[ii].getIden();
+      if( sensorID < 0 ) continue;
+      if( static_cast< size_t >( sensorID ) >= _sensorIDToPreAligner.size() ) _sensorIDToPreAligner.resize( sensorID + 1, -1 );
+      _sensorIDToPreAligner[ sensorID ] = static_cast< int >( ii );
+    }
+  for( size_t ii = 0; ii < _preAligners.size(); ii++ )
+    {
+      _preAlignerZOrder.push_back( _sensorIDtoZOrderMap[ _preAligners[ii].getIden() ] );
+    }
+  _planeHitX.assign( _preAligners.size(), std::vector<double>() );
+  _planeHitY.assign( _preAligners.size(), std::vector<double>() );
+
+  if( _convergenceTolerance > 0 ) {
+    if( _convergenceCheckInterval <= 0 ) _convergenceCheckInterval = 1000;
+    for( size_t ii = 0; ii < _preAligners.size(); ii++ ) {
+      EUTelConvergenceMonitor::instance().registerEstimator( this, "peakX_" + to_string( _preAligners[ii].getIden() ), _convergenceTolerance, _events );
+      EUTelConvergenceMonitor::instance().registerEstimator( this, "peakY_" + to_string( _preAligners[ii].getIden() ), _convergenceTolerance, _events );
+    }
+  }
+
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
   string tempHistoName = "";
   string basePath; 
@@ -212,90 +243,11 @@ void EUTelPreAlign::processRunHeader (LCRunHeader * rdr) {
 }
 
 
-void  EUTelPreAlign::FillHotPixelMap(LCEvent *event)
-{
-
-  if( _hotPixelCollectionName.empty()) return;
-
-  LCCollectionVec *hotPixelCollectionVec = 0;
-  try 
-    {
-      hotPixelCollectionVec = static_cast< LCCollectionVec* > ( event->getCollection( _hotPixelCollectionName  ) );
-      streamlog_out ( DEBUG5 ) << "Hotpixel database " << _hotPixelCollectionName.c_str() << " found" << endl; 
-    }
-  catch (...)
-    {
-      streamlog_out ( WARNING5 ) << "Hotpixel database " << _hotPixelCollectionName.c_str() << " not found" << endl; 
-      return;
-    }
-
-  CellIDDecoder<TrackerDataImpl> cellDecoder( hotPixelCollectionVec );
-	
-  for(int i=0; i<  hotPixelCollectionVec->getNumberOfElements(); i++)
-    {
-      TrackerDataImpl* hotPixelData = dynamic_cast< TrackerDataImpl *> ( hotPixelCollectionVec->getElementAt( i ) );
-      SparsePixelType  type         = static_cast<SparsePixelType> (static_cast<int> (cellDecoder( hotPixelData )["sparsePixelType"]));
-
-      int sensorID              = static_cast<int > ( cellDecoder( hotPixelData )["sensorID"] );
-
-      if( type  == kEUTelAPIXSparsePixel)
-	{  
-	  auto_ptr<EUTelSparseDataImpl<EUTelAPIXSparsePixel > > apixData(new EUTelSparseDataImpl<EUTelAPIXSparsePixel> ( hotPixelData ));
-	  EUTelAPIXSparsePixel apixPixel;
-	  //Push all single Pixels of one plane in the apixPixelVec
-	  for(  unsigned int iPixel = 0; iPixel < apixData->size(); iPixel++ ) 
-	    {
-	      std::vector<int> apixColVec();
-	      apixData->getSparsePixelAt( iPixel, &apixPixel);
-
-	      try
-		{
-		  _hotPixelMap[sensorID].push_back(std::make_pair(apixPixel.getXCoord(), apixPixel.getYCoord()));
-		}
-	      catch(...)
-		{
-		  streamlog_out ( ERROR5 ) << " cannot add pixel to hotpixel map!"  << endl; 
-		}
-	    }
-	}
-      else if( type  ==  kEUTelSimpleSparsePixel )
-	{  
-	  auto_ptr<EUTelSparseClusterImpl< EUTelSimpleSparsePixel > > m26Data( new EUTelSparseClusterImpl< EUTelSimpleSparsePixel >   ( hotPixelData ) );
-
-	  std::vector<EUTelSimpleSparsePixel*> m26PixelVec;
-	  EUTelSimpleSparsePixel m26Pixel;
-	  //Push all single Pixels of one plane in the m26PixelVec
-
-	  for(  unsigned int iPixel = 0; iPixel < m26Data->size(); iPixel++ ) 
-	    {
-              std::vector<int> m26ColVec();
-              m26Data->getSparsePixelAt( iPixel, &m26Pixel);
-
-              try
-		{
-		  _hotPixelMap[sensorID].push_back(std::make_pair(m26Pixel.getXCoord(), m26Pixel.getYCoord()));
-		}
-              catch(...)
-		{
-		  streamlog_out ( ERROR5 ) << " cannot add pixel to hotpixel map! SensorID: "  << sensorID << ", X:" << m26Pixel.getXCoord() << ", Y:" << m26Pixel.getYCoord() << endl; 
-		  abort();
-		}
-	    }
-	}          
-      else
-	{
-	  _UsefullHotPixelCollectionFound = 0;
-	}  	
-    }
-}
-
 void EUTelPreAlign::processEvent (LCEvent * event) {
 
   if(  isFirstEvent() )
     {
 
-      FillHotPixelMap(event);
-
       if(  _useReferenceHitCollection ) 
 	{
 	  try{
@@ -312,7 +264,13 @@ void EUTelPreAlign::processEvent (LCEvent * event) {
 
   ++_iEvt;
 
-  if(_iEvt > _events) return;
+  if(_iEvt > _events) {
+    if( _convergenceTolerance > 0 ) {
+      EUTelConvergenceMonitor::instance().setDone( this, _events );
+      EUTelConvergenceMonitor::instance().check( this );
+    }
+    return;
+  }
 
   EUTelEventImpl * evt = static_cast<EUTelEventImpl*> (event);
   
@@ -325,75 +283,96 @@ void EUTelPreAlign::processEvent (LCEvent * event) {
   }
 
   try {
-    LCCollectionVec * inputCollectionVec = dynamic_cast < LCCollectionVec * > (evt->getCollection(_inputHitCollectionName));
-
-    std::vector<float> residX;
-    std::vector<float> residY;
-    std::vector<PreAligner*> prealign;
+    // the hits are decoded once per event for all the processors
+    // using the same collections
+    const EUTelHitStore & hitStore = EUTelHitStore::get( event, _inputHitCollectionName,
+                                                         _useReferenceHitCollection ? _referenceHitCollectionName : "" );
+    const vector< bool > & hotHits = hitStore.getHotFlags( _hotPixelCollectionName );
+
+    // Sort the hits once: fixed plane hits on one side, the others
+    // into one position array per PreAligner
+    _refHitX.clear();
+    _refHitY.clear();
+    for( size_t ii = 0; ii < _planeHitX.size(); ii++ ) {
+      _planeHitX[ii].clear();
+      _planeHitY[ii].clear();
+    }
 
-    //Loop over hits in fixed plane:
+    const int fixedPlane = hitStore.getPlaneIndex( _fixedID );
+    if( fixedPlane >= 0 ) {
+      const EUTelHitStore::Plane & plane = hitStore.getPlane( fixedPlane );
+      _refHitX.assign( plane.x.begin(), plane.x.end() );
+      _refHitY.assign( plane.y.begin(), plane.y.end() );
+    }
 
-    for( size_t ref = 0; ref < inputCollectionVec->size(); ref++ )  {
+    // without fixed plane hits there is nothing to correlate with,
+    // no need to look at the other planes
+    for( size_t iPlane = 0; iPlane < hitStore.getNPlanes() && ! _refHitX.empty(); iPlane++ ) {
 
-      TrackerHitImpl * refHit = dynamic_cast< TrackerHitImpl * >  ( inputCollectionVec->getElementAt( ref ) ) ;
-      const double * refPos = refHit->getPosition();
+      if( static_cast< int >( iPlane ) == fixedPlane ) continue;
 
-      // identify fixed plane
-      if( guessSensorID(refPos) != _fixedID ) continue;
+      const EUTelHitStore::Plane & plane = hitStore.getPlane( iPlane );
+      int iPreAligner = -1;
+      if( plane.sensorID >= 0 && static_cast< size_t >( plane.sensorID ) < _sensorIDToPreAligner.size() ) {
+        iPreAligner = _sensorIDToPreAligner[ plane.sensorID ];
+      }
 
-      residX.clear();
-      residY.clear();
-      prealign.clear();
+      for( size_t iHit = 0; iHit < plane.size(); iHit++ ) {
+        if( hotHits[ plane.collectionIndex[iHit] ] ) continue;
+        if( iPreAligner < 0 ) {
+          streamlog_out ( ERROR5 ) << "Mismatched hit at " << plane.z[iHit] << endl;
+          continue;
+        }
+        _planeHitX[ iPreAligner ].push_back( plane.x[iHit] );
+        _planeHitY[ iPreAligner ].push_back( plane.y[iHit] );
+      }
+    }
 
-      for( size_t iHit = 0; iHit < inputCollectionVec->size(); iHit++) {
+    //Loop over hits in fixed plane:
 
-	TrackerHitImpl * hit = dynamic_cast< TrackerHitImpl * >  ( inputCollectionVec->getElementAt( iHit ) ) ;
-        if( hitContainsHotPixels(hit) ) continue;
-        
-        const double * pos = hit->getPosition();
-        int iHitID = guessSensorID(pos);
-        if( iHitID == _fixedID ) continue;
-        bool gotIt(false);
+    for( size_t ref = 0; ref < _refHitX.size(); ref++ )  {
 
-	for(size_t ii = 0; ii < _preAligners.size(); ii++)
-	  {
+      const double refX = _refHitX[ref];
+      const double refY = _refHitY[ref];
 
-	    PreAligner& pa = _preAligners.at(ii);
+      _residX.clear();
+      _residY.clear();
+      _residPreAligner.clear();
 
-	    if( pa.getIden() != iHitID  ) { continue; }
+      for( size_t ii = 0; ii < _preAligners.size(); ii++ ) {
 
-	    gotIt = true;
+        const std::vector<double> & hitX = _planeHitX[ii];
+        const std::vector<double> & hitY = _planeHitY[ii];
+        const int idZ = _preAlignerZOrder[ii];
+        const double xMin = _residualsXMin[idZ], xMax = _residualsXMax[idZ];
+        const double yMin = _residualsYMin[idZ], yMax = _residualsYMax[idZ];
 
-	    double correlationX =  refPos[0] - pos[0] ;
-	    double correlationY =  refPos[1] - pos[1] ;
+        for( size_t iHit = 0; iHit < hitX.size(); iHit++ ) {
 
-	    int idZ = _sensorIDtoZOrderMap[ iHitID ];
+          double correlationX =  refX - hitX[iHit] ;
+          double correlationY =  refY - hitY[iHit] ;
 
-	    if( 
-	       (_residualsXMin[idZ] < correlationX ) && ( correlationX < _residualsXMax[idZ]) &&
-	       (_residualsYMin[idZ] < correlationY ) && ( correlationY < _residualsYMax[idZ]) 
-		) {
-	      residX.push_back( correlationX );
-	      residY.push_back( correlationY );
-	      prealign.push_back(&pa);
-	    }
-	    break;
-	  }
-	if( not gotIt ) 
-	  {
-	    streamlog_out ( ERROR5 ) << "Mismatched hit at " << pos[2] << endl;
-	  }
+          if( 
+             ( xMin < correlationX ) && ( correlationX < xMax ) &&
+             ( yMin < correlationY ) && ( correlationY < yMax ) 
+              ) {
+            _residX.push_back( correlationX );
+            _residY.push_back( correlationY );
+            _residPreAligner.push_back( static_cast< int >( ii ) );
+          }
+        }
       }
 
-      if( prealign.size() > static_cast< unsigned int >(_minNumberOfCorrelatedHits) && residX.size() == residY.size() ) {
-	for( unsigned int ii = 0 ;ii < prealign.size(); ii++ ) {
+      if( _residPreAligner.size() > static_cast< unsigned int >(_minNumberOfCorrelatedHits) ) {
+	for( unsigned int ii = 0 ;ii < _residPreAligner.size(); ii++ ) {
 
-	  prealign[ii]->addPoint( residX[ii], residY[ii] );
+          PreAligner & pa = _preAligners[ _residPreAligner[ii] ];
+	  pa.addPoint( _residX[ii], _residY[ii] );
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 	  if( _fillHistos ) {
-	    ( dynamic_cast<AIDA::IHistogram1D*> (_hitXCorr[ prealign[ii]->getIden() ] ) )->fill( residX[ii] );
-	    ( dynamic_cast<AIDA::IHistogram1D*> (_hitYCorr[ prealign[ii]->getIden() ] ) )->fill( residY[ii] );
+	    ( dynamic_cast<AIDA::IHistogram1D*> (_hitXCorr[ pa.getIden() ] ) )->fill( _residX[ii] );
+	    ( dynamic_cast<AIDA::IHistogram1D*> (_hitYCorr[ pa.getIden() ] ) )->fill( _residY[ii] );
 	  }
 #endif
 	}
@@ -407,181 +386,20 @@ void EUTelPreAlign::processEvent (LCEvent * event) {
 
   if( isFirstEvent() ) _isFirstEvent = false;
 
-}
-
-bool EUTelPreAlign::hitContainsHotPixels( TrackerHitImpl   * hit) 
-{
-  bool skipHit = false;
-
-  // if no hot pixel map was loaded, just return here
-  if( _hotPixelMap.size() == 0) return 0;
-
-  try
-    {
-      LCObjectVec clusterVector = hit->getRawHits();
-
-      if ( hit->getType() == kEUTelSparseClusterImpl ) 
-	{
-	  TrackerDataImpl * clusterFrame = static_cast<TrackerDataImpl*> ( clusterVector[0] );
-	  eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelSimpleSparsePixel > *cluster = new eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelSimpleSparsePixel >(clusterFrame);
-
-	  int sensorID = cluster->getDetectorID();
-
-	  for ( unsigned int iPixel = 0; iPixel < cluster->size(); iPixel++ ) 
-	    {
-	      EUTelSimpleSparsePixel m26Pixel;
-	      cluster->getSparsePixelAt( iPixel, &m26Pixel);
-	      {
-		try{
-		  if( std::find(_hotPixelMap.at(sensorID).begin(), 
-				_hotPixelMap.at(sensorID).end(),
-				std::make_pair(m26Pixel.getXCoord(),m26Pixel.getYCoord()))
-		      != _hotPixelMap.at(sensorID).end()){ 
-		    skipHit = true; 	      
-		    delete cluster;                        			  
-		    return true; // if TRUE  this hit will be skipped
-		  }
-		}
-		catch(const std::out_of_range& oor){
-		  streamlog_out(DEBUG0) << " Could not find hot pixel map for sensor ID " 
-					<< sensorID << ": " << oor.what() << endl;
-		}
-	      }
-	    }
-
-	  delete cluster;
-	  return 0;
-	} 
-      else if ( hit->getType() == kEUTelBrickedClusterImpl ) 
-	{
-
-	  // fixed cluster implementation. Remember it
-	  //  can come from
-	  //  both RAW and ZS data
-   
-	  streamlog_out ( WARNING5 ) << " Hit type kEUTelBrickedClusterImpl is not implemented in hotPixel finder method, all pixels are considered for PreAlignment." <<  endl;
-
-	} 
-      else if ( hit->getType() == kEUTelDFFClusterImpl ) 
-	{
-
-	  // fixed cluster implementation. Remember it can come from
-	  // both RAW and ZS data
-	  streamlog_out ( WARNING5 ) << " Hit type kEUTelDFFClusterImpl is not implemented in hotPixel finder method, all pixels are considered for PreAlignment." <<  endl;
-	} 
-      else if ( hit->getType() == kEUTelFFClusterImpl ) 
-	{
-
-	  // fixed cluster implementation. Remember it can come from
-	  // both RAW and ZS data
-	  streamlog_out ( WARNING5 ) << " Hit type kEUTelFFClusterImpl is not implemented in hotPixel finder method, all pixels are considered for PreAlignment." <<  endl;
-	} 
-      else if ( hit->getType() == kEUTelAPIXClusterImpl ) 
-	{
-
-	  TrackerDataImpl * clusterFrame = static_cast<TrackerDataImpl*> ( clusterVector[0] );
-	  eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelAPIXSparsePixel > *apixCluster = new eutelescope::EUTelSparseClusterImpl< eutelescope::EUTelAPIXSparsePixel >(clusterFrame);
-          
-	  int sensorID = apixCluster->getDetectorID();
-	  for (unsigned int iPixel = 0; iPixel < apixCluster->size(); ++iPixel) 
-	    {
-	      EUTelAPIXSparsePixel apixPixel;
-	      apixCluster->getSparsePixelAt(iPixel, &apixPixel);
-	      {
-		try{
-		  if( std::find(_hotPixelMap.at(sensorID).begin(), 
-				_hotPixelMap.at(sensorID).end(),
-				std::make_pair(apixPixel.getXCoord(), apixPixel.getYCoord()))
-		      != _hotPixelMap.at(sensorID).end() ) {
-		    skipHit = true; 	      
-		    delete apixCluster;                        
-		    return true; // if TRUE  this hit will be skipped
-		  }
-		  else
-		    { 
-		      skipHit = false;
-		    }
-		}
-		catch(const std::out_of_range& oor){
-		  streamlog_out(DEBUG0) << " Could not find hot pixel map for sensor ID " 
-					<< sensorID << ": " << oor.what() << endl;
-		}
-      
-	      }
-	    }                
-	  delete apixCluster;
-	  return skipHit; // if TRUE  this hit will be skipped
-	} 
-      else
-	{
-	  streamlog_out ( WARNING5 ) << " Hit type is not known and is not implemented in hotPixel finder method, all pixels are considered for PreAlignment." <<  endl;
-	}
-    }
-  catch (exception& e)
-    {
-      streamlog_out(ERROR4) << "something went wrong in EUTelPreAlign::hitContainsHotPixels: " << e.what() << endl;
-    }
-  catch(...)
-    { 
-      // if anything went wrong in the above return FALSE, meaning do not skip this hit
-    
-      streamlog_out(ERROR4) << "something went wrong in EUTelPreAlign::hitContainsHotPixels " << endl;
-      return 0;
-    }
-
-  // if none of the above worked return FALSE, meaning do not skip this hit
-  return 0;
-}
-
-
-int EUTelPreAlign::guessSensorID(const double * hit ) 
-{
-
-  int sensorID = -1;
-  double minDistance =  numeric_limits< double >::max() ;
-
-  if( _referenceHitVec == 0 || _useReferenceHitCollection == false )
-    {
-      // use z information of planes instead of reference vector
-      for(  int iPlane = 0 ; iPlane < _siPlanesLayerLayout->getNLayers(); ++iPlane ) {
-	double distance = std::abs( hit[2] - _siPlaneZPosition[ iPlane ] );
-	if(  distance < minDistance ) {
-	  minDistance = distance;
-	  sensorID = _siPlanesLayerLayout->getID( iPlane );
-	}
-      }
-      if(  minDistance > 30  ) {
-	// advice the user that the guessing wasn't successful 
-	streamlog_out( WARNING3 ) << "A hit was found " << minDistance << " mm far from the nearest plane\n"
-	  "Please check the consistency of the data with the GEAR file: hitPosition[2]=" << hit[2] <<       endl;
-      }
-    
-      return sensorID;
-    }
-
-  for(size_t ii = 0 ; ii < static_cast< unsigned int >(_referenceHitVec->getNumberOfElements()); ii++)
-    {
-      EUTelReferenceHit* refhit = static_cast< EUTelReferenceHit*> ( _referenceHitVec->getElementAt(ii) ) ;
-        
-      TVector3 hit3d( hit[0], hit[1], hit[2] );
-      TVector3 hitInPlane( refhit->getXOffset(), refhit->getYOffset(), refhit->getZOffset());
-      TVector3 norm2Plane( refhit->getAlpha(), refhit->getBeta(), refhit->getGamma() );
- 
-      double distance = abs( norm2Plane.Dot(hit3d-hitInPlane) );
-      if ( distance < minDistance ) 
-        {
-	  minDistance = distance;
-	  sensorID = refhit->getSensorID();
-	}    
-
+  if( _convergenceTolerance > 0 && _iEvt % _convergenceCheckInterval == 0 ) {
+    EUTelConvergenceMonitor & monitor = EUTelConvergenceMonitor::instance();
+    for( size_t ii = 0; ii < _preAligners.size(); ii++ ) {
+      PreAligner & pa = _preAligners[ii];
+      // no peak to follow yet
+      if( pa.getNPoints() == 0 ) continue;
+      monitor.update( this, "peakX_" + to_string( pa.getIden() ), pa.getPeakX(), _iEvt );
+      monitor.update( this, "peakY_" + to_string( pa.getIden() ), pa.getPeakY(), _iEvt );
     }
+    monitor.check( this );
+  }
 
-  return sensorID;
 }
 
-
-
-      
 void EUTelPreAlign::end() {
   LCWriter * lcWriter = LCFactory::getInstance()->createLCWriter();
   try {
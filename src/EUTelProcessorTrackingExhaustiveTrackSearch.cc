@@ -32,6 +32,7 @@
 #include "EUTelUtility.h"
 #include "EUTelExhaustiveTrackFinder.h"
 #include "EUTelGeometryTelescopeGeoDescription.h"
+#include "EUTelProfiler.h"
 // Cluster types
 #include "EUTelSparseCluster2Impl.h"
 #include "EUTelSparseClusterImpl.h"
@@ -305,7 +306,11 @@ void EUTelProcessorTrackingExhaustiveTrackSearch::processEvent(LCEvent * evt) {
         _trackFinder->SetAllHits(allHitsVec);
         static_cast<EUTelExhaustiveTrackFinder*>(_trackFinder)->SetNEmptyPlanes(nEmptyPlanes);
         streamlog_out(DEBUG1) << "Trying to find tracks..." << endl;
-        EUTelTrackFinder::SearchResult searchResult = _trackFinder->SearchTracks();
+        EUTelTrackFinder::SearchResult searchResult;
+        {
+            EUTelProfiler::Scope profilerScope( "track search" );
+            searchResult = _trackFinder->SearchTracks();
+        }
         streamlog_out(DEBUG1) << "Search results = " << static_cast<int>(searchResult) << endl;
         streamlog_out(DEBUG1) << "Retrieving track candidates..." << endl;
         vector< EVENT::TrackerHitVec > trackCandidates = _trackFinder->GetTrackCandidates();
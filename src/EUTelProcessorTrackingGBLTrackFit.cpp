@@ -127,6 +127,7 @@ _excludePlanesFromFit(),
 _runPede(false),
 _alignmentConstantLCIOFile("alignment.slcio"),
 _maxMilleChi2Cut(1000.),
+_nThreads(1),
 _tgeoFileName("TELESCOPE.root"),
 _histoInfoFileName("histoinfo.xml"),
 _trackCandidateHitsInputCollectionName("TrackCandidateHitCollection"),
@@ -193,6 +194,8 @@ _aidaProfileMap2D()
 
     registerOptionalParameter("MilleMaxChi2Cut", "Maximum chi2 of a track candidate that goes into millepede", _maxMilleChi2Cut, double(1000.));
 
+    registerOptionalParameter("NumberOfThreads", "Number of threads fitting the GBL trajectories (1 = no additional thread). The output does not depend on it", _nThreads, static_cast<int> (1));
+
     registerOptionalParameter("AlignmentPlanes", "Ids of planes to be used in alignment", _alignmentPlaneIds, IntVec());
  
     //
@@ -311,6 +314,7 @@ void EUTelProcessorTrackingGBLTrackFit::init() {
         Fitter->SetBeamEnergy(_eBeam);
         Fitter->SetBeamCharge(_qBeam);
         Fitter->SetChi2Cut(_maxMilleChi2Cut);
+        Fitter->setNThreads(_nThreads > 1 ? _nThreads : 1);
         if (!_mEstimatorType.empty() ) Fitter->setMEstimatorType(_mEstimatorType);
         _trackFitter = Fitter;
 
@@ -0,0 +1,282 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelProfiler.h"
+#include "EUTelUtility.h"
+
+// system includes <>
+#include <cmath>
+#include <dlfcn.h>
+#include <iomanip>
+#include <limits>
+
+using namespace std;
+using namespace eutelescope;
+
+EUTelProfiler::Scope::Scope(const char * section) :
+  _section(0),
+  _wallTime(0.),
+  _cpuTime(0.),
+  _allocations(0),
+  _allocatedBytes(0) {
+
+  EUTelProfiler & profiler = EUTelProfiler::instance();
+  if ( ! profiler.isEnabled() ) return;
+
+  _section        = section;
+  _allocations    = profiler.getAllocations();
+  _allocatedBytes = profiler.getAllocatedBytes();
+  _cpuTime        = Utility::getCPUTime();
+  _wallTime       = Utility::getWallTime();
+}
+
+EUTelProfiler::Scope::~Scope() {
+
+  if ( _section == 0 ) return;
+
+  double wallTime = Utility::getWallTime() - _wallTime;
+  double cpuTime  = Utility::getCPUTime() - _cpuTime;
+  EUTelProfiler & profiler = EUTelProfiler::instance();
+  profiler.record( _section, wallTime, cpuTime,
+                   profiler.getAllocations() - _allocations, profiler.getAllocatedBytes() - _allocatedBytes );
+}
+
+EUTelProfiler & EUTelProfiler::instance() {
+  static EUTelProfiler profiler;
+  return profiler;
+}
+
+EUTelProfiler::EUTelProfiler() :
+  _enabled(false),
+  _sections(),
+  _sectionIndex(),
+  _runNumber(0),
+  _eventNumber(0),
+  _hasEvent(false),
+  _checkpointWallTime(0.),
+  _checkpointCpuTime(0.),
+  _checkpointAllocations(0),
+  _checkpointAllocatedBytes(0),
+  _eventLog(),
+  _allocationCounters(0) {
+
+  // exported by libEutelescopeAllocationHook.so, when preloaded
+  _allocationCounters = static_cast< const volatile long * >( dlsym( RTLD_DEFAULT, "eutelescope_allocation_counters" ) );
+}
+
+EUTelProfiler::~EUTelProfiler() {
+  if ( _eventLog.is_open() ) _eventLog.close();
+}
+
+long EUTelProfiler::getAllocations() const {
+  return _allocationCounters != 0 ? _allocationCounters[0] : 0;
+}
+
+long EUTelProfiler::getAllocatedBytes() const {
+  return _allocationCounters != 0 ? _allocationCounters[1] : 0;
+}
+
+void EUTelProfiler::record(const string & name, double wallTime, double cpuTime,
+                           long allocations, long allocatedBytes) {
+
+  map< string, size_t >::iterator iter = _sectionIndex.find( name );
+  if ( iter == _sectionIndex.end() ) {
+    Section section;
+    section.name                = name;
+    section.nEvents             = 0;
+    section.wallTime            = 0.;
+    section.cpuTime             = 0.;
+    section.minWallTime         = numeric_limits< double >::max();
+    section.maxWallTime         = 0.;
+    section.allocations         = 0.;
+    section.allocatedBytes      = 0.;
+    section.wallTimeBins.assign( nTimeBins, 0 );
+    section.eventWallTime       = 0.;
+    section.eventCpuTime        = 0.;
+    section.eventAllocations    = 0;
+    section.eventAllocatedBytes = 0;
+    section.inEvent             = false;
+    iter = _sectionIndex.insert( make_pair( name, _sections.size() ) ).first;
+    _sections.push_back( section );
+  }
+
+  // a section can be entered more than once per event
+  Section & section = _sections[ iter->second ];
+  section.eventWallTime       += wallTime;
+  section.eventCpuTime        += cpuTime;
+  section.eventAllocations    += allocations;
+  section.eventAllocatedBytes += allocatedBytes;
+  section.inEvent = true;
+}
+
+void EUTelProfiler::beginEvent(int runNumber, int eventNumber) {
+
+  endEvent();
+  _runNumber   = runNumber;
+  _eventNumber = eventNumber;
+  _hasEvent    = true;
+}
+
+void EUTelProfiler::checkpoint(const string & section, int runNumber, int eventNumber) {
+
+  double wallTime     = Utility::getWallTime();
+  double cpuTime      = Utility::getCPUTime();
+  long allocations    = getAllocations();
+  long allocatedBytes = getAllocatedBytes();
+
+  if ( ! _hasEvent || runNumber != _runNumber || eventNumber != _eventNumber ) {
+    beginEvent( runNumber, eventNumber );
+  } else {
+    record( section, wallTime - _checkpointWallTime, cpuTime - _checkpointCpuTime,
+            allocations - _checkpointAllocations, allocatedBytes - _checkpointAllocatedBytes );
+  }
+
+  // the checkpoint itself is not counted in the next section
+  _checkpointAllocations    = getAllocations();
+  _checkpointAllocatedBytes = getAllocatedBytes();
+  _checkpointCpuTime        = Utility::getCPUTime();
+  _checkpointWallTime       = Utility::getWallTime();
+}
+
+void EUTelProfiler::endEvent() {
+
+  for ( size_t i = 0; i < _sections.size(); ++i ) {
+
+    Section & section = _sections[i];
+    if ( ! section.inEvent ) continue;
+
+    ++section.nEvents;
+    section.wallTime       += section.eventWallTime;
+    section.cpuTime        += section.eventCpuTime;
+    section.allocations    += section.eventAllocations;
+    section.allocatedBytes += section.eventAllocatedBytes;
+    section.minWallTime = min( section.minWallTime, section.eventWallTime );
+    section.maxWallTime = max( section.maxWallTime, section.eventWallTime );
+    ++section.wallTimeBins[ timeBin( section.eventWallTime ) ];
+
+    if ( _eventLog.is_open() ) {
+      _eventLog << _runNumber << "," << _eventNumber << "," << section.name << ","
+                << section.eventWallTime * 1000. << "," << section.eventCpuTime * 1000. << ","
+                << section.eventAllocations << "," << section.eventAllocatedBytes << "\n";
+    }
+
+    section.eventWallTime       = 0.;
+    section.eventCpuTime        = 0.;
+    section.eventAllocations    = 0;
+    section.eventAllocatedBytes = 0;
+    section.inEvent = false;
+  }
+  _hasEvent = false;
+}
+
+bool EUTelProfiler::openEventLog(const string & filename) {
+
+  if ( _eventLog.is_open() ) _eventLog.close();
+  _eventLog.open( filename.c_str() );
+  if ( ! _eventLog.is_open() ) return false;
+  _eventLog << "run,event,section,wall_ms,cpu_ms,allocations,bytes\n";
+  return true;
+}
+
+int EUTelProfiler::timeBin(double time) {
+  // 10 bins per decade from 1 us
+  if ( time <= 1e-6 ) return 0;
+  int bin = static_cast< int >( floor( 10. * log10( time / 1e-6 ) ) );
+  return bin < nTimeBins ? bin : nTimeBins - 1;
+}
+
+double EUTelProfiler::timeBinCenter(int bin) {
+  return 1e-6 * pow( 10., ( bin + 0.5 ) / 10. );
+}
+
+double EUTelProfiler::quantile(const Section & section, double fraction) const {
+
+  long needed = static_cast< long >( ceil( fraction * section.nEvents ) );
+  long seen = 0;
+  for ( int bin = 0; bin < nTimeBins; ++bin ) {
+    seen += section.wallTimeBins[ bin ];
+    if ( seen >= needed && seen > 0 ) return min( timeBinCenter( bin ), section.maxWallTime );
+  }
+  return section.maxWallTime;
+}
+
+void EUTelProfiler::printSummary(ostream & os) {
+
+  // the last event is still open
+  endEvent();
+  if ( _eventLog.is_open() ) _eventLog.flush();
+
+  if ( _sections.empty() ) return;
+
+  os << "Profile of the job, times per event in ms";
+  if ( ! hasAllocationHook() ) os << " (allocations not counted, the allocation hook library is not loaded)";
+  os << endl;
+
+  os << setw(24) << left << "section" << right
+     << setw(9)  << "events"
+     << setw(11) << "mean"
+     << setw(11) << "median"
+     << setw(11) << "90%"
+     << setw(11) << "99%"
+     << setw(11) << "max"
+     << setw(11) << "cpu"
+     << setw(11) << "total[s]"
+     << setw(11) << "allocs"
+     << setw(11) << "kB" << endl;
+
+  ios_base::fmtflags flags = os.flags();
+  streamsize precision = os.precision();
+  os << fixed << setprecision( 3 );
+  for ( size_t i = 0; i < _sections.size(); ++i ) {
+    const Section & section = _sections[i];
+    if ( section.nEvents == 0 ) continue;
+    double n = static_cast< double >( section.nEvents );
+    os << setw(24) << left << section.name << right
+       << setw(9)  << section.nEvents
+       << setw(11) << 1000. * section.wallTime / n
+       << setw(11) << 1000. * quantile( section, 0.5 )
+       << setw(11) << 1000. * quantile( section, 0.9 )
+       << setw(11) << 1000. * quantile( section, 0.99 )
+       << setw(11) << 1000. * section.maxWallTime
+       << setw(11) << 1000. * section.cpuTime / n
+       << setw(11) << section.wallTime
+       << setw(11) << setprecision( 1 ) << section.allocations / n
+       << setw(11) << section.allocatedBytes / n / 1024. << setprecision( 3 ) << endl;
+  }
+  os.flags( flags );
+  os.precision( precision );
+}
+
+bool EUTelProfiler::writeSummary(const string & filename) {
+
+  endEvent();
+
+  ofstream file( filename.c_str() );
+  if ( ! file.is_open() ) return false;
+
+  file << "section,events,mean_ms,median_ms,p90_ms,p99_ms,max_ms,cpu_ms,total_s,allocations,kB\n";
+  for ( size_t i = 0; i < _sections.size(); ++i ) {
+    const Section & section = _sections[i];
+    if ( section.nEvents == 0 ) continue;
+    double n = static_cast< double >( section.nEvents );
+    file << section.name << "," << section.nEvents << ","
+         << 1000. * section.wallTime / n << ","
+         << 1000. * quantile( section, 0.5 ) << ","
+         << 1000. * quantile( section, 0.9 ) << ","
+         << 1000. * quantile( section, 0.99 ) << ","
+         << 1000. * section.maxWallTime << ","
+         << 1000. * section.cpuTime / n << ","
+         << section.wallTime << ","
+         << section.allocations / n << ","
+         << section.allocatedBytes / n / 1024. << "\n";
+  }
+  return true;
+}
@@ -213,12 +213,10 @@ void EUTelRawDataSparsifier::processEvent (LCEvent * event) {
             float data      = (*rawIter) - (*pedIter);
             float threshold = sigmaCut * (*noiseIter);
             if ( data > threshold  ) {
-              auto_ptr<EUTelSimpleSparsePixel> sparsePixel( new EUTelSimpleSparsePixel );
-              sparsePixel->setXCoord( matrixDecoder.getXFromIndex(iPixel) );
-              sparsePixel->setYCoord( matrixDecoder.getYFromIndex(iPixel) );
-              sparsePixel->setSignal( static_cast<short> ( data ) );
-              streamlog_out ( DEBUG0 ) << (*sparsePixel.get()) << endl;
-              sparseData.addSparsePixel( sparsePixel.get() );
+              const short xCoord = matrixDecoder.getXFromIndex(iPixel);
+              const short yCoord = matrixDecoder.getYFromIndex(iPixel);
+              streamlog_out ( DEBUG0 ) << "x " << xCoord << " y " << yCoord << " signal " << data << endl;
+              sparseData.addSparsePixel( xCoord, yCoord, static_cast<short> ( data ) );
             }
           }
           ++rawIter;
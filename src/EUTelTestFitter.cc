@@ -18,6 +18,7 @@
 #include "EUTelRunHeaderImpl.h"
 #include "EUTelHistogramManager.h"
 #include "EUTelExceptions.h"
+#include "EUTelHitStore.h"
 #include "EUTelReferenceHit.h"
 
 
@@ -157,6 +158,7 @@ EUTelTestFitter::EUTelTestFitter()
   _planeX0(NULL),
   _planeResolution(NULL),
   _isActive(NULL),
+  _sensorIDToPlane(),
   _planeWindowIDs(NULL),
   _planeMaskIDs(NULL),
   _nRun(0),
@@ -574,6 +576,7 @@ void EUTelTestFitter::init() {
       _planeX0[iz]=_siPlanesLayerLayout->getDUTRadLength();
       resolution = _siPlanesLayerLayout->getDUTSensitiveResolution();
     }
+    _sensorIDToPlane[ _planeID[iz] ] = iz;
 
     iActive = (resolution > 0);
 
@@ -1086,6 +1089,10 @@ void EUTelTestFitter::processEvent( LCEvent * event ) {
 
   IntVec * planeHitID   = new IntVec[_nTelPlanes];
 
+  // the sensors of the hits are guessed once per event for all the
+  // processors using the same collection
+  const EUTelHitStore & hitStore = EUTelHitStore::get( event, _inputColName );
+
   // Loop over hits
 
   int nGoodHit = 0;
@@ -1123,7 +1130,23 @@ void EUTelTestFitter::processEvent( LCEvent * event ) {
     double distMin =  1.;
     hitPlane[ihit] = -1 ;
 
-    for(int ipl=0;ipl<_nTelPlanes;ipl++)  
+    // the hits placed by the hit store only need to be checked
+    // against their plane; the DUT and the simulated hits are not in
+    // the store and need the full search
+    bool fromStore = false;
+    map< int, int >::const_iterator storePlane = _sensorIDToPlane.find( hitStore.getHitSensorID( ihit ) );
+    if( storePlane != _sensorIDToPlane.end() )
+    {
+      double dist =  hitZ[ihit] - _planePosition[storePlane->second] ;
+      if( dist < 0 ) dist = -dist;
+      if( dist < distMin )
+      {
+        hitPlane[ihit] = storePlane->second;
+        fromStore      = true;
+      }
+    }
+
+    for(int ipl=0;ipl<_nTelPlanes && ! fromStore;ipl++)  
     {
       double dist =  hitZ[ihit] - _planePosition[ipl] ;
       if( dist < 0 ) dist = -dist; // always positive defined !
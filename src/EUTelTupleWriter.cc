@@ -0,0 +1,453 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#if defined(USE_ROOT) || defined(MARLIN_USE_ROOT)
+
+// personal includes ".h"
+#include "EUTelTupleWriter.h"
+
+// marlin includes ".h"
+#include "marlin/Processor.h"
+
+// lcio includes <.h>
+#include <Exceptions.h>
+
+// ROOT includes
+#include <TFile.h>
+#include <TTree.h>
+#include <TDirectory.h>
+#include <TThread.h>
+
+// system includes <>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace eutelescope;
+
+namespace eutelescope {
+
+  //! A block of rows of one EUTelTupleTree, stored column by column
+  /*! Scalar integer columns use longs, scalar double columns use
+   *  doubles. Vector columns are flattened in ints or doubles and
+   *  rowEnds holds, for each row, the end of its values.
+   */
+  struct EUTelTupleBlock {
+
+    struct ColumnData {
+      vector<Long64_t> longs;
+      vector<double>   doubles;
+      vector<int>      ints;
+      vector<size_t>   rowEnds;
+
+      void clear() {
+        longs.clear();
+        doubles.clear();
+        ints.clear();
+        rowEnds.clear();
+      }
+    };
+
+    EUTelTupleBlock() : tree(0), nRows(0), columns() { }
+
+    //! Prepare the block for a new tree, keeping the allocated memory
+    void reset(EUTelTupleTree * newTree, size_t nColumns) {
+      tree  = newTree;
+      nRows = 0;
+      if ( columns.size() < nColumns ) columns.resize( nColumns );
+      for ( size_t iCol = 0; iCol < columns.size(); ++iCol ) columns[ iCol ].clear();
+    }
+
+    EUTelTupleTree * tree;
+    size_t nRows;
+    vector<ColumnData> columns;
+  };
+
+}
+
+EUTelTupleTree::EUTelTupleTree(EUTelTupleFile * file, const string & name, const string & title) :
+  _file(file),
+  _name(name),
+  _tree(0),
+  _columns(),
+  _block(0),
+  _rows(0) {
+
+  _tree = new TTree( name.c_str(), title.c_str() );
+
+}
+
+EUTelTupleTree::~EUTelTupleTree() {
+
+  for ( size_t iCol = 0; iCol < _columns.size(); ++iCol ) {
+    delete _columns[ iCol ].intVectorBranch;
+    delete _columns[ iCol ].doubleVectorBranch;
+  }
+  delete _block;
+
+}
+
+int EUTelTupleTree::addColumn(const string & name, ColumnType type) {
+
+  if ( _file->_isStarted ) {
+    throw lcio::Exception( "EUTelTupleTree: column " + name + " booked on " + _name + " after the file was started" );
+  }
+
+  Column column;
+  column.name               = name;
+  column.type               = type;
+  column.longValue          = 0;
+  column.doubleValue        = 0;
+  column.intBranch          = 0;
+  column.longBranch         = 0;
+  column.doubleBranch       = 0;
+  column.intVectorBranch    = 0;
+  column.doubleVectorBranch = 0;
+  _columns.push_back( column );
+
+  return static_cast< int >( _columns.size() ) - 1;
+
+}
+
+void EUTelTupleTree::book(int basketSize, Long64_t autoFlush) {
+
+  // the branch addresses point into _columns: it is not resized
+  // any more from now on
+  for ( size_t iCol = 0; iCol < _columns.size(); ++iCol ) {
+    Column& column = _columns[ iCol ];
+    const char * name = column.name.c_str();
+    switch ( column.type ) {
+    case kInt:
+      _tree->Branch( name, &column.intBranch, ( column.name + "/I" ).c_str(), basketSize );
+      break;
+    case kLong:
+      _tree->Branch( name, &column.longBranch, ( column.name + "/L" ).c_str(), basketSize );
+      break;
+    case kDouble:
+      _tree->Branch( name, &column.doubleBranch, ( column.name + "/D" ).c_str(), basketSize );
+      break;
+    case kIntVector:
+      column.intVectorBranch = new vector<int>;
+      _tree->Branch( name, &column.intVectorBranch, basketSize );
+      break;
+    case kDoubleVector:
+      column.doubleVectorBranch = new vector<double>;
+      _tree->Branch( name, &column.doubleVectorBranch, basketSize );
+      break;
+    }
+  }
+
+  _tree->SetAutoFlush( autoFlush );
+
+}
+
+void EUTelTupleTree::prepareBlock() {
+
+  if ( _block == 0 ) {
+    _block = _file->getBlock();
+    _block->reset( this, _columns.size() );
+  }
+
+}
+
+void EUTelTupleTree::fill(int column, int value) {
+  _columns[ column ].longValue   = value;
+  _columns[ column ].doubleValue = value;
+}
+
+void EUTelTupleTree::fill(int column, long value) {
+  _columns[ column ].longValue   = value;
+  _columns[ column ].doubleValue = value;
+}
+
+void EUTelTupleTree::fill(int column, float value) {
+  _columns[ column ].longValue   = static_cast< Long64_t >( value );
+  _columns[ column ].doubleValue = value;
+}
+
+void EUTelTupleTree::fill(int column, double value) {
+  _columns[ column ].longValue   = static_cast< Long64_t >( value );
+  _columns[ column ].doubleValue = value;
+}
+
+void EUTelTupleTree::fill(int column, const vector<int> & values) {
+
+  prepareBlock();
+  EUTelTupleBlock::ColumnData& data = _block->columns[ column ];
+  if ( _columns[ column ].type == kIntVector ) {
+    data.ints.insert( data.ints.end(), values.begin(), values.end() );
+  } else {
+    data.doubles.insert( data.doubles.end(), values.begin(), values.end() );
+  }
+
+}
+
+void EUTelTupleTree::fill(int column, const vector<double> & values) {
+
+  prepareBlock();
+  EUTelTupleBlock::ColumnData& data = _block->columns[ column ];
+  if ( _columns[ column ].type == kDoubleVector ) {
+    data.doubles.insert( data.doubles.end(), values.begin(), values.end() );
+  } else {
+    for ( size_t i = 0; i < values.size(); ++i ) data.ints.push_back( static_cast< int >( values[ i ] ) );
+  }
+
+}
+
+void EUTelTupleTree::addRow() {
+
+  prepareBlock();
+
+  for ( size_t iCol = 0; iCol < _columns.size(); ++iCol ) {
+    Column& column = _columns[ iCol ];
+    EUTelTupleBlock::ColumnData& data = _block->columns[ iCol ];
+    switch ( column.type ) {
+    case kInt:
+    case kLong:
+      data.longs.push_back( column.longValue );
+      break;
+    case kDouble:
+      data.doubles.push_back( column.doubleValue );
+      break;
+    case kIntVector:
+      data.rowEnds.push_back( data.ints.size() );
+      break;
+    case kDoubleVector:
+      data.rowEnds.push_back( data.doubles.size() );
+      break;
+    }
+    column.longValue   = 0;
+    column.doubleValue = 0;
+  }
+
+  ++_block->nRows;
+  ++_rows;
+
+  if ( _block->nRows >= _file->getRowsPerBlock() ) flush();
+
+}
+
+void EUTelTupleTree::flush() {
+
+  if ( _block == 0 ) return;
+
+  EUTelTupleBlock * block = _block;
+  _block = 0;
+
+  if ( block->nRows == 0 ) {
+    // only vector values of an uncommitted row, drop them
+    _file->writeBlock( block );
+    return;
+  }
+  _file->submit( block );
+
+}
+
+void EUTelTupleTree::writeBlock(EUTelTupleBlock * block) {
+
+  for ( size_t iRow = 0; iRow < block->nRows; ++iRow ) {
+
+    for ( size_t iCol = 0; iCol < _columns.size(); ++iCol ) {
+      Column& column = _columns[ iCol ];
+      const EUTelTupleBlock::ColumnData& data = block->columns[ iCol ];
+      size_t begin = ( iRow == 0 || data.rowEnds.empty() ) ? 0 : data.rowEnds[ iRow - 1 ];
+      switch ( column.type ) {
+      case kInt:
+        column.intBranch = static_cast< Int_t >( data.longs[ iRow ] );
+        break;
+      case kLong:
+        column.longBranch = data.longs[ iRow ];
+        break;
+      case kDouble:
+        column.doubleBranch = data.doubles[ iRow ];
+        break;
+      case kIntVector:
+        column.intVectorBranch->assign( data.ints.begin() + begin, data.ints.begin() + data.rowEnds[ iRow ] );
+        break;
+      case kDoubleVector:
+        column.doubleVectorBranch->assign( data.doubles.begin() + begin, data.doubles.begin() + data.rowEnds[ iRow ] );
+        break;
+      }
+    }
+
+    _tree->Fill();
+  }
+
+}
+
+
+EUTelTupleFile::EUTelTupleFile(const string & fileName) :
+  _fileName(fileName),
+  _file(0),
+  _trees(),
+  _basketSize(32000),
+  _autoFlush(-30000000),
+  _rowsPerBlock(1000),
+  _useBackgroundWriting(false),
+  _queueSize(4),
+  _fullBlocks(0),
+  _freeBlocks(0),
+  _writerThread(),
+  _isWriterThreadRunning(false),
+  _isStarted(false) {
+
+  TDirectory * previousDir = gDirectory;
+  _file = new TFile( fileName.c_str(), "RECREATE" );
+  if ( _file->IsZombie() ) {
+    delete _file;
+    _file = 0;
+    if ( previousDir ) previousDir->cd();
+    throw lcio::IOException( "EUTelTupleFile: unable to open " + fileName );
+  }
+  if ( previousDir ) previousDir->cd();
+
+}
+
+EUTelTupleFile::~EUTelTupleFile() {
+
+  close();
+
+}
+
+EUTelTupleTree * EUTelTupleFile::addTree(const string & name, const string & title) {
+
+  if ( _isStarted ) {
+    throw lcio::Exception( "EUTelTupleFile: tree " + name + " booked after the file was started" );
+  }
+
+  TDirectory * previousDir = gDirectory;
+  _file->cd();
+  EUTelTupleTree * tree = new EUTelTupleTree( this, name, title );
+  if ( previousDir ) previousDir->cd();
+
+  _trees.push_back( tree );
+  return tree;
+
+}
+
+void EUTelTupleFile::start() {
+
+  if ( _isStarted || _file == 0 ) return;
+
+  TDirectory * previousDir = gDirectory;
+  _file->cd();
+  for ( size_t iTree = 0; iTree < _trees.size(); ++iTree ) {
+    _trees[ iTree ]->book( _basketSize, _autoFlush );
+  }
+  if ( previousDir ) previousDir->cd();
+
+  // blocks in flight: one per tree being filled, the full ones
+  // waiting and the one being written
+  _freeBlocks = new EUTelBoundedQueue<EUTelTupleBlock *>( _trees.size() + _queueSize + 1 );
+  _isStarted  = true;
+
+  if ( !_useBackgroundWriting ) return;
+
+  // ROOT is used from two threads from now on
+  TThread::Initialize();
+
+  _fullBlocks = new EUTelBoundedQueue<EUTelTupleBlock *>( _queueSize );
+  int status = pthread_create( &_writerThread, 0, &EUTelTupleFile::writerThreadEntry, this );
+  if ( status != 0 ) {
+    streamlog_out( WARNING2 ) << "Unable to start the writer thread of " << _fileName
+                              << " (error " << status << "), writing in the foreground" << endl;
+    delete _fullBlocks;
+    _fullBlocks = 0;
+    _useBackgroundWriting = false;
+    return;
+  }
+  _isWriterThreadRunning = true;
+
+}
+
+EUTelTupleBlock * EUTelTupleFile::getBlock() {
+
+  EUTelTupleBlock * block = 0;
+  if ( _freeBlocks != 0 && _freeBlocks->tryPop( block ) ) return block;
+  return new EUTelTupleBlock;
+
+}
+
+void EUTelTupleFile::submit(EUTelTupleBlock * block) {
+
+  if ( _isWriterThreadRunning && _fullBlocks->push( block ) ) return;
+  writeBlock( block );
+
+}
+
+void EUTelTupleFile::writeBlock(EUTelTupleBlock * block) {
+
+  block->tree->writeBlock( block );
+  block->reset( 0, 0 );
+  if ( _freeBlocks == 0 || !_freeBlocks->tryPush( block ) ) delete block;
+
+}
+
+void EUTelTupleFile::writeBehind() {
+
+  EUTelTupleBlock * block = 0;
+  while ( _fullBlocks->pop( block ) ) {
+    writeBlock( block );
+  }
+
+}
+
+void * EUTelTupleFile::writerThreadEntry(void * self) {
+
+  static_cast< EUTelTupleFile * >( self )->writeBehind();
+  return 0;
+
+}
+
+void EUTelTupleFile::close() {
+
+  if ( _file == 0 ) return;
+
+  if ( _isStarted ) {
+    for ( size_t iTree = 0; iTree < _trees.size(); ++iTree ) {
+      _trees[ iTree ]->flush();
+    }
+  }
+
+  if ( _isWriterThreadRunning ) {
+    _fullBlocks->close();
+    pthread_join( _writerThread, 0 );
+    _isWriterThreadRunning = false;
+  }
+
+  TDirectory * previousDir = gDirectory;
+  _file->cd();
+  _file->Write();
+  _file->Close();
+  if ( previousDir && previousDir != _file ) previousDir->cd();
+  delete _file;
+  _file = 0;
+
+  // the TTree objects were owned and deleted by the file
+  for ( size_t iTree = 0; iTree < _trees.size(); ++iTree ) {
+    _trees[ iTree ]->_tree = 0;
+    delete _trees[ iTree ];
+  }
+  _trees.clear();
+
+  EUTelTupleBlock * block = 0;
+  if ( _freeBlocks != 0 ) {
+    while ( _freeBlocks->tryPop( block ) ) delete block;
+  }
+  delete _freeBlocks;
+  _freeBlocks = 0;
+  delete _fullBlocks;
+  _fullBlocks = 0;
+
+  _isStarted = false;
+
+}
+
+#endif // USE_ROOT || MARLIN_USE_ROOT
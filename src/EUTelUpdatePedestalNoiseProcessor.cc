@@ -62,7 +62,12 @@ EUTelUpdatePedestalNoiseProcessor::EUTelUpdatePedestalNoiseProcessor ()
   _fixedWeight(0),
   _iRun(0),
   _iEvt(0),
-  _noOfConsecutiveMissing(0){
+  _noOfConsecutiveMissing(0),
+  _detectorState(),
+  _cachedPedestalCollection(NULL),
+  _cachedNoiseCollection(NULL),
+  _cachedStatusCollection(NULL),
+  _cachedRunNumber(-1){
 
   // modify processor description
   _description =
@@ -90,7 +95,7 @@ EUTelUpdatePedestalNoiseProcessor::EUTelUpdatePedestalNoiseProcessor ()
                              _updateAlgo, string(EUTELESCOPE::FIXEDWEIGHT));
 
   registerProcessorParameter("UpdateFrequency",
-                             "How often the algorithm should be applied",
+                             "How often the algorithm should be applied (every N events)",
                              _updateFrequency, static_cast<int>(10));
 
   registerOptionalParameter("FixedWeightValue",
@@ -157,6 +162,13 @@ void EUTelUpdatePedestalNoiseProcessor::processRunHeader (LCRunHeader * rdr ) {
   // reset the event counter
   _iEvt = 0;
 
+  // the conditions may change with the run
+  _detectorState.clear();
+  _cachedPedestalCollection = NULL;
+  _cachedNoiseCollection    = NULL;
+  _cachedStatusCollection   = NULL;
+  _cachedRunNumber          = -1;
+
 }
 
 
@@ -281,26 +293,33 @@ void EUTelUpdatePedestalNoiseProcessor::fixedWeightUpdate(LCEvent * evt) {
 
     _noOfConsecutiveMissing = 0;
 
+    if ( ! updateDetectorCache( evt->getRunNumber(), pedestalCollection, noiseCollection, statusCollection ) ) {
+      streamlog_out( WARNING2 ) << "Pedestal, noise or status object missing, not updating" << endl;
+      return;
+    }
+
+    const float weight = static_cast< float >( _fixedWeight );
+
     for (int i = 0; i < rawDataCollection->getNumberOfElements(); i++) {
 
       TrackerRawDataImpl * rawData  = dynamic_cast < TrackerRawDataImpl * > (rawDataCollection->getElementAt(i));
       int iDetector = static_cast<int > ( rawDataDecoder( rawData )["sensorID"] ) ;
 
+      if ( iDetector < 0 || static_cast< size_t >( iDetector ) >= _detectorState.size()
+           || _detectorState[iDetector].status == NULL ) {
+        streamlog_out( WARNING2 ) << "No pedestal and noise for sensor " << iDetector << endl;
+        continue;
+      }
+      DetectorState & state = _detectorState[iDetector];
 
-      TrackerRawDataImpl * status   = dynamic_cast < TrackerRawDataImpl * > (statusCollection->getElementAt(iDetector));
-      TrackerDataImpl    * noise    = dynamic_cast < TrackerDataImpl * >    (noiseCollection->getElementAt(iDetector));
-      TrackerDataImpl    * pedestal = dynamic_cast < TrackerDataImpl * >    (pedestalCollection->getElementAt(iDetector));
-
-      for (unsigned int iPixel = 0; iPixel < status->adcValues().size(); iPixel++) {
+      const ShortVec & adcValues = rawData->getADCValues();
+      size_t nPixel = state.nPixel;
+      if ( adcValues.size() < nPixel ) nPixel = adcValues.size();
+      if ( nPixel == 0 ) continue;
 
-        if ( status->adcValues()[iPixel] == EUTELESCOPE::GOODPIXEL ) {
-          pedestal->chargeValues()[iPixel] = ( (_fixedWeight - 1) * pedestal->chargeValues()[iPixel] +
-                                               rawData->getADCValues()[iPixel] ) / _fixedWeight;
-          noise->chargeValues()[iPixel]    = sqrt( ( (_fixedWeight - 1) * pow( noise->chargeValues()[iPixel], 2 ) +
-                                                     pow( rawData->getADCValues()[iPixel] - pedestal->chargeValues()[iPixel], 2) ) /
-                                                   _fixedWeight );
-        }
-      }
+      fixedWeightKernel( &adcValues[0], &state.status->adcValues()[0],
+                         &state.pedestal->chargeValues()[0], &state.noise->chargeValues()[0],
+                         nPixel, weight );
     }
   }  catch ( DataNotAvailableException& e) {
     if ( _noOfConsecutiveMissing <= _maxNoOfConsecutiveMissing ) {
@@ -316,6 +335,83 @@ void EUTelUpdatePedestalNoiseProcessor::fixedWeightUpdate(LCEvent * evt) {
 
 
 
+bool EUTelUpdatePedestalNoiseProcessor::updateDetectorCache(int runNumber,
+                                                            LCCollectionVec * pedestalCollection,
+                                                            LCCollectionVec * noiseCollection,
+                                                            LCCollectionVec * statusCollection) {
+
+  // the conditions are valid for a whole run: a collection at the
+  // address of a deleted one, with as many elements, is only trusted
+  // within the same run
+  if ( runNumber          == _cachedRunNumber          &&
+       pedestalCollection == _cachedPedestalCollection &&
+       noiseCollection    == _cachedNoiseCollection    &&
+       statusCollection   == _cachedStatusCollection   &&
+       static_cast< int >( _detectorState.size() ) == statusCollection->getNumberOfElements() ) {
+    return true;
+  }
+
+  _detectorState.clear();
+  _cachedPedestalCollection = NULL;
+  _cachedNoiseCollection    = NULL;
+  _cachedStatusCollection   = NULL;
+  _cachedRunNumber          = -1;
+
+  // the objects are indexed by sensorID, as they always have been
+  // by this processor
+  const int nDetector = statusCollection->getNumberOfElements();
+  if ( pedestalCollection->getNumberOfElements() < nDetector ||
+       noiseCollection->getNumberOfElements()    < nDetector ) return false;
+
+  _detectorState.resize( nDetector );
+  for ( int iDetector = 0; iDetector < nDetector; ++iDetector ) {
+    DetectorState & state = _detectorState[iDetector];
+    state.status   = dynamic_cast < TrackerRawDataImpl * > (statusCollection->getElementAt(iDetector));
+    state.pedestal = dynamic_cast < TrackerDataImpl * >    (pedestalCollection->getElementAt(iDetector));
+    state.noise    = dynamic_cast < TrackerDataImpl * >    (noiseCollection->getElementAt(iDetector));
+    if ( state.status == NULL || state.pedestal == NULL || state.noise == NULL ) {
+      _detectorState.clear();
+      return false;
+    }
+    state.nPixel = state.status->adcValues().size();
+    if ( state.pedestal->chargeValues().size() < state.nPixel ) state.nPixel = state.pedestal->chargeValues().size();
+    if ( state.noise->chargeValues().size()    < state.nPixel ) state.nPixel = state.noise->chargeValues().size();
+  }
+
+  _cachedPedestalCollection = pedestalCollection;
+  _cachedNoiseCollection    = noiseCollection;
+  _cachedStatusCollection   = statusCollection;
+  _cachedRunNumber          = runNumber;
+  return true;
+}
+
+void EUTelUpdatePedestalNoiseProcessor::fixedWeightKernel(const short * adc, const short * status,
+                                                          float * pedestal, float * noise,
+                                                          size_t nPixel, float weight) {
+
+  // P' = P + (D - P) / W and N'^2 = N^2 + ((D - P')^2 - N^2) / W,
+  // the same as the weighted averages with (W - 1) / W and 1 / W
+  const float invWeight = 1.f / weight;
+  const short goodPixel = static_cast< short >( EUTELESCOPE::GOODPIXEL );
+
+  for ( size_t iPixel = 0; iPixel < nPixel; ++iPixel ) {
+    // 1 for good pixels, 0 for the others
+    const float good   = static_cast< float >( status[iPixel] == goodPixel );
+    const float signal = static_cast< float >( adc[iPixel] );
+
+    const float oldPede  = pedestal[iPixel];
+    const float newPede  = oldPede + good * invWeight * ( signal - oldPede );
+    const float residual = signal - newPede;
+
+    const float oldNoise  = noise[iPixel];
+    const float oldNoise2 = oldNoise * oldNoise;
+    const float newNoise  = std::sqrt( oldNoise2 + invWeight * ( residual * residual - oldNoise2 ) );
+
+    pedestal[iPixel] = newPede;
+    noise[iPixel]    = oldNoise + good * ( newNoise - oldNoise );
+  }
+}
+
 void EUTelUpdatePedestalNoiseProcessor::end() {
 
   if ( _monitoredPixelPedestal.size() == 0 ) {
@@ -21,6 +21,7 @@
 #include <EVENT/LCEvent.h>
 
 #include <cstdio>
+#include <time.h>
 
 namespace eutelescope {
 
@@ -387,6 +388,18 @@ namespace eutelescope {
 
                 return X;
         }
+
+        double getWallTime() {
+                timespec now;
+                clock_gettime( CLOCK_MONOTONIC, &now );
+                return now.tv_sec + 1e-9 * now.tv_nsec;
+        }
+
+        double getCPUTime() {
+                timespec now;
+                clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &now );
+                return now.tv_sec + 1e-9 * now.tv_nsec;
+        }
         
     }
 }
@@ -0,0 +1,72 @@
+#include "EUTelUtilityProfiler.h"
+#include "EUTelProfiler.h"
+
+// C++
+#include <iostream>
+#include <sstream>
+
+using namespace lcio;
+using namespace marlin;
+using namespace eutelescope;
+
+EUTelUtilityProfiler aEUTelUtilityProfiler ;
+
+bool EUTelUtilityProfiler::_summaryPrinted = false;
+
+
+EUTelUtilityProfiler::EUTelUtilityProfiler() : 
+  Processor("EUTelUtilityProfiler"),
+  _sectionName(""),
+  _eventLogFile(""),
+  _summaryFile("")
+{
+  _description = "EUTelUtilityProfiler records the time and memory allocations spent"
+    " in the processors since the previous EUTelUtilityProfiler" ;	
+	
+  registerOptionalParameter( "SectionName", 
+			     "Name of the section ending at this checkpoint, the processor name if empty",
+			     _sectionName, std::string(""));
+  registerOptionalParameter( "EventLogFile",
+			     "CSV file where the measurements of every event are written, none if empty",
+			     _eventLogFile, std::string(""));
+  registerOptionalParameter( "SummaryFile",
+			     "CSV file where the profile of the job is written at the end, none if empty",
+			     _summaryFile, std::string(""));
+}
+    
+    
+void EUTelUtilityProfiler::init() { 
+  // this method is called only once even when the rewind is active
+
+  printParameters ();	
+
+  if ( _sectionName.empty() ) _sectionName = name();
+
+  EUTelProfiler & profiler = EUTelProfiler::instance();
+  profiler.setEnabled( true );
+  if ( ! _eventLogFile.empty() && ! profiler.openEventLog( _eventLogFile ) ) {
+    streamlog_out( ERROR4 ) << "Cannot create the profile file " << _eventLogFile << std::endl;
+  }
+  if ( ! profiler.hasAllocationHook() ) {
+    streamlog_out( MESSAGE4 ) << "The allocation hook library is not preloaded, the allocations will not be counted" << std::endl;
+  }
+}
+    
+void EUTelUtilityProfiler::processRunHeader( LCRunHeader* /* run */ ) { 
+  /* Nothing to do here... */
+} 
+    
+void EUTelUtilityProfiler::processEvent( LCEvent * evt ) { 
+  EUTelProfiler::instance().checkpoint( _sectionName, evt->getRunNumber(), evt->getEventNumber() );
+}
+    
+void EUTelUtilityProfiler::end(){ 
+  if ( ! _summaryFile.empty() && ! EUTelProfiler::instance().writeSummary( _summaryFile ) ) {
+    streamlog_out( ERROR4 ) << "Cannot create the profile summary file " << _summaryFile << std::endl;
+  }
+  if ( _summaryPrinted ) return;
+  _summaryPrinted = true;
+  std::ostringstream summary;
+  EUTelProfiler::instance().printSummary( summary );
+  streamlog_out( MESSAGE4 ) << summary.str();
+}
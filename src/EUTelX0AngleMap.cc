@@ -0,0 +1,175 @@
+// Version: $Id$
+/*
+ * This source code is part of the Eutelescope package of Marlin.
+ * You are free to use this source files for your own development as
+ * long as it stays in a public research context. You are not
+ * allowed to use it for commercial purpose. You must put this
+ * header with author names in all development based on this file.
+ */
+
+#include "EUTelX0AngleMap.h"
+
+//  System includes
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace eutelescope;
+using namespace std;
+
+EUTelX0AngleMap::EUTelX0AngleMap()
+  : _nBinsX(0),
+  _nBinsY(0),
+  _nAngleBins(0),
+  _minAngle(0.0),
+  _maxAngle(0.0),
+  _entries(),
+  _sum(),
+  _sum2(),
+  _angleCounts()
+{
+}
+
+void EUTelX0AngleMap::setGeometry(int nBinsX, int nBinsY, int nAngleBins, double minAngle, double maxAngle){
+  _nBinsX = ( nBinsX > 0 ) ? nBinsX : 0;
+  _nBinsY = ( nBinsY > 0 ) ? nBinsY : 0;
+  _nAngleBins = ( nAngleBins > 0 ) ? nAngleBins : 1;
+  _minAngle = minAngle;
+  _maxAngle = maxAngle;
+
+  const size_t nBins = static_cast< size_t >( _nBinsX ) * _nBinsY;
+  _entries.assign(nBins, 0);
+  _sum.assign(nBins, 0.0);
+  _sum2.assign(nBins, 0.0);
+  _angleCounts.assign(nBins * ( _nAngleBins + 2 ), 0);
+}
+
+int EUTelX0AngleMap::getIndex(int xBin, int yBin) const {
+  if(xBin < 0 || xBin >= _nBinsX || yBin < 0 || yBin >= _nBinsY) return -1;
+  return xBin * _nBinsY + yBin;
+}
+
+void EUTelX0AngleMap::fill(int xBin, int yBin, double angle){
+  const int index = getIndex(xBin, yBin);
+  if(index < 0) return;
+
+  ++_entries[index];
+  _sum[index] += angle;
+  _sum2[index] += angle * angle;
+
+  // same binning convention as TH1::FindBin
+  int angleBin;
+  if(angle < _minAngle) angleBin = 0;
+  else if(!(angle < _maxAngle)) angleBin = _nAngleBins + 1;
+  else angleBin = 1 + static_cast< int >( _nAngleBins * ( angle - _minAngle ) / ( _maxAngle - _minAngle ) );
+  if(angleBin > _nAngleBins + 1) angleBin = _nAngleBins + 1;
+  ++_angleCounts[ static_cast< size_t >( index ) * ( _nAngleBins + 2 ) + angleBin ];
+}
+
+bool EUTelX0AngleMap::merge(const EUTelX0AngleMap & other){
+  if(other._nBinsX != _nBinsX || other._nBinsY != _nBinsY || other._nAngleBins != _nAngleBins
+     || other._minAngle != _minAngle || other._maxAngle != _maxAngle) return false;
+
+  for(size_t i = 0; i < _entries.size(); ++i){
+    _entries[i] += other._entries[i];
+    _sum[i] += other._sum[i];
+    _sum2[i] += other._sum2[i];
+  }
+  for(size_t i = 0; i < _angleCounts.size(); ++i){
+    _angleCounts[i] += other._angleCounts[i];
+  }
+  return true;
+}
+
+unsigned long long EUTelX0AngleMap::getEntries(int xBin, int yBin) const {
+  const int index = getIndex(xBin, yBin);
+  return ( index < 0 ) ? 0 : _entries[index];
+}
+
+double EUTelX0AngleMap::getMean(int xBin, int yBin) const {
+  const int index = getIndex(xBin, yBin);
+  if(index < 0 || _entries[index] == 0) return 0.0;
+  return _sum[index] / _entries[index];
+}
+
+double EUTelX0AngleMap::getRMS(int xBin, int yBin) const {
+  const int index = getIndex(xBin, yBin);
+  if(index < 0 || _entries[index] == 0) return 0.0;
+  const double mean = _sum[index] / _entries[index];
+  const double variance = _sum2[index] / _entries[index] - mean * mean;
+  return ( variance > 0 ) ? sqrt(variance) : 0.0;
+}
+
+double EUTelX0AngleMap::getQuantile(int xBin, int yBin, double fraction) const {
+  const int index = getIndex(xBin, yBin);
+  if(index < 0 || _entries[index] == 0) return 0.0;
+
+  const unsigned int * counts = getAngleHistogram(xBin, yBin);
+  const double binWidth = ( _maxAngle - _minAngle ) / _nAngleBins;
+  const double target = fraction * _entries[index];
+
+  double cumulative = counts[0];
+  if(cumulative >= target) return _minAngle;
+  for(int bin = 1; bin <= _nAngleBins; ++bin){
+    if(counts[bin] > 0 && cumulative + counts[bin] >= target){
+      return _minAngle + binWidth * ( bin - 1 + ( target - cumulative ) / counts[bin] );
+    }
+    cumulative += counts[bin];
+  }
+  return _maxAngle;
+}
+
+const unsigned int * EUTelX0AngleMap::getAngleHistogram(int xBin, int yBin) const {
+  const int index = getIndex(xBin, yBin);
+  if(index < 0) return NULL;
+  return &_angleCounts[ static_cast< size_t >( index ) * ( _nAngleBins + 2 ) ];
+}
+
+void EUTelX0AngleMap::write(ostream & os, const string & name) const {
+  os.precision(17);
+  os << "EUTelX0AngleMap " << name << " " << _nBinsX << " " << _nBinsY << " "
+     << _nAngleBins << " " << _minAngle << " " << _maxAngle << "\n";
+
+  size_t nonEmpty = 0;
+  for(size_t i = 0; i < _entries.size(); ++i) if(_entries[i] > 0) ++nonEmpty;
+  os << nonEmpty << "\n";
+
+  for(size_t i = 0; i < _entries.size(); ++i){
+    if(_entries[i] == 0) continue;
+    const unsigned int * counts = &_angleCounts[ i * ( _nAngleBins + 2 ) ];
+    int filledBins = 0;
+    for(int bin = 0; bin < _nAngleBins + 2; ++bin) if(counts[bin] > 0) ++filledBins;
+
+    // bin, moments, then the filled histogram bins as (bin count) pairs
+    os << i << " " << _entries[i] << " " << _sum[i] << " " << _sum2[i] << " " << filledBins;
+    for(int bin = 0; bin < _nAngleBins + 2; ++bin){
+      if(counts[bin] > 0) os << " " << bin << " " << counts[bin];
+    }
+    os << "\n";
+  }
+}
+
+bool EUTelX0AngleMap::read(istream & is, string & name){
+  string tag;
+  int nBinsX, nBinsY, nAngleBins;
+  double minAngle, maxAngle;
+  if(!( is >> tag >> name >> nBinsX >> nBinsY >> nAngleBins >> minAngle >> maxAngle ) || tag != "EUTelX0AngleMap") return false;
+  setGeometry(nBinsX, nBinsY, nAngleBins, minAngle, maxAngle);
+
+  size_t nonEmpty;
+  if(!( is >> nonEmpty )) return false;
+  for(size_t iBin = 0; iBin < nonEmpty; ++iBin){
+    size_t i;
+    int filledBins;
+    if(!( is >> i ) || i >= _entries.size()) return false;
+    if(!( is >> _entries[i] >> _sum[i] >> _sum2[i] >> filledBins )) return false;
+    for(int iFilled = 0; iFilled < filledBins; ++iFilled){
+      int bin;
+      unsigned int count;
+      if(!( is >> bin >> count ) || bin < 0 || bin >= _nAngleBins + 2) return false;
+      _angleCounts[ i * ( _nAngleBins + 2 ) + bin ] = count;
+    }
+  }
+  return true;
+}
@@ -1,9 +1,11 @@
 // Version: $Id$
 #include "EUTelX0Processor.h"
+#include "EUTELESCOPE.h"
 #include <cmath>
 #include "TCanvas.h"
 #include "TStyle.h"
 #include <cstdlib>
+#include <algorithm>
 using namespace marlin;
 using namespace eutelescope;
 using namespace std;
@@ -12,6 +14,8 @@ EUTelX0Processor::EUTelX0Processor()
   :Processor("EUTelX0Processor"),
   _beamEnergy(0.0), 
   _dutPosition(0.0),
+  _partialResultsOutputFile(""),
+  _partialResultsInputFiles(),
   _eventNumber(0),
   _histoThing(),
   _histoThing2D(),
@@ -146,7 +150,9 @@ EUTelX0Processor::EUTelX0Processor()
   registerProcessorParameter("RadiationLengthMapMaxY","Used to determine the maximum Y for the radiation length map, measured in XXX", maxy, static_cast< double > (6.0));
   registerProcessorParameter("RadiationLengthMapBinSizeX","Used to determine the spatial resolution in X for the radiation length map, measured in XXX", binsizex, static_cast< double > (1.0));
   registerProcessorParameter("RadiationLengthMapBinSizeY","Used to determine the spatial resolution in Y for the radiation length map, measured in XXX", binsizey, static_cast< double > (1.0));
-  registerProcessorParameter("Cut","This is the maximum allowed distance in X and y between two tracks and where they meet on the DUT", _cut, static_cast< double > (0.0));
+  registerProcessorParameter("Cut","This is the maximum allowed distance in X and y between two tracks and where they meet on the DUT. Front and back double daf tracks are only paired if they are within this distance, each track with at most one other", _cut, static_cast< double > (0.0));
+  registerOptionalParameter("PartialResultsOutputFile","If not empty, the scattering angles accumulated by this job are written to this file at the end, so that they can be merged with the ones of other jobs", _partialResultsOutputFile, string (""));
+  registerOptionalParameter("PartialResultsInputFiles","Files written by other jobs with PartialResultsOutputFile, their scattering angles are added to the ones of this job before making the radiation length maps. The map binning must be the same", _partialResultsInputFiles, std::vector< std::string > ());
 }
 
 void EUTelX0Processor::init()
@@ -163,6 +169,16 @@ void EUTelX0Processor::init()
   binsx = static_cast< int >((maxx-minx)/binsizex);
   binsy = static_cast< int >((maxy-miny)/binsizey);
 
+  //The scattering angles are accumulated in fixed size maps, one more bin is needed for the upper edge
+  for(int k = 1; k < 5; ++k){
+    ScatteringAngleXSingleMapData[k].setGeometry(binsx+1,binsy+1,nobinsangle,minbinangle,maxbinangle);
+    ScatteringAngleYSingleMapData[k].setGeometry(binsx+1,binsy+1,nobinsangle,minbinangle,maxbinangle);
+  }
+  ScatteringAngleXTripleMapData.setGeometry(binsx+1,binsy+1,nobinsangle,minbinangle,maxbinangle);
+  ScatteringAngleYTripleMapData.setGeometry(binsx+1,binsy+1,nobinsangle,minbinangle,maxbinangle);
+  ScatteringAngleXTripleMapDataDaf.setGeometry(binsx+1,binsy+1,nobinsangle,minbinangle,maxbinangle);
+  ScatteringAngleYTripleMapDataDaf.setGeometry(binsx+1,binsy+1,nobinsangle,minbinangle,maxbinangle);
+
   AngleXFrontThreePlanesDoubleDaf = new TH1D("AngleXFrontThreePlanesDoubleDaf", "Angles of Tracks in X Direction relative to the Z Axis for  Three Planes from Double Daf Fitting; \\theta_{x} (rads); Count", nobinsangle,minbinangle,maxbinangle);
   _histoThing["AngleXFrontThreePlanesDoubleDaf"] = AngleXFrontThreePlanesDoubleDaf;
 
@@ -984,17 +1000,17 @@ void EUTelX0Processor::TriplePlaneTrackScatteringAngles(vector< double > scatter
   const double scatteringanglex = scatterx.at(1) - scatterx.at(0);
   const double scatteringangley = scattery.at(1) - scattery.at(0);
 
-  double x1 = hits.at(2).x() + (_dutPosition - hits.at(2).z())*tan(scatterx.at(0));
-  double y1 = hits.at(2).y() + (_dutPosition - hits.at(2).z())*tan(scattery.at(0));
+  const double dutposition = GetDUTPosition(hits);
+  double x1 = hits.at(2).x() + (dutposition - hits.at(2).z())*tan(scatterx.at(0));
+  double y1 = hits.at(2).y() + (dutposition - hits.at(2).z())*tan(scattery.at(0));
   //Name the histograms
   std::stringstream ssscatterx,ssscattery,ssscatterxy;
   if(doubledaf == true){
     ssscatterx << "ScatteringAngleXDoubleDaf";
     ssscattery << "ScatteringAngleYDoubleDaf";
     ssscatterxy << "ScatteringAngleXYDoubleDaf";
-    _dutPosition = hits.at(2).z() + 5.1; //TODO HACK just put in the value for now from run 8876 whilst I test, need to add this variable to my runs.csv list
-    double x2 = hits.at(9).x() + (_dutPosition - hits.at(9).z())*tan(scatterx.at(1));
-    double y2 = hits.at(9).y() + (_dutPosition - hits.at(9).z())*tan(scattery.at(1));
+    double x2 = hits.at(9).x() + (dutposition - hits.at(9).z())*tan(scatterx.at(1));
+    double y2 = hits.at(9).y() + (dutposition - hits.at(9).z())*tan(scattery.at(1));
 
     streamlog_out(DEBUG5) << "x1 = " << x1 << endl;
     streamlog_out(DEBUG5) << "x2 = " << x2 << endl;
@@ -1002,7 +1018,7 @@ void EUTelX0Processor::TriplePlaneTrackScatteringAngles(vector< double > scatter
     streamlog_out(DEBUG5) << "y2 = " << y2 << endl;
     streamlog_out(DEBUG5) << "scatterx(0) = " << scatterx.at(0) << endl;
     streamlog_out(DEBUG5) << "scatterx(1) = " << scatterx.at(1) << endl;
-    streamlog_out(DEBUG5) << "dutPosition = " << _dutPosition << endl;
+    streamlog_out(DEBUG5) << "dutPosition = " << dutposition << endl;
     streamlog_out(DEBUG5) << "_cut = " << _cut << endl << endl;
 
     if(!(x1 < x2 + _cut && x1 > x2 - _cut && y1 < y2 + _cut && y1 > y2 - _cut)){
@@ -1019,12 +1035,11 @@ void EUTelX0Processor::TriplePlaneTrackScatteringAngles(vector< double > scatter
 
   pair< int, int > position(ConversionHitmapToX0map(x1,y1));
   if(doubledaf == true){
-    ScatteringAngleXTripleMapDataDaf[position].push_back(scatteringanglex);
-    ScatteringAngleYTripleMapDataDaf[position].push_back(scatteringangley);
+    ScatteringAngleXTripleMapDataDaf.fill(position.first,position.second,scatteringanglex);
+    ScatteringAngleYTripleMapDataDaf.fill(position.first,position.second,scatteringangley);
   } else{
-    cout << "filling the map data" << endl;
-    ScatteringAngleXTripleMapData[position].push_back(scatteringanglex);
-    ScatteringAngleYTripleMapData[position].push_back(scatteringangley);
+    ScatteringAngleXTripleMapData.fill(position.first,position.second,scatteringanglex);
+    ScatteringAngleYTripleMapData.fill(position.first,position.second,scatteringangley);
   }
   try{
     dynamic_cast< TH1D* >(_histoThing[ssscatterx.str().c_str()])->Fill(scatteringanglex);
@@ -1061,8 +1076,8 @@ void EUTelX0Processor::SinglePlaneTrackScatteringAngles(vector< double > scatter
     double x = hits[i+1].x();
     double y = hits[i+1].y();
     pair< int, int > position(ConversionHitmapToX0map(x,y));
-    ScatteringAngleXSingleMapData[i+1][position].push_back(scatteringanglex);
-    ScatteringAngleYSingleMapData[i+1][position].push_back(scatteringangley);
+    ScatteringAngleXSingleMapData[i+1].fill(position.first,position.second,scatteringanglex);
+    ScatteringAngleYSingleMapData[i+1].fill(position.first,position.second,scatteringangley);
     try{
       dynamic_cast< TH1D* >(_histoThing[ssscatterx.str().c_str()])->Fill(scatteringanglex);
     } catch(std::bad_cast &bc){
@@ -1133,49 +1148,25 @@ void EUTelX0Processor::processEvent(LCEvent *evt)
       LCCollection* trackcollection2 = evt->getCollection(_trackCollectionName2);
       int elementnumber2 = trackcollection2->getNumberOfElements();
       streamlog_out(DEBUG2) << "Created trackcollection2, it has " << elementnumber2 << " elements" << endl;
-      for(int i = 0; i < elementnumber1; ++i){
-        for(int j = 0; j < elementnumber2; ++j){
-          streamlog_out(DEBUG0) << "i = " << i << ", j = " << j << endl;
-          Track *eventtrack1 = dynamic_cast< Track* >(trackcollection1->getElementAt(i));
-          Track *eventtrack2 = dynamic_cast< Track* >(trackcollection2->getElementAt(j));
-          streamlog_out(DEBUG0) << "Dynamically casted tracks: " << &eventtrack1 << " and " << &eventtrack2 << endl;
-          std::vector< TrackerHit* > trackhits1 = eventtrack1->getTrackerHits();
-          streamlog_out(DEBUG0) << "Got the tracker hit 1" << endl;
-          std::vector< TrackerHit* > trackhits2 = eventtrack2->getTrackerHits();
-          streamlog_out(DEBUG0) << "Got the tracker hit 2" << endl;
-          std::vector< TVector3 > hits;
-          int k(0);
-          TVector3 *tempvec = new TVector3();
-          for(std::vector< TrackerHit* >::iterator it = trackhits1.begin(); it != trackhits1.end(); ++it){
-            if((*it)->getType() == 32){  //Check if the hit type is the aligned hits or the fitted points (we want fitted points)
-              streamlog_out(DEBUG0) << "k = " << k << endl;
-              Double_t x = (*it)->getPosition()[0];
-              Double_t y = (*it)->getPosition()[1];
-              Double_t z = (*it)->getPosition()[2];
-              k++;
-	      tempvec->SetXYZ(x,y,z);
-              hits.push_back(*tempvec);
-            } //End of if query for type check
-          } //End of for loop running through trackhits
-          streamlog_out(DEBUG0) << "Filled hits from first track" << endl;
-          for(std::vector< TrackerHit* >::iterator it = trackhits2.begin(); it != trackhits2.end(); ++it){
-            if((*it)->getType() == 32){  //Check if the hit type is the aligned hits or the fitted points (we want fitted points)
-              streamlog_out(DEBUG0) << "k = " << k << endl;
-              Double_t x = (*it)->getPosition()[0];
-              Double_t y = (*it)->getPosition()[1];
-              Double_t z = (*it)->getPosition()[2];
-              k++;
-	      tempvec->SetXYZ(x,y,z);
-              hits.push_back(*tempvec);
-            } //End of if query for type check
-          } //End of for loop running through trackhits
-          streamlog_out(DEBUG0) << "Filled hits from second track" << endl;
-          delete tempvec;
-          pair< vector< double >, vector< double > > scatterpairtripledaf(GetTripleTrackAnglesDoubleDafFitted(eventtrack1, eventtrack2));
-          streamlog_out(DEBUG0) << "Worked out track angles" << endl;
+      //Only the front and back tracks which meet on the DUT are paired, each track is used at most once
+      std::vector< DUTTrackPoint > frontpoints, backpoints;
+      GetDUTTrackPoints(trackcollection1, true, frontpoints);
+      GetDUTTrackPoints(trackcollection2, false, backpoints);
+      std::vector< std::pair< size_t, size_t > > matches(MatchDoubleDafTracks(frontpoints, backpoints));
+      streamlog_out(DEBUG2) << "Matched " << matches.size() << " pairs of double daf tracks" << endl;
+      for(std::vector< std::pair< size_t, size_t > >::iterator it = matches.begin(); it != matches.end(); ++it){
+        const DUTTrackPoint &front = frontpoints[it->first];
+        const DUTTrackPoint &back = backpoints[it->second];
+        std::vector< TVector3 > hits(front.hits);
+        hits.insert(hits.end(), back.hits.begin(), back.hits.end());
+        pair< vector< double >, vector< double > > scatterpairtripledaf(GetTripleTrackAnglesDoubleDafFitted(front.track, back.track));
+        streamlog_out(DEBUG0) << "Worked out track angles" << endl;
+        try{
           TriplePlaneTrackScatteringAngles(scatterpairtripledaf.first, scatterpairtripledaf.second, hits, true);
-          streamlog_out(DEBUG0) << "Worked out scattering angles" << endl;
+        } catch(std::string &outofmap){
+          streamlog_out(DEBUG2) << outofmap << endl;
         }
+        streamlog_out(DEBUG0) << "Worked out scattering angles" << endl;
       }
       for(int i = 0; i < elementnumber1; ++i){
         Track *eventtrack1 = dynamic_cast< Track* >(trackcollection1->getElementAt(i));
@@ -1216,6 +1207,87 @@ void EUTelX0Processor::processEvent(LCEvent *evt)
   _eventNumber++;
 }
 
+double EUTelX0Processor::GetDUTPosition(const std::vector< TVector3 > &fronthits){
+  //DUTPosition is relative to plane 2, the value of run 8876 is only used when it is not set in the steering file
+  const double offset = parameterSet("DUTPosition") ? _dutPosition : 5.1; //TODO HACK value from run 8876, need to add this variable to my runs.csv list
+  return fronthits.at(2).z() + offset;
+}
+
+void EUTelX0Processor::GetDUTTrackPoints(LCCollection *trackcollection, bool front, std::vector< DUTTrackPoint > &trackpoints){
+  const int elementnumber = trackcollection->getNumberOfElements();
+  trackpoints.clear();
+  trackpoints.reserve(elementnumber);
+  for(int i = 0; i < elementnumber; ++i){
+    DUTTrackPoint point;
+    point.track = dynamic_cast< Track* >(trackcollection->getElementAt(i));
+    const std::vector< TrackerHit* > &trackhits = point.track->getTrackerHits();
+    for(std::vector< TrackerHit* >::const_iterator it = trackhits.begin(); it != trackhits.end(); ++it){
+      if((*it)->getType() == 32){  //Check if the hit type is the aligned hits or the fitted points (we want fitted points)
+        const double *pos = (*it)->getPosition();
+        point.hits.push_back(TVector3(pos[0],pos[1],pos[2]));
+      }
+    }
+    //The same planes as in GetTripleTrackAnglesDoubleDafFitted and TriplePlaneTrackScatteringAngles: the front tracks
+    //are extrapolated from plane 2 along planes 1-2, the back tracks from plane 3 along their first two planes
+    const size_t lastplane = front ? 2 : 3;
+    const size_t firstplane = front ? 1 : 0;
+    if(point.hits.size() <= lastplane){
+      streamlog_out(DEBUG2) << "Track " << i << " has only " << point.hits.size() << " fitted points, not using it" << endl;
+      continue;
+    }
+    const TVector3 &p1 = point.hits[firstplane];
+    const TVector3 &p2 = point.hits[firstplane + 1];
+    const TVector3 &p3 = point.hits[lastplane];
+    const double anglex = atan2(p2.x() - p1.x(), p2.z() - p1.z());
+    const double angley = atan2(p2.y() - p1.y(), p2.z() - p1.z());
+    //Both daf fitters give fitted points on all the planes, so plane 2 is at the same z for front and back tracks
+    const double dutposition = GetDUTPosition(point.hits);
+    point.x = p3.x() + (dutposition - p3.z())*tan(anglex);
+    point.y = p3.y() + (dutposition - p3.z())*tan(angley);
+    trackpoints.push_back(point);
+  }
+}
+
+std::vector< std::pair< size_t, size_t > > EUTelX0Processor::MatchDoubleDafTracks(const std::vector< DUTTrackPoint > &frontpoints, const std::vector< DUTTrackPoint > &backpoints){
+  std::vector< std::pair< size_t, size_t > > matches;
+  if(frontpoints.empty() || backpoints.empty()) return matches;
+
+  //Index the back tracks in x so that only the ones within _cut are looked at
+  std::vector< std::pair< double, size_t > > backx;
+  backx.reserve(backpoints.size());
+  for(size_t j = 0; j < backpoints.size(); ++j){
+    backx.push_back(std::make_pair(backpoints[j].x, j));
+  }
+  std::sort(backx.begin(), backx.end());
+
+  //Candidate pairs with their squared distance on the DUT
+  std::vector< std::pair< double, std::pair< size_t, size_t > > > candidates;
+  for(size_t i = 0; i < frontpoints.size(); ++i){
+    const DUTTrackPoint &front = frontpoints[i];
+    std::vector< std::pair< double, size_t > >::const_iterator it = std::upper_bound(backx.begin(), backx.end(), std::make_pair(front.x - _cut, backpoints.size()));
+    for(; it != backx.end() && it->first < front.x + _cut; ++it){
+      const DUTTrackPoint &back = backpoints[it->second];
+      if(!(front.x > back.x - _cut && front.y < back.y + _cut && front.y > back.y - _cut)) continue;
+      const double dx = front.x - back.x;
+      const double dy = front.y - back.y;
+      candidates.push_back(std::make_pair(dx*dx + dy*dy, std::make_pair(i, it->second)));
+    }
+  }
+
+  //One to one assignment, the closest pairs first
+  std::sort(candidates.begin(), candidates.end());
+  std::vector< bool > frontused(frontpoints.size(), false);
+  std::vector< bool > backused(backpoints.size(), false);
+  for(size_t k = 0; k < candidates.size(); ++k){
+    const std::pair< size_t, size_t > &match = candidates[k].second;
+    if(frontused[match.first] || backused[match.second]) continue;
+    frontused[match.first] = true;
+    backused[match.second] = true;
+    matches.push_back(match);
+  }
+  return matches;
+}
+
 std::pair<double,double> EUTelX0Processor::GetLowerAndUpperBounds(TH1D *temphisto){
   double lowrange(-9999), highrange(9999);
   double maxx = -999999;
@@ -1247,35 +1319,89 @@ std::pair<double,double> EUTelX0Processor::GetLowerAndUpperBounds(TH1D *temphist
   return ranges;
 }
 
-double EUTelX0Processor::getSigma(vector<double> vec){
-  double mean(0);
+double EUTelX0Processor::getSigma(const EUTelX0AngleMap &angles, pair< int, int > position){
+  if(angles.getEntries(position.first,position.second) == 0){
+    return 0;
+  }
+  //Rebuild the angle histogram of this bin from the accumulated counts, including under and overflow
   TH1D *temphisto = new TH1D("temphisto","temphisto",nobinsangle,minbinangle,maxbinangle);
-  for(vector< double >::iterator it = vec.begin(); it != vec.end(); ++it){
-    temphisto->Fill(*it);
-//    mean += *it;
+  const unsigned int *counts = angles.getAngleHistogram(position.first,position.second);
+  for(int i = 0; i < nobinsangle + 2; ++i){
+    temphisto->SetBinContent(i,counts[i]);
   }
-  mean /= vec.size();
-  double sigma(0);
-//  for(vector< double >::iterator it = vec.begin(); it != vec.end(); ++it){
-//    sigma += (mean - *it)*(mean - *it);
-//  }
-//  sigma /= static_cast<double>(vec.size());
-//  sigma = sqrt(sigma);
+  temphisto->SetEntries(static_cast< double >(angles.getEntries(position.first,position.second)));
   gErrorIgnoreLevel=kError;
   std::pair<double,double> range(GetLowerAndUpperBounds(temphisto));
   TF1 *fit = new TF1("fit","1/(sqrt(2*3.1415)*[0])*exp((-x*x)/(2*[0]*[0]))*[1]",range.first,range.second);
   int goodfit = temphisto->Fit(fit, "QRME");
-  if(goodfit != 0){
-    return 0;
+  double sigmafit(0);
+  if(goodfit == 0){
+    sigmafit = fit->GetParameter(0);
   }
-  double sigmafit = fit->GetParameter(2);
   delete fit;
   delete temphisto;
-//  if(sigma != sigma){
-//    return 0;
-//  } else{
   return sigmafit;
-//  }
+}
+
+EUTelX0AngleMap* EUTelX0Processor::getAngleMap(const std::string &name){
+  if(name == "ScatteringAngleXTriple") return &ScatteringAngleXTripleMapData;
+  if(name == "ScatteringAngleYTriple") return &ScatteringAngleYTripleMapData;
+  if(name == "ScatteringAngleXTripleDoubleDaf") return &ScatteringAngleXTripleMapDataDaf;
+  if(name == "ScatteringAngleYTripleDoubleDaf") return &ScatteringAngleYTripleMapDataDaf;
+  for(int k = 1; k < 5; ++k){
+    std::stringstream ssx,ssy;
+    ssx << "ScatteringAngleXPlane" << k;
+    ssy << "ScatteringAngleYPlane" << k;
+    if(name == ssx.str()) return &ScatteringAngleXSingleMapData[k];
+    if(name == ssy.str()) return &ScatteringAngleYSingleMapData[k];
+  }
+  return NULL;
+}
+
+void EUTelX0Processor::writePartialResults(){
+  std::ofstream outfile(_partialResultsOutputFile.c_str());
+  if(!outfile){
+    streamlog_out(ERROR5) << "Unable to open the partial results file " << _partialResultsOutputFile << endl;
+    return;
+  }
+  ScatteringAngleXTripleMapData.write(outfile,"ScatteringAngleXTriple");
+  ScatteringAngleYTripleMapData.write(outfile,"ScatteringAngleYTriple");
+  if(_doubleDafFitted){
+    ScatteringAngleXTripleMapDataDaf.write(outfile,"ScatteringAngleXTripleDoubleDaf");
+    ScatteringAngleYTripleMapDataDaf.write(outfile,"ScatteringAngleYTripleDoubleDaf");
+  }
+  for(int k = 1; k < 5; ++k){
+    std::stringstream ssx,ssy;
+    ssx << "ScatteringAngleXPlane" << k;
+    ssy << "ScatteringAngleYPlane" << k;
+    ScatteringAngleXSingleMapData[k].write(outfile,ssx.str());
+    ScatteringAngleYSingleMapData[k].write(outfile,ssy.str());
+  }
+  streamlog_out(MESSAGE5) << "Partial results written to " << _partialResultsOutputFile << endl;
+}
+
+void EUTelX0Processor::readPartialResults(){
+  for(std::vector< std::string >::iterator it = _partialResultsInputFiles.begin(); it != _partialResultsInputFiles.end(); ++it){
+    std::ifstream infile(it->c_str());
+    if(!infile){
+      streamlog_out(ERROR5) << "Unable to open the partial results file " << *it << ", skipping it" << endl;
+      continue;
+    }
+    EUTelX0AngleMap partial;
+    std::string name;
+    while(partial.read(infile,name)){
+      EUTelX0AngleMap *anglemap = getAngleMap(name);
+      if(anglemap == NULL){
+        streamlog_out(WARNING5) << "Unknown map " << name << " in the partial results file " << *it << endl;
+      } else if(!anglemap->merge(partial)){
+        streamlog_out(ERROR5) << "The binning of map " << name << " in the partial results file " << *it << " does not match the one of this job, skipping it" << endl;
+      }
+    }
+    if(!infile.eof()){
+      streamlog_out(ERROR5) << "The partial results file " << *it << " is corrupted, only the maps before the error have been merged" << endl;
+    }
+    streamlog_out(MESSAGE5) << "Partial results merged from " << *it << endl;
+  }
 }
 
 void EUTelX0Processor::end()
@@ -1286,6 +1412,10 @@ void EUTelX0Processor::end()
   //calculateX0();
   int numberofplanes = 6;
   gErrorIgnoreLevel=kError;
+  if(!_partialResultsOutputFile.empty()){
+    writePartialResults();
+  }
+  readPartialResults();
   for(double i = minx; i <= maxx; i += binsizex)
   {
     streamlog_out(MESSAGE6) << "The Radiation Length Map has made it to " << i << endl;
@@ -1293,27 +1423,27 @@ void EUTelX0Processor::end()
     {
       pair< int, int > position(ConversionHitmapToX0map(i,j));
       for(int k = 1; k < numberofplanes - 1; ++k){
-        double sigmasinglex = getSigma(ScatteringAngleXSingleMapData[k][position]);
+        double sigmasinglex = getSigma(ScatteringAngleXSingleMapData[k],position);
         ScatteringAngleXSingleMap[k]->Fill(i,j,sigmasinglex);
-        double sigmasingley = getSigma(ScatteringAngleYSingleMapData[k][position]);;
+        double sigmasingley = getSigma(ScatteringAngleYSingleMapData[k],position);
         ScatteringAngleYSingleMap[k]->Fill(i,j,sigmasingley);
 
         double x0single = pow(sqrt(pow(sigmasinglex,2)+pow(sigmasingley,2))*1000.0*_beamEnergy/13.6,1.0/0.555);
         RadiationLengthSingleMap[k]->Fill(i,j,x0single);
 
       }
-      double sigmatriplex = getSigma(ScatteringAngleXTripleMapData[position]);
+      double sigmatriplex = getSigma(ScatteringAngleXTripleMapData,position);
       ScatteringAngleXTripleMap->Fill(i,j,sigmatriplex);
-      double sigmatripley = getSigma(ScatteringAngleYTripleMapData[position]);
+      double sigmatripley = getSigma(ScatteringAngleYTripleMapData,position);
       ScatteringAngleYTripleMap->Fill(i,j,sigmatripley);
       
       double x0triple = pow(sqrt(pow(sigmatriplex,2)+pow(sigmatripley,2))*1000.0*_beamEnergy/13.6,1.0/0.555);
       RadiationLengthTripleMap->Fill(i,j,x0triple);
 
       if(_doubleDafFitted){
-        double sigmatriplexdaf = getSigma(ScatteringAngleXTripleMapDataDaf[position]);
+        double sigmatriplexdaf = getSigma(ScatteringAngleXTripleMapDataDaf,position);
         ScatteringAngleXTripleMapDoubleDaf->Fill(i,j,sigmatriplexdaf);
-        double sigmatripleydaf = getSigma(ScatteringAngleYTripleMapDataDaf[position]);
+        double sigmatripleydaf = getSigma(ScatteringAngleYTripleMapDataDaf,position);
         ScatteringAngleYTripleMapDoubleDaf->Fill(i,j,sigmatripleydaf);
   
         double x0tripledaf = pow(sqrt(pow(sigmatriplexdaf,2)+pow(sigmatripleydaf,2))*1000.0*_beamEnergy/13.6,1.0/0.555);
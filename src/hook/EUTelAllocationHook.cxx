@@ -0,0 +1,73 @@
+// Version: $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// Allocation hook for EUTelProfiler
+//
+// This library replaces the global operator new and delete with
+// versions counting the allocations, which EUTelProfiler finds at run
+// time. It has to be preloaded, as the Marlin processors are loaded
+// too late to replace the allocator of the job:
+//
+//   LD_PRELOAD=libEutelescopeAllocationHook.so Marlin steering.xml
+
+// system includes <>
+#include <cstdlib>
+#include <new>
+
+extern "C" {
+  //! Number of allocations and allocated bytes since the start of the job
+  volatile long eutelescope_allocation_counters[2] = { 0, 0 };
+}
+
+namespace {
+
+  void * allocate(std::size_t size) {
+    __sync_fetch_and_add( &eutelescope_allocation_counters[0], 1L );
+    __sync_fetch_and_add( &eutelescope_allocation_counters[1], static_cast< long >( size ) );
+    return std::malloc( size > 0 ? size : 1 );
+  }
+
+}
+
+void * operator new(std::size_t size) throw(std::bad_alloc) {
+  void * p = allocate( size );
+  if ( p == 0 ) throw std::bad_alloc();
+  return p;
+}
+
+void * operator new[](std::size_t size) throw(std::bad_alloc) {
+  void * p = allocate( size );
+  if ( p == 0 ) throw std::bad_alloc();
+  return p;
+}
+
+void * operator new(std::size_t size, const std::nothrow_t&) throw() {
+  return allocate( size );
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t&) throw() {
+  return allocate( size );
+}
+
+void operator delete(void * p) throw() {
+  std::free( p );
+}
+
+void operator delete[](void * p) throw() {
+  std::free( p );
+}
+
+void operator delete(void * p, const std::nothrow_t&) throw() {
+  std::free( p );
+}
+
+void operator delete[](void * p, const std::nothrow_t&) throw() {
+  std::free( p );
+}
@@ -0,0 +1,289 @@
+// Version $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#include "EUTelAlignmentCache.h"
+
+#include "TVector3.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace eutelescope;
+
+const int nPlane  = 6;
+const int nEvent  = 20;
+
+const string cacheName = "alignmentcachetest.cache";
+
+// the settings of the writer, 28 characters
+const string parameters = "HitCollectionName=hit;Cuts=1";
+
+int nFailed = 0;
+
+void check(bool condition, const string & what) {
+  cout << ( condition ? " OK     " : " FAILED " ) << what << endl;
+  if ( ! condition ) ++nFailed;
+}
+
+//! The hits of an event, a different number for every event
+void makeEvent(int iEvent, vector< EUTelAlignmentCache::Hit > & hits, vector< int > & trackHits) {
+
+  hits.clear();
+  trackHits.clear();
+
+  // one hit per plane for each track, and (iEvent % 3) tracks
+  const int nTrack = iEvent % 3;
+  for ( int iTrack = 0; iTrack < nTrack; ++iTrack ) {
+    for ( int iPlane = 0; iPlane < nPlane; ++iPlane ) {
+      EUTelAlignmentCache::Hit hit;
+      hit.x       = 0.1 * iEvent + iTrack;
+      hit.y       = - 0.2 * iEvent - iTrack;
+      hit.z       = 150. * iPlane;
+      hit.sigmaX  = 0.0043f;
+      hit.sigmaY  = 0.0043f;
+      hit.plane   = iPlane;
+      hit.padding = 0;
+      hits.push_back( hit );
+      // the third plane is missing in the first track
+      trackHits.push_back( ( iTrack == 0 && iPlane == 2 ) ? -1 : static_cast< int >( hits.size() ) - 1 );
+    }
+  }
+}
+
+bool writeCache(const string & filename, bool closeIt) {
+
+  vector< int > sensorIDs;
+  for ( int iPlane = 0; iPlane < nPlane; ++iPlane ) sensorIDs.push_back( iPlane );
+
+  EUTelAlignmentCacheWriter writer;
+  if ( ! writer.open( filename, sensorIDs, parameters ) ) return false;
+
+  vector< EUTelAlignmentCache::Hit > hits;
+  vector< int > trackHits;
+  for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+    makeEvent( iEvent, hits, trackHits );
+    writer.writeEvent( hits, trackHits );
+  }
+  if ( closeIt ) return writer.close();
+  return true;
+}
+
+bool sameHit(const EUTelAlignmentCache::Hit & a, const EUTelAlignmentCache::Hit & b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z && a.sigmaX == b.sigmaX && a.sigmaY == b.sigmaY && a.plane == b.plane;
+}
+
+bool readBack(const string & filename) {
+
+  EUTelAlignmentCacheReader reader;
+  if ( ! reader.open( filename ) ) return false;
+  if ( reader.getNPlanes() != static_cast< size_t >( nPlane ) || reader.getNEvents() != static_cast< size_t >( nEvent ) ) return false;
+  if ( reader.getParameters() != parameters ) return false;
+
+  // twice, to check the rewind as well
+  for ( int iPass = 0; iPass < 2; ++iPass ) {
+    const EUTelAlignmentCache::Hit * hits;
+    const int * trackHits;
+    int nHits, nTracks;
+    vector< EUTelAlignmentCache::Hit > expectedHits;
+    vector< int > expectedTrackHits;
+    for ( int iEvent = 0; iEvent < nEvent; ++iEvent ) {
+      if ( ! reader.nextEvent( hits, nHits, trackHits, nTracks ) ) return false;
+      makeEvent( iEvent, expectedHits, expectedTrackHits );
+      if ( nHits != static_cast< int >( expectedHits.size() ) ) return false;
+      if ( nTracks * nPlane != static_cast< int >( expectedTrackHits.size() ) ) return false;
+      for ( int iHit = 0; iHit < nHits; ++iHit ) {
+        if ( ! sameHit( hits[iHit], expectedHits[iHit] ) ) return false;
+      }
+      for ( int iIndex = 0; iIndex < nTracks * nPlane; ++iIndex ) {
+        if ( trackHits[iIndex] != expectedTrackHits[iIndex] ) return false;
+      }
+    }
+    if ( reader.nextEvent( hits, nHits, trackHits, nTracks ) ) return false;
+    reader.rewind();
+  }
+  return true;
+}
+
+bool canOpen(const string & filename) {
+  EUTelAlignmentCacheReader reader;
+  return reader.open( filename );
+}
+
+vector< char > readFile(const string & filename) {
+  ifstream file( filename.c_str(), ios::binary );
+  return vector< char >( ( istreambuf_iterator< char >( file ) ), istreambuf_iterator< char >() );
+}
+
+void writeFile(const string & filename, const vector< char > & content, size_t size) {
+  ofstream file( filename.c_str(), ios::binary );
+  if ( size > 0 ) file.write( &content[0], size );
+}
+
+bool fileExists(const string & filename) {
+  ifstream file( filename.c_str() );
+  return file.good();
+}
+
+//! The constants of one alignment iteration, lengths in mm
+struct Constants {
+  double alpha, beta, gamma;
+  double offset[3];
+};
+
+//! The rotation first correction of EUTelApplyAlignmentProcessor,
+//! direct direction, with the reference hit refhit, in mm
+void applyAlignmentProcessor(double position[3], const double refhit[3], const Constants & constants) {
+
+  double x_refhit = refhit[0] + constants.offset[0];
+  double y_refhit = refhit[1] + constants.offset[1];
+  double z_refhit = refhit[2] + constants.offset[2];
+
+  TVector3 iCenterOfSensorFrame( position[0] - x_refhit, position[1] - y_refhit, position[2] - z_refhit );
+  iCenterOfSensorFrame.RotateX( - constants.alpha );
+  iCenterOfSensorFrame.RotateY( - constants.beta  );
+  iCenterOfSensorFrame.RotateZ( - constants.gamma );
+
+  position[0] = x_refhit + iCenterOfSensorFrame(0) - constants.offset[0];
+  position[1] = y_refhit + iCenterOfSensorFrame(1) - constants.offset[1];
+  position[2] = z_refhit + iCenterOfSensorFrame(2) - constants.offset[2];
+}
+
+//! Replay two alignment iterations on hits of a plane far from the
+//! origin, in um as EUTelMille does, and compare with the processor
+bool sameAsApplyAlignment() {
+
+  const double refhit[3] = { 1.5, -2.5, 300. };
+  const double centre[3] = { 1000. * refhit[0], 1000. * refhit[1], 1000. * refhit[2] };
+
+  Constants constants[2];
+  constants[0].alpha = 0.002;
+  constants[0].beta  = -0.003;
+  constants[0].gamma = 0.01;
+  constants[0].offset[0] = 0.05;
+  constants[0].offset[1] = -0.02;
+  constants[0].offset[2] = 0.3;
+  constants[1].alpha = -0.0005;
+  constants[1].beta  = 0.001;
+  constants[1].gamma = -0.002;
+  constants[1].offset[0] = -0.004;
+  constants[1].offset[1] = 0.006;
+  constants[1].offset[2] = -0.01;
+
+  for ( int iHit = 0; iHit < 10; ++iHit ) {
+
+    double expected[3] = { refhit[0] + 0.9 * iHit - 4., refhit[1] - 0.5 * iHit + 2., refhit[2] + 0.01 * iHit };
+    double replayed[3] = { 1000. * expected[0], 1000. * expected[1], 1000. * expected[2] };
+
+    for ( int iConst = 0; iConst < 2; ++iConst ) {
+      applyAlignmentProcessor( expected, refhit, constants[iConst] );
+
+      const double offset[3] = { 1000. * constants[iConst].offset[0], 1000. * constants[iConst].offset[1], 1000. * constants[iConst].offset[2] };
+      EUTelAlignmentCache::applyAlignment( replayed, centre, constants[iConst].alpha, constants[iConst].beta, constants[iConst].gamma, offset );
+    }
+
+    // within 1 nm
+    for ( int i = 0; i < 3; ++i ) {
+      if ( std::abs( replayed[i] - 1000. * expected[i] ) > 1e-3 ) return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+
+  remove( cacheName.c_str() );
+  remove( ( cacheName + ".tmp" ).c_str() );
+
+  // round trip
+  check( writeCache( cacheName, true ), "write a cache" );
+  check( fileExists( cacheName ) && ! fileExists( cacheName + ".tmp" ), "the cache has its final name after close()" );
+  check( readBack( cacheName ), "read back the parameters, all the hits and track candidates" );
+
+  // a writer not closed leaves no cache behind
+  const string crashedName = "alignmentcachetest-crashed.cache";
+  remove( crashedName.c_str() );
+  check( writeCache( crashedName, false ), "write a cache without closing it" );
+  check( ! fileExists( crashedName ) && ! fileExists( crashedName + ".tmp" ), "an unclosed cache is discarded" );
+  check( ! canOpen( crashedName ), "an unclosed cache cannot be opened" );
+
+  // truncated files
+  const vector< char > content = readFile( cacheName );
+  const string damagedName = "alignmentcachetest-damaged.cache";
+  const size_t trailerSize = 16;
+
+  writeFile( damagedName, content, content.size() / 2 );
+  check( ! canOpen( damagedName ), "a cache cut in the middle is rejected" );
+
+  writeFile( damagedName, content, content.size() - trailerSize );
+  check( ! canOpen( damagedName ), "a cache without trailer is rejected" );
+
+  writeFile( damagedName, content, content.size() - 1 );
+  check( ! canOpen( damagedName ), "a cache with a partial trailer is rejected" );
+
+  writeFile( damagedName, content, content.size() );
+  check( canOpen( damagedName ), "an intact copy is accepted" );
+
+  // find the first event with tracks: header of 8 + 4 * 8 bytes and
+  // the padded parameters, then events of 8 + hits * 40 + padded
+  // tracks * planes * 4 bytes
+  const size_t firstEvent = 8 + 32 + 32;
+  const size_t secondEvent = firstEvent + 8; // event 0 has no tracks
+  int counts[2];
+  memcpy( counts, &content[secondEvent], sizeof( counts ) );
+  check( counts[0] == nPlane && counts[1] == 1, "the layout of the test cache is the expected one" );
+
+  // a track candidate pointing outside its event
+  vector< char > damaged( content );
+  const size_t firstIndex = secondEvent + 8 + nPlane * sizeof( EUTelAlignmentCache::Hit );
+  int badIndex = nPlane;
+  memcpy( &damaged[firstIndex], &badIndex, sizeof( int ) );
+  writeFile( damagedName, damaged, damaged.size() );
+  check( ! canOpen( damagedName ), "a track candidate with an out of range hit index is rejected" );
+
+  badIndex = -2;
+  memcpy( &damaged[firstIndex], &badIndex, sizeof( int ) );
+  writeFile( damagedName, damaged, damaged.size() );
+  check( ! canOpen( damagedName ), "a track candidate with a negative hit index is rejected" );
+
+  // parameters longer than the file
+  damaged = content;
+  int badLength = static_cast< int >( content.size() );
+  memcpy( &damaged[8 + 4 + nPlane * sizeof( int )], &badLength, sizeof( int ) );
+  writeFile( damagedName, damaged, damaged.size() );
+  check( ! canOpen( damagedName ), "a header with a wrong parameter length is rejected" );
+
+  // a hit on a plane that does not exist
+  damaged = content;
+  const size_t planeOffset = secondEvent + 8 + 3 * sizeof( double ) + 2 * sizeof( float );
+  int badPlane = nPlane;
+  memcpy( &damaged[planeOffset], &badPlane, sizeof( int ) );
+  writeFile( damagedName, damaged, damaged.size() );
+  check( ! canOpen( damagedName ), "a hit on an unknown plane is rejected" );
+
+  remove( cacheName.c_str() );
+  remove( damagedName.c_str() );
+
+  // the alignment constants applied to the cached hits
+  check( sameAsApplyAlignment(), "the replayed hits match EUTelApplyAlignmentProcessor" );
+
+  if ( nFailed > 0 ) {
+    cout << nFailed << " checks failed" << endl;
+    return 1;
+  }
+  cout << "All checks passed" << endl;
+  return 0;
+}
@@ -0,0 +1,398 @@
+// -*- mode: c++; mode: auto-fill; mode: flyspell-prog; -*-
+// Version $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// Synthetic input of the reconstruction benchmark.
+//
+// Straight tracks crossing six Mimosa26 planes and one FE-I4 plane
+// (the geometry of gear_benchmark.xml) plus random noise hits are
+// written as zero suppressed data (zsdata_m26 and zsdata_apix), and
+// optionally as not zero suppressed Mimosa26 frames (rawdata) to
+// benchmark the sparsification too. The random generator is part of
+// this file, so that the same options give the same events on every
+// machine. See the README for the options.
+
+#include "lcio.h"
+#include "EUTELESCOPE.h"
+#include "EUTelRunHeaderImpl.h"
+#include "EUTelEventImpl.h"
+#include "EUTelSimpleSparsePixel.h"
+#include "EUTelAPIXSparsePixel.h"
+#include "EUTelSparseDataImpl.h"
+#include "IMPL/LCEventImpl.h"
+#include "IMPL/LCCollectionVec.h"
+#include "IMPL/TrackerDataImpl.h"
+#include "IMPL/TrackerRawDataImpl.h"
+#include "UTIL/CellIDEncoder.h"
+#include "UTIL/LCTime.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace lcio;
+using namespace eutelescope;
+
+// geometry, as in gear_benchmark.xml
+const int    nPlane                = 7;
+const int    planeID[nPlane]       = { 0, 1, 2, 20, 3, 4, 5 };
+const double planeZ[nPlane]        = { 0., 150., 300., 450., 600., 750., 900. };
+const bool   planeIsFEI4[nPlane]   = { false, false, false, true, false, false, false };
+const int    nMimosa26             = 6;
+
+const int    m26NPixelX  = 1152;
+const int    m26NPixelY  = 576;
+const double m26PitchX   = 0.018402778;
+const double m26PitchY   = 0.018402778;
+
+const int    fei4NPixelX = 80;
+const int    fei4NPixelY = 336;
+const double fei4PitchX  = 0.250;
+const double fei4PitchY  = 0.050;
+
+// beam
+const double beamSizeX     = 5.;     // mm, sigma
+const double beamSizeY     = 2.5;    // mm, sigma
+const double beamDivergence = 0.001; // rad, sigma
+
+// charge is shared with the neighbour pixel when the track is closer
+// than this fraction of the pitch to the pixel border
+const double chargeSharing = 0.25;
+
+// the not zero suppressed frames take their pixel noise from a table,
+// much faster than a gaussian per pixel
+const int    noiseTableSize = 1 << 16;
+
+// signal of a fired pixel in the not zero suppressed frames, in ADC
+const short  rawSignal      = 20;
+
+const double pi = 3.14159265358979323846;
+
+// options
+int    nEvent        = 1000;
+double tracksPerEvent = 1.;
+double noiseOccupancy = 1e-4;
+double rawNoise      = 1.;
+unsigned int seed    = 1;
+bool   doRaw         = false;
+string outputPath    = ".";
+
+unsigned int randomState;
+
+// xorshift generator, the same sequence on every platform
+double uniform();
+double gaussian();
+int    poisson(double mean);
+
+void addTrackHit(int iPlane, double x, double y, set< pair< int, int > > & pixels);
+void addNoiseHits(int iPlane, set< pair< int, int > > & pixels);
+void writeRunHeader(LCWriter * lcWriter);
+void usage();
+
+int main(int argc, char ** argv) {
+
+  for ( int arg = 1; arg < argc; arg++ ) {
+    if      ( strcmp( argv[arg], "-h" ) == 0 ) { usage(); return 0; }
+    else if ( strcmp( argv[arg], "-raw" ) == 0 ) doRaw = true;
+    else if ( arg + 1 < argc && strcmp( argv[arg], "-n" ) == 0 ) nEvent         = atoi( argv[++arg] );
+    else if ( arg + 1 < argc && strcmp( argv[arg], "-t" ) == 0 ) tracksPerEvent = atof( argv[++arg] );
+    else if ( arg + 1 < argc && strcmp( argv[arg], "-o" ) == 0 ) noiseOccupancy = atof( argv[++arg] );
+    else if ( arg + 1 < argc && strcmp( argv[arg], "-s" ) == 0 ) rawNoise       = atof( argv[++arg] );
+    else if ( arg + 1 < argc && strcmp( argv[arg], "-r" ) == 0 ) seed           = atoi( argv[++arg] );
+    else if ( arg + 1 < argc && strcmp( argv[arg], "-d" ) == 0 ) outputPath     = argv[++arg];
+    else {
+      cerr << "Unknown option " << argv[arg] << endl;
+      usage();
+      return 1;
+    }
+  }
+
+  // xorshift must not start from 0
+  randomState = seed != 0 ? seed : 1;
+
+  LCWriter * zsWriter = LCFactory::getInstance()->createLCWriter();
+  LCWriter * rawWriter = doRaw ? LCFactory::getInstance()->createLCWriter() : 0;
+  try {
+    zsWriter->open( outputPath + "/benchmark-zs.slcio", LCIO::WRITE_NEW );
+    if ( doRaw ) rawWriter->open( outputPath + "/benchmark-raw.slcio", LCIO::WRITE_NEW );
+  } catch ( IOException& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  writeRunHeader( zsWriter );
+  if ( doRaw ) writeRunHeader( rawWriter );
+
+  vector< short > noiseTable;
+  if ( doRaw ) {
+    noiseTable.resize( noiseTableSize );
+    for ( int i = 0; i < noiseTableSize; i++ ) {
+      noiseTable[i] = static_cast< short >( floor( rawNoise * gaussian() + 0.5 ) );
+    }
+  }
+
+  long nTrack = 0, nHit = 0;
+
+  for ( int iEvent = 0; iEvent <= nEvent; iEvent++ ) {
+    if ( iEvent % 1000 == 0 )
+      cout << "Generating event " << iEvent << endl;
+
+    EUTelEventImpl * zsEvent  = new EUTelEventImpl;
+    EUTelEventImpl * rawEvent = doRaw ? new EUTelEventImpl : 0;
+    LCTime * now = new LCTime;
+    zsEvent->setDetectorName("benchmark");
+    zsEvent->setRunNumber( seed );
+    zsEvent->setEventNumber( iEvent );
+    zsEvent->setTimeStamp( now->timeStamp() );
+    if ( doRaw ) {
+      rawEvent->setDetectorName("benchmark");
+      rawEvent->setRunNumber( seed );
+      rawEvent->setEventNumber( iEvent );
+      rawEvent->setTimeStamp( now->timeStamp() );
+    }
+    delete now;
+
+    if ( iEvent < nEvent ) {
+
+      zsEvent->setEventType( kDE );
+      if ( doRaw ) rawEvent->setEventType( kDE );
+
+      // the fired pixels of every plane
+      vector< set< pair< int, int > > > pixels( nPlane );
+
+      int nEventTrack = poisson( tracksPerEvent );
+      nTrack += nEventTrack;
+      for ( int iTrack = 0; iTrack < nEventTrack; iTrack++ ) {
+        double x0 = beamSizeX * gaussian();
+        double y0 = beamSizeY * gaussian();
+        double slopeX = beamDivergence * gaussian();
+        double slopeY = beamDivergence * gaussian();
+        for ( int iPlane = 0; iPlane < nPlane; iPlane++ ) {
+          addTrackHit( iPlane, x0 + slopeX * planeZ[iPlane], y0 + slopeY * planeZ[iPlane], pixels[iPlane] );
+        }
+      }
+      for ( int iPlane = 0; iPlane < nPlane; iPlane++ ) {
+        addNoiseHits( iPlane, pixels[iPlane] );
+        nHit += pixels[iPlane].size();
+      }
+
+      LCCollectionVec * m26Collection  = new LCCollectionVec( LCIO::TRACKERDATA );
+      LCCollectionVec * apixCollection = new LCCollectionVec( LCIO::TRACKERDATA );
+      LCCollectionVec * rawCollection  = doRaw ? new LCCollectionVec( LCIO::TRACKERRAWDATA ) : 0;
+      CellIDEncoder< TrackerDataImpl > m26Encoder( EUTELESCOPE::ZSDATADEFAULTENCODING, m26Collection );
+      CellIDEncoder< TrackerDataImpl > apixEncoder( EUTELESCOPE::ZSDATADEFAULTENCODING, apixCollection );
+
+      for ( int iPlane = 0; iPlane < nPlane; iPlane++ ) {
+
+        TrackerDataImpl * zsFrame = new TrackerDataImpl;
+        set< pair< int, int > >::const_iterator iter;
+
+        if ( planeIsFEI4[iPlane] ) {
+
+          apixEncoder["sensorID"]        = planeID[iPlane];
+          apixEncoder["sparsePixelType"] = static_cast< int >( kEUTelAPIXSparsePixel );
+          apixEncoder.setCellID( zsFrame );
+          EUTelSparseDataImpl< EUTelAPIXSparsePixel > sparseData( zsFrame );
+          for ( iter = pixels[iPlane].begin(); iter != pixels[iPlane].end(); ++iter ) {
+            // time over threshold 1 to 14, all in the same bunch crossing
+            EUTelAPIXSparsePixel pixel( iter->first, iter->second, 1 + static_cast< short >( 14 * uniform() ), 0, 7 );
+            sparseData.addSparsePixel( &pixel );
+          }
+          apixCollection->push_back( zsFrame );
+
+        } else {
+
+          m26Encoder["sensorID"]        = planeID[iPlane];
+          m26Encoder["sparsePixelType"] = static_cast< int >( kEUTelSimpleSparsePixel );
+          m26Encoder.setCellID( zsFrame );
+          EUTelSparseDataImpl< EUTelSimpleSparsePixel > sparseData( zsFrame );
+          for ( iter = pixels[iPlane].begin(); iter != pixels[iPlane].end(); ++iter ) {
+            sparseData.addSparsePixel( iter->first, iter->second, 1 );
+          }
+          m26Collection->push_back( zsFrame );
+
+          if ( doRaw ) {
+            TrackerRawDataImpl * rawMatrix = new TrackerRawDataImpl;
+            CellIDEncoder< TrackerRawDataImpl > idEncoder( EUTELESCOPE::MATRIXDEFAULTENCODING, rawCollection );
+            idEncoder["sensorID"] = planeID[iPlane];
+            idEncoder["xMin"]     = 0;
+            idEncoder["xMax"]     = m26NPixelX - 1;
+            idEncoder["yMin"]     = 0;
+            idEncoder["yMax"]     = m26NPixelY - 1;
+            idEncoder.setCellID( rawMatrix );
+
+            ShortVec & adcValues = rawMatrix->adcValues();
+            adcValues.resize( m26NPixelX * m26NPixelY );
+            int offset = static_cast< int >( noiseTableSize * uniform() );
+            for ( size_t iPixel = 0; iPixel < adcValues.size(); iPixel++ ) {
+              adcValues[iPixel] = noiseTable[ ( offset + iPixel ) % noiseTableSize ];
+            }
+            for ( iter = pixels[iPlane].begin(); iter != pixels[iPlane].end(); ++iter ) {
+              adcValues[ iter->first + iter->second * m26NPixelX ] += rawSignal;
+            }
+            rawCollection->push_back( rawMatrix );
+          }
+        }
+      }
+
+      zsEvent->addCollection( m26Collection, "zsdata_m26" );
+      zsEvent->addCollection( apixCollection, "zsdata_apix" );
+      if ( doRaw ) {
+        // the FE-I4 is always read out zero suppressed
+        LCCollectionVec * apixCopy = new LCCollectionVec( LCIO::TRACKERDATA );
+        CellIDEncoder< TrackerDataImpl > copyEncoder( EUTELESCOPE::ZSDATADEFAULTENCODING, apixCopy );
+        for ( size_t i = 0; i < apixCollection->size(); i++ ) {
+          TrackerDataImpl * original = static_cast< TrackerDataImpl * >( apixCollection->getElementAt( i ) );
+          TrackerDataImpl * copy = new TrackerDataImpl;
+          copy->setCellID0( original->getCellID0() );
+          copy->setChargeValues( original->getChargeValues() );
+          apixCopy->push_back( copy );
+        }
+        rawEvent->addCollection( rawCollection, "rawdata" );
+        rawEvent->addCollection( apixCopy, "zsdata_apix" );
+      }
+
+    } else {
+      zsEvent->setEventType( kEORE );
+      if ( doRaw ) rawEvent->setEventType( kEORE );
+    }
+
+    zsWriter->writeEvent( static_cast< LCEventImpl * >( zsEvent ) );
+    delete zsEvent;
+    if ( doRaw ) {
+      rawWriter->writeEvent( static_cast< LCEventImpl * >( rawEvent ) );
+      delete rawEvent;
+    }
+  }
+
+  zsWriter->close();
+  delete zsWriter;
+  if ( doRaw ) {
+    rawWriter->close();
+    delete rawWriter;
+  }
+
+  cout << nEvent << " events, " << nTrack << " tracks, "
+       << static_cast< double >( nHit ) / ( nEvent > 0 ? nEvent : 1 ) << " fired pixels per event" << endl;
+  return 0;
+}
+
+double uniform() {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return ( randomState & 0xffffffff ) / 4294967296.;
+}
+
+double gaussian() {
+  // Box-Muller, one of the two numbers is enough here
+  double u1 = uniform();
+  double u2 = uniform();
+  if ( u1 < 1e-300 ) u1 = 1e-300;
+  return sqrt( -2. * log( u1 ) ) * cos( 2. * pi * u2 );
+}
+
+int poisson(double mean) {
+  double limit = exp( -mean );
+  double product = uniform();
+  int n = 0;
+  while ( product > limit ) {
+    product *= uniform();
+    ++n;
+  }
+  return n;
+}
+
+void addTrackHit(int iPlane, double x, double y, set< pair< int, int > > & pixels) {
+
+  int    nPixelX = planeIsFEI4[iPlane] ? fei4NPixelX : m26NPixelX;
+  int    nPixelY = planeIsFEI4[iPlane] ? fei4NPixelY : m26NPixelY;
+  double pitchX  = planeIsFEI4[iPlane] ? fei4PitchX  : m26PitchX;
+  double pitchY  = planeIsFEI4[iPlane] ? fei4PitchY  : m26PitchY;
+
+  // the plane is centred on the beam axis, as in the GEAR file
+  double u = x / pitchX + 0.5 * nPixelX;
+  double v = y / pitchY + 0.5 * nPixelY;
+  if ( u < 0 || v < 0 || u >= nPixelX || v >= nPixelY ) return;
+
+  int column = static_cast< int >( u );
+  int row    = static_cast< int >( v );
+  int neighbourX = 0, neighbourY = 0;
+  if      ( u - column < chargeSharing )      neighbourX = -1;
+  else if ( u - column > 1 - chargeSharing )  neighbourX =  1;
+  if      ( v - row < chargeSharing )         neighbourY = -1;
+  else if ( v - row > 1 - chargeSharing )     neighbourY =  1;
+
+  for ( int dx = 0; dx <= 1; dx++ ) {
+    for ( int dy = 0; dy <= 1; dy++ ) {
+      if ( ( dx == 1 && neighbourX == 0 ) || ( dy == 1 && neighbourY == 0 ) ) continue;
+      int pixelX = column + dx * neighbourX;
+      int pixelY = row    + dy * neighbourY;
+      if ( pixelX >= 0 && pixelX < nPixelX && pixelY >= 0 && pixelY < nPixelY ) {
+        pixels.insert( make_pair( pixelX, pixelY ) );
+      }
+    }
+  }
+}
+
+void addNoiseHits(int iPlane, set< pair< int, int > > & pixels) {
+
+  int nPixelX = planeIsFEI4[iPlane] ? fei4NPixelX : m26NPixelX;
+  int nPixelY = planeIsFEI4[iPlane] ? fei4NPixelY : m26NPixelY;
+
+  int nNoise = poisson( noiseOccupancy * nPixelX * nPixelY );
+  for ( int iNoise = 0; iNoise < nNoise; iNoise++ ) {
+    pixels.insert( make_pair( static_cast< int >( nPixelX * uniform() ), static_cast< int >( nPixelY * uniform() ) ) );
+  }
+}
+
+void writeRunHeader(LCWriter * lcWriter) {
+
+  vector< int > minX( nMimosa26, 0 );
+  vector< int > minY( nMimosa26, 0 );
+  vector< int > maxX( nMimosa26, m26NPixelX - 1 );
+  vector< int > maxY( nMimosa26, m26NPixelY - 1 );
+
+  EUTelRunHeaderImpl * runHeader = new EUTelRunHeaderImpl();
+  runHeader->setRunNumber( seed );
+  runHeader->setDetectorName("benchmark");
+  runHeader->setHeaderVersion(0.0011);
+  runHeader->setDataType(EUTELESCOPE::CONVDATA);
+  runHeader->setDateTime();
+  runHeader->setDAQHWName("benchmarkgen");
+  runHeader->setDAQHWVersion(0.0001);
+  runHeader->setDAQSWName("benchmarkgen");
+  runHeader->setDAQSWVersion(0.0001);
+  runHeader->setNoOfEvent( nEvent );
+  runHeader->setNoOfDetector( nMimosa26 );
+  runHeader->setMinX( minX );
+  runHeader->setMaxX( maxX );
+  runHeader->setMinY( minY );
+  runHeader->setMaxY( maxY );
+
+  lcWriter->writeRunHeader( runHeader );
+  delete runHeader;
+}
+
+void usage() {
+  cout << "./benchmarkgen [options]" << endl
+       << "  -n events      number of events (default " << nEvent << ")" << endl
+       << "  -t tracks      mean number of tracks per event (default " << tracksPerEvent << ")" << endl
+       << "  -o occupancy   noise hits per pixel and event (default " << noiseOccupancy << ")" << endl
+       << "  -s noise       pixel noise of the raw Mimosa26 frames, in ADC (default " << rawNoise << ")" << endl
+       << "  -r seed        random seed, also the run number (default " << seed << ")" << endl
+       << "  -d path        output directory (default " << outputPath << ")" << endl
+       << "  -raw           also write the not zero suppressed Mimosa26 frames" << endl;
+}
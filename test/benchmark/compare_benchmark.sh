@@ -0,0 +1,47 @@
+#!/bin/bash
+# Compares two results files of run_benchmark.sh, typically of two
+# commits: for every job and section, the median time per event (mean
+# time for the whole jobs) of both and their ratio. Sections slower by
+# more than the tolerance, and sections found in only one of the two
+# files, are flagged and make the script fail.
+
+if [ $# -lt 2 ]
+then
+    echo "Usage: $0 reference.csv new.csv [tolerance, default 0.10]"
+    exit 1
+fi
+
+TOLERANCE=${3:-0.10}
+
+awk -F, -v tolerance="$TOLERANCE" '
+  # columns: 8 job, 9 section, 11 mean_ms, 12 median_ms
+  FNR == 1 { next }
+  {
+    key = $8 "," $9
+    time = ( $9 == "job" ) ? $11 : $12
+  }
+  NR == FNR { reference[key] = time; next }
+  !( key in reference ) {
+    printf "%-12s %-20s %12s %12.3f %8s %s\n", $8, $9, "-", time, "-", "MISSING in reference"
+    missing++
+    next
+  }
+  {
+    seen[key] = 1
+    ratio = ( reference[key] > 0 ) ? time / reference[key] : 0
+    flag = ""
+    if ( ratio > 1 + tolerance ) { flag = "SLOWER"; slower++ }
+    else if ( ratio > 0 && ratio < 1 - tolerance ) flag = "faster"
+    printf "%-12s %-20s %12.3f %12.3f %8.2f %s\n", $8, $9, reference[key], time, ratio, flag
+  }
+  BEGIN { printf "%-12s %-20s %12s %12s %8s\n", "job", "section", "ref [ms]", "new [ms]", "ratio" }
+  END {
+    for ( key in reference ) {
+      if ( key in seen ) continue
+      split( key, field, "," )
+      printf "%-12s %-20s %12.3f %12s %8s %s\n", field[1], field[2], reference[key], "-", "-", "MISSING in new"
+      missing++
+    }
+    exit ( slower > 0 || missing > 0 )
+  }
+' "$1" "$2"
@@ -0,0 +1,119 @@
+#!/bin/bash
+# Reconstruction benchmark: generates synthetic telescope data with
+# benchmarkgen, runs every reconstruction stage as a separate Marlin job
+# and the whole chain in one job, and collects the EUTelUtilityProfiler
+# tables of all the jobs in one CSV file. See the README.
+
+usage() {
+    echo "Usage: $0 [options]"
+    echo "  -n events      number of events (default $NEVENTS)"
+    echo "  -t tracks      mean number of tracks per event (default $NTRACKS)"
+    echo "  -o occupancy   noise hits per pixel and event (default $OCCUPANCY)"
+    echo "  -s noise       pixel noise of the raw Mimosa26 frames (default $NOISE)"
+    echo "  -r seed        random seed (default $SEED)"
+    echo "  -raw           also benchmark the zero suppression of raw Mimosa26 frames"
+    echo "  -d path        working directory (default $WORKDIR)"
+    echo "  -l label       label of the results, e.g. the name of a branch (default $LABEL)"
+    echo "  -h             this help"
+}
+
+NEVENTS=1000
+NTRACKS=1
+OCCUPANCY=1e-4
+NOISE=1
+SEED=1
+RAW=0
+WORKDIR=$(pwd)/benchmark
+LABEL=default
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+	-n) NEVENTS=$2; shift ;;
+	-t) NTRACKS=$2; shift ;;
+	-o) OCCUPANCY=$2; shift ;;
+	-s) NOISE=$2; shift ;;
+	-r) SEED=$2; shift ;;
+	-raw) RAW=1 ;;
+	-d) WORKDIR=$2; shift ;;
+	-l) LABEL=$2; shift ;;
+	-h) usage; exit 0 ;;
+	*) echo " Unknown option $1"; usage; exit 1 ;;
+    esac
+    shift
+done
+
+BENCHMARKDIR=$(cd $(dirname $0) && pwd)
+
+if ! which Marlin > /dev/null 2>&1
+then
+    echo " Marlin not found - please set up the environment (build_env.sh) first!"
+    exit 1
+fi
+
+if [ ! -x $BENCHMARKDIR/benchmarkgen ]
+then
+    echo " Building benchmarkgen"
+    make -C $BENCHMARKDIR || exit 1
+fi
+
+if [ -n "$EUTELESCOPE" ] && [ -d "$EUTELESCOPE/.git" ]
+then
+    COMMIT=$(cd $EUTELESCOPE && git rev-parse --short HEAD)
+else
+    COMMIT=unknown
+fi
+
+DATADIR=$WORKDIR/data
+OUTPUTDIR=$WORKDIR/output
+mkdir -p $DATADIR $OUTPUTDIR $WORKDIR/steering
+
+echo " Generating $NEVENTS events in $DATADIR"
+GENOPTIONS="-n $NEVENTS -t $NTRACKS -o $OCCUPANCY -s $NOISE -r $SEED -d $DATADIR"
+[ $RAW -eq 1 ] && GENOPTIONS="$GENOPTIONS -raw"
+$BENCHMARKDIR/benchmarkgen $GENOPTIONS > $OUTPUTDIR/benchmarkgen.log || exit 1
+
+# the stages in isolation, each one reading the output of the previous
+# one, then the whole chain
+JOBS="cluster hitmaker align fit fullchain"
+[ $RAW -eq 1 ] && JOBS="sparsify $JOBS"
+
+RESULTS=$WORKDIR/benchmark-results.csv
+echo "commit,label,nevents,tracks,occupancy,noise,seed,job,section,events,mean_ms,median_ms,p90_ms,p99_ms,max_ms,cpu_ms,total_s,allocations,kB" > $RESULTS
+PREFIX="$COMMIT,$LABEL,$NEVENTS,$NTRACKS,$OCCUPANCY,$NOISE,$SEED"
+
+# count the allocations if the hook library is there
+HOOK=""
+for dir in $EUTELESCOPE/lib $EUTELESCOPE/build; do
+    [ -f $dir/libEutelescopeAllocationHook.so ] && HOOK=$dir/libEutelescopeAllocationHook.so
+done
+
+for JOB in $JOBS; do
+    STEERING=$WORKDIR/steering/$JOB.xml
+    sed -e "s|@DataPath@|$DATADIR|g" \
+	-e "s|@OutputPath@|$OUTPUTDIR|g" \
+	-e "s|@GearFile@|$BENCHMARKDIR/gear_benchmark.xml|g" \
+	-e "s|@MaxRecordNumber@|0|g" \
+	-e "s|@Events@|$NEVENTS|g" \
+	-e "s|@Verbosity@|MESSAGE4|g" \
+	$BENCHMARKDIR/steering/$JOB.xml > $STEERING
+
+    echo " Running $JOB"
+    START=$(date +%s.%N)
+    (cd $OUTPUTDIR && LD_PRELOAD=$HOOK Marlin $STEERING > $OUTPUTDIR/$JOB.log 2>&1)
+    STATUS=$?
+    STOP=$(date +%s.%N)
+    if [ $STATUS -ne 0 ] || [ ! -f $OUTPUTDIR/$JOB-profile.csv ]
+    then
+	echo " $JOB failed, see $OUTPUTDIR/$JOB.log"
+	exit 1
+    fi
+
+    # the sections of the job, then the job itself, with the reading
+    # of the data and the initialisation
+    tail -n +2 $OUTPUTDIR/$JOB-profile.csv | sed -e "s|^|$PREFIX,$JOB,|" >> $RESULTS
+    echo "$START $STOP $NEVENTS" | awk -v prefix="$PREFIX,$JOB,job" \
+	'{ t = $2 - $1; printf "%s,%d,%.3f,,,,,,%.3f,,\n", prefix, $3, 1000. * t / $3, t }' >> $RESULTS
+done
+
+echo " Results written to $RESULTS"
+column -s, -t < $RESULTS | cut -c1-200
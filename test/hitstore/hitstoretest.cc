@@ -0,0 +1,218 @@
+// Version $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#include "EUTELESCOPE.h"
+#include "EUTelHitStore.h"
+
+#include "lcio.h"
+#include "IMPL/LCEventImpl.h"
+#include "IMPL/LCCollectionVec.h"
+#include "IMPL/TrackerDataImpl.h"
+#include "IMPL/TrackerHitImpl.h"
+#include "UTIL/CellIDEncoder.h"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace lcio;
+using namespace eutelescope;
+
+// four planes, given in an order different from the z order and with
+// sensor IDs different from the plane indices
+const int    nPlane = 4;
+const int    sensorIDs[nPlane] = { 2, 0, 1, 8 };
+const double planeZ[nPlane]    = { 300., 0., 150., 450. };
+
+const string hitCollectionName      = "hit";
+const string hotPixelCollectionName = "hotpixel";
+
+int nFailed = 0;
+
+void check(bool condition, const string & what) {
+  cout << ( condition ? " OK     " : " FAILED " ) << what << endl;
+  if ( ! condition ) ++nFailed;
+}
+
+//! A sparse Mimosa26 cluster of one or two pixels
+TrackerDataImpl * makeCluster(LCCollectionVec * clusterCollection, int sensorID, short x, short y, bool twoPixels) {
+
+  CellIDEncoder< TrackerDataImpl > encoder( EUTELESCOPE::ZSCLUSTERDEFAULTENCODING, clusterCollection );
+  TrackerDataImpl * cluster = new TrackerDataImpl;
+  encoder["sensorID"]        = sensorID;
+  encoder["clusterID"]       = clusterCollection->getNumberOfElements();
+  encoder["sparsePixelType"] = static_cast< int >( kEUTelSimpleSparsePixel );
+  encoder["quality"]         = 0;
+  encoder.setCellID( cluster );
+
+  // x, y and signal of each pixel
+  FloatVec pixels;
+  pixels.push_back( x );
+  pixels.push_back( y );
+  pixels.push_back( 1. );
+  if ( twoPixels ) {
+    pixels.push_back( x + 1 );
+    pixels.push_back( y );
+    pixels.push_back( 1. );
+  }
+  cluster->setChargeValues( pixels );
+  clusterCollection->push_back( cluster );
+  return cluster;
+}
+
+void addHit(LCCollectionVec * hitCollection, double x, double y, double z, TrackerDataImpl * cluster) {
+
+  TrackerHitImpl * hit = new TrackerHitImpl;
+  double pos[3] = { x, y, z };
+  hit->setPosition( pos );
+
+  FloatVec cov( 6, 0. );
+  cov[0] = 0.0004f;
+  cov[2] = 0.0009f;
+  hit->setCovMatrix( cov );
+
+  if ( cluster != 0 ) {
+    hit->setType( kEUTelSparseClusterImpl );
+    hit->rawHits().push_back( cluster );
+  } else {
+    // a hit with no pixels to look at
+    hit->setType( kEUTelFFClusterImpl );
+  }
+  hitCollection->push_back( hit );
+}
+
+//! The hot pixel database: one pixel on one sensor
+void addHotPixels(LCEventImpl * event, int sensorID, short x, short y) {
+
+  LCCollectionVec * hotPixelCollection = new LCCollectionVec( LCIO::TRACKERDATA );
+  CellIDEncoder< TrackerDataImpl > encoder( EUTELESCOPE::ZSDATADEFAULTENCODING, hotPixelCollection );
+
+  TrackerDataImpl * hotPixels = new TrackerDataImpl;
+  encoder["sensorID"]        = sensorID;
+  encoder["sparsePixelType"] = static_cast< int >( kEUTelSimpleSparsePixel );
+  encoder.setCellID( hotPixels );
+
+  FloatVec pixels;
+  pixels.push_back( x );
+  pixels.push_back( y );
+  pixels.push_back( 0. );
+  hotPixels->setChargeValues( pixels );
+
+  hotPixelCollection->push_back( hotPixels );
+  event->addCollection( hotPixelCollection, hotPixelCollectionName );
+}
+
+//! Five hits, see the checks in main()
+LCEventImpl * makeEvent(int runNumber, int eventNumber, int hotSensorID) {
+
+  LCEventImpl * event = new LCEventImpl;
+  event->setRunNumber( runNumber );
+  event->setEventNumber( eventNumber );
+
+  LCCollectionVec * clusterCollection = new LCCollectionVec( LCIO::TRACKERDATA );
+  LCCollectionVec * hitCollection     = new LCCollectionVec( LCIO::TRACKERHIT );
+
+  addHit( hitCollection, 1.,  2.,  0.02,  makeCluster( clusterCollection, 0, 10, 10, false ) );
+  addHit( hitCollection, 3.,  4.,  150.1, makeCluster( clusterCollection, 1, 5, 7, false ) );
+  addHit( hitCollection, 5.,  6.,  299.9, makeCluster( clusterCollection, 2, 5, 7, false ) );
+  addHit( hitCollection, 7.,  8.,  450.,  makeCluster( clusterCollection, 8, 4, 7, true ) );
+  addHit( hitCollection, 9., 10.,  0.,    0 );
+
+  event->addCollection( clusterCollection, "cluster" );
+  event->addCollection( hitCollection, hitCollectionName );
+  addHotPixels( event, hotSensorID, 5, 7 );
+  return event;
+}
+
+bool near(double a, double b) {
+  return std::abs( a - b ) < 1e-6;
+}
+
+int main() {
+
+  EUTelHitStore::setPlanes( vector< int >( sensorIDs, sensorIDs + nPlane ), vector< double >( planeZ, planeZ + nPlane ) );
+
+  // the hot pixel (5, 7) is on sensor 1
+  LCEventImpl * event = makeEvent( 1, 0, 1 );
+  const EUTelHitStore & store = EUTelHitStore::get( event, hitCollectionName );
+
+  // planes
+  check( store.getNPlanes() == static_cast< size_t >( nPlane ), "one plane per layer" );
+  bool planesInOrder = true;
+  for ( int iPlane = 0; iPlane < nPlane; ++iPlane ) {
+    if ( store.getPlane( iPlane ).sensorID != sensorIDs[iPlane] || store.getPlaneIndex( sensorIDs[iPlane] ) != iPlane ) planesInOrder = false;
+  }
+  check( planesInOrder, "the planes are in the layer order" );
+  check( store.getPlaneIndex( 5 ) == -1, "an unknown sensor has no plane" );
+
+  // plane assignment
+  const int expectedSensorIDs[5] = { 0, 1, 2, 8, 0 };
+  check( store.getNHits() == 5, "every hit of the collection is known" );
+  bool sensorsRight = true;
+  for ( int iHit = 0; iHit < 5; ++iHit ) {
+    if ( store.getHitSensorID( iHit ) != expectedSensorIDs[iHit] ) sensorsRight = false;
+    if ( store.getHitPlane( iHit ) != store.getPlaneIndex( expectedSensorIDs[iHit] ) ) sensorsRight = false;
+  }
+  check( sensorsRight, "each hit is on the nearest plane along z" );
+
+  const EUTelHitStore::Plane & plane0 = store.getPlane( store.getPlaneIndex( 0 ) );
+  check( plane0.size() == 2 && plane0.collectionIndex[0] == 0 && plane0.collectionIndex[1] == 4, "the hits of a plane keep the collection order" );
+  check( store.getHitIndex( 4 ) == 1, "the index of a hit in its plane" );
+  check( near( plane0.x[1], 9. ) && near( plane0.y[1], 10. ) && near( plane0.z[1], 0. ), "the hit positions" );
+  check( near( plane0.errX[0], 0.02 ) && near( plane0.errY[0], 0.03 ), "the hit errors from the covariance matrix" );
+
+  // hot flags
+  check( ! store.isHitHot( 0, hotPixelCollectionName ), "a hit without hot pixel is not flagged" );
+  check( store.isHitHot( 1, hotPixelCollectionName ), "a hit with a hot pixel is flagged" );
+  check( ! store.isHitHot( 2, hotPixelCollectionName ), "the same pixel on another sensor is not hot" );
+  check( ! store.isHitHot( 3, hotPixelCollectionName ), "a cluster on another sensor is not flagged" );
+  check( ! store.isHitHot( 4, hotPixelCollectionName ), "a hit without sparse cluster is never flagged" );
+  check( store.getHotFlags( hotPixelCollectionName ).size() == 5, "one hot flag per hit of the collection" );
+  check( &store.getHotFlags( hotPixelCollectionName ) == &store.getHotFlags( hotPixelCollectionName ), "the hot flags are computed once" );
+  check( ! store.isHitHot( 1, "" ), "without hot pixel collection no hit is flagged" );
+
+  // the store belongs to the event, whatever the hot pixel collection
+  check( &EUTelHitStore::get( event, hitCollectionName ) == &store, "the store is built once per event" );
+  bool transient = false;
+  try {
+    transient = event->getCollection( "EUTelHitStore_" + hitCollectionName + "_" )->isTransient();
+  } catch ( DataNotAvailableException& e ) {
+    transient = false;
+  }
+  check( transient, "the store is a transient collection of the event" );
+  delete event;
+
+  // a new run with another hot pixel database: the pixel is now on
+  // sensor 2, and a later event of the same run cannot change it
+  event = makeEvent( 2, 0, 2 );
+  const EUTelHitStore & newRunStore = EUTelHitStore::get( event, hitCollectionName );
+  check( ! newRunStore.isHitHot( 1, hotPixelCollectionName ) && newRunStore.isHitHot( 2, hotPixelCollectionName ), "the hot pixels are read again for a new run" );
+  delete event;
+
+  event = makeEvent( 2, 1, 8 );
+  const EUTelHitStore & sameRunStore = EUTelHitStore::get( event, hitCollectionName );
+  check( ! sameRunStore.isHitHot( 3, hotPixelCollectionName ) && sameRunStore.isHitHot( 2, hotPixelCollectionName ), "the hot pixels are kept within a run" );
+  delete event;
+
+  // the hot pixel is the second pixel of the cluster on sensor 8
+  event = makeEvent( 3, 0, 8 );
+  const EUTelHitStore & clusterStore = EUTelHitStore::get( event, hitCollectionName );
+  check( clusterStore.isHitHot( 3, hotPixelCollectionName ) && ! clusterStore.isHitHot( 1, hotPixelCollectionName ), "every pixel of a cluster is checked" );
+  delete event;
+
+  if ( nFailed > 0 ) {
+    cout << nFailed << " checks failed" << endl;
+    return 1;
+  }
+  cout << "All checks passed" << endl;
+  return 0;
+}
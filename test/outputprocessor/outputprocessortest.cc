@@ -0,0 +1,177 @@
+// Version $Id$
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#include "EUTELESCOPE.h"
+#include "EUTelEventImpl.h"
+
+#include "lcio.h"
+#include "IO/LCWriter.h"
+#include "IO/LCReader.h"
+#include "IMPL/LCEventImpl.h"
+#include "IMPL/LCRunHeaderImpl.h"
+#include "IMPL/LCCollectionVec.h"
+#include "IMPL/TrackerDataImpl.h"
+#include "IMPL/TrackerHitImpl.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace lcio;
+using namespace eutelescope;
+
+// see outputprocessortest.xml
+const string inputFileName  = "outputprocessor_input.slcio";
+const string outputFileName = "outputprocessor_output.slcio";
+
+const int runNumber = 1;
+const int nEvent    = 20;
+
+// the kept collections and their number of elements. The hits point
+// to the elements of the dropped collection
+const string keptDataName    = "keptdata";
+const string keptHitName     = "kepthit";
+const string droppedDataName = "droppeddata";
+const int    nKeptData       = 2;
+const int    nKeptHit        = 3;
+
+int nFailed = 0;
+
+void check(bool condition, const string & what) {
+  cout << ( condition ? " OK     " : " FAILED " ) << what << endl;
+  if ( ! condition ) ++nFailed;
+}
+
+LCCollectionVec * makeDataCollection(int nElement) {
+  LCCollectionVec * collection = new LCCollectionVec( LCIO::TRACKERDATA );
+  for ( int iElement = 0; iElement < nElement; ++iElement ) {
+    TrackerDataImpl * data = new TrackerDataImpl;
+    FloatVec charges( 3, static_cast< float >( iElement ) );
+    data->setChargeValues( charges );
+    collection->push_back( data );
+  }
+  return collection;
+}
+
+//! Write nEvent data events and an EORE
+void writeInput() {
+
+  LCWriter * writer = LCFactory::getInstance()->createLCWriter();
+  writer->open( inputFileName, LCIO::WRITE_NEW );
+
+  LCRunHeaderImpl * runHeader = new LCRunHeaderImpl;
+  runHeader->setRunNumber( runNumber );
+  runHeader->setDetectorName( "test" );
+  writer->writeRunHeader( runHeader );
+  delete runHeader;
+
+  for ( int iEvent = 0; iEvent <= nEvent; ++iEvent ) {
+
+    EUTelEventImpl * event = new EUTelEventImpl;
+    event->setRunNumber( runNumber );
+    event->setEventNumber( iEvent );
+
+    if ( iEvent == nEvent ) {
+      event->setEventType( kEORE );
+    } else {
+      event->setEventType( kDE );
+
+      LCCollectionVec * droppedData = makeDataCollection( nKeptHit );
+      LCCollectionVec * keptHits    = new LCCollectionVec( LCIO::TRACKERHIT );
+      for ( int iHit = 0; iHit < nKeptHit; ++iHit ) {
+        TrackerHitImpl * hit = new TrackerHitImpl;
+        hit->rawHits().push_back( static_cast< TrackerDataImpl * >( droppedData->getElementAt( iHit ) ) );
+        keptHits->push_back( hit );
+      }
+      event->addCollection( makeDataCollection( nKeptData ), keptDataName );
+      event->addCollection( keptHits, keptHitName );
+      event->addCollection( droppedData, droppedDataName );
+    }
+
+    writer->writeEvent( event );
+    delete event;
+  }
+
+  writer->close();
+  delete writer;
+}
+
+//! Read the output back: only the kept collections of every event
+void checkOutput() {
+
+  LCReader * reader = LCFactory::getInstance()->createLCReader();
+  reader->open( outputFileName );
+
+  vector< string > keptNames;
+  keptNames.push_back( keptDataName );
+  keptNames.push_back( keptHitName );
+  sort( keptNames.begin(), keptNames.end() );
+
+  int  nDataEvent     = 0;
+  bool inOrder        = true;
+  bool namesRight     = true;
+  bool elementsRight  = true;
+  bool lastIsEORE     = false;
+
+  LCEvent * event;
+  while ( ( event = reader->readNextEvent() ) != 0 ) {
+
+    EUTelEventImpl * eutelEvent = static_cast< EUTelEventImpl * >( event );
+    lastIsEORE = ( eutelEvent->getEventType() == kEORE );
+    if ( lastIsEORE ) continue;
+
+    if ( event->getRunNumber() != runNumber || event->getEventNumber() != nDataEvent ) inOrder = false;
+    ++nDataEvent;
+
+    vector< string > names( event->getCollectionNames()->begin(), event->getCollectionNames()->end() );
+    sort( names.begin(), names.end() );
+    if ( names != keptNames ) {
+      namesRight = false;
+      continue;
+    }
+    if ( event->getCollection( keptDataName )->getNumberOfElements() != nKeptData ||
+         event->getCollection( keptHitName )->getNumberOfElements() != nKeptHit ) elementsRight = false;
+  }
+
+  reader->close();
+  delete reader;
+
+  check( nDataEvent == nEvent, "every data event is written" );
+  check( inOrder, "the events keep their run, number and order" );
+  check( namesRight, "every event has the kept collections and nothing else" );
+  check( elementsRight, "the kept collections have all their elements" );
+  check( lastIsEORE, "the last event is an EORE" );
+}
+
+int main(int argc, char ** argv) {
+
+  const string mode = ( argc > 1 ) ? argv[1] : "";
+
+  if ( mode == "write" ) {
+    writeInput();
+    cout << "Written " << inputFileName << endl;
+    return 0;
+  }
+
+  if ( mode != "check" ) {
+    cerr << "Usage: " << argv[0] << " write|check" << endl;
+    return 1;
+  }
+
+  checkOutput();
+  if ( nFailed > 0 ) {
+    cout << nFailed << " checks failed" << endl;
+    return 1;
+  }
+  cout << "All checks passed" << endl;
+  return 0;
+}